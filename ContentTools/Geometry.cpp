@@ -0,0 +1,556 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "Geometry.h"
+#include "MeshSimplification.h"
+#include "../Engine/Utilities/Quantization.h"
+#include <cmath>
+#include <cstring>
+#ifdef _WIN64
+#include <combaseapi.h>
+#endif // _WIN64
+
+namespace savage::tools {
+	namespace {
+
+		constexpr f32 pi{ 3.14159265358979f };
+		constexpr u32 min_corners_per_thread{ 16 * 1024 };
+
+		struct float3
+		{
+			f32 x, y, z;
+		};
+
+		float3 to_float3(const math::v3& v) { return { v.x, v.y, v.z }; }
+		float3 operator-(const float3& a, const float3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		float3 operator+(const float3& a, const float3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+		float3 operator*(const float3& a, f32 s) { return { a.x * s, a.y * s, a.z * s }; }
+		f32 dot(const float3& a, const float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+		float3 cross(const float3& a, const float3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+		float3 normalize(const float3& v, const float3& fallback)
+		{
+			const f32 length_sq{ dot(v, v) };
+			return length_sq > 1e-30f ? v * (1.f / sqrtf(length_sq)) : fallback;
+		}
+
+		// Run on all cores when the meshes are not already processed at the same time
+		template<typename F>
+		void for_range(bool parallel, u32 count, F&& func)
+		{
+			if (parallel) parallel_for(count, min_corners_per_thread, func);
+			else if (count) func(0u, count);
+		}
+
+		// The corners (index into raw_indices) that use each position, as one list per position
+		struct corner_lists
+		{
+			utl::vector<u32> offsets; // Corners of position p are corners[offsets[p]] to corners[offsets[p + 1]]
+			utl::vector<u32> corners;
+		};
+
+		corner_lists make_corner_lists(const mesh& m)
+		{
+			corner_lists lists;
+			lists.offsets.assign(m.positions.size() + 1, 0);
+			for (u32 index : m.raw_indices) ++lists.offsets[index + 1];
+			for (size_t i{ 1 }; i < lists.offsets.size(); ++i) lists.offsets[i] += lists.offsets[i - 1];
+
+			lists.corners.resize(m.raw_indices.size());
+			utl::vector<u32> fill(lists.offsets.begin(), lists.offsets.end() - 1);
+			for (u32 corner{ 0 }; corner < (u32)m.raw_indices.size(); ++corner)
+			{
+				lists.corners[fill[m.raw_indices[corner]]++] = corner;
+			}
+			return lists;
+		}
+
+		// Merge positions that are closer than a millionth of the size of the mesh. Positions go into a hash grid
+		// with cells that size, so a close position is always in one of the 27 cells around it.
+		// Triangles that lose an area because of it are removed
+		void weld_positions(mesh& m)
+		{
+			const u32 count{ (u32)m.positions.size() };
+			if (!count) return;
+
+			float3 min{ to_float3(m.positions[0]) }, max{ min };
+			for (const auto& p : m.positions)
+			{
+				min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+				max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+			}
+			const f32 extent{ std::max(std::max(max.x - min.x, max.y - min.y), max.z - min.z) };
+			const f32 epsilon{ std::max(extent * 1e-6f, 1e-7f) };
+			const f32 inv_cell{ 1.f / epsilon };
+
+			// Open addressing table from cell to the first position in it. Positions in a cell are linked with next
+			u32 table_size{ 1 };
+			while (table_size < count * 2) table_size <<= 1;
+			struct cell { s32 x, y, z; u32 first; };
+			utl::vector<cell> table(table_size, { 0, 0, 0, u32_invalid_id });
+			utl::vector<u32> next;
+			utl::vector<math::v3> unique;
+			utl::vector<u32> remap(count);
+			next.reserve(count);
+			unique.reserve(count);
+
+			auto hash = [table_size](s32 x, s32 y, s32 z) {
+				return ((u32)x * 73856093u ^ (u32)y * 19349663u ^ (u32)z * 83492791u) & (table_size - 1);
+			};
+			auto find_cell = [&](s32 x, s32 y, s32 z) -> cell& {
+				u32 slot{ hash(x, y, z) };
+				while (table[slot].first != u32_invalid_id && (table[slot].x != x || table[slot].y != y || table[slot].z != z))
+				{
+					slot = (slot + 1) & (table_size - 1);
+				}
+				return table[slot];
+			};
+
+			const f32 epsilon_sq{ epsilon * epsilon };
+			for (u32 i{ 0 }; i < count; ++i)
+			{
+				const float3 p{ to_float3(m.positions[i]) };
+				const s32 cx{ (s32)floorf((p.x - min.x) * inv_cell) }, cy{ (s32)floorf((p.y - min.y) * inv_cell) }, cz{ (s32)floorf((p.z - min.z) * inv_cell) };
+
+				u32 match{ u32_invalid_id };
+				for (s32 dz{ -1 }; dz <= 1 && match == u32_invalid_id; ++dz)
+				{
+					for (s32 dy{ -1 }; dy <= 1 && match == u32_invalid_id; ++dy)
+					{
+						for (s32 dx{ -1 }; dx <= 1 && match == u32_invalid_id; ++dx)
+						{
+							for (u32 u{ find_cell(cx + dx, cy + dy, cz + dz).first }; u != u32_invalid_id; u = next[u])
+							{
+								const float3 d{ to_float3(unique[u]) - p };
+								if (dot(d, d) <= epsilon_sq) { match = u; break; }
+							}
+						}
+					}
+				}
+
+				if (match == u32_invalid_id)
+				{
+					match = (u32)unique.size();
+					cell& c{ find_cell(cx, cy, cz) };
+					if (c.first == u32_invalid_id) c = { cx, cy, cz, u32_invalid_id };
+					next.push_back(c.first);
+					c.first = match;
+					unique.push_back(m.positions[i]);
+				}
+				remap[i] = match;
+			}
+
+			m.positions = std::move(unique);
+
+			// Remap the triangles and drop the ones that collapsed, with their attributes
+			const bool has_normals{ m.normals.size() == m.raw_indices.size() };
+			const bool has_tangents{ m.tangents.size() == m.raw_indices.size() };
+			u32 kept{ 0 };
+			for (u32 corner{ 0 }; corner < (u32)m.raw_indices.size(); corner += 3)
+			{
+				const u32 a{ remap[m.raw_indices[corner]] }, b{ remap[m.raw_indices[corner + 1]] }, c{ remap[m.raw_indices[corner + 2]] };
+				if (a == b || b == c || a == c) continue;
+				m.raw_indices[kept] = a;
+				m.raw_indices[kept + 1] = b;
+				m.raw_indices[kept + 2] = c;
+				for (u32 k{ 0 }; k < 3; ++k)
+				{
+					if (has_normals) m.normals[kept + k] = m.normals[corner + k];
+					if (has_tangents) m.tangents[kept + k] = m.tangents[corner + k];
+					for (auto& uv_set : m.uv_sets) uv_set[kept + k] = uv_set[corner + k];
+				}
+				kept += 3;
+			}
+			m.raw_indices.resize(kept);
+			if (has_normals) m.normals.resize(kept);
+			if (has_tangents) m.tangents.resize(kept);
+			for (auto& uv_set : m.uv_sets) uv_set.resize(kept);
+		}
+
+		// Make a normal for each corner from the triangles around its position. Triangles are only smoothed
+		// together if the angle between them is at most smoothing_angle degrees, so sharper edges stay hard.
+		// Each triangle adds its normal weighted by its area
+		void calculate_normals(mesh& m, const corner_lists& lists, f32 smoothing_angle, bool parallel)
+		{
+			const u32 triangle_count{ (u32)m.raw_indices.size() / 3 };
+			utl::vector<float3> face_normals(triangle_count);
+			utl::vector<float3> unit_normals(triangle_count);
+			for_range(parallel, triangle_count, [&](u32 begin, u32 end) {
+				for (u32 t{ begin }; t < end; ++t)
+				{
+					const float3 p0{ to_float3(m.positions[m.raw_indices[t * 3]]) };
+					const float3 p1{ to_float3(m.positions[m.raw_indices[t * 3 + 1]]) };
+					const float3 p2{ to_float3(m.positions[m.raw_indices[t * 3 + 2]]) };
+					face_normals[t] = cross(p1 - p0, p2 - p0);
+					unit_normals[t] = normalize(face_normals[t], { 0.f, 1.f, 0.f });
+				}
+			});
+
+			const f32 cos_angle{ cosf(std::clamp(smoothing_angle, 0.f, 180.f) * pi / 180.f) - 1e-6f };
+			m.normals.resize(m.raw_indices.size());
+			for_range(parallel, (u32)m.raw_indices.size(), [&](u32 begin, u32 end) {
+				for (u32 corner{ begin }; corner < end; ++corner)
+				{
+					const u32 t{ corner / 3 };
+					const u32 position{ m.raw_indices[corner] };
+					float3 normal{ 0.f, 0.f, 0.f };
+					for (u32 i{ lists.offsets[position] }; i < lists.offsets[position + 1]; ++i)
+					{
+						const u32 other{ lists.corners[i] / 3 };
+						if (dot(unit_normals[t], unit_normals[other]) >= cos_angle) normal = normal + face_normals[other];
+					}
+					const float3 n{ normalize(normal, unit_normals[t]) };
+					m.normals[corner] = { n.x, n.y, n.z };
+				}
+			});
+		}
+
+		bool same_vertex(const vertex& a, const vertex& b)
+		{
+			return fabsf(a.normal.x - b.normal.x) < 1e-5f && fabsf(a.normal.y - b.normal.y) < 1e-5f && fabsf(a.normal.z - b.normal.z) < 1e-5f &&
+				   fabsf(a.uv.x - b.uv.x) < 1e-6f && fabsf(a.uv.y - b.uv.y) < 1e-6f;
+		}
+
+		// Corners with the same position, normal and uv share a vertex. Vertices are made in the order of the positions
+		void make_vertices(mesh& m, const corner_lists& lists)
+		{
+			const bool has_uvs{ !m.uv_sets.empty() && m.uv_sets[0].size() == m.raw_indices.size() };
+			m.vertices.clear();
+			m.vertices.reserve(m.positions.size());
+			m.indices.resize(m.raw_indices.size());
+
+			for (u32 position{ 0 }; position < (u32)m.positions.size(); ++position)
+			{
+				const u32 first_vertex{ (u32)m.vertices.size() };
+				for (u32 i{ lists.offsets[position] }; i < lists.offsets[position + 1]; ++i)
+				{
+					const u32 corner{ lists.corners[i] };
+					vertex v{};
+					v.position = m.positions[position];
+					v.normal = m.normals[corner];
+					if (has_uvs) v.uv = m.uv_sets[0][corner];
+
+					u32 index{ first_vertex };
+					while (index < (u32)m.vertices.size() && !same_vertex(m.vertices[index], v)) ++index;
+					if (index == (u32)m.vertices.size()) m.vertices.emplace_back(v);
+					m.indices[corner] = index;
+				}
+			}
+		}
+
+		// Tangents that follow the MikkTSpace conventions so normal maps baked with it look right:
+		// the tangent of each triangle (from its uvs) is projected onto the plane of the vertex normal, normalized and
+		// added up weighted by the angle of the triangle at that corner. Corners with mirrored uvs (the other bitangent
+		// sign) get their own vertex. Shaders rebuild the bitangent as tangent.w * cross(normal, tangent.xyz)
+		// NOTE: MikkTSpace also splits vertices whose tangents point too far apart, which is not done here
+		void calculate_tangents(mesh& m, bool parallel)
+		{
+			const u32 corner_count{ (u32)m.indices.size() };
+			utl::vector<float3> corner_tangents(corner_count);
+			utl::vector<f32> corner_signs(corner_count);
+
+			for_range(parallel, corner_count / 3, [&](u32 begin, u32 end) {
+				for (u32 t{ begin }; t < end; ++t)
+				{
+					const vertex* v[3]{ &m.vertices[m.indices[t * 3]], &m.vertices[m.indices[t * 3 + 1]], &m.vertices[m.indices[t * 3 + 2]] };
+					const float3 e1{ to_float3(v[1]->position) - to_float3(v[0]->position) };
+					const float3 e2{ to_float3(v[2]->position) - to_float3(v[0]->position) };
+					const f32 du1{ v[1]->uv.x - v[0]->uv.x }, dv1{ v[1]->uv.y - v[0]->uv.y };
+					const f32 du2{ v[2]->uv.x - v[0]->uv.x }, dv2{ v[2]->uv.y - v[0]->uv.y };
+					const f32 area{ du1 * dv2 - du2 * dv1 };
+					// Same as MikkTSpace: the sign of the uv area is the orientation (and the bitangent sign), the size is normalized away
+					const f32 orientation{ area > 0.f ? 1.f : -1.f };
+					const float3 tangent{ (e1 * dv2 - e2 * dv1) * orientation };
+
+					for (u32 k{ 0 }; k < 3; ++k)
+					{
+						const float3 n{ to_float3(v[k]->normal) };
+						// The angle at the corner is measured between the edges projected onto the plane of the normal
+						const float3 a{ to_float3(v[(k + 1) % 3]->position) - to_float3(v[k]->position) };
+						const float3 b{ to_float3(v[(k + 2) % 3]->position) - to_float3(v[k]->position) };
+						const float3 pa{ normalize(a - n * dot(n, a), { 0.f, 0.f, 0.f }) };
+						const float3 pb{ normalize(b - n * dot(n, b), { 0.f, 0.f, 0.f }) };
+						const f32 angle{ acosf(std::clamp(dot(pa, pb), -1.f, 1.f)) };
+						const float3 projected{ normalize(tangent - n * dot(n, tangent), { 0.f, 0.f, 0.f }) };
+						corner_tangents[t * 3 + k] = projected * angle;
+						corner_signs[t * 3 + k] = orientation;
+					}
+				}
+			});
+
+			// Split vertices used with both signs. The corners with a negative sign move to a copy
+			const u32 vertex_count{ (u32)m.vertices.size() };
+			utl::vector<u32> mirrored(vertex_count, u32_invalid_id);
+			utl::vector<u8> has_positive(vertex_count, 0);
+			for (u32 corner{ 0 }; corner < corner_count; ++corner)
+			{
+				if (corner_signs[corner] > 0.f) has_positive[m.indices[corner]] = 1;
+			}
+			for (u32 corner{ 0 }; corner < corner_count; ++corner)
+			{
+				u32& index{ m.indices[corner] };
+				if (corner_signs[corner] > 0.f || !has_positive[index]) continue;
+				if (mirrored[index] == u32_invalid_id)
+				{
+					mirrored[index] = (u32)m.vertices.size();
+					m.vertices.push_back(m.vertices[index]);
+				}
+				index = mirrored[index];
+			}
+
+			utl::vector<float3> sums(m.vertices.size(), { 0.f, 0.f, 0.f });
+			utl::vector<f32> signs(m.vertices.size(), 1.f);
+			for (u32 corner{ 0 }; corner < corner_count; ++corner)
+			{
+				sums[m.indices[corner]] = sums[m.indices[corner]] + corner_tangents[corner];
+				signs[m.indices[corner]] = corner_signs[corner];
+			}
+
+			for_range(parallel, (u32)m.vertices.size(), [&](u32 begin, u32 end) {
+				for (u32 i{ begin }; i < end; ++i)
+				{
+					vertex& v{ m.vertices[i] };
+					const float3 n{ to_float3(v.normal) };
+					// No uvs to follow, so any direction on the plane of the normal will do
+					const float3 any{ fabsf(n.x) < 0.9f ? float3{ 1.f, 0.f, 0.f } : float3{ 0.f, 1.f, 0.f } };
+					const float3 t{ normalize(sums[i], normalize(any - n * dot(n, any), { 1.f, 0.f, 0.f })) };
+					v.tangent = { t.x, t.y, t.z, signs[i] };
+				}
+			});
+		}
+
+		void optimize_mesh(mesh& m)
+		{
+			m.cache_stats_before = analyze_vertex_cache(m.indices, (u32)m.vertices.size(), sizeof(vertex));
+			optimize_vertex_cache(m.indices, (u32)m.vertices.size());
+			optimize_vertex_fetch(m);
+			m.cache_stats_after = analyze_vertex_cache(m.indices, (u32)m.vertices.size(), sizeof(vertex));
+			build_meshlets(m);
+		}
+
+		void process_mesh(mesh& m, const geometry_import_settings& settings, bool parallel)
+		{
+			assert(!(m.raw_indices.size() % 3));
+			weld_positions(m);
+			const corner_lists lists{ make_corner_lists(m) };
+
+			if (settings.calculate_normals || m.normals.size() != m.raw_indices.size())
+			{
+				calculate_normals(m, lists, settings.smothing_angle, parallel);
+			}
+			make_vertices(m, lists);
+
+			const bool has_uvs{ !m.uv_sets.empty() && m.uv_sets[0].size() == m.raw_indices.size() };
+			if (settings.calculate_tangents && has_uvs) calculate_tangents(m, parallel);
+
+			m.elements = elements_type::normal;
+			if (has_uvs) m.elements |= elements_type::uv;
+			if (settings.calculate_tangents && has_uvs) m.elements |= elements_type::tangent;
+
+			optimize_mesh(m);
+		}
+
+		// Add simplified meshes after the only mesh of a lod group. Groups with more meshes have their lods made by hand
+		void generate_lods(lod_group& lod, u32 lod_count)
+		{
+			if (lod.meshes.size() != 1) return;
+			for (u32 i{ 0 }; i < lod_count; ++i)
+			{
+				const mesh& source{ lod.meshes.back() };
+				const u32 triangle_count{ (u32)source.indices.size() / 3 };
+				mesh m{};
+				const f32 error{ simplify_mesh(source, m, triangle_count / 2) };
+				if (m.indices.size() / 3 > triangle_count * 9 / 10) break; // Not simpler enough to be worth a lod
+
+				m.name = lod.meshes[0].name + "_lod" + std::to_string(lod.meshes.size());
+				m.lod_id = (u32)lod.meshes.size();
+				m.lod_threshold = error;
+				m.elements = source.elements;
+				optimize_mesh(m);
+				lod.meshes.emplace_back(std::move(m));
+			}
+		}
+
+		u32 vertex_size(u32 elements, vertex_format::type format)
+		{
+			const bool compact{ format == vertex_format::compact };
+			u32 size{ sizeof(f32) * 3 };
+			if (elements & elements_type::normal) size += compact ? sizeof(u32) : sizeof(f32) * 3;
+			if (elements & elements_type::tangent) size += compact ? sizeof(u32) : sizeof(f32) * 4;
+			if (elements & elements_type::uv) size += compact ? sizeof(u16) * 2 : sizeof(f32) * 2;
+			return size;
+		}
+
+		// Fill the packed vertices and indices of a processed mesh
+		void pack_mesh(mesh& m, vertex_format::type format)
+		{
+			if (format == vertex_format::position_only) m.elements = elements_type::position_only;
+			m.vertex_size = vertex_size(m.elements, format);
+			const u32 vertex_count{ (u32)m.vertices.size() };
+			m.packed_vertices.resize((size_t)vertex_count * m.vertex_size);
+
+			const bool compact{ format == vertex_format::compact };
+			u8* out{ m.packed_vertices.data() };
+			auto write = [&out](const void* data, size_t size) { memcpy(out, data, size); out += size; };
+			for (const vertex& v : m.vertices)
+			{
+				write(&v.position, sizeof(f32) * 3);
+				if (m.elements & elements_type::normal)
+				{
+					if (compact)
+					{
+						const u32 normal{ math::pack_unit_vector(v.normal, 16) };
+						write(&normal, sizeof(u32));
+					}
+					else write(&v.normal, sizeof(f32) * 3);
+				}
+				if (m.elements & elements_type::tangent)
+				{
+					if (compact)
+					{
+						const math::v3 t{ v.tangent.x, v.tangent.y, v.tangent.z };
+						const u32 tangent{ (math::pack_unit_vector(t, 15) << 1) | (v.tangent.w < 0.f ? 1 : 0) };
+						write(&tangent, sizeof(u32));
+					}
+					else write(&v.tangent, sizeof(f32) * 4);
+				}
+				if (m.elements & elements_type::uv)
+				{
+					if (compact)
+					{
+						const u16 uv[2]{ math::f32_to_f16(v.uv.x), math::f32_to_f16(v.uv.y) };
+						write(uv, sizeof(uv));
+					}
+					else write(&v.uv, sizeof(f32) * 2);
+				}
+			}
+			assert(out == m.packed_vertices.data() + m.packed_vertices.size());
+
+			m.index_size = vertex_count <= (1u << 16) ? sizeof(u16) : sizeof(u32);
+			m.packed_indices.resize(m.indices.size() * m.index_size);
+			if (m.index_size == sizeof(u16))
+			{
+				u16* const indices{ (u16*)m.packed_indices.data() };
+				for (size_t i{ 0 }; i < m.indices.size(); ++i) indices[i] = (u16)m.indices[i];
+			}
+			else memcpy(m.packed_indices.data(), m.indices.data(), m.packed_indices.size());
+		}
+
+		u32 padded_name_size(const std::string& name)
+		{
+			return sizeof(u32) + (((u32)name.size() + 3) & ~3u);
+		}
+
+		u32 get_scene_size(const scene& scene)
+		{
+			u32 size{ (u32)sizeof(packed_scene_header) + padded_name_size(scene.name) };
+			for (const auto& lod : scene.lod_groups)
+			{
+				size += padded_name_size(lod.name) + sizeof(u32);
+				for (const auto& m : lod.meshes)
+				{
+					// Index data is padded so the next mesh stays aligned
+					size += padded_name_size(m.name) + sizeof(packed_mesh_header) + (u32)m.packed_vertices.size() +
+						(((u32)m.packed_indices.size() + 3) & ~3u) + (u32)(m.meshlets.size() * sizeof(meshlet)) +
+						(u32)(m.meshlet_vertices.size() * sizeof(u32)) + (((u32)m.meshlet_triangles.size() + 3) & ~3u);
+				}
+			}
+			return size;
+		}
+
+		void write_name(u8*& at, const std::string& name)
+		{
+			const u32 length{ (u32)name.size() };
+			memcpy(at, &length, sizeof(u32));
+			memcpy(at + sizeof(u32), name.data(), length);
+			at += padded_name_size(name);
+		}
+
+	} // Anonymous namespace
+
+	void process_scene(scene& scene, const geometry_import_settings& settings)
+	{
+		utl::vector<mesh*> meshes;
+		for (auto& lod : scene.lod_groups)
+		{
+			for (auto& m : lod.meshes) meshes.push_back(&m);
+		}
+
+		// One mesh at a time on each core. A single mesh uses all cores for its own work instead
+		const bool parallel_meshes{ meshes.size() > 1 };
+		parallel_for((u32)meshes.size(), 1, [&](u32 begin, u32 end) {
+			for (u32 i{ begin }; i < end; ++i) process_mesh(*meshes[i], settings, !parallel_meshes);
+		});
+
+		if (settings.lod_count)
+		{
+			parallel_for((u32)scene.lod_groups.size(), 1, [&](u32 begin, u32 end) {
+				for (u32 i{ begin }; i < end; ++i) generate_lods(scene.lod_groups[i], settings.lod_count);
+			});
+		}
+	}
+
+	void pack_data(scene& scene, scene_data& data)
+	{
+		assert(data.settings.vertex_format < vertex_format::count);
+		const vertex_format::type format{ (vertex_format::type)data.settings.vertex_format };
+		utl::vector<mesh*> meshes;
+		for (auto& lod : scene.lod_groups)
+		{
+			for (auto& m : lod.meshes) meshes.push_back(&m);
+		}
+		parallel_for((u32)meshes.size(), 1, [&](u32 begin, u32 end) {
+			for (u32 i{ begin }; i < end; ++i) pack_mesh(*meshes[i], format);
+		});
+
+		const u32 size{ get_scene_size(scene) };
+#ifdef _WIN64
+		u8* const buffer{ (u8*)CoTaskMemAlloc(size) };
+#else
+		u8* const buffer{ (u8*)malloc(size) };
+#endif // _WIN64
+		assert(buffer);
+		memset(buffer, 0, size); // Padding
+
+		u8* at{ buffer };
+		const packed_scene_header header{ packed_scene_magic, packed_scene_version, size, (u32)scene.lod_groups.size() };
+		memcpy(at, &header, sizeof(header));
+		at += sizeof(header);
+		write_name(at, scene.name);
+
+		for (const auto& lod : scene.lod_groups)
+		{
+			write_name(at, lod.name);
+			const u32 mesh_count{ (u32)lod.meshes.size() };
+			memcpy(at, &mesh_count, sizeof(u32));
+			at += sizeof(u32);
+
+			for (const auto& m : lod.meshes)
+			{
+				write_name(at, m.name);
+				const packed_mesh_header mesh_header{ m.lod_id, m.lod_threshold, format, m.elements,
+					m.vertex_size, (u32)m.vertices.size(), m.index_size, (u32)m.indices.size(),
+					(u32)m.meshlets.size(), (u32)m.meshlet_vertices.size(), (u32)m.meshlet_triangles.size() / 3 };
+				memcpy(at, &mesh_header, sizeof(mesh_header));
+				at += sizeof(mesh_header);
+				memcpy(at, m.packed_vertices.data(), m.packed_vertices.size());
+				at += m.packed_vertices.size();
+				memcpy(at, m.packed_indices.data(), m.packed_indices.size());
+				at += (m.packed_indices.size() + 3) & ~(size_t)3;
+				memcpy(at, m.meshlets.data(), m.meshlets.size() * sizeof(meshlet));
+				at += m.meshlets.size() * sizeof(meshlet);
+				memcpy(at, m.meshlet_vertices.data(), m.meshlet_vertices.size() * sizeof(u32));
+				at += m.meshlet_vertices.size() * sizeof(u32);
+				memcpy(at, m.meshlet_triangles.data(), m.meshlet_triangles.size());
+				at += (m.meshlet_triangles.size() + 3) & ~(size_t)3;
+			}
+		}
+		assert(at == buffer + size);
+
+		data.buffer = buffer;
+		data.buffer_size = size;
+	}
+}
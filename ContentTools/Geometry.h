@@ -7,9 +7,45 @@ MIT License - see LICENSE file
 
 #pragma once
 #include "ToolsCommon.h"
+#include "MeshOptimization.h"
+#include "Meshlets.h"
 
 namespace savage::tools {
 
+	// A unique combination of the attributes of a mesh corner
+	struct vertex
+	{
+		math::v4							tangent{};	// w is the sign of the bitangent: bitangent = w * cross(normal, tangent)
+		math::v3							position{};
+		math::v3							normal{};
+		math::v2							uv{};
+	};
+
+	// What a packed vertex has after its position
+	struct elements_type
+	{
+		enum type : u32
+		{
+			position_only = 0x00,
+			normal = 0x01,
+			tangent = 0x02,	// With the sign of the bitangent
+			uv = 0x04,
+		};
+	};
+
+	// How the elements of a vertex are written in the packed vertex buffer, in the order position, normal, tangent, uv
+	struct vertex_format
+	{
+		enum type : u8
+		{
+			compact,		// f32 position, u32 octahedral normal (16:16), u32 octahedral tangent (15:15) and sign (lowest bit), 2 x f16 uv
+			full_precision,	// f32 position, 3 x f32 normal, 4 x f32 tangent, 2 x f32 uv
+			position_only,	// f32 position for depth and shadow passes
+
+			count
+		};
+	};
+
 	// Defines a mesh for geometry as scratch space
 	struct mesh 
 	{
@@ -22,9 +58,23 @@ namespace savage::tools {
 		utl::vector<u32>					raw_indices;
 
 		// Intermediate data
+		utl::vector<vertex>					vertices;
+		utl::vector<u32>					indices;
 
 		// Output data
-
+		std::string							name;
+		u32									lod_id{ u32_invalid_id };
+		f32									lod_threshold{ -1.f };	// Simplification error of a generated lod, in the units of the mesh
+		vertex_cache_stats					cache_stats_before;	// Of the vertices and indices before they are reordered
+		vertex_cache_stats					cache_stats_after;
+		u32									elements{ elements_type::position_only };
+		u32									vertex_size{ 0 };
+		u32									index_size{ 0 };	// 2 when all vertices fit in a u16, else 4
+		utl::vector<u8>						packed_vertices;
+		utl::vector<u8>						packed_indices;
+		utl::vector<meshlet>				meshlets;
+		utl::vector<u32>					meshlet_vertices;	// Index into vertices
+		utl::vector<u8>						meshlet_triangles;	// Index into the vertices of the meshlet
 	};
 
 	// Defines LOD groups for the geometry
@@ -50,8 +100,16 @@ namespace savage::tools {
 		u8  reverse_handedness;
 		u8  import_embeded_textures;
 		u8  import_animations;
+		u8  vertex_format;	// vertex_format::type
+		u8  lod_count;		// Simplified meshes to add to each lod group with a single mesh
 	};
 
+	// Weld the positions of every mesh, make the normals (and tangents) and then the vertices and indices,
+	// which are then ordered for the vertex cache and the vertex fetch and split into meshlets. Lod groups with a single mesh get
+	// settings.lod_count simplified meshes, each with at most half the triangles of the one before.
+	// The meshes are processed at the same time
+	void process_scene(scene& scene, const geometry_import_settings& settings);
+
 	// Define the scene data for geometry 
 	struct scene_data
 	{
@@ -60,4 +118,38 @@ namespace savage::tools {
 		geometry_import_settings	settings;
 	};
 
+	// Layout of the packed scene in scene_data::buffer. Everything is 4 byte aligned, names are padded to 4 bytes:
+	// [header][u32 name length][name]
+	// per lod group: [u32 name length][name][u32 mesh count]
+	//   per mesh: [u32 name length][name][mesh_header][vertices][indices][meshlets][meshlet vertices (u32)][meshlet triangles (3 x u8)]
+	constexpr u32 packed_scene_magic{ 0x4d475653 }; // 'SVGM'
+	constexpr u32 packed_scene_version{ 2 };
+
+	struct packed_scene_header
+	{
+		u32 magic;
+		u32 version;
+		u32 size;			// Of the whole buffer with this header
+		u32 lod_group_count;
+	};
+
+	struct packed_mesh_header
+	{
+		u32 lod_id;
+		f32 lod_threshold;
+		u32 vertex_format;	// vertex_format::type
+		u32 elements;		// elements_type::type flags
+		u32 vertex_size;
+		u32 vertex_count;
+		u32 index_size;
+		u32 index_count;
+		u32 meshlet_count;
+		u32 meshlet_vertex_count;
+		u32 meshlet_triangle_count;
+	};
+
+	// Write the processed vertices and indices of every mesh in the format of the settings into one buffer.
+	// The buffer is owned by the caller (freed with CoTaskMemFree on Windows and free() elsewhere)
+	void pack_data(scene& scene, scene_data& data);
+
 }
\ No newline at end of file
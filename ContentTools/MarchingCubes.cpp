@@ -0,0 +1,322 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "MarchingCubes.h"
+#include "Geometry.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define USE_SSE 1
+#include <xmmintrin.h>
+#else
+#define USE_SSE 0
+#endif
+
+namespace savage::tools {
+	namespace {
+
+		// Corner i of a cell is at (i & 1, (i >> 1) & 1, (i >> 2) & 1). Edges 0-3 go along x, 4-7 along y and 8-11
+		// along z. Bit 0 of an edge index is the lower of the other two axes (y, x, x) and bit 1 the higher (z, z, y)
+		u32 edge_index(u32 a, u32 b)
+		{
+			const u32 axis{ (a ^ b) == 1 ? 0u : ((a ^ b) == 2 ? 1u : 2u) };
+			const u32 corner{ std::min(a, b) };
+			const u32 x{ corner & 1 }, y{ (corner >> 1) & 1 }, z{ (corner >> 2) & 1 };
+			const u32 other[3]{ y | (z << 1), x | (z << 1), x | (y << 1) };
+			return axis * 4 + other[axis];
+		}
+
+		struct cell_case
+		{
+			u8 triangle_count;
+			u8 edges[15];
+		};
+
+		// The triangles of each of the 256 inside/outside combinations of the corners of a cell.
+		// Made from the faces of the cell instead of typing in the usual table: on each face a segment cuts off every
+		// run of inside corners, so both cells of a face always cut it the same way and the surface has no holes.
+		// The segments of all faces join into loops around the edges with a crossing, and each loop becomes a fan
+		struct case_table
+		{
+			cell_case cases[256];
+
+			case_table()
+			{
+				// Corners of each face counter clockwise seen from outside the cell
+				u32 faces[6][4];
+				for (u32 axis{ 0 }; axis < 3; ++axis)
+				{
+					const u32 u{ (axis + 1) % 3 }, v{ (axis + 2) % 3 };
+					for (u32 side{ 0 }; side < 2; ++side)
+					{
+						const u32 base{ side << axis };
+						const u32 square[4]{ base, base | (1u << u), base | (1u << u) | (1u << v), base | (1u << v) };
+						for (u32 i{ 0 }; i < 4; ++i) faces[axis * 2 + side][i] = square[side ? i : 3 - i];
+					}
+				}
+
+				for (u32 config{ 0 }; config < 256; ++config)
+				{
+					auto inside = [config](u32 corner) { return (config >> corner) & 1; };
+					u32 next[12];
+					for (auto& n : next) n = u32_invalid_id;
+					for (const auto& face : faces)
+					{
+						// From the edge going into a run of inside corners to the edge coming out of it
+						for (u32 i{ 0 }; i < 4; ++i)
+						{
+							const u32 a{ face[(i + 3) % 4] }, b{ face[i] };
+							if (inside(a) || !inside(b)) continue;
+							u32 last{ i };
+							while (inside(face[(last + 1) % 4])) last = (last + 1) % 4;
+							next[edge_index(a, b)] = edge_index(face[last], face[(last + 1) % 4]);
+						}
+					}
+
+					cell_case& c{ cases[config] };
+					c.triangle_count = 0;
+					bool visited[12]{};
+					for (u32 start{ 0 }; start < 12; ++start)
+					{
+						if (next[start] == u32_invalid_id || visited[start]) continue;
+						u32 loop[12], length{ 0 };
+						for (u32 e{ start }; !visited[e]; e = next[e])
+						{
+							visited[e] = true;
+							loop[length++] = e;
+						}
+						for (u32 i{ 1 }; i + 1 < length; ++i)
+						{
+							u8* const triangle{ &c.edges[c.triangle_count++ * 3] };
+							triangle[0] = (u8)loop[0];
+							triangle[1] = (u8)loop[i];
+							triangle[2] = (u8)loop[i + 1];
+						}
+					}
+				}
+
+				// The loops all turn the same way. Turn the triangles around if they face the inside for one corner
+				const cell_case& one{ cases[1] };
+				auto middle = [](u32 e) {
+					const u32 axis{ e / 4 }, a{ e & 1 }, b{ (e >> 1) & 1 };
+					const f32 p[3][3]{ { 0.5f, (f32)a, (f32)b }, { (f32)a, 0.5f, (f32)b }, { (f32)a, (f32)b, 0.5f } };
+					return math::v3{ p[axis][0], p[axis][1], p[axis][2] };
+				};
+				const math::v3 p0{ middle(one.edges[0]) }, p1{ middle(one.edges[1]) }, p2{ middle(one.edges[2]) };
+				const math::v3 e1{ p1.x - p0.x, p1.y - p0.y, p1.z - p0.z }, e2{ p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+				const f32 nx{ e1.y * e2.z - e1.z * e2.y }, ny{ e1.z * e2.x - e1.x * e2.z }, nz{ e1.x * e2.y - e1.y * e2.x };
+				if (nx + ny + nz < 0.f)
+				{
+					for (auto& c : cases)
+					{
+						for (u32 t{ 0 }; t < c.triangle_count; ++t) std::swap(c.edges[t * 3 + 1], c.edges[t * 3 + 2]);
+					}
+				}
+			}
+		};
+
+		const case_table& get_case_table()
+		{
+			static const case_table table{};
+			return table;
+		}
+
+		// Vertices on the top plane of a slab belong to the next slab. They are numbered in the same order the next
+		// slab makes its first plane, and marked until the offsets of the slabs are known
+		constexpr u32 next_slab_bit{ 0x80000000 };
+
+		struct slab
+		{
+			utl::vector<math::v3>	positions;
+			utl::vector<u32>		indices;
+		};
+
+		constexpr f32 balls[3][4]
+		{
+			// center, radius
+			{ -0.35f, 0.f, 0.f, 0.45f },
+			{ 0.35f, 0.1f, 0.f, 0.4f },
+			{ 0.f, 0.3f, 0.25f, 0.35f },
+		};
+
+		// 1 - sum(radius^2 / distance^2)
+		void evaluate_metaballs(const void* data, f32 x, f32 step, f32 y, f32 z, u32 count, f32* values)
+		{
+			const math::v3& size{ *(const math::v3*)data };
+			const math::v3 inv_size{ 1.f / size.x, 1.f / size.y, 1.f / size.z };
+			const f32 ny{ y * inv_size.y }, nz{ z * inv_size.z };
+#if USE_SSE
+			const __m128 offsets{ _mm_set_ps(3.f, 2.f, 1.f, 0.f) };
+			const __m128 x_step{ _mm_set1_ps(step * inv_size.x) };
+			__m128 nx{ _mm_add_ps(_mm_set1_ps(x * inv_size.x), _mm_mul_ps(offsets, x_step)) };
+			const __m128 four_steps{ _mm_mul_ps(_mm_set1_ps(4.f), x_step) };
+			for (u32 i{ 0 }; i < count; i += 4)
+			{
+				__m128 sum{ _mm_setzero_ps() };
+				for (const auto& ball : balls)
+				{
+					const __m128 dx{ _mm_sub_ps(nx, _mm_set1_ps(ball[0])) };
+					const f32 dy{ ny - ball[1] }, dz{ nz - ball[2] };
+					const __m128 d2{ _mm_add_ps(_mm_mul_ps(dx, dx), _mm_set1_ps(dy * dy + dz * dz + 1e-6f)) };
+					sum = _mm_add_ps(sum, _mm_div_ps(_mm_set1_ps(ball[3] * ball[3]), d2));
+				}
+				_mm_storeu_ps(values + i, _mm_sub_ps(_mm_set1_ps(1.f), sum));
+				nx = _mm_add_ps(nx, four_steps);
+			}
+#else
+			for (u32 i{ 0 }; i < count; ++i)
+			{
+				const f32 nx{ (x + i * step) * inv_size.x };
+				f32 sum{ 0.f };
+				for (const auto& ball : balls)
+				{
+					const f32 dx{ nx - ball[0] }, dy{ ny - ball[1] }, dz{ nz - ball[2] };
+					sum += ball[3] * ball[3] / (dx * dx + dy * dy + dz * dz + 1e-6f);
+				}
+				values[i] = 1.f - sum;
+			}
+#endif
+		}
+
+		// Polygonize the cells from plane z_begin to plane z_end
+		void march_slab(const marching_cubes_info& info, u32 z_begin, u32 z_end, slab& out)
+		{
+			const cell_case* const cases{ get_case_table().cases };
+			const u32 nx{ info.cells[0] }, ny{ info.cells[1] }, nz{ info.cells[2] };
+			const u32 row_size{ (nx + 1 + 3) & ~3u };
+			const math::v3 step{ (info.max.x - info.min.x) / nx, (info.max.y - info.min.y) / ny, (info.max.z - info.min.z) / nz };
+
+			// Two planes of values and of vertex ids on the x and y edges, one plane of ids on the z edges between them
+			utl::vector<f32> values[2]{ utl::vector<f32>(row_size * (ny + 1)), utl::vector<f32>(row_size * (ny + 1)) };
+			utl::vector<u32> x_edges[2]{ utl::vector<u32>(nx * (ny + 1)), utl::vector<u32>(nx * (ny + 1)) };
+			utl::vector<u32> y_edges[2]{ utl::vector<u32>((nx + 1) * ny), utl::vector<u32>((nx + 1) * ny) };
+			utl::vector<u32> z_edges((nx + 1) * (ny + 1));
+			u32 next_slab_count{ 0 };
+
+			auto add_vertex = [&](math::v3 p, u32 axis, f32 a, f32 b) {
+				const f32 t{ a / (a - b) };
+				(&p.x)[axis] += t * (&step.x)[axis];
+				out.positions.push_back(p);
+				return (u32)out.positions.size() - 1;
+			};
+
+			for (u32 z{ z_begin }; z <= z_end; ++z)
+			{
+				const u32 plane{ z & 1 };
+				f32* const v{ values[plane].data() };
+				const f32 pz{ info.min.z + z * step.z };
+				for (u32 y{ 0 }; y <= ny; ++y)
+				{
+					info.field.evaluate_row(info.field.data, info.min.x, step.x, info.min.y + y * step.y, pz, nx + 1, v + y * row_size);
+				}
+
+				// The x and y edges of this plane, the top plane of a slab that isn't the last is the next slab's
+				const bool next_slab{ z == z_end && z_end != nz };
+				auto edge_id = [&](math::v3 p, u32 axis, f32 a, f32 b) {
+					return next_slab ? next_slab_bit | next_slab_count++ : add_vertex(p, axis, a, b);
+				};
+				for (u32 y{ 0 }; y <= ny; ++y)
+				{
+					const f32* const row{ v + y * row_size };
+					const f32 py{ info.min.y + y * step.y };
+					for (u32 x{ 0 }; x < nx; ++x)
+					{
+						if ((row[x] < 0.f) == (row[x + 1] < 0.f)) continue;
+						x_edges[plane][y * nx + x] = edge_id({ info.min.x + x * step.x, py, pz }, 0, row[x], row[x + 1]);
+					}
+					if (y == ny) continue;
+					const f32* const next_row{ row + row_size };
+					for (u32 x{ 0 }; x <= nx; ++x)
+					{
+						if ((row[x] < 0.f) == (next_row[x] < 0.f)) continue;
+						y_edges[plane][y * (nx + 1) + x] = edge_id({ info.min.x + x * step.x, py, pz }, 1, row[x], next_row[x]);
+					}
+				}
+				if (z == z_begin) continue;
+
+				// The z edges and the cells between the last plane and this one
+				const f32* const below{ values[plane ^ 1].data() };
+				const f32 pz_below{ pz - step.z };
+				for (u32 y{ 0 }; y <= ny; ++y)
+				{
+					for (u32 x{ 0 }; x <= nx; ++x)
+					{
+						const f32 a{ below[y * row_size + x] }, b{ v[y * row_size + x] };
+						if ((a < 0.f) == (b < 0.f)) continue;
+						z_edges[y * (nx + 1) + x] = add_vertex({ info.min.x + x * step.x, info.min.y + y * step.y, pz_below }, 2, a, b);
+					}
+				}
+
+				const u32* const lower_x{ x_edges[plane ^ 1].data() }, * const upper_x{ x_edges[plane].data() };
+				const u32* const lower_y{ y_edges[plane ^ 1].data() }, * const upper_y{ y_edges[plane].data() };
+				for (u32 y{ 0 }; y < ny; ++y)
+				{
+					const f32* const b0{ below + y * row_size }, * const b1{ b0 + row_size };
+					const f32* const t0{ v + y * row_size }, * const t1{ t0 + row_size };
+					for (u32 x{ 0 }; x < nx; ++x)
+					{
+						const u32 config{ (u32)(b0[x] < 0.f) | (u32)(b0[x + 1] < 0.f) << 1 | (u32)(b1[x] < 0.f) << 2 | (u32)(b1[x + 1] < 0.f) << 3 |
+							(u32)(t0[x] < 0.f) << 4 | (u32)(t0[x + 1] < 0.f) << 5 | (u32)(t1[x] < 0.f) << 6 | (u32)(t1[x + 1] < 0.f) << 7 };
+						const cell_case& c{ cases[config] };
+						if (!c.triangle_count) continue;
+
+						const u32 ids[12]
+						{
+							lower_x[y * nx + x], lower_x[(y + 1) * nx + x], upper_x[y * nx + x], upper_x[(y + 1) * nx + x],
+							lower_y[y * (nx + 1) + x], lower_y[y * (nx + 1) + x + 1], upper_y[y * (nx + 1) + x], upper_y[y * (nx + 1) + x + 1],
+							z_edges[y * (nx + 1) + x], z_edges[y * (nx + 1) + x + 1], z_edges[(y + 1) * (nx + 1) + x], z_edges[(y + 1) * (nx + 1) + x + 1],
+						};
+						for (u32 i{ 0 }; i < c.triangle_count * 3u; ++i) out.indices.push_back(ids[c.edges[i]]);
+					}
+				}
+			}
+		}
+
+	} // Anonymous namespace
+
+	void create_marching_cubes(mesh& m, const marching_cubes_info& info)
+	{
+		assert(info.field.evaluate_row);
+		assert(info.cells[0] && info.cells[1] && info.cells[2]);
+		assert(info.max.x > info.min.x && info.max.y > info.min.y && info.max.z > info.min.z);
+
+		// A few slabs per thread so threads that finish early can help with the ones left
+		const u32 nz{ info.cells[2] };
+		const u32 slab_count{ std::min(nz, std::max(std::thread::hardware_concurrency(), 1u) * 4) };
+		utl::vector<slab> slabs(slab_count);
+		parallel_for(slab_count, 1, [&](u32 begin, u32 end) {
+			for (u32 i{ begin }; i < end; ++i) march_slab(info, nz * i / slab_count, nz * (i + 1) / slab_count, slabs[i]);
+		});
+
+		utl::vector<u32> offsets(slab_count + 1, (u32)m.positions.size());
+		for (u32 i{ 0 }; i < slab_count; ++i) offsets[i + 1] = offsets[i] + (u32)slabs[i].positions.size();
+		m.positions.resize(offsets[slab_count]);
+		size_t index_count{ m.raw_indices.size() };
+		for (const auto& s : slabs) index_count += s.indices.size();
+		const size_t first_index{ m.raw_indices.size() };
+		m.raw_indices.resize(index_count);
+
+		utl::vector<size_t> index_offsets(slab_count + 1, first_index);
+		for (u32 i{ 0 }; i < slab_count; ++i) index_offsets[i + 1] = index_offsets[i] + slabs[i].indices.size();
+		parallel_for(slab_count, 1, [&](u32 begin, u32 end) {
+			for (u32 i{ begin }; i < end; ++i)
+			{
+				std::copy(slabs[i].positions.begin(), slabs[i].positions.end(), m.positions.begin() + offsets[i]);
+				u32* const out{ m.raw_indices.data() + index_offsets[i] };
+				for (size_t k{ 0 }; k < slabs[i].indices.size(); ++k)
+				{
+					const u32 index{ slabs[i].indices[k] };
+					out[k] = index & next_slab_bit ? offsets[i + 1] + (index & ~next_slab_bit) : offsets[i] + index;
+				}
+			}
+		});
+	}
+
+	scalar_field metaball_field(const math::v3& size)
+	{
+		return { evaluate_metaballs, &size };
+	}
+}
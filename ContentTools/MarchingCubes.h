@@ -0,0 +1,39 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "ToolsCommon.h"
+
+namespace savage::tools {
+
+	struct mesh;
+
+	// A scalar field that is negative inside the surface and positive outside
+	struct scalar_field
+	{
+		// Write the values at (x + i * step, y, z) for i in [0, count) to values, which has room for count rounded up
+		// to a multiple of 4 so rows can be evaluated 4 at a time. Called from several threads at once
+		void(*evaluate_row)(const void* data, f32 x, f32 step, f32 y, f32 z, u32 count, f32* values);
+		const void* data;
+	};
+
+	struct marching_cubes_info
+	{
+		scalar_field	field;
+		math::v3		min;
+		math::v3		max;
+		u32				cells[3];	// Along x, y and z
+	};
+
+	// Make the positions and triangles of the surface where the field is 0 with marching cubes.
+	// Cells share the vertices on their edges, so every position is made once. The grid is split into slabs along z
+	// that run at the same time. Triangles face cross(p1 - p0, p2 - p0) away from the inside
+	void create_marching_cubes(mesh& m, const marching_cubes_info& info);
+
+	// Metaballs in the box from -size to size: three overlapping blobs. The field keeps a pointer to size
+	scalar_field metaball_field(const math::v3& size);
+}
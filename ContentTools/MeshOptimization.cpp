@@ -0,0 +1,172 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "MeshOptimization.h"
+#include "Geometry.h"
+
+namespace savage::tools {
+	namespace {
+
+		constexpr u32 cache_line_size{ 64 };
+		constexpr u32 fetch_cache_lines{ 256 }; // 16 KB, direct mapped
+
+		// The triangles that use each vertex, as one list per vertex
+		struct triangle_lists
+		{
+			utl::vector<u32> offsets; // Triangles of vertex v are triangles[offsets[v]] to triangles[offsets[v + 1]]
+			utl::vector<u32> triangles;
+		};
+
+		triangle_lists make_triangle_lists(const utl::vector<u32>& indices, u32 vertex_count)
+		{
+			triangle_lists lists;
+			lists.offsets.assign(vertex_count + 1, 0);
+			for (u32 index : indices) ++lists.offsets[index + 1];
+			for (u32 i{ 1 }; i <= vertex_count; ++i) lists.offsets[i] += lists.offsets[i - 1];
+
+			lists.triangles.resize(indices.size());
+			utl::vector<u32> fill(lists.offsets.begin(), lists.offsets.end() - 1);
+			for (u32 i{ 0 }; i < (u32)indices.size(); ++i)
+			{
+				lists.triangles[fill[indices[i]]++] = i / 3;
+			}
+			return lists;
+		}
+
+		// Tipsify: the next fanning vertex is the one in the cache that is oldest but will still be in it after
+		// its remaining triangles are drawn. Without one, go back to a vertex that still has triangles
+		u32 next_vertex(const utl::vector<u32>& candidates, const utl::vector<u32>& live, const utl::vector<u32>& cache_time,
+			u32 time, u32 cache_size, utl::vector<u32>& dead_ends, u32& cursor)
+		{
+			u32 best{ u32_invalid_id };
+			s32 best_priority{ -1 };
+			for (u32 v : candidates)
+			{
+				if (!live[v]) continue;
+				s32 priority{ 0 };
+				if (time - cache_time[v] + 2 * live[v] <= cache_size) priority = (s32)(time - cache_time[v]);
+				if (priority > best_priority)
+				{
+					best_priority = priority;
+					best = v;
+				}
+			}
+			if (best != u32_invalid_id) return best;
+
+			while (!dead_ends.empty())
+			{
+				const u32 v{ dead_ends.back() };
+				dead_ends.pop_back();
+				if (live[v]) return v;
+			}
+			while (cursor < live.size())
+			{
+				if (live[cursor]) return cursor;
+				++cursor;
+			}
+			return u32_invalid_id;
+		}
+
+	} // Anonymous namespace
+
+	vertex_cache_stats analyze_vertex_cache(const utl::vector<u32>& indices, u32 vertex_count, u32 vertex_size, u32 cache_size)
+	{
+		assert(cache_size && vertex_size);
+		vertex_cache_stats stats{};
+		if (indices.empty() || !vertex_count) return stats;
+
+		utl::vector<u32> cache_time(vertex_count, 0);
+		utl::vector<u64> lines(fetch_cache_lines, ~0ull);
+		u32 time{ cache_size + 1 }, transformed{ 0 };
+		u64 fetched_lines{ 0 };
+		for (u32 index : indices)
+		{
+			assert(index < vertex_count);
+			if (time - cache_time[index] <= cache_size) continue;
+			cache_time[index] = time++;
+			++transformed;
+
+			// Only transformed vertices are read from memory
+			const u64 first{ (u64)index * vertex_size / cache_line_size }, last{ ((u64)index * vertex_size + vertex_size - 1) / cache_line_size };
+			for (u64 line{ first }; line <= last; ++line)
+			{
+				u64& slot{ lines[line % fetch_cache_lines] };
+				if (slot != line)
+				{
+					slot = line;
+					++fetched_lines;
+				}
+			}
+		}
+
+		stats.acmr = (f32)transformed / (indices.size() / 3);
+		stats.atvr = (f32)transformed / vertex_count;
+		stats.overfetch = (f32)(fetched_lines * cache_line_size) / ((f32)vertex_count * vertex_size);
+		return stats;
+	}
+
+	void optimize_vertex_cache(utl::vector<u32>& indices, u32 vertex_count, u32 cache_size)
+	{
+		assert(!(indices.size() % 3) && cache_size);
+		const u32 triangle_count{ (u32)indices.size() / 3 };
+		if (!triangle_count) return;
+
+		const triangle_lists lists{ make_triangle_lists(indices, vertex_count) };
+		utl::vector<u32> live(vertex_count);
+		for (u32 v{ 0 }; v < vertex_count; ++v) live[v] = lists.offsets[v + 1] - lists.offsets[v];
+
+		utl::vector<u32> cache_time(vertex_count, 0);
+		utl::vector<u8> emitted(triangle_count, 0);
+		utl::vector<u32> dead_ends, candidates, output;
+		output.reserve(indices.size());
+		u32 time{ cache_size + 1 }, cursor{ 0 };
+
+		u32 fanning{ next_vertex(candidates, live, cache_time, time, cache_size, dead_ends, cursor) };
+		while (fanning != u32_invalid_id)
+		{
+			candidates.clear();
+			for (u32 i{ lists.offsets[fanning] }; i < lists.offsets[fanning + 1]; ++i)
+			{
+				const u32 triangle{ lists.triangles[i] };
+				if (emitted[triangle]) continue;
+				emitted[triangle] = 1;
+				for (u32 corner{ 0 }; corner < 3; ++corner)
+				{
+					const u32 v{ indices[triangle * 3 + corner] };
+					output.push_back(v);
+					dead_ends.push_back(v);
+					candidates.push_back(v);
+					--live[v];
+					if (time - cache_time[v] > cache_size) cache_time[v] = time++;
+				}
+			}
+			fanning = next_vertex(candidates, live, cache_time, time, cache_size, dead_ends, cursor);
+		}
+
+		assert(output.size() == indices.size());
+		indices.swap(output);
+	}
+
+	void optimize_vertex_fetch(mesh& m)
+	{
+		const u32 vertex_count{ (u32)m.vertices.size() };
+		utl::vector<u32> remap(vertex_count, u32_invalid_id);
+		utl::vector<vertex> vertices;
+		vertices.reserve(vertex_count);
+		for (u32& index : m.indices)
+		{
+			if (remap[index] == u32_invalid_id)
+			{
+				remap[index] = (u32)vertices.size();
+				vertices.push_back(m.vertices[index]);
+			}
+			index = remap[index];
+		}
+		// Vertices that no triangle uses are dropped
+		m.vertices.swap(vertices);
+	}
+}
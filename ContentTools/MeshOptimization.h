@@ -0,0 +1,32 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "ToolsCommon.h"
+
+namespace savage::tools {
+
+	struct mesh;
+
+	// How well an index buffer uses the post-transform vertex cache and the memory of the vertex buffer
+	struct vertex_cache_stats
+	{
+		f32 acmr{ 0.f };		// Average cache miss ratio: transformed vertices per triangle. 0.5 is best, 3 is worst
+		f32 atvr{ 0.f };		// Average transformed vertex ratio: transformed vertices per vertex. 1 is best
+		f32 overfetch{ 0.f };	// Bytes read from the vertex buffer per byte in it. 1 is best
+	};
+
+	// Simulate a FIFO vertex cache of cache_size entries and a cache of 64 byte lines for the vertex fetch
+	vertex_cache_stats analyze_vertex_cache(const utl::vector<u32>& indices, u32 vertex_count, u32 vertex_size, u32 cache_size = 16);
+
+	// Reorder the triangles so that they reuse the vertices in a cache of cache_size (Tipsify, Sander et al. 2007).
+	// Runs in linear time and does not depend on the exact cache size of the hardware
+	void optimize_vertex_cache(utl::vector<u32>& indices, u32 vertex_count, u32 cache_size = 16);
+
+	// Reorder the vertices of a processed mesh in the order the triangles first use them
+	void optimize_vertex_fetch(mesh& m);
+}
@@ -0,0 +1,395 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "MeshSimplification.h"
+#include "Geometry.h"
+#include <cmath>
+#include <cstring>
+
+namespace savage::tools {
+	namespace {
+
+		// A change of 1 in a normal or a uv costs as much as moving by a tenth of the size of the mesh
+		constexpr double attribute_weight{ 0.01 };
+		// Planes along the open border keep it in place much more than the triangles next to it
+		constexpr double border_weight{ 10.0 };
+
+		struct double3
+		{
+			double x, y, z;
+		};
+
+		double3 operator-(const double3& a, const double3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		double dot(const double3& a, const double3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+		double3 cross(const double3& a, const double3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+		// Sum of squared distances to a set of weighted planes: v'Av + 2b'v + c
+		struct quadric
+		{
+			double a00, a01, a02, a11, a12, a22;
+			double b0, b1, b2;
+			double c;
+			double weight;
+		};
+
+		void add_plane(quadric& q, const double3& n, double d, double weight)
+		{
+			q.a00 += weight * n.x * n.x; q.a01 += weight * n.x * n.y; q.a02 += weight * n.x * n.z;
+			q.a11 += weight * n.y * n.y; q.a12 += weight * n.y * n.z; q.a22 += weight * n.z * n.z;
+			q.b0 += weight * n.x * d; q.b1 += weight * n.y * d; q.b2 += weight * n.z * d;
+			q.c += weight * d * d;
+			q.weight += weight;
+		}
+
+		quadric operator+(const quadric& a, const quadric& b)
+		{
+			return { a.a00 + b.a00, a.a01 + b.a01, a.a02 + b.a02, a.a11 + b.a11, a.a12 + b.a12, a.a22 + b.a22,
+				a.b0 + b.b0, a.b1 + b.b1, a.b2 + b.b2, a.c + b.c, a.weight + b.weight };
+		}
+
+		// Mean squared distance of v to the planes
+		double error(const quadric& q, const double3& v)
+		{
+			const double e{ v.x * (q.a00 * v.x + q.a01 * v.y + q.a02 * v.z) + v.y * (q.a01 * v.x + q.a11 * v.y + q.a12 * v.z) +
+				v.z * (q.a02 * v.x + q.a12 * v.y + q.a22 * v.z) + 2.0 * (q.b0 * v.x + q.b1 * v.y + q.b2 * v.z) + q.c };
+			return fabs(e) / std::max(q.weight, 1e-20);
+		}
+
+		struct collapse
+		{
+			u32		from;	// Position
+			u32		to;
+			double	cost;
+		};
+
+		// A position next to another one and how many triangles their edge has. Border edges have one
+		struct edge
+		{
+			u32 position;
+			u32 triangle_count;
+		};
+
+		struct simplifier
+		{
+			const utl::vector<vertex>&	vertices;
+			utl::vector<u32>			indices;
+			utl::vector<u32>			position_of;		// Of each vertex
+			utl::vector<double3>		positions;			// Scaled to a mesh size of 1
+			utl::vector<quadric>		quadrics;
+			utl::vector<u32>			vertex_remap;
+			utl::vector<collapse>		best;				// Cheapest collapse of each position
+			utl::vector<u8>				changed;			// Triangles around the position changed in the last pass
+			double						scale{ 1.0 };
+
+			// Made again every pass. Triangles around p are triangles[triangle_offsets[p]] to [triangle_offsets[p + 1]],
+			// the edges of p are sorted by the other position in the same way
+			utl::vector<u32>			triangle_offsets;
+			utl::vector<u32>			triangles;
+			utl::vector<u32>			edge_offsets;
+			utl::vector<edge>			edges;
+
+			explicit simplifier(const mesh& m) : vertices{ m.vertices }, indices{ m.indices } {}
+
+			// Vertices with the same position are the sides of a seam. Processing welded the positions, so they are equal
+			void find_positions()
+			{
+				const u32 vertex_count{ (u32)vertices.size() };
+				utl::vector<u32> order(vertex_count);
+				for (u32 i{ 0 }; i < vertex_count; ++i) order[i] = i;
+				std::sort(order.begin(), order.end(), [this](u32 a, u32 b) {
+					const math::v3& pa{ vertices[a].position }, & pb{ vertices[b].position };
+					return pa.x != pb.x ? pa.x < pb.x : (pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z);
+				});
+
+				double3 min{ 1e30, 1e30, 1e30 }, max{ -1e30, -1e30, -1e30 };
+				for (const auto& v : vertices)
+				{
+					min = { std::min(min.x, (double)v.position.x), std::min(min.y, (double)v.position.y), std::min(min.z, (double)v.position.z) };
+					max = { std::max(max.x, (double)v.position.x), std::max(max.y, (double)v.position.y), std::max(max.z, (double)v.position.z) };
+				}
+				scale = std::max(std::max(max.x - min.x, max.y - min.y), std::max(max.z - min.z, 1e-20));
+
+				position_of.resize(vertex_count);
+				for (u32 i{ 0 }; i < vertex_count; ++i)
+				{
+					const math::v3& p{ vertices[order[i]].position };
+					if (!i || memcmp(&p, &vertices[order[i - 1]].position, sizeof(math::v3)))
+					{
+						positions.push_back({ (p.x - min.x) / scale, (p.y - min.y) / scale, (p.z - min.z) / scale });
+					}
+					position_of[order[i]] = (u32)positions.size() - 1;
+				}
+
+				vertex_remap.resize(vertex_count);
+				for (u32 i{ 0 }; i < vertex_count; ++i) vertex_remap[i] = i;
+				best.resize(positions.size());
+				changed.assign(positions.size(), 1);
+			}
+
+			void make_lists()
+			{
+				const u32 position_count{ (u32)positions.size() };
+				triangle_offsets.assign(position_count + 1, 0);
+				for (u32 index : indices) ++triangle_offsets[position_of[index] + 1];
+				for (u32 p{ 1 }; p <= position_count; ++p) triangle_offsets[p] += triangle_offsets[p - 1];
+				triangles.resize(indices.size());
+				utl::vector<u32> fill(triangle_offsets.begin(), triangle_offsets.end() - 1);
+				for (u32 i{ 0 }; i < (u32)indices.size(); ++i) triangles[fill[position_of[indices[i]]]++] = i / 3;
+
+				edge_offsets.resize(position_count + 1);
+				edges.clear();
+				utl::vector<u32> others;
+				for (u32 p{ 0 }; p < position_count; ++p)
+				{
+					edge_offsets[p] = (u32)edges.size();
+					others.clear();
+					for (u32 i{ triangle_offsets[p] }; i < triangle_offsets[p + 1]; ++i)
+					{
+						const u32 t{ triangles[i] };
+						for (u32 corner{ 0 }; corner < 3; ++corner)
+						{
+							const u32 q{ position_of[indices[t * 3 + corner]] };
+							if (q != p) others.push_back(q);
+						}
+					}
+					std::sort(others.begin(), others.end());
+					for (u32 i{ 0 }; i < others.size(); ++i)
+					{
+						if (i && others[i - 1] == others[i]) ++edges.back().triangle_count;
+						else edges.push_back({ others[i], 1 });
+					}
+				}
+				edge_offsets[position_count] = (u32)edges.size();
+			}
+
+			bool has_position(u32 t, u32 p) const
+			{
+				return position_of[indices[t * 3]] == p || position_of[indices[t * 3 + 1]] == p || position_of[indices[t * 3 + 2]] == p;
+			}
+
+			// Planes of the triangles weighted by area, and planes standing on the border edges
+			void make_quadrics()
+			{
+				quadrics.assign(positions.size(), quadric{});
+				auto triangle_normal = [this](u32 t, double& area) {
+					const double3& p0{ positions[position_of[indices[t * 3]]] };
+					const double3 n{ cross(positions[position_of[indices[t * 3 + 1]]] - p0, positions[position_of[indices[t * 3 + 2]]] - p0) };
+					const double length{ sqrt(dot(n, n)) };
+					area = length * 0.5;
+					return length < 1e-30 ? double3{ 0.0, 0.0, 0.0 } : double3{ n.x / length, n.y / length, n.z / length };
+				};
+
+				for (u32 t{ 0 }; t < (u32)indices.size() / 3; ++t)
+				{
+					double area;
+					const double3 n{ triangle_normal(t, area) };
+					const double d{ -dot(n, positions[position_of[indices[t * 3]]]) };
+					for (u32 corner{ 0 }; corner < 3; ++corner) add_plane(quadrics[position_of[indices[t * 3 + corner]]], n, d, area);
+				}
+
+				for (u32 p{ 0 }; p < (u32)positions.size(); ++p)
+				{
+					for (u32 e{ edge_offsets[p] }; e < edge_offsets[p + 1]; ++e)
+					{
+						if (edges[e].triangle_count != 1) continue;
+						const u32 q{ edges[e].position };
+						for (u32 i{ triangle_offsets[p] }; i < triangle_offsets[p + 1]; ++i)
+						{
+							const u32 t{ triangles[i] };
+							if (!has_position(t, q)) continue;
+							double area;
+							const double3 n{ triangle_normal(t, area) };
+							const double3 along{ positions[q] - positions[p] };
+							double3 side{ cross(along, n) };
+							const double side_length{ sqrt(dot(side, side)) };
+							if (side_length < 1e-30) break;
+							side = { side.x / side_length, side.y / side_length, side.z / side_length };
+							add_plane(quadrics[p], side, -dot(side, positions[p]), dot(along, along) * border_weight);
+							break;
+						}
+					}
+				}
+			}
+
+			// Check that from can go onto to and find where each of its vertices goes: to the vertex of the other
+			// position in the triangle they share. Returns the attribute part of the cost, or a negative value
+			double map_vertices(u32 from, u32 to, utl::vector<collapse>& mapping) const
+			{
+				mapping.clear();
+				u32 shared{ 0 };
+				for (u32 i{ triangle_offsets[from] }; i < triangle_offsets[from + 1]; ++i)
+				{
+					const u32 t{ triangles[i] };
+					u32 a{ u32_invalid_id }, b{ u32_invalid_id };
+					for (u32 corner{ 0 }; corner < 3; ++corner)
+					{
+						const u32 v{ indices[t * 3 + corner] };
+						if (position_of[v] == from) a = v;
+						else if (position_of[v] == to) b = v;
+					}
+					if (b == u32_invalid_id) continue;
+					++shared;
+					auto it{ std::find_if(mapping.begin(), mapping.end(), [a](const collapse& c) { return c.from == a; }) };
+					if (it == mapping.end()) mapping.push_back({ a, b, 0.0 });
+					else if (it->to != b) return -1.0; // The seam goes a different way
+				}
+				if (!shared || shared > 2) return -1.0;
+
+				// The two positions can only share the neighbours across the triangles of the edge, else the mesh folds
+				u32 common{ 0 };
+				for (u32 i{ edge_offsets[from] }, j{ edge_offsets[to] }; i < edge_offsets[from + 1] && j < edge_offsets[to + 1];)
+				{
+					if (edges[i].position < edges[j].position) ++i;
+					else if (edges[j].position < edges[i].position) ++j;
+					else { ++common; ++i; ++j; }
+				}
+				if (common != shared) return -1.0;
+
+				// Every vertex of from needs a place to go, and no triangle that stays may turn over
+				double cost{ 0.0 };
+				for (u32 i{ triangle_offsets[from] }; i < triangle_offsets[from + 1]; ++i)
+				{
+					const u32 t{ triangles[i] };
+					double3 before[3], after[3];
+					bool has_to{ false };
+					for (u32 corner{ 0 }; corner < 3; ++corner)
+					{
+						const u32 v{ indices[t * 3 + corner] };
+						const u32 p{ position_of[v] };
+						has_to |= p == to;
+						before[corner] = positions[p];
+						after[corner] = p == from ? positions[to] : positions[p];
+						if (p != from) continue;
+
+						auto it{ std::find_if(mapping.begin(), mapping.end(), [v](const collapse& c) { return c.from == v; }) };
+						if (it == mapping.end()) return -1.0;
+						const vertex& a{ vertices[v] }, & b{ vertices[it->to] };
+						const double dn{ (double)(a.normal.x - b.normal.x) * (a.normal.x - b.normal.x) + (double)(a.normal.y - b.normal.y) * (a.normal.y - b.normal.y) +
+							(double)(a.normal.z - b.normal.z) * (a.normal.z - b.normal.z) };
+						const double duv{ (double)(a.uv.x - b.uv.x) * (a.uv.x - b.uv.x) + (double)(a.uv.y - b.uv.y) * (a.uv.y - b.uv.y) };
+						cost = std::max(cost, (dn + duv) * attribute_weight);
+					}
+					if (has_to) continue;
+					const double3 n0{ cross(before[1] - before[0], before[2] - before[0]) };
+					const double3 n1{ cross(after[1] - after[0], after[2] - after[0]) };
+					if (dot(n0, n1) <= 1e-3 * sqrt(dot(n0, n0) * dot(n1, n1))) return -1.0;
+				}
+				return cost;
+			}
+
+			// The cheapest collapse of each position that changed in the last pass, skipping border positions unless
+			// they stay on the border. The other positions keep theirs, since nothing around them changed
+			void find_collapses(utl::vector<collapse>& collapses)
+			{
+				utl::vector<collapse> mapping, candidates;
+				for (u32 p{ 0 }; p < (u32)positions.size(); ++p)
+				{
+					if (!changed[p]) continue;
+					changed[p] = 0;
+					best[p] = { p, u32_invalid_id, 0.0 };
+
+					bool border{ false };
+					for (u32 e{ edge_offsets[p] }; e < edge_offsets[p + 1]; ++e) border |= edges[e].triangle_count == 1;
+					candidates.clear();
+					for (u32 e{ edge_offsets[p] }; e < edge_offsets[p + 1]; ++e)
+					{
+						if (border && edges[e].triangle_count != 1) continue;
+						const u32 q{ edges[e].position };
+						candidates.push_back({ p, q, error(quadrics[p] + quadrics[q], positions[q]) });
+					}
+					std::sort(candidates.begin(), candidates.end(), [](const collapse& a, const collapse& b) { return a.cost < b.cost; });
+
+					// The attribute cost only adds, so stop when the position cost alone is more than the best so far
+					for (const auto& c : candidates)
+					{
+						if (best[p].to != u32_invalid_id && c.cost >= best[p].cost) break;
+						const double attribute_cost{ map_vertices(p, c.to, mapping) };
+						if (attribute_cost < 0.0) continue;
+						if (best[p].to == u32_invalid_id || c.cost + attribute_cost < best[p].cost) best[p] = { p, c.to, c.cost + attribute_cost };
+					}
+				}
+
+				collapses.clear();
+				for (const auto& c : best)
+				{
+					if (c.to != u32_invalid_id) collapses.push_back(c);
+				}
+				std::sort(collapses.begin(), collapses.end(), [](const collapse& a, const collapse& b) { return a.cost < b.cost; });
+			}
+
+			// Collapse the cheapest edges that do not touch each other. Returns the number of collapses
+			u32 collapse_edges(const utl::vector<collapse>& collapses, u32 max_collapses, double& max_error)
+			{
+				// The triangles around from change, so it and its neighbours are locked for the rest of the pass.
+				// The neighbours of to only need a new collapse in the next pass, since the quadric of to changes
+				utl::vector<u8> locked(positions.size(), 0);
+				utl::vector<collapse> mapping;
+				// Only a part of the collapses can be made in a pass. Leave the much more expensive ones for later
+				// passes, when the cheap ones that were locked in this one have had their turn
+				const double max_cost{ collapses.empty() ? 0.0 : collapses[std::min((u32)collapses.size(), max_collapses) / 2].cost * 2.0 + 1e-12 };
+				u32 count{ 0 };
+				for (const collapse& c : collapses)
+				{
+					if (count >= max_collapses || c.cost > max_cost) break;
+					if (locked[c.from] || locked[c.to]) continue;
+					map_vertices(c.from, c.to, mapping);
+					for (const collapse& m : mapping) vertex_remap[m.from] = m.to;
+
+					for (u32 e{ edge_offsets[c.from] }; e < edge_offsets[c.from + 1]; ++e) locked[edges[e].position] = changed[edges[e].position] = 1;
+					for (u32 e{ edge_offsets[c.to] }; e < edge_offsets[c.to + 1]; ++e) changed[edges[e].position] = 1;
+					locked[c.from] = locked[c.to] = changed[c.from] = changed[c.to] = 1;
+					quadrics[c.to] = quadrics[c.to] + quadrics[c.from];
+					max_error = std::max(max_error, error(quadrics[c.to], positions[c.to]));
+					++count;
+				}
+
+				// Move the triangles to the new vertices and drop the ones that lost their area
+				u32 kept{ 0 };
+				for (u32 i{ 0 }; i < (u32)indices.size(); i += 3)
+				{
+					const u32 a{ vertex_remap[indices[i]] }, b{ vertex_remap[indices[i + 1]] }, c{ vertex_remap[indices[i + 2]] };
+					if (position_of[a] == position_of[b] || position_of[b] == position_of[c] || position_of[a] == position_of[c]) continue;
+					indices[kept] = a;
+					indices[kept + 1] = b;
+					indices[kept + 2] = c;
+					kept += 3;
+				}
+				indices.resize(kept);
+				return count;
+			}
+		};
+
+	} // Anonymous namespace
+
+	f32 simplify_mesh(const mesh& source, mesh& target, u32 target_triangles)
+	{
+		assert(!(source.indices.size() % 3));
+		simplifier s{ source };
+		double max_error{ 0.0 };
+		if (!source.vertices.empty())
+		{
+			s.find_positions();
+			s.make_lists();
+			s.make_quadrics();
+
+			// Each pass collapses a set of edges that do not share triangles, so the lists only change between passes
+			utl::vector<collapse> collapses;
+			while (s.indices.size() / 3 > target_triangles)
+			{
+				s.find_collapses(collapses);
+				// Most collapses remove two triangles
+				const u32 max_collapses{ std::max((u32)(s.indices.size() / 3 - target_triangles) / 2, 1u) };
+				if (!s.collapse_edges(collapses, max_collapses, max_error)) break;
+				s.make_lists();
+			}
+		}
+
+		target.vertices = source.vertices;
+		target.indices = std::move(s.indices);
+		return (f32)(sqrt(max_error) * s.scale);
+	}
+}
@@ -0,0 +1,22 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "ToolsCommon.h"
+
+namespace savage::tools {
+
+	struct mesh;
+
+	// Make a lower detail version of a processed mesh (vertices and indices) with at most target_triangles, by
+	// collapsing edges in the order of their quadric error (Garland and Heckbert 1997). Vertices only move onto
+	// their neighbours, so the attributes of the remaining vertices are kept. Collapses that change the open
+	// border of the mesh, tear a uv or normal seam or flip a triangle are not made. Stops early when there are no
+	// more collapses to make. Returns the largest error of a collapse: the root mean square distance of a
+	// remaining vertex to the surface it stands for
+	f32 simplify_mesh(const mesh& source, mesh& target, u32 target_triangles);
+}
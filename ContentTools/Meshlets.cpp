@@ -0,0 +1,183 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "Meshlets.h"
+#include "Geometry.h"
+#include <cmath>
+
+namespace savage::tools {
+	namespace {
+
+		constexpr u8 not_in_meshlet{ 0xff };
+		static_assert(max_meshlet_vertices < not_in_meshlet);
+
+		// Bounding sphere around the vertices and the cone around the normals of the triangles
+		void calculate_bounds(const mesh& m, meshlet& meshlet)
+		{
+			math::v3 min{ 1e30f, 1e30f, 1e30f }, max{ -1e30f, -1e30f, -1e30f };
+			for (u32 i{ 0 }; i < meshlet.vertex_count; ++i)
+			{
+				const math::v3& p{ m.vertices[m.meshlet_vertices[meshlet.vertex_offset + i]].position };
+				min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+				max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+			}
+			const math::v3 center{ (min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f };
+			f32 radius_sq{ 0.f };
+			for (u32 i{ 0 }; i < meshlet.vertex_count; ++i)
+			{
+				const math::v3& p{ m.vertices[m.meshlet_vertices[meshlet.vertex_offset + i]].position };
+				const f32 dx{ p.x - center.x }, dy{ p.y - center.y }, dz{ p.z - center.z };
+				radius_sq = std::max(radius_sq, dx * dx + dy * dy + dz * dz);
+			}
+			meshlet.center[0] = center.x;
+			meshlet.center[1] = center.y;
+			meshlet.center[2] = center.z;
+			meshlet.radius = sqrtf(radius_sq);
+
+			utl::vector<math::v3> normals;
+			math::v3 axis{ 0.f, 0.f, 0.f };
+			for (u32 i{ 0 }; i < meshlet.triangle_count; ++i)
+			{
+				const u8* const triangle{ &m.meshlet_triangles[meshlet.triangle_offset + i * 3] };
+				u32 corners[3];
+				for (u32 k{ 0 }; k < 3; ++k) corners[k] = m.meshlet_vertices[meshlet.vertex_offset + triangle[k]];
+				const math::v3& p0{ m.vertices[corners[0]].position }, & p1{ m.vertices[corners[1]].position }, & p2{ m.vertices[corners[2]].position };
+				const math::v3 e1{ p1.x - p0.x, p1.y - p0.y, p1.z - p0.z }, e2{ p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+				math::v3 n{ e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+				const f32 length{ sqrtf(n.x * n.x + n.y * n.y + n.z * n.z) };
+				if (length <= 0.f) continue;
+				n = { n.x / length, n.y / length, n.z / length };
+				normals.push_back(n);
+				axis = { axis.x + n.x, axis.y + n.y, axis.z + n.z };
+			}
+
+			const f32 axis_length{ sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z) };
+			f32 min_dot{ 1.f };
+			if (axis_length > 0.f)
+			{
+				axis = { axis.x / axis_length, axis.y / axis_length, axis.z / axis_length };
+				for (const auto& n : normals) min_dot = std::min(min_dot, n.x * axis.x + n.y * axis.y + n.z * axis.z);
+			}
+			else min_dot = -1.f;
+
+			meshlet.cone_axis[0] = axis.x;
+			meshlet.cone_axis[1] = axis.y;
+			meshlet.cone_axis[2] = axis.z;
+			// The cutoff is the sine of the angle of the widest normal, past 84 degrees the cone is of no use
+			meshlet.cone_cutoff = min_dot <= 0.1f ? 1.f : sqrtf(1.f - min_dot * min_dot);
+		}
+
+	} // Anonymous namespace
+
+	void build_meshlets(mesh& m)
+	{
+		m.meshlets.clear();
+		m.meshlet_vertices.clear();
+		m.meshlet_triangles.clear();
+		const u32 vertex_count{ (u32)m.vertices.size() };
+		const u32 triangle_count{ (u32)m.indices.size() / 3 };
+		if (!triangle_count) return;
+
+		// Triangles around each vertex
+		utl::vector<u32> offsets(vertex_count + 1, 0), triangles(m.indices.size());
+		for (u32 index : m.indices) ++offsets[index + 1];
+		for (u32 v{ 1 }; v <= vertex_count; ++v) offsets[v] += offsets[v - 1];
+		{
+			utl::vector<u32> fill(offsets.begin(), offsets.end() - 1);
+			for (u32 i{ 0 }; i < (u32)m.indices.size(); ++i) triangles[fill[m.indices[i]]++] = i / 3;
+		}
+
+		utl::vector<u8> used(triangle_count, 0);
+		utl::vector<u8> local(vertex_count, not_in_meshlet);
+		utl::vector<u32> candidates;
+		u32 cursor{ 0 };
+
+		meshlet current{};
+		math::v3 sum{ 0.f, 0.f, 0.f };
+
+		auto new_vertices = [&](u32 t) {
+			u32 count{ 0 };
+			for (u32 k{ 0 }; k < 3; ++k) count += local[m.indices[t * 3 + k]] == not_in_meshlet;
+			return count;
+		};
+
+		auto add_triangle = [&](u32 t) {
+			used[t] = 1;
+			for (u32 k{ 0 }; k < 3; ++k)
+			{
+				const u32 v{ m.indices[t * 3 + k] };
+				if (local[v] == not_in_meshlet)
+				{
+					local[v] = (u8)current.vertex_count++;
+					m.meshlet_vertices.push_back(v);
+					const math::v3& p{ m.vertices[v].position };
+					sum = { sum.x + p.x, sum.y + p.y, sum.z + p.z };
+					for (u32 i{ offsets[v] }; i < offsets[v + 1]; ++i)
+					{
+						if (!used[triangles[i]]) candidates.push_back(triangles[i]);
+					}
+				}
+				m.meshlet_triangles.push_back(local[v]);
+			}
+			++current.triangle_count;
+		};
+
+		auto finish_meshlet = [&]() {
+			for (u32 i{ 0 }; i < current.vertex_count; ++i) local[m.meshlet_vertices[current.vertex_offset + i]] = not_in_meshlet;
+			calculate_bounds(m, current);
+			m.meshlets.push_back(current);
+			current = {};
+			current.vertex_offset = (u32)m.meshlet_vertices.size();
+			current.triangle_offset = (u32)m.meshlet_triangles.size();
+			sum = { 0.f, 0.f, 0.f };
+			candidates.clear();
+		};
+
+		for (;;)
+		{
+			// Pick the next triangle: first the neighbours that fit, else the next one in index order, which the
+			// vertex cache optimization has put close by
+			u32 best{ u32_invalid_id }, best_new{ 4 };
+			f32 best_distance{ 1e30f };
+			if (current.vertex_count)
+			{
+				const f32 inv_count{ 1.f / current.vertex_count };
+				const math::v3 centroid{ sum.x * inv_count, sum.y * inv_count, sum.z * inv_count };
+				u32 kept{ 0 };
+				for (u32 t : candidates)
+				{
+					if (used[t]) continue;
+					candidates[kept++] = t;
+					const u32 added{ new_vertices(t) };
+					if (current.vertex_count + added > max_meshlet_vertices || added > best_new) continue;
+					const math::v3& p{ m.vertices[m.indices[t * 3]].position };
+					const f32 dx{ p.x - centroid.x }, dy{ p.y - centroid.y }, dz{ p.z - centroid.z };
+					const f32 distance{ dx * dx + dy * dy + dz * dz };
+					if (added < best_new || distance < best_distance)
+					{
+						best = t;
+						best_new = added;
+						best_distance = distance;
+					}
+				}
+				candidates.resize(kept);
+			}
+
+			if (best == u32_invalid_id)
+			{
+				while (cursor < triangle_count && used[cursor]) ++cursor;
+				if (cursor == triangle_count) break;
+				if (current.vertex_count + new_vertices(cursor) > max_meshlet_vertices) finish_meshlet();
+				best = cursor;
+			}
+
+			add_triangle(best);
+			if (current.triangle_count == max_meshlet_triangles) finish_meshlet();
+		}
+		if (current.triangle_count) finish_meshlet();
+	}
+}
@@ -0,0 +1,36 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "ToolsCommon.h"
+
+namespace savage::tools {
+
+	struct mesh;
+
+	constexpr u32 max_meshlet_vertices{ 64 };
+	constexpr u32 max_meshlet_triangles{ 124 };
+
+	// A small cluster of triangles that is culled as a whole. Same layout as graphics::meshlet in the engine
+	struct meshlet
+	{
+		u32 vertex_offset;		// First of its vertices in mesh::meshlet_vertices
+		u32 triangle_offset;	// First byte of its triangles in mesh::meshlet_triangles
+		u32 vertex_count;
+		u32 triangle_count;
+		f32 center[3];			// Bounding sphere
+		f32 radius;
+		f32 cone_axis[3];		// All triangles face away from a viewer where dot(normalize(center - viewer), cone_axis) >= cone_cutoff
+		f32 cone_cutoff;		// 1 when the triangles face too many ways to ever be culled
+	};
+	static_assert(sizeof(meshlet) == 48);
+
+	// Split the triangles of a processed mesh into meshlets of at most max_meshlet_vertices and max_meshlet_triangles.
+	// Meshlets grow over neighbouring triangles, preferring the ones that add the fewest vertices and are closest.
+	// Each triangle is 3 u8 indices into the vertices of its meshlet
+	void build_meshlets(mesh& m);
+}
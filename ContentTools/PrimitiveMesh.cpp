@@ -7,6 +7,8 @@ MIT License - see LICENSE file
 
 #include "PrimitiveMesh.h"
 #include "Geometry.h"
+#include "MarchingCubes.h"
+#include <cmath>
 
 namespace savage::tools {
 	namespace {
@@ -36,13 +38,400 @@ namespace savage::tools {
 
 		static_assert(_countof(creators) == primitive_mesh_type::count);
 
+		constexpr f32 pi{ 3.14159265358979f };
+		constexpr f32 two_pi{ 2.f * pi };
+		// Rows of vertices are split between threads, each thread gets at least this many vertices
+		constexpr u32 min_vertices_per_thread{ 16 * 1024 };
+
+		enum axis : u32 { x, y, z };
+
+		// Segments for the lod. Each lod has half the segments of the one before
+		u32 lod_segments(u32 segments, u32 lod, u32 min)
+		{
+			return std::max(lod < 32 ? segments >> lod : 0u, min);
+		}
+
+		// A grid of columns x rows quads that vertex() bends into a shape. The first or last row of vertices
+		// can be all at one point (like the pole of a sphere), then that row of quads is made of triangles.
+		// Triangles face the side of cross(next row - vertex, next column - vertex) unless flip_winding is set
+		struct grid
+		{
+			u32		columns;
+			u32		rows;
+			bool	collapsed_first_row{ false };
+			bool	collapsed_last_row{ false };
+			bool	flip_winding{ false };
+		};
+
+		// Add the vertices and triangles of a grid to the mesh. uvs has one uv per vertex.
+		// vertex(column, row, position, uv) is called from many threads at once
+		template<typename F>
+		void add_grid(mesh& m, utl::vector<math::v2>& uvs, const grid& g, F&& vertex)
+		{
+			assert(g.columns && g.rows);
+			assert(!(g.collapsed_first_row && g.collapsed_last_row && g.rows == 1));
+			const u32 row_length{ g.columns + 1 };
+			const u32 first_vertex{ (u32)m.positions.size() };
+			const u32 first_index{ (u32)m.raw_indices.size() };
+			const u32 full_row_triangles{ 2 * g.columns };
+			const u32 triangle_count{ g.rows * full_row_triangles - (g.collapsed_first_row ? g.columns : 0) - (g.collapsed_last_row ? g.columns : 0) };
+
+			m.positions.resize(first_vertex + (size_t)row_length * (g.rows + 1));
+			uvs.resize(m.positions.size());
+			m.raw_indices.resize(first_index + (size_t)triangle_count * 3);
+
+			const u32 rows_per_thread{ std::max(min_vertices_per_thread / row_length, 1u) };
+			parallel_for(g.rows + 1, rows_per_thread, [&](u32 begin, u32 end) {
+				for (u32 j{ begin }; j < end; ++j)
+				{
+					const u32 row_start{ first_vertex + j * row_length };
+					for (u32 i{ 0 }; i < row_length; ++i)
+					{
+						vertex(i, j, m.positions[row_start + i], uvs[row_start + i]);
+					}
+				}
+			});
+
+			parallel_for(g.rows, rows_per_thread, [&](u32 begin, u32 end) {
+				for (u32 j{ begin }; j < end; ++j)
+				{
+					// Triangles before this row. Only the first row can have less than all of them
+					const u32 skip_first{ g.collapsed_first_row && j == 0 };
+					const u32 skip_second{ g.collapsed_last_row && j == g.rows - 1 };
+					u32* index{ &m.raw_indices[first_index + 3 * (j * full_row_triangles - ((g.collapsed_first_row && j) ? g.columns : 0))] };
+
+					for (u32 i{ 0 }; i < g.columns; ++i)
+					{
+						const u32 v0{ first_vertex + j * row_length + i };
+						const u32 v1{ v0 + row_length };
+						const u32 v2{ v0 + 1 };
+						const u32 v3{ v1 + 1 };
+						// The first triangle has 2 vertices in this row, the second has 2 in the next one
+						if (!skip_first)
+						{
+							*index++ = v0;
+							*index++ = g.flip_winding ? v2 : v1;
+							*index++ = g.flip_winding ? v1 : v2;
+						}
+						if (!skip_second)
+						{
+							*index++ = v2;
+							*index++ = g.flip_winding ? v3 : v1;
+							*index++ = g.flip_winding ? v1 : v3;
+						}
+					}
+				}
+			});
+		}
+
+		// Primitives have one uv set with a uv for each index (the same vertex can have another uv in each triangle)
+		void set_uvs(mesh& m, const utl::vector<math::v2>& uvs)
+		{
+			m.uv_sets.resize(1);
+			utl::vector<math::v2>& uv_set{ m.uv_sets[0] };
+			uv_set.resize(m.raw_indices.size());
+			parallel_for((u32)m.raw_indices.size(), min_vertices_per_thread, [&](u32 begin, u32 end) {
+				for (u32 i{ begin }; i < end; ++i) uv_set[i] = uvs[m.raw_indices[i]];
+			});
+		}
+
+		void add_lod_group(scene& scene, const char* name, mesh&& m, const primitive_init_info& info)
+		{
+			m.name = name;
+			m.lod_id = info.lod;
+			lod_group lod{};
+			lod.name = name;
+			lod.meshes.emplace_back(std::move(m));
+			scene.lod_groups.emplace_back(std::move(lod));
+		}
+
+		void create_plane(scene& scene, const primitive_init_info& info)
+		{
+			const grid g{ lod_segments(info.segments[axis::x], info.lod, 1), lod_segments(info.segments[axis::z], info.lod, 1) };
+			const f32 column_step{ 1.f / g.columns }, row_step{ 1.f / g.rows };
+			const math::v3 size{ info.size };
+
+			mesh m{};
+			utl::vector<math::v2> uvs;
+			add_grid(m, uvs, g, [&](u32 i, u32 j, math::v3& position, math::v2& uv) {
+				position = { (i * column_step - 0.5f) * size.x, 0.f, (j * row_step - 0.5f) * size.z };
+				uv = { i * column_step, 1.f - j * row_step };
+			});
+			set_uvs(m, uvs);
+			add_lod_group(scene, "plane", std::move(m), info);
+		}
+
+		void create_cube(scene& scene, const primitive_init_info& info)
+		{
+			const math::v3 size{ info.size };
+			const f32 half_size[3]{ size.x * 0.5f, size.y * 0.5f, size.z * 0.5f };
+			mesh m{};
+			utl::vector<math::v2> uvs;
+
+			// Each face is a plane. Columns go along the next axis after the normal, rows along the one after that
+			for (u32 face{ 0 }; face < 6; ++face)
+			{
+				const u32 normal_axis{ face / 2 };
+				const f32 sign{ (face & 1) ? -1.f : 1.f };
+				const u32 column_axis{ (normal_axis + 1) % 3 };
+				const u32 row_axis{ (normal_axis + 2) % 3 };
+				// cross(row axis, column axis) points to -normal_axis, so flip the faces on the positive side
+				const grid g{ lod_segments(info.segments[column_axis], info.lod, 1), lod_segments(info.segments[row_axis], info.lod, 1),
+							  false, false, sign > 0.f };
+				const f32 column_step{ 1.f / g.columns }, row_step{ 1.f / g.rows };
+
+				add_grid(m, uvs, g, [&](u32 i, u32 j, math::v3& position, math::v2& uv) {
+					f32 p[3];
+					p[normal_axis] = sign * half_size[normal_axis];
+					p[column_axis] = (2.f * i * column_step - 1.f) * half_size[column_axis];
+					p[row_axis] = (2.f * j * row_step - 1.f) * half_size[row_axis];
+					position = { p[0], p[1], p[2] };
+					uv = { i * column_step, 1.f - j * row_step };
+				});
+			}
+			set_uvs(m, uvs);
+			add_lod_group(scene, "cube", std::move(m), info);
+		}
+
+		void create_uv_sphere(scene& scene, const primitive_init_info& info)
+		{
+			// Columns go around (phi), rows go from the top pole to the bottom one (theta)
+			const grid g{ lod_segments(info.segments[axis::x], info.lod, 3), lod_segments(info.segments[axis::y], info.lod, 2), true, true, true };
+			const f32 column_step{ 1.f / g.columns }, row_step{ 1.f / g.rows };
+			const math::v3 size{ info.size };
+
+			mesh m{};
+			utl::vector<math::v2> uvs;
+			add_grid(m, uvs, g, [&](u32 i, u32 j, math::v3& position, math::v2& uv) {
+				const f32 theta{ pi * j * row_step };
+				const f32 phi{ two_pi * i * column_step };
+				// Make the poles exact so they are the same point in every column
+				const f32 sin_theta{ (j == 0 || j == g.rows) ? 0.f : sinf(theta) };
+				const f32 cos_theta{ j == 0 ? 1.f : (j == g.rows ? -1.f : cosf(theta)) };
+				position = { sin_theta * cosf(phi) * size.x, cos_theta * size.y, sin_theta * sinf(phi) * size.z };
+				uv = { i * column_step, j * row_step };
+			});
+			set_uvs(m, uvs);
+			add_lod_group(scene, "uv_sphere", std::move(m), info);
+		}
+
+		void create_ico_shpere(scene& scene, const primitive_init_info& info)
+		{
+			constexpr f32 t{ 1.61803399f }; // Golden ratio
+			const math::v3 corners[12]
+			{
+				{ -1.f, t, 0.f }, { 1.f, t, 0.f }, { -1.f, -t, 0.f }, { 1.f, -t, 0.f },
+				{ 0.f, -1.f, t }, { 0.f, 1.f, t }, { 0.f, -1.f, -t }, { 0.f, 1.f, -t },
+				{ t, 0.f, -1.f }, { t, 0.f, 1.f }, { -t, 0.f, -1.f }, { -t, 0.f, 1.f },
+			};
+			u32 faces[20][3]
+			{
+				{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+				{ 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+				{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+				{ 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 },
+			};
+
+			// Make every face point out: cross(b - a, c - a) has to point away from the center
+			for (auto& f : faces)
+			{
+				const math::v3& a{ corners[f[0]] }, & b{ corners[f[1]] }, & c{ corners[f[2]] };
+				const f32 e1[3]{ b.x - a.x, b.y - a.y, b.z - a.z }, e2[3]{ c.x - a.x, c.y - a.y, c.z - a.z };
+				const f32 n[3]{ e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				if (n[0] * (a.x + b.x + c.x) + n[1] * (a.y + b.y + c.y) + n[2] * (a.z + b.z + c.z) < 0.f) std::swap(f[1], f[2]);
+			}
+
+			// Each face is split into a triangle grid with frequency steps along each edge.
+			// Row r of a face (r steps from corner a towards b) has frequency + 1 - r vertices
+			const u32 frequency{ lod_segments(info.segments[axis::x], info.lod, 1) };
+			const u32 face_vertices{ (frequency + 1) * (frequency + 2) / 2 };
+			const u32 face_triangles{ frequency * frequency };
+			const math::v3 size{ info.size };
+
+			mesh m{};
+			m.positions.resize((size_t)face_vertices * 20);
+			m.raw_indices.resize((size_t)face_triangles * 20 * 3);
+
+			auto row_start = [frequency](u32 r) { return r * (frequency + 1) - r * (r - 1) / 2; };
+			const u32 rows_per_thread{ std::max(min_vertices_per_thread / (frequency + 1), 1u) };
+			parallel_for(20 * frequency + 20, rows_per_thread, [&](u32 begin, u32 end) {
+				for (u32 row{ begin }; row < end; ++row)
+				{
+					const u32 face{ row / (frequency + 1) }, r{ row % (frequency + 1) };
+					const math::v3& a{ corners[faces[face][0]] }, & b{ corners[faces[face][1]] }, & c{ corners[faces[face][2]] };
+					math::v3* const out{ &m.positions[face * face_vertices + row_start(r)] };
+					for (u32 k{ 0 }; k <= frequency - r; ++k)
+					{
+						// Point on the flat face, then pushed out onto the sphere
+						const f32 u{ (f32)r / frequency }, v{ (f32)k / frequency };
+						const f32 p[3]{ a.x + (b.x - a.x) * u + (c.x - a.x) * v, a.y + (b.y - a.y) * u + (c.y - a.y) * v, a.z + (b.z - a.z) * u + (c.z - a.z) * v };
+						const f32 inv_length{ 1.f / sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]) };
+						out[k] = { p[0] * inv_length * size.x, p[1] * inv_length * size.y, p[2] * inv_length * size.z };
+					}
+				}
+			});
+
+			// Triangles between row r and r + 1 keep the (a, b, c) order of the face
+			parallel_for(20 * frequency, rows_per_thread, [&](u32 begin, u32 end) {
+				for (u32 row{ begin }; row < end; ++row)
+				{
+					const u32 face{ row / frequency }, r{ row % frequency };
+					const u32 base{ face * face_vertices };
+					const u32 this_row{ base + row_start(r) }, next_row{ base + row_start(r + 1) };
+					u32* index{ &m.raw_indices[3 * ((size_t)face * face_triangles + r * (2 * frequency - r))] };
+					for (u32 k{ 0 }; k < frequency - r; ++k)
+					{
+						*index++ = this_row + k;
+						*index++ = next_row + k;
+						*index++ = this_row + k + 1;
+						if (k + 1 < frequency - r)
+						{
+							*index++ = this_row + k + 1;
+							*index++ = next_row + k;
+							*index++ = next_row + k + 1;
+						}
+					}
+				}
+			});
+
+			// Spherical uvs. A triangle that crosses the seam gets u > 1 so it does not stretch over the whole texture
+			utl::vector<math::v2> uvs(m.positions.size());
+			parallel_for((u32)m.positions.size(), min_vertices_per_thread, [&](u32 begin, u32 end) {
+				for (u32 i{ begin }; i < end; ++i)
+				{
+					const math::v3& p{ m.positions[i] };
+					const f32 px{ p.x / size.x }, py{ p.y / size.y }, pz{ p.z / size.z };
+					uvs[i] = { atan2f(pz, px) / two_pi + 0.5f, acosf(std::clamp(py, -1.f, 1.f)) / pi };
+				}
+			});
+			set_uvs(m, uvs);
+			utl::vector<math::v2>& uv_set{ m.uv_sets[0] };
+			parallel_for((u32)m.raw_indices.size() / 3, min_vertices_per_thread / 3, [&](u32 begin, u32 end) {
+				for (u32 triangle{ begin }; triangle < end; ++triangle)
+				{
+					math::v2* const uv{ &uv_set[triangle * 3] };
+					const f32 max_u{ std::max(std::max(uv[0].x, uv[1].x), uv[2].x) };
+					for (u32 k{ 0 }; k < 3; ++k)
+					{
+						if (max_u - uv[k].x > 0.5f) uv[k].x += 1.f;
+					}
+				}
+			});
+			add_lod_group(scene, "ico_sphere", std::move(m), info);
+		}
+
+		// Add the cap of a cylinder at height y. It faces up when top is set
+		void add_disk(mesh& m, utl::vector<math::v2>& uvs, u32 columns, f32 y, const math::v3& size, bool top)
+		{
+			const f32 column_step{ 1.f / columns };
+			// Rows go from the center out, so cross(row, column) points down
+			add_grid(m, uvs, { columns, 1, true, false, top }, [&](u32 i, u32 j, math::v3& position, math::v2& uv) {
+				const f32 phi{ two_pi * i * column_step };
+				const f32 c{ j ? cosf(phi) : 0.f }, s{ j ? sinf(phi) : 0.f };
+				position = { c * size.x, y, s * size.z };
+				uv = { 0.5f + 0.5f * c, 0.5f + (top ? -0.5f : 0.5f) * s };
+			});
+		}
+
+		void create_cylender(scene& scene, const primitive_init_info& info)
+		{
+			const grid g{ lod_segments(info.segments[axis::x], info.lod, 3), lod_segments(info.segments[axis::y], info.lod, 1), false, false, true };
+			const f32 column_step{ 1.f / g.columns }, row_step{ 1.f / g.rows };
+			const math::v3 size{ info.size };
+
+			mesh m{};
+			utl::vector<math::v2> uvs;
+			// Rows go from the top down
+			add_grid(m, uvs, g, [&](u32 i, u32 j, math::v3& position, math::v2& uv) {
+				const f32 phi{ two_pi * i * column_step };
+				position = { cosf(phi) * size.x, (0.5f - j * row_step) * size.y, sinf(phi) * size.z };
+				uv = { i * column_step, j * row_step };
+			});
+			add_disk(m, uvs, g.columns, 0.5f * size.y, size, true);
+			add_disk(m, uvs, g.columns, -0.5f * size.y, size, false);
+			set_uvs(m, uvs);
+			add_lod_group(scene, "cylinder", std::move(m), info);
+		}
+
+		void create_capsule(scene& scene, const primitive_init_info& info)
+		{
+			// One grid from the top pole to the bottom one: rings of the top half sphere, the body, then the bottom half sphere
+			const u32 columns{ lod_segments(info.segments[axis::x], info.lod, 3) };
+			const u32 rings{ lod_segments(info.segments[axis::y], info.lod, 1) };
+			const u32 body_rows{ lod_segments(info.segments[axis::z], info.lod, 1) };
+			const grid g{ columns, 2 * rings + body_rows, true, true, true };
+			const f32 column_step{ 1.f / g.columns };
+			const math::v3 size{ info.size };
+			// The half spheres are as high as the smaller radius but the capsule can not be shorter than them
+			const f32 radius_y{ std::min(std::min(size.x, size.z), size.y * 0.5f) };
+			const f32 half_body{ size.y * 0.5f - radius_y };
+
+			mesh m{};
+			utl::vector<math::v2> uvs;
+			add_grid(m, uvs, g, [&](u32 i, u32 j, math::v3& position, math::v2& uv) {
+				f32 ring_scale, y;
+				if (j <= rings)
+				{
+					const f32 theta{ 0.5f * pi * j / rings };
+					ring_scale = j ? sinf(theta) : 0.f;
+					y = half_body + (j ? cosf(theta) : 1.f) * radius_y;
+				}
+				else if (j < rings + body_rows)
+				{
+					ring_scale = 1.f;
+					y = half_body - 2.f * half_body * (j - rings) / body_rows;
+				}
+				else
+				{
+					const u32 k{ j - rings - body_rows };
+					const f32 theta{ 0.5f * pi * k / rings };
+					ring_scale = k == rings ? 0.f : cosf(theta);
+					y = -half_body - (k == rings ? 1.f : sinf(theta)) * radius_y;
+				}
+				const f32 phi{ two_pi * i * column_step };
+				position = { ring_scale * cosf(phi) * size.x, y, ring_scale * sinf(phi) * size.z };
+				uv = { i * column_step, 0.5f - y / size.y };
+			});
+			set_uvs(m, uvs);
+			add_lod_group(scene, "capsule", std::move(m), info);
+		}
+
+		void create_marching_cube(scene& scene, const primitive_init_info& info)
+		{
+			// Metaballs in a box of segments cells on each side, with uvs projected from the top
+			const math::v3 size{ info.size };
+			marching_cubes_info mc{};
+			mc.field = metaball_field(info.size);
+			mc.min = { -size.x, -size.y, -size.z };
+			mc.max = size;
+			for (u32 i{ 0 }; i < 3; ++i) mc.cells[i] = lod_segments(info.segments[i], info.lod, 1);
+
+			mesh m{};
+			create_marching_cubes(m, mc);
+			utl::vector<math::v2> uvs(m.positions.size());
+			parallel_for((u32)uvs.size(), min_vertices_per_thread, [&](u32 begin, u32 end) {
+				for (u32 i{ begin }; i < end; ++i) uvs[i] = { 0.5f + 0.5f * m.positions[i].x / size.x, 0.5f - 0.5f * m.positions[i].z / size.z };
+			});
+			set_uvs(m, uvs);
+			add_lod_group(scene, "marching_cube", std::move(m), info);
+		}
+
 	} // Anonymous namespace
 
+	void create_primitive_mesh(scene& scene, const primitive_init_info& info)
+	{
+		assert(info.type < primitive_mesh_type::count);
+		creators[info.type](scene, info);
+	}
+
 	// DLL function to create a primitive mesh
 	EDITOR_INTERFACE void CreatePrimitiveMesh(scene_data* data, primitive_init_info* info)
 	{
 		assert(data && info);
 		assert(info->type < primitive_mesh_type::count);
 		scene scene{};
+		create_primitive_mesh(scene, *info);
+		process_scene(scene, data->settings);
+		pack_data(scene, *data);
 	}
-}
\ No newline at end of file
+}
@@ -24,6 +24,14 @@ namespace savage::tools {
 	};
 
 	// Define the initial values of a procedural mesh
+	// plane:		segments along x and z, size of the plane in x and z
+	// cube:		segments along x, y and z, size of the cube
+	// uv_sphere:	segments around (min 3) and from pole to pole (min 2), size is the radius on each axis
+	// ico_sphere:	segments[0] splits each edge of the icosahedron, size is the radius on each axis
+	// cylinder:	segments around (min 3) and along the height, size is the radius in x and z and the height in y
+	// capsule:		segments around (min 3), rings in each half sphere and along the body, same size as a cylinder
+	// marching_cube:	metaballs in a grid of segments cells along x, y and z, size is half the box on each axis
+	// Each lod halves the segments (down to the minimum)
 	struct primitive_init_info
 	{
 		primitive_mesh_type type;
@@ -31,4 +39,8 @@ namespace savage::tools {
 		math::v3			size{ 1, 1,1 };
 		u32					lod{ 0 };
 	};
+
+	struct scene;
+	// Add a lod group with the primitive mesh to the scene
+	void create_primitive_mesh(scene& scene, const primitive_init_info& info);
 }
@@ -7,8 +7,41 @@ MIT License - see LICENSE file
 
 #pragma once
 #include "CommonHeaders.h"
+#include <algorithm>
+#include <string>
+#include <thread>
 
 // Keep declarations consistent and avoid name mangling by the compiler
 #ifndef  EDITOR_INTERFACE
+#ifdef _MSC_VER
 #define EDITOR_INTERFACE extern "C" __declspec(dllexport)
+#else
+#define EDITOR_INTERFACE extern "C" __attribute__((visibility("default")))
+#endif // _MSC_VER
 #endif // ! EDITOR_INTERFACE
+
+namespace savage::tools {
+
+	// Call func(begin, end) on ranges of [0, count) on all cores. Each thread gets at least min_per_thread
+	// items so small jobs stay on this thread. func has to be safe to call at the same time
+	template<typename F>
+	void parallel_for(u32 count, u32 min_per_thread, F&& func)
+	{
+		const u32 max_threads{ std::max(std::thread::hardware_concurrency(), 1u) };
+		const u32 thread_count{ std::min(max_threads, std::max(count / std::max(min_per_thread, 1u), 1u)) };
+		if (thread_count <= 1)
+		{
+			if (count) func(0u, count);
+			return;
+		}
+
+		const u32 per_thread{ (count + thread_count - 1) / thread_count };
+		utl::vector<std::thread> threads;
+		for (u32 begin{ per_thread }; begin < count; begin += per_thread)
+		{
+			threads.emplace_back([&func, begin, end{ std::min(begin + per_thread, count) }]() { func(begin, end); });
+		}
+		func(0u, per_thread);
+		for (auto& thread : threads) thread.join();
+	}
+}
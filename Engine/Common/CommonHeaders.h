@@ -7,7 +7,9 @@ MIT License - see LICENSE file
 
 #pragma once
 
+#ifdef _MSC_VER
 #pragma warning(disable: 4530) // Disable exception warning
+#endif
 
 // C/C++
 #include <stdint.h>
@@ -21,11 +23,15 @@ MIT License - see LICENSE file
 #endif
 
 // common headers
-#include "..\Utilities\Utilities.h"
-#include "..\Utilities\MathTypes.h"
+#include "../Utilities/Utilities.h"
+#include "../Utilities/MathTypes.h"
 #include "PrimitiveTypes.h"
 #include "ID.h"
 
+#ifndef _countof
+#define _countof(a) (sizeof(a) / sizeof(a[0])) // MSVC has this built in
+#endif
+
 #ifdef _DEBUG
 #define DEBUG_OP(x) x
 #else
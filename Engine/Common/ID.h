@@ -69,6 +69,14 @@ namespace savage::id {
 		return index(id) | (generation << detail::index_bits);
 	}
 
+	// Check if a new generation can still be made at the index of the ID. A slot that ran out of generations
+	// must not be reused: its next ID would match an old one, so stale IDs would come back to life
+	constexpr bool
+	has_next_generation(id_type id)
+	{
+		return id::generation(id) + 1 < detail::generation_mask;
+	}
+
 	// Differentiates between debug build and release build to force id type
 #if _DEBUG
 	namespace detail {
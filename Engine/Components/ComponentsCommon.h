@@ -6,6 +6,6 @@ MIT License - see LICENSE file
 */
 
 #pragma once
-#include "..\Common\CommonHeaders.h"
-#include "..\Common\ID.h"
-#include "..\EngineAPI\GameEntity.h"
\ No newline at end of file
+#include "../Common/CommonHeaders.h"
+#include "../Common/ID.h"
+#include "../EngineAPI/GameEntity.h"
\ No newline at end of file
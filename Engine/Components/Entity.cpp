@@ -8,6 +8,7 @@ MIT License - see LICENSE file
 #include "Entity.h"
 #include "Transform.h"
 #include "Script.h"
+#include "../Utilities/IOStream.h"
 
 namespace savage::game_entity {
 
@@ -22,6 +23,12 @@ namespace savage::game_entity {
 		// Get free unused IDs
 		utl::deque<entity_id>				free_ids;
 
+		// Rebuild the full ID of the entity living at the index
+		entity_id id_from_index(id::id_type index)
+		{
+			return entity_id{ index | ((id::id_type)generations[index] << id::detail::index_bits) };
+		}
+
 	} // Anonymous namespace
 
 	// Create game entity and get its index
@@ -89,8 +96,8 @@ namespace savage::game_entity {
 
 		transform::remove(transforms[index]); // Remove the transform
 		transforms[index] = {};
-		free_ids.push_back(id); // Free the spot in the array
-		
+		// Free the spot in the array unless it ran out of generations, then it is never used again
+		if (id::has_next_generation(id)) free_ids.push_back(id);
 	}
 
 	// Check if entity has same generation as spot
@@ -102,6 +109,110 @@ namespace savage::game_entity {
 		return (generations[index] == id::generation(id) && transforms[index].is_valid()); // Return if they are the same generation otherwise it is not "alive"
 	}
 
+	void save_state(utl::vector<u8>& buffer)
+	{
+		utl::blob_stream_writer blob{ buffer };
+		const u32 count{ (u32)generations.size() };
+		blob.write(count);
+		blob.write(generations.data(), count * sizeof(id::generation_type));
+
+		// Transforms live at the index of their entity, so one byte per slot is enough to know which entities are alive
+		const size_t alive_offset{ blob.offset() };
+		buffer.resize(alive_offset + count);
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			buffer[alive_offset + i] = transforms[i].is_valid() ? 1 : 0;
+		}
+
+		// Write the free list in order so IDs are reused the same way after a restore
+		blob.write((u32)free_ids.size());
+		for (const entity_id id : free_ids)
+		{
+			blob.write((id::id_type)id);
+		}
+
+		// Write the scripts. The count is patched once we know it
+		const size_t script_count_offset{ blob.offset() };
+		u32 script_count{ 0 };
+		blob.write(script_count);
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			if (!scripts[i].is_valid()) continue;
+			blob.write(i);
+			script::serialize(scripts[i], buffer);
+			++script_count;
+		}
+		blob.write_at(script_count_offset, script_count);
+	}
+
+	bool check_state(utl::blob_stream_reader& blob, u32 transform_count)
+	{
+		if (blob.remaining() < sizeof(u32)) return false;
+		const u32 count{ blob.read<u32>() };
+		if (count != transform_count) return false;
+		if ((u64)count * (sizeof(id::generation_type) + 1) + sizeof(u32) > blob.remaining()) return false;
+		blob.skip(count * sizeof(id::generation_type));
+		const u8* const alive{ blob.position() };
+		blob.skip(count);
+
+		const u32 free_count{ blob.read<u32>() };
+		if ((u64)free_count * sizeof(id::id_type) + sizeof(u32) > blob.remaining()) return false;
+		for (u32 i{ 0 }; i < free_count; ++i)
+		{
+			if (id::index(entity_id{ blob.read<id::id_type>() }) >= count) return false;
+		}
+
+		// Scripts are written in entity order, so an entity can't have more than one
+		const u32 script_count{ blob.read<u32>() };
+		u64 next_index{ 0 };
+		for (u32 i{ 0 }; i < script_count; ++i)
+		{
+			if (blob.remaining() < sizeof(u32)) return false;
+			const u32 index{ blob.read<u32>() };
+			if (index < next_index || index >= count || !alive[index] || !script::check_serialized(blob)) return false;
+			next_index = (u64)index + 1;
+		}
+		return true;
+	}
+
+	void load_state(utl::blob_stream_reader& blob)
+	{
+		// Remove the scripts of the current world. They are re-created from the saved data below
+		for (auto& c : scripts)
+		{
+			if (!c.is_valid()) continue;
+			script::remove(c);
+			c = {};
+		}
+
+		const u32 count{ blob.read<u32>() };
+		generations.resize(count);
+		blob.read(generations.data(), count * sizeof(id::generation_type));
+
+		// NOTE: resize() only allocates when the world grew since the last restore
+		transforms.resize(count);
+		scripts.resize(count);
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			transforms[i] = blob.read<u8>() ? transform::component{ transform::transform_id{ i } } : transform::component{};
+		}
+
+		free_ids.clear();
+		const u32 free_count{ blob.read<u32>() };
+		for (u32 i{ 0 }; i < free_count; ++i)
+		{
+			free_ids.push_back(entity_id{ blob.read<id::id_type>() });
+		}
+
+		const u32 script_count{ blob.read<u32>() };
+		for (u32 i{ 0 }; i < script_count; ++i)
+		{
+			const id::id_type index{ blob.read<u32>() };
+			assert(index < count && transforms[index].is_valid());
+			scripts[index] = script::deserialize(blob, entity{ id_from_index(index) });
+		}
+	}
+
 	transform::component entity::transform() const
 	{
 		assert(is_alive(_id));
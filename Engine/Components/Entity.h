@@ -18,6 +18,8 @@ namespace savage {
 
 #undef INIT_INFO
 
+	namespace utl { class blob_stream_reader; }
+
 	namespace game_entity {
 		// Initialization information
 		struct entity_info
@@ -32,5 +34,14 @@ namespace savage {
 		void remove(entity_id id);
 		// Check if entity has same generation as spot
 		bool is_alive(entity_id id);
+
+		// Append the generations, free list and scripts to the buffer (used by world snapshots)
+		void save_state(utl::vector<u8>& buffer);
+		// Move past data written by save_state() without changing anything. Returns false if it is cut short,
+		// refers to entities that don't exist or doesn't have transform_count entities (one transform per entity slot)
+		bool check_state(utl::blob_stream_reader& blob, u32 transform_count);
+		// Replace all entities with data written by save_state()
+		// NOTE: The transform state has to be loaded first as scripts may read it when they are created
+		void load_state(utl::blob_stream_reader& blob);
 	}
 }
\ No newline at end of file
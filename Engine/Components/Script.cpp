@@ -7,17 +7,26 @@ MIT License - see LICENSE file
 
 #include "Script.h"
 #include "Entity.h"
+#include "../Utilities/IOStream.h"
 
 namespace savage::script
 {
 	namespace {
 
 		utl::vector<detail::script_ptr>		entity_scripts;
+		// Creator and entity of each script instance (same order as entity_scripts)
+		// NOTE: The instance can be null while game code is being reloaded or if its class was removed
+		utl::vector<detail::script_creator>	script_creators;
+		utl::vector<game_entity::entity_id>	script_entities;
 		utl::vector<id::id_type>			id_mapping;
 
 		utl::vector<id::generation_type>	generations;
 		utl::deque<script_id>				free_ids;
 
+		// Lookups of the loaded game code, nullptr if there is none (see set_module_lookups())
+		module_tag_lookup					module_tag_of{ nullptr };
+		module_creator_lookup				module_creator_of{ nullptr };
+
 		using script_registry = std::unordered_map<size_t, detail::script_creator>;
 
 		script_registry& registry() 
@@ -47,8 +56,21 @@ namespace savage::script
 			const id::id_type index{ id::index(id) }; // Get ID index
 			assert(index < generations.size() && id_mapping[index] < entity_scripts.size());
 			assert(generations[index] == id::generation(id));
-			// Return if it is the same generation and the index of the script is not null
-			return (generations[index] == id::generation(id)) && entity_scripts[id_mapping[index]] && entity_scripts[id_mapping[index]] -> is_valid();
+			// Return if it is the same generation and the script is valid
+			// NOTE: A null instance is a script whose game code is being reloaded or was removed, it still exists
+			const detail::script_ptr& ptr{ entity_scripts[id_mapping[index]] };
+			return (generations[index] == id::generation(id)) && (!ptr || ptr->is_valid());
+		}
+
+		// Find the registered tag of a script creator. Returns 0 if the creator is not in this module's registry
+		// NOTE: This is a linear search, but there are only as many entries as there are script classes
+		size_t find_tag(detail::script_creator creator)
+		{
+			for (const auto& pair : registry())
+			{
+				if (pair.second == creator) return pair.first;
+			}
+			return 0;
 		}
 	} // anonymous namespace
 
@@ -65,10 +87,9 @@ namespace savage::script
 
 		script_creator get_script_creator(size_t tag)
 		{
-			// Lookup the script creator using its tag
+			// Lookup the script creator using its tag. Returns nullptr if there is no script with that tag
 			auto script = savage::script::registry().find(tag);
-			assert(script != savage::script::registry().end() && script->first == tag);
-			return script->second;
+			return script != savage::script::registry().end() ? script->second : nullptr;
 		}
 		
 #ifdef USE_WITH_EDITOR
@@ -90,7 +111,7 @@ namespace savage::script
 		if (free_ids.size() > id::min_deleted_elements)
 		{
 			id = free_ids.front(); // Find first free slot
-			assert(!exists(id)); //Assert that id does not exist
+			assert(id_mapping[id::index(id)] == id::invalid_id); // The slot can't have a script
 			free_ids.pop_front(); // Remove it form the free ids as it being used
 			// Increase the generation of the slot
 			id = script_id{ id::new_generation(id) }; 
@@ -108,6 +129,8 @@ namespace savage::script
 		assert(id::is_valid(id));
 		const id::id_type index{ (id::id_type)entity_scripts.size() };
 		entity_scripts.emplace_back(info.script_creator(entity)); // Add instance to end of entity scripts
+		script_creators.emplace_back(info.script_creator);
+		script_entities.emplace_back(entity.get_id());
 		assert(entity_scripts.back()->get_id() == entity.get_id()); // Id of script class and entity should be the same
 		// Get location of where the entity script was added
 		id_mapping[id::index(id)] = index;
@@ -120,10 +143,65 @@ namespace savage::script
 		assert(c.is_valid() && exists(c.get_id())); // Can't remove a dead object
 		const script_id id{ c.get_id() };
 		const id::id_type index{ id_mapping[id::index(id)] };
-		const script_id last_id{ entity_scripts.back()->script().get_id() }; // Get the id of the script at the end of the list
+		const script_id last_id{ game_entity::entity{ script_entities.back() }.script().get_id() }; // Get the id of the script at the end of the list
 		utl::erase_unordered(entity_scripts, index); // Remove the object in question
+		utl::erase_unordered(script_creators, index);
+		utl::erase_unordered(script_entities, index);
 		id_mapping[id::index(last_id)] = index; // Reference the moved object to its old ID
 		id_mapping[id::index(id)] = id::invalid_id; // Set the removed component to an invalid ID
+		if (id::has_next_generation(id)) free_ids.push_back(id); // Reuse the slot (see game_entity::remove())
+	}
+
+	void serialize(component c, utl::vector<u8>& buffer)
+	{
+		assert(c.is_valid() && exists(c.get_id()));
+		const id::id_type index{ id_mapping[id::index(c.get_id())] };
+		utl::blob_stream_writer blob{ buffer };
+
+		// Only the tag is written, creators are code addresses that don't stay valid after a reload or a restart.
+		// 0 if neither the registry nor the game code knows the script, it is not made again then
+		const detail::script_creator creator{ script_creators[index] };
+		size_t tag{ find_tag(creator) };
+		if (!tag && creator && module_tag_of) tag = module_tag_of(creator);
+		blob.write(tag);
+
+		// Reserve the size then let the script write its state (if it has any)
+		const size_t size_offset{ blob.offset() };
+		blob.write(u32{ 0 });
+		if (entity_scripts[index]) entity_scripts[index]->serialize(buffer);
+		blob.write_at(size_offset, (u32)(blob.offset() - size_offset - sizeof(u32)));
+	}
+
+	bool check_serialized(utl::blob_stream_reader& blob)
+	{
+		if (blob.remaining() < sizeof(size_t) + sizeof(u32)) return false;
+		blob.skip(sizeof(size_t));
+		const u32 size{ blob.read<u32>() };
+		if (size > blob.remaining()) return false;
+		blob.skip(size);
+		return true;
+	}
+
+	component deserialize(utl::blob_stream_reader& blob, game_entity::entity entity)
+	{
+		const size_t tag{ blob.read<size_t>() };
+		const u32 size{ blob.read<u32>() };
+
+		detail::script_creator creator{ tag ? detail::get_script_creator(tag) : nullptr };
+		if (!creator && tag && module_creator_of) creator = module_creator_of(tag);
+
+		// The script had no instance when it was saved or its class is no longer in the registry or the game code
+		if (!creator)
+		{
+			blob.skip(size);
+			return {};
+		}
+
+		// Create the script then give it back its state
+		const component c{ create(init_info{ creator }, entity) };
+		entity_scripts[id_mapping[id::index(c.get_id())]]->deserialize(blob.position(), size);
+		blob.skip(size);
+		return c;
 	}
 
 	void update(float dt)
@@ -131,9 +209,78 @@ namespace savage::script
 		// Goes through all scripts and calls the update function
 		for (auto& ptr : entity_scripts)
 		{
-			ptr->update(dt);
+			if (ptr) ptr->update(dt);
 		}
 	}
+
+	u32 unload_module_scripts(module_tag_lookup tag_of, utl::vector<u8>& saved)
+	{
+		assert(tag_of);
+		utl::blob_stream_writer blob{ saved };
+		const size_t count_offset{ blob.offset() };
+		u32 count{ 0 };
+		blob.write(count);
+
+		for (u32 index{ 0 }; index < (u32)entity_scripts.size(); ++index)
+		{
+			if (!entity_scripts[index]) continue;
+			const size_t tag{ tag_of(script_creators[index]) };
+			if (!tag) continue;
+
+			// [slot][tag][size][state]
+			blob.write(index);
+			blob.write(tag);
+			const size_t size_offset{ blob.offset() };
+			blob.write(u32{ 0 });
+			entity_scripts[index]->serialize(saved);
+			blob.write_at(size_offset, (u32)(blob.offset() - size_offset - sizeof(u32)));
+
+			// The code of the instance goes away with the module so it has to be destroyed now
+			entity_scripts[index].reset();
+			script_creators[index] = nullptr;
+			++count;
+		}
+
+		blob.write_at(count_offset, count);
+		return count;
+	}
+
+	u32 reload_module_scripts(module_creator_lookup creator_of, const utl::vector<u8>& saved)
+	{
+		assert(creator_of);
+		utl::blob_stream_reader blob{ saved.data(), saved.size() };
+		const u32 count{ blob.read<u32>() };
+		u32 reloaded{ 0 };
+
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			// No scripts can be added or removed between unloading and reloading, so the slot is still the same
+			const u32 index{ blob.read<u32>() };
+			const size_t tag{ blob.read<size_t>() };
+			const u32 size{ blob.read<u32>() };
+			assert(index < entity_scripts.size() && !entity_scripts[index]);
+
+			const detail::script_creator creator{ creator_of(tag) };
+			if (creator)
+			{
+				entity_scripts[index] = creator(game_entity::entity{ script_entities[index] });
+				script_creators[index] = creator;
+				entity_scripts[index]->deserialize(blob.position(), size);
+				++reloaded;
+			}
+			blob.skip(size);
+		}
+
+		assert(blob.position() == saved.data() + saved.size());
+		return reloaded;
+	}
+
+	void set_module_lookups(module_tag_lookup tag_of, module_creator_lookup creator_of)
+	{
+		assert(!tag_of == !creator_of);
+		module_tag_of = tag_of;
+		module_creator_of = creator_of;
+	}
 }
 
 #ifdef USE_WITH_EDITOR
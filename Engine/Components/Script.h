@@ -9,6 +9,8 @@ MIT License - see LICENSE file
 #include "ComponentsCommon.h"
 
 
+namespace savage::utl { class blob_stream_reader; }
+
 namespace savage::script {
 
 	// Contains initialization information for script component
@@ -22,4 +24,27 @@ namespace savage::script {
 	// Remove script component
 	void remove(component c);
 	void update(float dt);
+
+	// Append the tag of the script and its optional state to the buffer (used by world snapshots)
+	void serialize(component c, utl::vector<u8>& buffer);
+	// Move past data written by serialize(). Returns false if it is cut short
+	bool check_serialized(utl::blob_stream_reader& blob);
+	// Create a script for the entity from data written by serialize(). The tag is looked up in the registry then
+	// in the loaded game code. Returns an invalid component if neither has the script
+	component deserialize(utl::blob_stream_reader& blob, game_entity::entity entity);
+
+	// Hot reload of the game code module. Scripts keep their component IDs, only their instances are swapped.
+	// Returns the tag of a creator from the module that is unloaded, or 0 if the creator is not from it
+	using module_tag_lookup = size_t(*)(detail::script_creator);
+	// Returns the creator of a tag in the module that was loaded, or nullptr if that script no longer exists
+	using module_creator_lookup = detail::script_creator(*)(size_t);
+
+	// Save the state of every script made by the module then destroy them. Call before the module is unloaded
+	u32 unload_module_scripts(module_tag_lookup tag_of, utl::vector<u8>& saved);
+	// Make the scripts again with the new module and give them their state back.
+	// Scripts whose class is gone are left without an instance. Returns how many were made again
+	u32 reload_module_scripts(module_creator_lookup creator_of, const utl::vector<u8>& saved);
+	// Lookups of the loaded game code module so serialize() and deserialize() can find its scripts by tag.
+	// Set when the module is loaded and cleared with nullptrs when it is unloaded
+	void set_module_lookups(module_tag_lookup tag_of, module_creator_lookup creator_of);
 }
\ No newline at end of file
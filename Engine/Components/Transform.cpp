@@ -7,6 +7,11 @@ MIT License - see LICENSE file
 
 #include "Transform.h"
 #include "Entity.h"
+#include "../Utilities/IOStream.h"
+#include "../Utilities/LinearAllocator.h"
+#include "../Utilities/Quantization.h"
+#include <algorithm>
+#include <cstring>
 
 namespace savage::transform
 {
@@ -16,6 +21,303 @@ namespace savage::transform
 		utl::vector<math::v4> rotations;
 		utl::vector<math::v3> scales;
 
+		// Static transforms are packed together. static_mapping goes from entity index to packed index
+		// NOTE: They still have their slot in the arrays above, this is extra data for passes that only read statics
+		utl::vector<packed_transform>	static_transforms;
+		utl::vector<id::id_type>		static_entities;
+		utl::vector<u32>				static_mapping;
+		utl::vector<static_chunk>		static_chunks;
+
+		// Dynamic transforms are packed by category. dynamic_mapping goes from entity index to the index in its stream
+		utl::vector<category>			categories;
+		utl::vector<u32>				dynamic_mapping;
+		utl::vector<id::id_type>		uniform_entities;
+		utl::vector<f32>				uniform_scales;
+		utl::vector<id::id_type>		nonuniform_entities;
+
+		constexpr u32 position_bits{ 16 };
+
+		constexpr bool is_uniform(const math::v3& scale)
+		{
+			return scale.x == scale.y && scale.x == scale.z;
+		}
+
+		// Row-major world matrix for row vectors with the scale already applied to each axis
+		void make_matrix(const math::v3& p, const math::v4& q, f32 sx, f32 sy, f32 sz, math::m4x4& m)
+		{
+			const f32 xx{ q.x * q.x }, yy{ q.y * q.y }, zz{ q.z * q.z };
+			const f32 xy{ q.x * q.y }, xz{ q.x * q.z }, yz{ q.y * q.z };
+			const f32 wx{ q.w * q.x }, wy{ q.w * q.y }, wz{ q.w * q.z };
+			m.m[0][0] = (1.f - 2.f * (yy + zz)) * sx; m.m[0][1] = 2.f * (xy + wz) * sx;		  m.m[0][2] = 2.f * (xz - wy) * sx;			m.m[0][3] = 0.f;
+			m.m[1][0] = 2.f * (xy - wz) * sy;		  m.m[1][1] = (1.f - 2.f * (xx + zz)) * sy; m.m[1][2] = 2.f * (yz + wx) * sy;			m.m[1][3] = 0.f;
+			m.m[2][0] = 2.f * (xz + wy) * sz;		  m.m[2][1] = 2.f * (yz - wx) * sz;		  m.m[2][2] = (1.f - 2.f * (xx + yy)) * sz; m.m[2][3] = 0.f;
+			m.m[3][0] = p.x;						  m.m[3][1] = p.y;						  m.m[3][2] = p.z;							m.m[3][3] = 1.f;
+		}
+
+		// Size of a half float without branching, so the static query loop stays tight. Shifting the bits into
+		// place and scaling by 2^112 fixes up the exponent bias, denormals included. Infinity comes out finite
+		f32 f16_magnitude(u16 value)
+		{
+			const u32 bits{ (u32)(value & 0x7fff) << 13 };
+			f32 result;
+			memcpy(&result, &bits, sizeof(f32));
+			return result * 5.192296858534828e+33f;
+		}
+
+		f32 max_scale(const math::v3& s)
+		{
+			return std::max(std::max(fabsf(s.x), fabsf(s.y)), fabsf(s.z));
+		}
+
+		bool overlaps(const math::v3& p, f32 object_radius, const math::v3& center, f32 radius)
+		{
+			const f32 dx{ p.x - center.x }, dy{ p.y - center.y }, dz{ p.z - center.z };
+			const f32 r{ object_radius + radius };
+			return dx * dx + dy * dy + dz * dz <= r * r;
+		}
+
+		// Kernels specialized for each category. Static queries decode the packed form (16 bytes), uniform scale
+		// reads one float from its own stream and only non-uniform scale reads the scale array
+		template<category C>
+		void build_matrices(math::m4x4* const matrices)
+		{
+			if constexpr (C == category::static_transform)
+			{
+				// Decoding the rotation costs more than reading it, so this goes through the full arrays
+				const u32 count{ (u32)static_entities.size() };
+				for (u32 i{ 0 }; i < count; ++i)
+				{
+					const id::id_type index{ static_entities[i] };
+					const f32 s{ scales[index].x };
+					make_matrix(positions[index], rotations[index], s, s, s, matrices[i]);
+				}
+			}
+			else if constexpr (C == category::dynamic_uniform)
+			{
+				const u32 count{ (u32)uniform_entities.size() };
+				for (u32 i{ 0 }; i < count; ++i)
+				{
+					const id::id_type index{ uniform_entities[i] };
+					const f32 s{ uniform_scales[i] };
+					make_matrix(positions[index], rotations[index], s, s, s, matrices[i]);
+				}
+			}
+			else
+			{
+				const u32 count{ (u32)nonuniform_entities.size() };
+				for (u32 i{ 0 }; i < count; ++i)
+				{
+					const id::id_type index{ nonuniform_entities[i] };
+					const math::v3& s{ scales[index] };
+					make_matrix(positions[index], rotations[index], s.x, s.y, s.z, matrices[i]);
+				}
+			}
+		}
+
+		template<category C>
+		u32 find(const math::v3& center, f32 radius, f32 object_radius, id::id_type* const found)
+		{
+			u32 found_count{ 0 };
+			if constexpr (C == category::static_transform)
+			{
+				// Only reads the packed transforms, 16 bytes each. The step of each chunk is worked out once so
+				// decoding a position is a multiply-add per axis
+				utl::scratch scratch{};
+				utl::vector<math::v3, utl::scratch_allocator<math::v3>> steps{ scratch.allocator<math::v3>() };
+				steps.resize(static_chunks.size());
+				for (u32 i{ 0 }; i < (u32)static_chunks.size(); ++i)
+				{
+					constexpr f32 inv_steps{ 1.f / (f32)((1u << position_bits) - 1) };
+					const static_chunk& chunk{ static_chunks[i] };
+					steps[i] = { (chunk.max.x - chunk.min.x) * inv_steps, (chunk.max.y - chunk.min.y) * inv_steps, (chunk.max.z - chunk.min.z) * inv_steps };
+				}
+
+				const u32 count{ (u32)static_transforms.size() };
+				for (u32 i{ 0 }; i < count; ++i)
+				{
+					const packed_transform& packed{ static_transforms[i] };
+					const math::v3& min{ static_chunks[packed.chunk].min };
+					const math::v3& step{ steps[packed.chunk] };
+					const math::v3 p{ min.x + packed.position[0] * step.x, min.y + packed.position[1] * step.y, min.z + packed.position[2] * step.z };
+					found[found_count] = static_entities[i];
+					found_count += overlaps(p, object_radius * f16_magnitude(packed.scale), center, radius);
+				}
+			}
+			else if constexpr (C == category::dynamic_uniform)
+			{
+				const u32 count{ (u32)uniform_entities.size() };
+				for (u32 i{ 0 }; i < count; ++i)
+				{
+					const id::id_type index{ uniform_entities[i] };
+					found[found_count] = index;
+					found_count += overlaps(positions[index], object_radius * fabsf(uniform_scales[i]), center, radius);
+				}
+			}
+			else
+			{
+				const u32 count{ (u32)nonuniform_entities.size() };
+				for (u32 i{ 0 }; i < count; ++i)
+				{
+					const id::id_type index{ nonuniform_entities[i] };
+					found[found_count] = index;
+					found_count += overlaps(positions[index], object_radius * max_scale(scales[index]), center, radius);
+				}
+			}
+			return found_count;
+		}
+
+		utl::vector<id::id_type>& dynamic_stream(category c)
+		{
+			assert(c == category::dynamic_uniform || c == category::dynamic_nonuniform);
+			return c == category::dynamic_uniform ? uniform_entities : nonuniform_entities;
+		}
+
+		void remove_dynamic(id::id_type index)
+		{
+			if (index >= categories.size() || categories[index] == category::count || categories[index] == category::static_transform) return;
+			const category c{ categories[index] };
+			const u32 stream_index{ dynamic_mapping[index] };
+			utl::vector<id::id_type>& entities{ dynamic_stream(c) };
+
+			// Move the last transform of the category into the removed slot
+			dynamic_mapping[entities.back()] = stream_index;
+			utl::erase_unordered(entities, stream_index);
+			if (c == category::dynamic_uniform) utl::erase_unordered(uniform_scales, stream_index);
+			dynamic_mapping[index] = u32_invalid_id;
+			categories[index] = category::count;
+		}
+
+		// Put a dynamic transform in the stream of the category its scale needs, moving it if that changed
+		void set_dynamic(id::id_type index)
+		{
+			if (categories.size() <= index)
+			{
+				categories.resize(index + 1, category::count);
+				dynamic_mapping.resize(index + 1, u32_invalid_id);
+			}
+			const category c{ is_uniform(scales[index]) ? category::dynamic_uniform : category::dynamic_nonuniform };
+			if (categories[index] != c)
+			{
+				remove_dynamic(index);
+				utl::vector<id::id_type>& entities{ dynamic_stream(c) };
+				dynamic_mapping[index] = (u32)entities.size();
+				entities.emplace_back(index);
+				if (c == category::dynamic_uniform) uniform_scales.emplace_back();
+				categories[index] = c;
+			}
+			if (c == category::dynamic_uniform) uniform_scales[dynamic_mapping[index]] = scales[index].x;
+		}
+
+		// Check if the transform at the entity index can be packed in the chunk without clamping it.
+		// Being off by less than the quantization error is fine, unpacked positions can round to just outside the bounds
+		bool fits_static(id::id_type index, const static_chunk& chunk)
+		{
+			auto axis = [](f32 value, f32 min, f32 max) {
+				const f32 margin{ (max - min) / (f32)((1u << position_bits) - 1) };
+				return value >= min - margin && value <= max + margin;
+			};
+			const math::v3& p{ positions[index] };
+			const math::v3& s{ scales[index] };
+			return fabsf(s.x - s.y) < 1e-4f && fabsf(s.x - s.z) < 1e-4f &&
+				axis(p.x, chunk.min.x, chunk.max.x) && axis(p.y, chunk.min.y, chunk.max.y) && axis(p.z, chunk.min.z, chunk.max.z);
+		}
+
+		// Pack the transform at the entity index and put the unpacked values back so both forms are the same
+		void set_static(id::id_type index, u32 chunk_index)
+		{
+			assert(chunk_index < static_chunks.size());
+			const static_chunk& chunk{ static_chunks[chunk_index] };
+			assert(fits_static(index, chunk));
+
+			if (static_mapping.size() <= index) static_mapping.resize(index + 1, u32_invalid_id);
+			if (categories.size() <= index)
+			{
+				categories.resize(index + 1, category::count);
+				dynamic_mapping.resize(index + 1, u32_invalid_id);
+			}
+			u32& packed_index{ static_mapping[index] };
+			if (packed_index == u32_invalid_id)
+			{
+				packed_index = (u32)static_transforms.size();
+				static_transforms.emplace_back();
+				static_entities.emplace_back(index);
+			}
+			categories[index] = category::static_transform;
+
+			packed_transform& packed{ static_transforms[packed_index] };
+			packed = pack(positions[index], rotations[index], scales[index].x, chunk, chunk_index);
+			unpack(packed, chunk, positions[index], rotations[index], scales[index]);
+		}
+
+		void remove_static(id::id_type index)
+		{
+			if (index >= static_mapping.size() || static_mapping[index] == u32_invalid_id) return;
+			const u32 packed_index{ static_mapping[index] };
+
+			// Move the last static transform into the removed slot
+			static_mapping[static_entities.back()] = packed_index;
+			static_mapping[index] = u32_invalid_id;
+			utl::erase_unordered(static_transforms, packed_index);
+			utl::erase_unordered(static_entities, packed_index);
+			categories[index] = category::count;
+		}
+
+		template<typename T>
+		void write_vector(utl::blob_stream_writer& blob, const utl::vector<T>& v)
+		{
+			blob.write((u32)v.size());
+			blob.write(v.data(), v.size() * sizeof(T));
+		}
+
+		template<typename T>
+		void read_vector(utl::blob_stream_reader& blob, utl::vector<T>& v)
+		{
+			v.resize(blob.read<u32>());
+			blob.read(v.data(), v.size() * sizeof(T));
+		}
+
+		// A vector written by write_vector() that is still in the snapshot.
+		// Elements are copied out because the data in the snapshot isn't aligned
+		template<typename T>
+		struct saved_vector
+		{
+			const u8*	data{ nullptr };
+			u32			size{ 0 };
+
+			T operator[](u32 i) const
+			{
+				assert(i < size);
+				T value;
+				memcpy(&value, data + (size_t)i * sizeof(T), sizeof(T));
+				return value;
+			}
+		};
+
+		// Move past a vector written by write_vector(). Returns false if the data is cut short
+		template<typename T>
+		bool skip_vector(utl::blob_stream_reader& blob, saved_vector<T>& v)
+		{
+			if (blob.remaining() < sizeof(u32)) return false;
+			v.size = blob.read<u32>();
+			const u64 size{ (u64)v.size * sizeof(T) };
+			if (size > blob.remaining()) return false;
+			v.data = blob.position();
+			blob.skip(size);
+			return true;
+		}
+
+		// Check that the entities of a dynamic stream have that category and map back to their place in the stream
+		bool check_stream(const saved_vector<id::id_type>& entities, category c, const saved_vector<category>& saved_categories,
+			const saved_vector<u32>& saved_dynamic_mapping)
+		{
+			for (u32 i{ 0 }; i < entities.size; ++i)
+			{
+				const id::id_type index{ entities[i] };
+				if (index >= saved_categories.size || saved_categories[index] != c || saved_dynamic_mapping[index] != i) return false;
+			}
+			return true;
+		}
+
 	} // Anonymous namespace
 
 	// Create transform component
@@ -40,12 +342,257 @@ namespace savage::transform
 			scales.emplace_back(info.scale);
 		}
 
-		return component(transform_id{ (id::id_type)positions.size() - 1 });
+		if (info.static_chunk != u32_invalid_id) set_static(entity_index, info.static_chunk);
+		else set_dynamic(entity_index);
+
+		// Transforms are stored at the same index as their entity
+		return component(transform_id{ entity_index });
 	}
 	// Remove transform component
 	void remove(component c)
 	{
 		assert(c.is_valid());
+		remove_static(id::index(c.get_id()));
+		remove_dynamic(id::index(c.get_id()));
+	}
+
+	u32 add_static_chunk(const math::v3& min, const math::v3& max)
+	{
+		assert(min.x <= max.x && min.y <= max.y && min.z <= max.z);
+		static_chunks.push_back({ min, max });
+		return (u32)static_chunks.size() - 1;
+	}
+
+	void remove_static_chunks()
+	{
+		assert(static_transforms.empty());
+		static_chunks.clear();
+	}
+
+	packed_transform pack(const math::v3& position, const math::v4& rotation, f32 scale, const static_chunk& chunk, u32 chunk_index)
+	{
+		// A flat chunk still needs a range to quantize against
+		auto axis = [](f32 value, f32 min, f32 max) {
+			return (u16)(max > min ? math::quantize_float(value, min, max, position_bits) : 0);
+		};
+		packed_transform packed{};
+		packed.position[0] = axis(position.x, chunk.min.x, chunk.max.x);
+		packed.position[1] = axis(position.y, chunk.min.y, chunk.max.y);
+		packed.position[2] = axis(position.z, chunk.min.z, chunk.max.z);
+		packed.scale = math::f32_to_f16(scale);
+		packed.rotation = math::pack_quaternion(rotation);
+		packed.chunk = chunk_index;
+		return packed;
+	}
+
+	void unpack(const packed_transform& packed, const static_chunk& chunk, math::v3& position, math::v4& rotation, math::v3& scale)
+	{
+		auto axis = [](u16 value, f32 min, f32 max) {
+			return max > min ? math::dequantize_float(value, min, max, position_bits) : min;
+		};
+		position = { axis(packed.position[0], chunk.min.x, chunk.max.x),
+					 axis(packed.position[1], chunk.min.y, chunk.max.y),
+					 axis(packed.position[2], chunk.min.z, chunk.max.z) };
+		rotation = math::unpack_quaternion(packed.rotation);
+		const f32 s{ math::f16_to_f32(packed.scale) };
+		scale = { s, s, s };
+	}
+
+	storage_view view()
+	{
+		return { positions.data(), rotations.data(), scales.data(), (u32)positions.size() };
+	}
+
+	static_storage_view static_view()
+	{
+		return { static_transforms.data(), static_entities.data(), static_chunks.data(), (u32)static_transforms.size(), (u32)static_chunks.size() };
+	}
+
+	category_storage_view view(category c)
+	{
+		switch (c)
+		{
+		case category::static_transform: return { static_entities.data(), (u32)static_entities.size() };
+		case category::dynamic_uniform: return { uniform_entities.data(), (u32)uniform_entities.size() };
+		case category::dynamic_nonuniform: return { nonuniform_entities.data(), (u32)nonuniform_entities.size() };
+		default: assert(false); return {};
+		}
+	}
+
+	category get_category(id::id_type index)
+	{
+		assert(index < categories.size() && categories[index] != category::count);
+		return categories[index];
+	}
+
+	void world_matrices(category c, math::m4x4* const matrices)
+	{
+		assert(matrices || !view(c).count);
+		switch (c)
+		{
+		case category::static_transform: build_matrices<category::static_transform>(matrices); break;
+		case category::dynamic_uniform: build_matrices<category::dynamic_uniform>(matrices); break;
+		case category::dynamic_nonuniform: build_matrices<category::dynamic_nonuniform>(matrices); break;
+		default: assert(false);
+		}
+	}
+
+	void world_matrices(const id::id_type* const indices, u32 count, math::m4x4* const matrices)
+	{
+		assert((indices && matrices) || !count);
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			const id::id_type index{ indices[i] };
+			assert(index < positions.size());
+			const math::v3& s{ scales[index] };
+			make_matrix(positions[index], rotations[index], s.x, s.y, s.z, matrices[i]);
+		}
+	}
+
+	u32 find_overlapping(category c, const math::v3& center, f32 radius, f32 object_radius, id::id_type* const found)
+	{
+		assert(found || !view(c).count);
+		switch (c)
+		{
+		case category::static_transform: return find<category::static_transform>(center, radius, object_radius, found);
+		case category::dynamic_uniform: return find<category::dynamic_uniform>(center, radius, object_radius, found);
+		case category::dynamic_nonuniform: return find<category::dynamic_nonuniform>(center, radius, object_radius, found);
+		default: assert(false); return 0;
+		}
+	}
+
+	u32 find_overlapping(const id::id_type* const indices, u32 count, const math::v3& center, f32 radius, f32 object_radius, id::id_type* const found)
+	{
+		assert((indices && found) || !count);
+		u32 found_count{ 0 };
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			const id::id_type index{ indices[i] };
+			assert(index < positions.size());
+			found[found_count] = index;
+			found_count += overlaps(positions[index], object_radius * max_scale(scales[index]), center, radius);
+		}
+		return found_count;
+	}
+
+	void set(id::id_type index, const math::v3& position, const math::v4& rotation, const math::v3& scale)
+	{
+		assert(index < positions.size());
+		positions[index] = position;
+		rotations[index] = rotation;
+		scales[index] = scale;
+		// Static transforms can still be moved (by the editor). They stay static as long as they fit in their chunk,
+		// otherwise they become dynamic so the new values are kept as they are instead of being clamped
+		if (index < static_mapping.size() && static_mapping[index] != u32_invalid_id)
+		{
+			const u32 chunk_index{ static_transforms[static_mapping[index]].chunk };
+			if (fits_static(index, static_chunks[chunk_index]))
+			{
+				set_static(index, chunk_index);
+			}
+			else
+			{
+				remove_static(index);
+				set_dynamic(index);
+			}
+		}
+		else if (index < categories.size() && categories[index] != category::count)
+		{
+			set_dynamic(index);
+		}
+	}
+
+	void save_state(utl::vector<u8>& buffer)
+	{
+		utl::blob_stream_writer blob{ buffer };
+		const u32 count{ (u32)positions.size() };
+		blob.write(count);
+		// Each array is written as one contiguous block so this is just three memcpy's
+		blob.write(positions.data(), count * sizeof(math::v3));
+		blob.write(rotations.data(), count * sizeof(math::v4));
+		blob.write(scales.data(), count * sizeof(math::v3));
+		write_vector(blob, static_transforms);
+		write_vector(blob, static_entities);
+		write_vector(blob, static_mapping);
+		write_vector(blob, static_chunks);
+		write_vector(blob, categories);
+		write_vector(blob, dynamic_mapping);
+		write_vector(blob, uniform_entities);
+		write_vector(blob, uniform_scales);
+		write_vector(blob, nonuniform_entities);
+	}
+
+	bool check_state(utl::blob_stream_reader& blob, u32& count)
+	{
+		if (blob.remaining() < sizeof(u32)) return false;
+		count = blob.read<u32>();
+		const u64 size{ (u64)count * (2 * sizeof(math::v3) + sizeof(math::v4)) };
+		if (size > blob.remaining()) return false;
+		blob.skip(size);
+
+		saved_vector<packed_transform> saved_static_transforms;
+		saved_vector<id::id_type> saved_static_entities, saved_uniform_entities, saved_nonuniform_entities;
+		saved_vector<u32> saved_static_mapping, saved_dynamic_mapping;
+		saved_vector<static_chunk> saved_static_chunks;
+		saved_vector<category> saved_categories;
+		saved_vector<f32> saved_uniform_scales;
+		if (!skip_vector(blob, saved_static_transforms) || !skip_vector(blob, saved_static_entities) || !skip_vector(blob, saved_static_mapping) ||
+			!skip_vector(blob, saved_static_chunks) || !skip_vector(blob, saved_categories) || !skip_vector(blob, saved_dynamic_mapping) || !skip_vector(blob, saved_uniform_entities) ||
+			!skip_vector(blob, saved_uniform_scales) || !skip_vector(blob, saved_nonuniform_entities)) return false;
+
+		// The arrays of each kind of transform go together, and the mappings are at most one per transform
+		const u32 static_count{ saved_static_transforms.size };
+		if (saved_static_entities.size != static_count || saved_uniform_scales.size != saved_uniform_entities.size ||
+			saved_static_mapping.size > count || saved_categories.size > count || saved_dynamic_mapping.size != saved_categories.size) return false;
+
+		// Every index has to be inside the array it is used with, and the mappings have to agree with the streams
+		for (u32 i{ 0 }; i < static_count; ++i)
+		{
+			const id::id_type index{ saved_static_entities[i] };
+			if (index >= saved_static_mapping.size || saved_static_mapping[index] != i || index >= saved_categories.size ||
+				saved_categories[index] != category::static_transform || saved_static_transforms[i].chunk >= saved_static_chunks.size) return false;
+		}
+		for (u32 i{ 0 }; i < saved_static_mapping.size; ++i)
+		{
+			const u32 packed_index{ saved_static_mapping[i] };
+			if (packed_index != u32_invalid_id && (packed_index >= static_count || saved_static_entities[packed_index] != i)) return false;
+		}
+		for (u32 i{ 0 }; i < saved_categories.size; ++i)
+		{
+			const category c{ saved_categories[i] };
+			const u32 stream_index{ saved_dynamic_mapping[i] };
+			switch (c)
+			{
+			case category::static_transform: if (i >= saved_static_mapping.size || saved_static_mapping[i] == u32_invalid_id) return false; break;
+			case category::dynamic_uniform: if (stream_index >= saved_uniform_entities.size || saved_uniform_entities[stream_index] != i) return false; break;
+			case category::dynamic_nonuniform: if (stream_index >= saved_nonuniform_entities.size || saved_nonuniform_entities[stream_index] != i) return false; break;
+			case category::count: break;
+			default: return false;
+			}
+		}
+		return check_stream(saved_uniform_entities, category::dynamic_uniform, saved_categories, saved_dynamic_mapping) &&
+			check_stream(saved_nonuniform_entities, category::dynamic_nonuniform, saved_categories, saved_dynamic_mapping);
+	}
+
+	void load_state(utl::blob_stream_reader& blob)
+	{
+		const u32 count{ blob.read<u32>() };
+		// NOTE: resize() only allocates when the world grew since the last restore
+		positions.resize(count);
+		rotations.resize(count);
+		scales.resize(count);
+		blob.read(positions.data(), count * sizeof(math::v3));
+		blob.read(rotations.data(), count * sizeof(math::v4));
+		blob.read(scales.data(), count * sizeof(math::v3));
+		read_vector(blob, static_transforms);
+		read_vector(blob, static_entities);
+		read_vector(blob, static_mapping);
+		read_vector(blob, static_chunks);
+		read_vector(blob, categories);
+		read_vector(blob, dynamic_mapping);
+		read_vector(blob, uniform_entities);
+		read_vector(blob, uniform_scales);
+		read_vector(blob, nonuniform_entities);
 	}
 
 	math::v4 component::rotation() const
@@ -9,6 +9,8 @@ MIT License - see LICENSE file
 #include "ComponentsCommon.h"
 
 
+namespace savage::utl { class blob_stream_reader; }
+
 namespace savage::transform {
 
 	// Contains initialization information for transform component
@@ -17,10 +19,109 @@ namespace savage::transform {
 		f32 position[3]{};
 		f32 rotation[4]{};
 		f32 scale[3]{1.f, 1.f, 1.f};
+		u32 static_chunk{ u32_invalid_id }; // Store as a static transform in this chunk (see add_static_chunk()). Scale must be uniform
+	};
+
+	// Static transforms (level geometry that does not move) are also kept in a compact form:
+	// position in 16 bits per axis relative to the bounds of its chunk, rotation in 32 bits (smallest three)
+	// and uniform scale as a 16 bit float. Systems that only go through static transforms read 16 bytes per
+	// entity instead of 40. The full precision arrays in storage_view hold the same (quantized) values.
+	// NOTE: The packed form is kept next to the full arrays, so a static transform takes 24 bytes more than a
+	//		 dynamic one (packed form, entity index and mapping). Nothing else is cached for statics: the static
+	//		 kernel of find_overlapping() decodes position and scale from the packed form, world_matrices() reads
+	//		 the full arrays since decoding the rotation costs more than it saves.
+	struct static_chunk
+	{
+		math::v3 min;
+		math::v3 max;
+	};
+
+	struct packed_transform
+	{
+		u16 position[3];
+		u16 scale;		// f16
+		u32 rotation;	// math::pack_quaternion()
+		u32 chunk;
 	};
+	static_assert(sizeof(packed_transform) == 16);
+
+	// Add the bounds of a group of static transforms. Returns the chunk index
+	u32 add_static_chunk(const math::v3& min, const math::v3& max);
+	// Forget all chunks. There can be no static transforms left
+	void remove_static_chunks();
+	packed_transform pack(const math::v3& position, const math::v4& rotation, f32 scale, const static_chunk& chunk, u32 chunk_index);
+	void unpack(const packed_transform& packed, const static_chunk& chunk, math::v3& position, math::v4& rotation, math::v3& scale);
 
 	// Create transform component
 	component create(init_info info, game_entity::entity entity);
 	// Remove transform component
 	void remove(component c);
+
+	// Read-only view of the transform arrays for systems that go through every transform.
+	// Transforms are stored at the index of their entity, including slots of removed entities.
+	// NOTE: The pointers are only valid until the next entity is created
+	struct storage_view
+	{
+		const math::v3*	positions{ nullptr };
+		const math::v4*	rotations{ nullptr };
+		const math::v3*	scales{ nullptr };
+		u32				count{ 0 };
+	};
+	storage_view view();
+	// Read-only view of the static transforms. They are packed together, entity_indices has the entity of each one
+	// NOTE: The pointers are only valid until the next static transform is created or removed
+	struct static_storage_view
+	{
+		const packed_transform*	transforms{ nullptr };
+		const id::id_type*		entity_indices{ nullptr };
+		const static_chunk*		chunks{ nullptr };
+		u32						count{ 0 };
+		u32						chunk_count{ 0 };
+	};
+	static_storage_view static_view();
+	// Every transform is also in exactly one category, picked from what it needs to build its world matrix:
+	// static transforms never move and are read from their packed form when that is cheaper, uniform scale only
+	// scales by one number and only non-uniform scale needs the full math. Each category keeps its own
+	// packed stream so the kernels for it are specialized at compile time and skip the work it doesn't need.
+	enum class category : u32
+	{
+		static_transform,	// Has a static chunk (always uniform scale)
+		dynamic_uniform,	// Scale is the same on all axes
+		dynamic_nonuniform,
+
+		count
+	};
+	// Entity indices of the transforms in a category, in the order the kernels below write them
+	// NOTE: The pointer is only valid until the next transform is created, removed or changes category
+	struct category_storage_view
+	{
+		const id::id_type*	entity_indices{ nullptr };
+		u32					count{ 0 };
+	};
+	category_storage_view view(category c);
+	category get_category(id::id_type index);
+	// Write the row-major world matrix (row vectors: scale, rotate, then translate) of every transform in the category
+	void world_matrices(category c, math::m4x4* const matrices);
+	// Same for any list of entity indices without knowing their category (the generic path)
+	void world_matrices(const id::id_type* const indices, u32 count, math::m4x4* const matrices);
+	// Find the transforms in a category with a bounding sphere (object_radius times the largest scale) that
+	// overlaps the sphere at center. Writes their entity indices to found (room for every transform searched)
+	// and returns how many there are
+	u32 find_overlapping(category c, const math::v3& center, f32 radius, f32 object_radius, id::id_type* const found);
+	// Same for any list of entity indices without knowing their category (the generic path)
+	u32 find_overlapping(const id::id_type* const indices, u32 count, const math::v3& center, f32 radius, f32 object_radius, id::id_type* const found);
+
+	// Overwrite the transform at the entity index (used to apply changes made outside of the engine)
+	// A static transform is quantized again if it is still inside its chunk with a uniform scale,
+	// otherwise it stops being static and keeps the values as they are
+	void set(id::id_type index, const math::v3& position, const math::v4& rotation, const math::v3& scale);
+
+	// Append the position, rotation, scale, static transform and category arrays to the buffer (used by world snapshots)
+	void save_state(utl::vector<u8>& buffer);
+	// Move past data written by save_state() without changing anything and get the number of transforms.
+	// Returns false if it is cut short or an index in it is outside the array it is used with
+	bool check_state(utl::blob_stream_reader& blob, u32& count);
+	// Replace the position, rotation and scale arrays with data written by save_state()
+	// NOTE: The data has to be checked with check_state() first if it can be broken
+	void load_state(utl::blob_stream_reader& blob);
 }
\ No newline at end of file
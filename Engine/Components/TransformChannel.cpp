@@ -0,0 +1,200 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "TransformChannel.h"
+#include "Entity.h"
+#include "Transform.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace savage::transform_channel {
+	namespace {
+
+		constexpr size_t channel_alignment{ 64 };
+
+		channel_header*	channel{ nullptr };
+		size_t			channel_size{ 0 };
+
+		constexpr u32 align_up(size_t size)
+		{
+			return (u32)((size + channel_alignment - 1) & ~(channel_alignment - 1));
+		}
+
+		template<typename T>
+		T* at_offset(u32 offset)
+		{
+			return (T*)((u8*)channel + offset);
+		}
+
+		transform_edit* edit_slots()
+		{
+			return at_offset<transform_edit>(channel->queue_offset);
+		}
+
+	} // Anonymous namespace
+
+	bool initialize(u32 capacity, u32 queue_capacity /* = 4096 */)
+	{
+		assert(!channel && capacity && queue_capacity);
+		if (channel) return false;
+
+		u32 slots{ 1 };
+		while (slots < queue_capacity) slots <<= 1;
+
+		// Header, then positions, rotations and scales of both buffers, then the edit slots
+		const u32 positions_size{ align_up(capacity * sizeof(math::v3)) };
+		const u32 rotations_size{ align_up(capacity * sizeof(math::v4)) };
+		u32 offset{ align_up(sizeof(channel_header)) };
+		u32 array_offsets[2][3];
+		for (auto& buffer : array_offsets)
+		{
+			buffer[0] = offset; offset += positions_size;
+			buffer[1] = offset; offset += rotations_size;
+			buffer[2] = offset; offset += positions_size;
+		}
+		const u32 queue_offset{ offset };
+		channel_size = (size_t)queue_offset + slots * sizeof(transform_edit);
+
+		void* const memory{ ::operator new(channel_size, std::align_val_t{ channel_alignment }, std::nothrow) };
+		if (!memory) return false;
+		memset(memory, 0, channel_size);
+
+		channel = new (memory) channel_header{};
+		channel->magic = channel_magic;
+		channel->version = channel_version;
+		channel->capacity = capacity;
+		channel->queue_capacity = slots;
+		channel->queue_offset = queue_offset;
+		for (u32 i{ 0 }; i < 2; ++i)
+		{
+			transform_buffer& buffer{ channel->buffers[i] };
+			buffer.positions_offset = array_offsets[i][0];
+			buffer.rotations_offset = array_offsets[i][1];
+			buffer.scales_offset = array_offsets[i][2];
+		}
+		return true;
+	}
+
+	void shutdown()
+	{
+		if (!channel) return;
+		channel->~channel_header();
+		::operator delete(channel, std::align_val_t{ channel_alignment });
+		channel = nullptr;
+		channel_size = 0;
+	}
+
+	channel_header* data()
+	{
+		return channel;
+	}
+
+	size_t size()
+	{
+		return channel_size;
+	}
+
+	bool publish()
+	{
+		assert(channel);
+		const transform::storage_view transforms{ transform::view() };
+		const u32 count{ std::min(transforms.count, channel->capacity) };
+		const u64 frame{ channel->frame.load(std::memory_order_relaxed) + 1 };
+
+		// Write to the buffer that is not the latest one. Readers of it will see an odd sequence or a changed one
+		const u32 back{ 1 - channel->latest.load(std::memory_order_relaxed) };
+		transform_buffer& buffer{ channel->buffers[back] };
+		const u32 sequence{ buffer.sequence.load(std::memory_order_relaxed) };
+		buffer.sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		buffer.count = count;
+		buffer.total = transforms.count;
+		buffer.frame = frame;
+		memcpy(at_offset<math::v3>(buffer.positions_offset), transforms.positions, count * sizeof(math::v3));
+		memcpy(at_offset<math::v4>(buffer.rotations_offset), transforms.rotations, count * sizeof(math::v4));
+		memcpy(at_offset<math::v3>(buffer.scales_offset), transforms.scales, count * sizeof(math::v3));
+
+		buffer.sequence.store(sequence + 2, std::memory_order_release);
+		channel->latest.store(back, std::memory_order_release);
+		channel->frame.store(frame, std::memory_order_release);
+		return count == transforms.count;
+	}
+
+	u32 apply_edits()
+	{
+		assert(channel);
+		edit_queue& queue{ channel->queue };
+		const u32 mask{ channel->queue_capacity - 1 };
+		u32 tail{ queue.tail.load(std::memory_order_relaxed) };
+		const u32 head{ queue.head.load(std::memory_order_acquire) };
+		const transform_edit* const slots{ edit_slots() };
+
+		u32 applied{ 0 };
+		for (; tail != head; ++tail)
+		{
+			const transform_edit& edit{ slots[tail & mask] };
+			const game_entity::entity_id id{ edit.entity_id };
+			if (!id::is_valid(id) || !game_entity::is_alive(id)) continue;
+
+			// Only change what the edit has flags for
+			const id::id_type index{ id::index(id) };
+			const transform::storage_view transforms{ transform::view() };
+			const math::v3 position{ (edit.flags & edit_flags::position) ? math::v3{ edit.position } : transforms.positions[index] };
+			const math::v4 rotation{ (edit.flags & edit_flags::rotation) ? math::v4{ edit.rotation } : transforms.rotations[index] };
+			const math::v3 scale{ (edit.flags & edit_flags::scale) ? math::v3{ edit.scale } : transforms.scales[index] };
+			transform::set(index, position, rotation, scale);
+			++applied;
+		}
+
+		// Let the editor reuse the slots
+		queue.tail.store(tail, std::memory_order_release);
+		return applied;
+	}
+
+	bool push_edit(const transform_edit& edit)
+	{
+		assert(channel);
+		edit_queue& queue{ channel->queue };
+		const u32 head{ queue.head.load(std::memory_order_relaxed) };
+		const u32 tail{ queue.tail.load(std::memory_order_acquire) };
+		if (head - tail >= channel->queue_capacity) return false;
+
+		edit_slots()[head & (channel->queue_capacity - 1)] = edit;
+		queue.head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool begin_read(read_view& view)
+	{
+		assert(channel);
+		if (!channel->frame.load(std::memory_order_acquire)) return false;
+
+		const u32 latest{ channel->latest.load(std::memory_order_acquire) };
+		const transform_buffer& buffer{ channel->buffers[latest] };
+		const u32 sequence{ buffer.sequence.load(std::memory_order_acquire) };
+		if (sequence & 1) return false; // Being written. Can only happen if the reader is more than a frame behind
+
+		view.positions = at_offset<const math::v3>(buffer.positions_offset);
+		view.rotations = at_offset<const math::v4>(buffer.rotations_offset);
+		view.scales = at_offset<const math::v3>(buffer.scales_offset);
+		view.count = buffer.count;
+		view.total = buffer.total;
+		view.frame = buffer.frame;
+		view.buffer = latest;
+		view.sequence = sequence;
+		return true;
+	}
+
+	bool end_read(const read_view& view)
+	{
+		assert(channel && view.buffer < 2);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return channel->buffers[view.buffer].sequence.load(std::memory_order_relaxed) == view.sequence;
+	}
+}
@@ -0,0 +1,116 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "ComponentsCommon.h"
+#include <atomic>
+#include <cstddef>
+
+// A block of memory the engine shares with the editor so viewports can see runtime transforms
+// and send changes back without copying or calling into the engine for each entity.
+//
+// The engine publishes all transforms into one of two buffers each frame and then flips
+// "latest" to it. Each buffer has a sequence number that is odd while the engine writes to it,
+// so a reader checks it before and after reading to know the data did not change under it.
+// Edits flow the other way through a lock-free ring with one producer (the editor) and one
+// consumer (the engine).
+//
+// NOTE: The layout is read by the editor (Savage-Editor/DLLWrappers/TransformChannel.cs)
+//		 so any change here has to be made there too and the version increased.
+namespace savage::transform_channel {
+
+	constexpr u32 channel_magic{ 0x43545653 }; // 'SVTC'
+	constexpr u32 channel_version{ 2 };
+
+	// What parts of the transform an edit changes
+	enum edit_flags : u32
+	{
+		position = 0x01,
+		rotation = 0x02,
+		scale = 0x04,
+	};
+
+	// One change sent by the editor
+	struct transform_edit
+	{
+		id::id_type	entity_id;
+		u32			flags;			// edit_flags
+		f32			position[3];
+		f32			rotation[4];	// Quaternion
+		f32			scale[3];
+	};
+	static_assert(sizeof(transform_edit) == 48);
+
+	struct transform_buffer
+	{
+		std::atomic<u32>	sequence;			// Odd while the engine is writing to this buffer
+		u32					count;				// Number of transforms, stored at the index of their entity
+		u64					frame;				// Frame the transforms are from
+		u32					positions_offset;	// Offsets of the arrays from the start of the channel
+		u32					rotations_offset;
+		u32					scales_offset;
+		u32					total;				// Number of transforms the engine had. More than count if the channel is too small
+	};
+	static_assert(sizeof(transform_buffer) == 32);
+
+	// Head and tail are on their own cache lines so the editor and engine do not fight over them
+	struct edit_queue
+	{
+		alignas(64) std::atomic<u32> head; // Next slot the editor writes to
+		alignas(64) std::atomic<u32> tail; // Next slot the engine reads from
+	};
+
+	struct channel_header
+	{
+		u32					magic;
+		u32					version;
+		u32					capacity;		// Max transforms per buffer
+		u32					queue_capacity;	// Number of edit slots (power of 2)
+		std::atomic<u64>	frame;			// Number of frames published
+		std::atomic<u32>	latest;			// Index of the buffer with the newest complete frame
+		u32					queue_offset;	// Offset of the edit slots from the start of the channel
+		transform_buffer	buffers[2];
+		edit_queue			queue;
+	};
+	static_assert(std::atomic<u32>::is_always_lock_free && std::atomic<u64>::is_always_lock_free);
+	static_assert(sizeof(std::atomic<u32>) == sizeof(u32) && sizeof(std::atomic<u64>) == sizeof(u64));
+	static_assert(offsetof(channel_header, buffers) == 32 && offsetof(channel_header, queue) == 128 && offsetof(edit_queue, tail) == 64);
+
+	// What a reader sees of one published frame. Check it is still valid with end_read() after using it
+	struct read_view
+	{
+		const math::v3*	positions{ nullptr };
+		const math::v4*	rotations{ nullptr };
+		const math::v3*	scales{ nullptr };
+		u32				count{ 0 };
+		u32				total{ 0 };		// More than count if the channel was too small for all transforms
+		u64				frame{ 0 };
+		u32				buffer{ 0 };
+		u32				sequence{ 0 };
+	};
+
+	// Make the channel. queue_capacity is rounded up to a power of 2
+	bool initialize(u32 capacity, u32 queue_capacity = 4096);
+	void shutdown();
+	// Start of the channel memory (nullptr if not initialized) and its size in bytes
+	channel_header* data();
+	size_t size();
+
+	// Engine side: copy the current transforms into the back buffer and make it the latest. Returns false if
+	// there are more transforms than the channel can hold. Only the first capacity are published then, and the
+	// buffer's total tells the editor how big to make the channel when it opens it again
+	bool publish();
+	// Engine side: apply all edits in the queue. Edits for entities that are no longer alive are dropped
+	u32 apply_edits();
+
+	// Editor side: add an edit to the queue. Returns false if the queue is full
+	bool push_edit(const transform_edit& edit);
+	// Editor side: get the latest frame. Returns false if nothing was published yet
+	bool begin_read(read_view& view);
+	// Editor side: returns false if the engine wrote to the buffer while it was being read
+	bool end_read(const read_view& view);
+}
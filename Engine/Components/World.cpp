@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "World.h"
+#include "Entity.h"
+#include "Transform.h"
+#include "../Utilities/IOStream.h"
+#include <algorithm>
+
+namespace savage::world {
+	namespace {
+
+		// "SVWS" - Savage world snapshot
+		constexpr u32 snapshot_magic{ 0x53575653 };
+		// Bump whenever what the save_state() functions write changes, so restore() turns down older snapshots
+		// 2: static transforms, 3: transform categories, 4: scripts are saved by tag only, 5: no static matrices and bounds
+		constexpr u32 snapshot_version{ 5 };
+		// Size of the blocks compared when making deltas. Small enough that moving a few entities
+		// only touches a few blocks, big enough that the run headers don't cost more than the data
+		constexpr u32 delta_block_size{ 64 };
+
+		// Check if a block of the snapshot is different from the same block in the base
+		bool block_changed(const utl::vector<u8>& base, const utl::vector<u8>& snapshot, u32 block)
+		{
+			const size_t offset{ (size_t)block * delta_block_size };
+			const size_t length{ std::min<size_t>(delta_block_size, snapshot.size() - offset) };
+			if (offset + length > base.size()) return true;
+			return memcmp(base.data() + offset, snapshot.data() + offset, length) != 0;
+		}
+
+	} // Anonymous namespace
+
+	void snapshot(utl::vector<u8>& buffer)
+	{
+		// NOTE: clear() keeps the capacity so we only allocate when the world grows
+		buffer.clear();
+		utl::blob_stream_writer blob{ buffer };
+		blob.write(snapshot_magic);
+		blob.write(snapshot_version);
+
+		// Transforms go first because scripts may read them when they are re-created on restore
+		transform::save_state(buffer);
+		game_entity::save_state(buffer);
+	}
+
+	bool restore(const utl::vector<u8>& buffer)
+	{
+		if (buffer.size() < 2 * sizeof(u32)) return false;
+
+		utl::blob_stream_reader blob{ buffer.data(), buffer.size() };
+		if (blob.read<u32>() != snapshot_magic) return false;
+		if (blob.read<u32>() != snapshot_version) return false;
+
+		// Go through the whole snapshot first so a broken one is found before anything is changed
+		const size_t state_offset{ blob.offset() };
+		u32 transform_count{ 0 };
+		if (!transform::check_state(blob, transform_count) || !game_entity::check_state(blob, transform_count) || blob.remaining()) return false;
+
+		utl::blob_stream_reader state{ buffer.data() + state_offset, buffer.size() - state_offset };
+		transform::load_state(state);
+		game_entity::load_state(state);
+
+		// Check if we read all the data in the buffer
+		assert(!state.remaining());
+		return true;
+	}
+
+	void make_delta(const utl::vector<u8>& base, const utl::vector<u8>& snapshot, utl::vector<u8>& delta)
+	{
+		delta.clear();
+		utl::blob_stream_writer blob{ delta };
+		const u32 size{ (u32)snapshot.size() };
+		const u32 block_count{ (size + delta_block_size - 1) / delta_block_size };
+		blob.write(size);
+
+		// Write runs of changed blocks as [first block][number of blocks][data]
+		u32 block{ 0 };
+		while (block < block_count)
+		{
+			if (!block_changed(base, snapshot, block))
+			{
+				++block;
+				continue;
+			}
+
+			const u32 first_block{ block };
+			while (block < block_count && block_changed(base, snapshot, block)) ++block;
+
+			const size_t offset{ (size_t)first_block * delta_block_size };
+			const size_t end{ std::min<size_t>((size_t)block * delta_block_size, size) };
+			blob.write(first_block);
+			blob.write(block - first_block);
+			blob.write(snapshot.data() + offset, end - offset);
+		}
+	}
+
+	void apply_delta(utl::vector<u8>& base, const utl::vector<u8>& delta)
+	{
+		assert(delta.size() >= sizeof(u32));
+		utl::blob_stream_reader blob{ delta.data(), delta.size() };
+		const u32 size{ blob.read<u32>() };
+		base.resize(size);
+
+		while (blob.offset() < delta.size())
+		{
+			const u32 first_block{ blob.read<u32>() };
+			const u32 count{ blob.read<u32>() };
+			const size_t offset{ (size_t)first_block * delta_block_size };
+			const size_t end{ std::min<size_t>((size_t)(first_block + count) * delta_block_size, size) };
+			assert(offset < end);
+			blob.read(base.data() + offset, end - offset);
+		}
+		assert(blob.offset() == delta.size());
+	}
+
+	void rewind_buffer::push()
+	{
+		snapshot(_scratch);
+
+		if (!_current.empty() && _capacity > 1)
+		{
+			// Reuse the memory of the oldest frame if we are full
+			utl::vector<u8> delta{};
+			if (!_deltas.empty() && _deltas.size() + 1 >= _capacity)
+			{
+				delta = std::move(_deltas.front());
+				_deltas.pop_front();
+			}
+
+			// Store how to go from the new frame back to the current one
+			make_delta(_scratch, _current, delta);
+			_deltas.push_back(std::move(delta));
+		}
+
+		std::swap(_current, _scratch);
+	}
+
+	bool rewind_buffer::rewind(u32 frames /* = 1 */)
+	{
+		if (frames >= size()) return false;
+
+		// Walk back one frame at a time, newest delta first
+		for (u32 i{ 0 }; i < frames; ++i)
+		{
+			apply_delta(_current, _deltas.back());
+			_deltas.pop_back();
+		}
+
+		return restore(_current);
+	}
+
+	void rewind_buffer::clear()
+	{
+		_current.clear();
+		_deltas.clear();
+	}
+
+	size_t rewind_buffer::memory_size() const
+	{
+		size_t size{ _current.size() };
+		for (const auto& delta : _deltas) size += delta.size();
+		return size;
+	}
+}
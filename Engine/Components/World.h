@@ -0,0 +1,50 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "ComponentsCommon.h"
+
+namespace savage::world {
+
+	// Write the whole runtime state (entities, transforms and scripts) to the buffer
+	// NOTE: The buffer is reused so snapshots taken every frame don't allocate once it is big enough
+	void snapshot(utl::vector<u8>& buffer);
+	// Replace the runtime state with a snapshot. Returns false if the data isn't a valid snapshot
+	bool restore(const utl::vector<u8>& buffer);
+
+	// Store only the blocks of a snapshot that changed compared to the base snapshot
+	void make_delta(const utl::vector<u8>& base, const utl::vector<u8>& snapshot, utl::vector<u8>& delta);
+	// Rebuild a snapshot from the base it was compared against and the delta (done in place)
+	void apply_delta(utl::vector<u8>& base, const utl::vector<u8>& delta);
+
+	// Keeps the last few snapshots of the world for rewinding
+	// Only the newest snapshot is stored in full. Older ones are stored as deltas going backwards in time,
+	// so rewinding one frame is a single apply_delta() and dropping the oldest frame is free
+	class rewind_buffer
+	{
+	public:
+		explicit rewind_buffer(u32 capacity) : _capacity{ capacity } { assert(capacity); }
+
+		// Take a snapshot of the world and add it as the newest frame
+		void push();
+		// Go back a number of frames and restore the world to that point
+		bool rewind(u32 frames = 1);
+		// Clear all frames
+		void clear();
+
+		// Number of frames we can go back to
+		u32 size() const { return _current.empty() ? 0 : (u32)_deltas.size() + 1; }
+		// Memory used by the stored frames in bytes
+		size_t memory_size() const;
+
+	private:
+		utl::vector<u8>					_current;
+		utl::vector<u8>					_scratch;
+		utl::deque<utl::vector<u8>>		_deltas; // Newest delta at the back
+		const u32						_capacity;
+	};
+}
@@ -0,0 +1,308 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "Compression.h"
+#include "../Core/JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace savage::content {
+	namespace {
+
+		// Each sequence is [token][more literal length][literals][u16 offset][more match length]
+		// The token has the literal length in the high 4 bits and the match length - min_match in the low 4 bits.
+		// A length of 15 continues with bytes that are added on until one is less than 255.
+		// The block always ends with literals so the decoder knows where to stop.
+		constexpr u32 min_match{ 4 };
+		constexpr u32 last_literals{ 5 };		// The last bytes are always literals
+		constexpr u32 match_safe_distance{ 12 };	// No match starts this close to the end
+		constexpr u32 max_offset{ 65535 };
+		constexpr u32 hash_bits{ 14 };
+		constexpr u32 stored_block{ 0x80000000 };
+		// A compressed block can't give more than this many bytes per byte (a length byte of 255 adds 255 bytes)
+		constexpr u64 max_ratio{ 255 };
+
+		u32 read_32(const u8* p)
+		{
+			u32 value;
+			memcpy(&value, p, sizeof(u32));
+			return value;
+		}
+
+		u32 hash(u32 sequence)
+		{
+			return (sequence * 2654435761u) >> (32 - hash_bits);
+		}
+
+		u8* write_length(u8* dst, u32 length)
+		{
+			for (; length >= 255; length -= 255) *dst++ = 255;
+			*dst++ = (u8)length;
+			return dst;
+		}
+
+		u8* write_sequence(u8* dst, const u8* literals, u32 literal_length, u32 offset, u32 match_length)
+		{
+			u8* const token{ dst++ };
+			*token = (u8)(std::min(literal_length, 15u) << 4);
+			if (literal_length >= 15) dst = write_length(dst, literal_length - 15);
+			memcpy(dst, literals, literal_length);
+			dst += literal_length;
+			if (!match_length) return dst; // Last literals
+
+			*dst++ = (u8)offset;
+			*dst++ = (u8)(offset >> 8);
+			const u32 length{ match_length - min_match };
+			*token |= (u8)std::min(length, 15u);
+			if (length >= 15) dst = write_length(dst, length - 15);
+			return dst;
+		}
+
+		// Read a length that goes on past the token. Returns false if it runs past the end
+		bool read_length(const u8*& src, const u8* const end, size_t& length)
+		{
+			u8 byte;
+			do {
+				if (src >= end) return false;
+				byte = *src++;
+				length += byte;
+			} while (byte == 255);
+			return true;
+		}
+
+		struct block_table
+		{
+			const compressed_header*	header;
+			const u8*					sizes;	// u32 per block
+			const u8*					blocks;
+		};
+
+		// Check the header against the blocks that are really there, so a broken or hostile file can't ask for
+		// more memory than its blocks can fill
+		bool read_block_table(const u8* data, size_t size, block_table& table)
+		{
+			if (!is_compressed(data, size)) return false;
+			compressed_header header;
+			memcpy(&header, data, sizeof(header));
+			if (header.version != compressed_version || !header.block_size || header.block_size >= stored_block) return false;
+			if (header.block_count != header.size / header.block_size + (header.size % header.block_size ? 1 : 0)) return false;
+			if (size < sizeof(header) + (u64)header.block_count * sizeof(u32)) return false;
+
+			table.header = (const compressed_header*)data;
+			table.sizes = data + sizeof(header);
+			table.blocks = table.sizes + header.block_count * sizeof(u32);
+
+			const u8* at{ table.blocks };
+			for (u32 i{ 0 }; i < header.block_count; ++i)
+			{
+				const u32 block_size{ read_32(table.sizes + i * sizeof(u32)) };
+				const u64 compressed_size{ block_size & ~stored_block };
+				const u64 out_size{ std::min((u64)header.block_size, header.size - (u64)i * header.block_size) };
+				if (compressed_size > (u64)(data + size - at)) return false;
+				if ((block_size & stored_block) ? compressed_size != out_size : out_size > compressed_size * max_ratio) return false;
+				at += compressed_size;
+			}
+			return true;
+		}
+
+	} // Anonymous namespace
+
+	size_t compress_block(const u8* src, size_t size, u8* dst)
+	{
+		u8* const dst_start{ dst };
+		const u8* const end{ src + size };
+		const u8* anchor{ src }; // Start of the literals not written yet
+
+		if (size > match_safe_distance)
+		{
+			// Last position seen for each hashed 4 bytes, as an offset from src
+			utl::vector<u32> table(1ull << hash_bits, u32_invalid_id);
+			const u8* const match_limit{ end - last_literals };
+			const u8* p{ src };
+
+			while (p < end - match_safe_distance)
+			{
+				const u32 sequence{ read_32(p) };
+				const u32 h{ hash(sequence) };
+				const u32 candidate{ table[h] };
+				table[h] = (u32)(p - src);
+
+				if (candidate == u32_invalid_id || (u32)(p - src) - candidate > max_offset || read_32(src + candidate) != sequence)
+				{
+					++p;
+					continue;
+				}
+
+				// Found a match, see how far it goes
+				const u8* match{ src + candidate };
+				const u8* q{ p + min_match };
+				const u8* m{ match + min_match };
+				while (q < match_limit && *q == *m) { ++q; ++m; }
+
+				dst = write_sequence(dst, anchor, (u32)(p - anchor), (u32)(p - match), (u32)(q - p));
+				p = anchor = q;
+			}
+		}
+
+		dst = write_sequence(dst, anchor, (u32)(end - anchor), 0, 0);
+		assert((size_t)(dst - dst_start) <= compress_bound(size));
+		return (size_t)(dst - dst_start);
+	}
+
+	bool decompress_block(const u8* src, size_t size, u8* dst, size_t dst_size)
+	{
+		const u8* const src_end{ src + size };
+		u8* const dst_start{ dst };
+		u8* const dst_end{ dst + dst_size };
+
+		while (src < src_end)
+		{
+			const u8 token{ *src++ };
+
+			// Copy the literals
+			size_t literal_length{ (size_t)(token >> 4) };
+			if (literal_length == 15 && !read_length(src, src_end, literal_length)) return false;
+			if ((size_t)(src_end - src) < literal_length || (size_t)(dst_end - dst) < literal_length) return false;
+			memcpy(dst, src, literal_length);
+			src += literal_length;
+			dst += literal_length;
+			if (src == src_end) break; // Last literals
+
+			// Copy the match. It can overlap with what it writes when the offset is less than the length
+			if (src_end - src < 2) return false;
+			const size_t offset{ (size_t)src[0] | ((size_t)src[1] << 8) };
+			src += 2;
+			size_t match_length{ (size_t)(token & 15) };
+			if (match_length == 15 && !read_length(src, src_end, match_length)) return false;
+			match_length += min_match;
+			if (!offset || offset > (size_t)(dst - dst_start) || (size_t)(dst_end - dst) < match_length) return false;
+
+			const u8* match{ dst - offset };
+			if (offset >= match_length)
+			{
+				memcpy(dst, match, match_length);
+				dst += match_length;
+			}
+			else
+			{
+				for (size_t i{ 0 }; i < match_length; ++i) *dst++ = *match++;
+			}
+		}
+		return dst == dst_end;
+	}
+
+	utl::vector<u8> compress(const u8* data, size_t size, u32 block_size /* = default_block_size */)
+	{
+		assert(block_size && block_size < stored_block);
+		compressed_header header{ compressed_magic, compressed_version, size, block_size, (u32)((size + block_size - 1) / block_size) };
+		const size_t table_size{ header.block_count * sizeof(u32) };
+
+		utl::vector<u8> result(sizeof(header) + table_size + compress_bound(size));
+		memcpy(result.data(), &header, sizeof(header));
+		u8* const sizes{ result.data() + sizeof(header) };
+		u8* dst{ sizes + table_size };
+
+		for (u32 i{ 0 }; i < header.block_count; ++i)
+		{
+			const u8* const block{ data + (size_t)i * block_size };
+			const u32 raw_size{ (u32)std::min((size_t)block_size, size - (size_t)i * block_size) };
+			u32 block_compressed_size{ (u32)compress_block(block, raw_size, dst) };
+			if (block_compressed_size >= raw_size)
+			{
+				// Keep it as is so the block is never bigger and costs only a copy to load
+				memcpy(dst, block, raw_size);
+				block_compressed_size = raw_size | stored_block;
+			}
+			memcpy(sizes + i * sizeof(u32), &block_compressed_size, sizeof(u32));
+			dst += block_compressed_size & ~stored_block;
+		}
+
+		result.resize(dst - result.data());
+		return result;
+	}
+
+	bool is_compressed(const u8* data, size_t size)
+	{
+		return size >= sizeof(compressed_header) && read_32(data) == compressed_magic;
+	}
+
+	u64 decompressed_size(const u8* data, size_t size)
+	{
+		block_table table;
+		return read_block_table(data, size, table) ? table.header->size : 0;
+	}
+
+	namespace {
+		// Shared by the jobs of one decompress() call. Each job takes the next block until there are none left
+		struct decompress_state
+		{
+			compressed_header		header;
+			const u8*				sizes;
+			const u8* const*		block_starts;
+			u8*						dst;
+			std::atomic<u32>		next_block{ 0 };
+			std::atomic<bool>		failed{ false };
+		};
+
+		void decompress_blocks(void* data)
+		{
+			decompress_state& s{ *(decompress_state*)data };
+			u32 i;
+			while ((i = s.next_block.fetch_add(1, std::memory_order_relaxed)) < s.header.block_count)
+			{
+				const u32 block_size{ read_32(s.sizes + i * sizeof(u32)) };
+				const size_t compressed_size{ (size_t)(s.block_starts[i + 1] - s.block_starts[i]) };
+				u8* const out{ s.dst + (size_t)i * s.header.block_size };
+				const size_t out_size{ (size_t)std::min((u64)s.header.block_size, s.header.size - (u64)i * s.header.block_size) };
+
+				// The table was checked, so a stored block has exactly the right size
+				if (block_size & stored_block)
+				{
+					memcpy(out, s.block_starts[i], out_size);
+				}
+				else if (!decompress_block(s.block_starts[i], compressed_size, out, out_size))
+				{
+					s.failed = true;
+					return;
+				}
+			}
+		}
+	} // Anonymous namespace
+
+	bool decompress(const u8* data, size_t size, u8* dst, u32 thread_count /* = 0 */)
+	{
+		block_table table;
+		if (!read_block_table(data, size, table)) return false;
+		const compressed_header header{ *table.header };
+
+		// Find where each block starts so they can all be done at once
+		utl::vector<const u8*> block_starts(header.block_count + 1);
+		block_starts[0] = table.blocks;
+		for (u32 i{ 0 }; i < header.block_count; ++i)
+		{
+			block_starts[i + 1] = block_starts[i] + (read_32(table.sizes + i * sizeof(u32)) & ~stored_block);
+		}
+
+		decompress_state state{ header, table.sizes, block_starts.data(), dst };
+
+		// The blocks are shared out as jobs when the job system can take them from this thread
+		u32 job_count{ 1 };
+		if (jobs::is_job_thread())
+		{
+			job_count = std::min(thread_count ? thread_count : jobs::thread_count(), header.block_count);
+		}
+
+		// This thread does its share too
+		std::atomic<u32> pending{ job_count ? job_count - 1 : 0 };
+		for (u32 i{ 1 }; i < job_count; ++i) jobs::submit("decompress", decompress_blocks, &state, &pending);
+		decompress_blocks(&state);
+		jobs::wait(pending);
+
+		return !state.failed;
+	}
+}
@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "CommonHeaders.h"
+
+// Block compression for content files. The data is cut into blocks of the same size that are
+// compressed on their own with an LZ4 style codec (byte aligned literal runs and matches, no
+// entropy coding) so they can be decompressed at the same time on all cores.
+//
+// File layout: [compressed_header][u32 size of each block][blocks]
+// A block with the stored_block bit set in its size was not worth compressing and is copied as is.
+namespace savage::content {
+
+	constexpr u32 compressed_magic{ 0x5a475653 }; // 'SVGZ'
+	constexpr u32 compressed_version{ 1 };
+	constexpr u32 default_block_size{ 256 * 1024 };
+
+	struct compressed_header
+	{
+		u32		magic;
+		u32		version;
+		u64		size;			// Size of the data before compression
+		u32		block_size;
+		u32		block_count;
+	};
+	static_assert(sizeof(compressed_header) == 24);
+
+	// Largest size compress_block() can write for size bytes
+	constexpr size_t compress_bound(size_t size) { return size + size / 255 + 16; }
+
+	// Compress one block. dst needs room for compress_bound(size) bytes. Returns the compressed size
+	size_t compress_block(const u8* src, size_t size, u8* dst);
+	// Decompress one block into exactly dst_size bytes. Returns false if the data is broken
+	bool decompress_block(const u8* src, size_t size, u8* dst, size_t dst_size);
+
+	// Compress data into the block file layout
+	utl::vector<u8> compress(const u8* data, size_t size, u32 block_size = default_block_size);
+	// True if the data starts with a compressed_header
+	bool is_compressed(const u8* data, size_t size);
+	// Size of the data once decompressed. 0 if it is not compressed or the header asks for more than its blocks can hold
+	u64 decompressed_size(const u8* data, size_t size);
+	// Decompress all blocks into dst, which needs decompressed_size() bytes. The blocks are shared out as jobs
+	// over up to thread_count threads (0 uses all threads of the job system). Called from a thread that can't
+	// run jobs (see jobs::is_job_thread()), all blocks are done on this thread. Returns false if the data is broken
+	bool decompress(const u8* data, size_t size, u8* dst, u32 thread_count = 0);
+}
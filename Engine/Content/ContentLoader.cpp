@@ -6,15 +6,24 @@ MIT License - see LICENSE file
 */
 
 #include "ContentLoader.h"
-#include "..\Components\Entity.h"
-#include "..\Components\Transform.h"
-#include "..\Components\Script.h"
+#include "../Components/Entity.h"
+#include "../Components/Transform.h"
+#include "../Components/Script.h"
+#include "../Utilities/Checksum.h"
+#include "../Utilities/LinearAllocator.h"
+#include "../Utilities/MathSIMD.h"
+#include "Compression.h"
 
 #if !defined(SHIPPING)
 
 #include <fstream>
 #include <filesystem>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#ifdef _WIN64
 #include <Windows.h>
+#endif // _WIN64
 
 namespace savage::content {
 	namespace {
@@ -23,20 +32,96 @@ namespace savage::content {
 		{
 			transform,
 			script,
+			static_transform,
 
 			count
 		};
 
+		// Each entity in game.bin starts with these
+		enum entity_flags : u32
+		{
+			is_static = 0x01, // Set in the editor for entities that never move
+		};
+
+		// game.bin starts with the entity count, or with this when it has static transforms
+		// [magic][version][chunk count][chunk bounds, 6 f32 each][entity count][entities]
+		constexpr u32 static_magic{ 0x42475653 }; // 'SVGB'
+		constexpr u32 static_version{ 1 };
+		constexpr f32 static_chunk_size{ 64.f }; // Static transforms in the same cell of this size share their bounds
+		constexpr u32 transform_size{ 9 * sizeof(f32) }; // Position, rotation and scale
+		constexpr u32 static_transform_size{ 4 * sizeof(u16) + 2 * sizeof(u32) };
+		u32 static_chunk_offset{ 0 }; // Index of the first chunk of the loaded game.bin
+
 		// Hold the entities
 		utl::vector<game_entity::entity> entities;
 		// Hold component information
 		transform::init_info transform_info{};
 		script::init_info script_info{};
 
+		// Same as XMQuaternionRotationRollPitchYawFromVector (roll around z, then pitch around x, then yaw around y)
+		// but without DirectXMath so the loader also works on Linux
+		void euler_to_quaternion(const f32 (&pitch_yaw_roll)[3], f32 (&quat)[4])
+		{
+			const math::v3 euler{ &pitch_yaw_roll[0] };
+			math::v4 q{};
+			math::euler_to_quat_batch(&euler, &q, 1);
+			memcpy(&quat[0], &q.x, sizeof(quat));
+		}
+
+		// Set the working directory to where the executable is so game.bin can be found
+		bool set_working_directory()
+		{
+#ifdef _WIN64
+			wchar_t path[MAX_PATH]; // get the 260 Windows path max length
+			const u32 length{ GetModuleFileName(0, &path[0], MAX_PATH) }; // Get the full path to the executable
+			if (!length || GetLastError() == ERROR_INSUFFICIENT_BUFFER) return false; // Throw an error
+			std::filesystem::path p{ path };
+#else
+			std::error_code error{};
+			const std::filesystem::path p{ std::filesystem::read_symlink("/proc/self/exe", error) };
+			if (error) return false;
+#endif // _WIN64
+			std::error_code error_code{};
+			std::filesystem::current_path(p.parent_path(), error_code);
+			return !error_code;
+		}
+
+		// Read a u32 that may not be aligned and move the read pointer
+		u32 read_u32(const u8*& data)
+		{
+			u32 value;
+			memcpy(&value, data, sizeof(u32));
+			data += sizeof(u32);
+			return value;
+		}
+
+		utl::vector<u8> read_file(const char* file_name)
+		{
+			std::ifstream file(file_name, std::ios::in | std::ios::binary | std::ios::ate);
+			if (!file) return {};
+			utl::vector<u8> data((size_t)file.tellg());
+			file.seekg(0);
+			file.read((char*)data.data(), data.size());
+			return data;
+		}
+
+		// Read a file that may be block compressed. Compressed files are decompressed as jobs when the job system runs
+		utl::vector<u8> read_content_file(const char* file_name)
+		{
+			utl::vector<u8> file{ read_file(file_name) };
+			if (!is_compressed(file.data(), file.size())) return file;
+
+			// The size is checked against the blocks first, so a broken header can't make us allocate any amount
+			const u64 size{ decompressed_size(file.data(), file.size()) };
+			if (!size) return {};
+			utl::vector<u8> data(size);
+			if (!decompress(file.data(), file.size(), data.data())) return {};
+			return data;
+		}
+
 		// Define reading a transform from binary
 		bool read_transform(const u8*& data, game_entity::entity_info& info)
 		{
-			using namespace DirectX;
 			f32 rotation[3];
 
 			assert(!info.transform); // Check if pointer is set
@@ -50,11 +135,8 @@ namespace savage::content {
 			data += sizeof(transform_info.scale); // Move the read pointer
 
 			// Convert the rotation to quat
-			XMFLOAT3A rot{ &rotation[0] };
-			XMVECTOR quat{ XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3A(&rot)) };
-			XMFLOAT4A rot_quart{};
-			XMStoreFloat4A(&rot_quart, quat);
-			memcpy(&transform_info.rotation[0], &rot_quart.x, sizeof(transform_info.rotation)); // Copy the data from the temp value
+			euler_to_quaternion(rotation, transform_info.rotation);
+			transform_info.static_chunk = u32_invalid_id;
 
 			// Set a pointer to the transform info 
 			info.transform = &transform_info;
@@ -66,7 +148,7 @@ namespace savage::content {
 		bool read_script(const u8*& data, game_entity::entity_info& info)
 		{
 			assert(!info.script);
-			const u32 name_length{ *data }; data += sizeof(u32); // Read how long the name of the scrip is 
+			const u32 name_length{ read_u32(data) }; // Read how long the name of the scrip is 
 			if (!name_length) return false; // Should not be zero
 			// Script names should never be more than 255 characters if so something very wrong
 			assert(name_length < 256);
@@ -84,6 +166,30 @@ namespace savage::content {
 			return script_info.script_creator != nullptr;
 		}
 
+		// Define reading a static transform (made by pack_static_transforms()) from binary
+		bool read_static_transform(const u8*& data, game_entity::entity_info& info)
+		{
+			assert(!info.transform);
+			transform::packed_transform packed;
+			memcpy(&packed, data, sizeof(packed));
+			data += static_transform_size;
+
+			const transform::static_storage_view statics{ transform::static_view() };
+			packed.chunk += static_chunk_offset;
+			if (packed.chunk >= statics.chunk_count) return false;
+
+			math::v3 position, scale;
+			math::v4 rotation;
+			transform::unpack(packed, statics.chunks[packed.chunk], position, rotation, scale);
+			memcpy(&transform_info.position[0], &position, sizeof(transform_info.position));
+			memcpy(&transform_info.rotation[0], &rotation, sizeof(transform_info.rotation));
+			memcpy(&transform_info.scale[0], &scale, sizeof(transform_info.scale));
+			transform_info.static_chunk = packed.chunk;
+
+			info.transform = &transform_info;
+			return true;
+		}
+
 		// Returns a bool to show if the content loaded. Takes a pointer reference and an entity info.
 		using component_reader = bool(*)(const u8*&, game_entity::entity_info&);
 		// Array of script creators
@@ -91,40 +197,60 @@ namespace savage::content {
 		{
 			read_transform,
 			read_script,
+			read_static_transform,
 		};
 		static_assert(_countof(component_readers) == component_type::count); // Each component needs a reader
 
-	} // Anonymous namespace
+		// Move past an entity without loading it. Returns false if the data is broken
+		bool skip_entity(const u8*& at, const u8* const end)
+		{
+			constexpr u32 su32{ sizeof(u32) };
+			if (end - at < 2 * su32) return false;
+			at += su32; // Entity flags
+			const u32 num_components{ read_u32(at) };
+			for (u32 component_index{ 0 }; component_index < num_components; ++component_index)
+			{
+				if (end - at < su32) return false;
+				switch (read_u32(at))
+				{
+				case component_type::transform: at += transform_size; break;
+				case component_type::static_transform: at += static_transform_size; break;
+				case component_type::script: if (end - at < su32) return false; at += read_u32(at); break; // Name
+				default: return false;
+				}
+				if (at > end) return false;
+			}
+			return true;
+		}
 
-	bool load_game()
-	{
-		// Set working directory to the executable path
-		wchar_t path[MAX_PATH]; // get the 260 Windows path max length
-		const u32 length{ GetModuleFileName(0, &path[0], MAX_PATH) }; // Get the full path to the executable
-		if (!length || GetLastError() == ERROR_INSUFFICIENT_BUFFER) return false; // Throw an error
-		std::filesystem::path p{ path };
-		SetCurrentDirectory(p.parent_path().wstring().c_str());
-
-		// Read game.bin and create the entities
-		std::ifstream game("game.bin", std::ios::in | std::ios::binary);
-		utl::vector<u8> buffer(std::istreambuf_iterator<char>(game), {});
-		assert(buffer.size()); // Should have a size
-		const u8* at{ buffer.data() };
-		constexpr u32 su32{ sizeof(u32) };
-		const u32 num_entities{ *at }; at += su32; // read the number of entities
-		if (!num_entities) return false;
+		// Find the transform of an entity that was checked by skip_entity(). Returns a pointer to its data or nullptr
+		const u8* find_transform(const u8* at)
+		{
+			at += sizeof(u32); // Entity flags
+			const u32 num_components{ read_u32(at) };
+			for (u32 component_index{ 0 }; component_index < num_components; ++component_index)
+			{
+				switch (read_u32(at))
+				{
+				case component_type::transform: return at;
+				case component_type::static_transform: at += static_transform_size; break;
+				case component_type::script: at += read_u32(at); break; // Name
+				default: assert(false); return nullptr;
+				}
+			}
+			return nullptr;
+		}
 
-		// Load the entities
-		for (u32 entity_index{ 0 }; entity_index < num_entities; ++entity_index)
+		bool load_entity(const u8* at)
 		{
 			game_entity::entity_info info{}; // Define the entity info for each entity
-			const u32 entity_types{ *at }; at += su32; // Read the entity type
-			const u32 num_components{ *at }; at += su32; // read the number of components
+			[[maybe_unused]] const u32 flags{ read_u32(at) }; // Read the entity flags
+			const u32 num_components{ read_u32(at) }; // read the number of components
 			if (!num_components) return false;
 
 			for (u32 component_index{ 0 }; component_index < num_components; ++component_index)
 			{
-				const u32 component_type{ *at }; at += su32;
+				const u32 component_type{ read_u32(at) };
 				assert(component_type < component_type::count); // Needs to be in the right range
 				if (!component_readers[component_type](at, info)) return false;
 			}
@@ -134,10 +260,113 @@ namespace savage::content {
 			game_entity::entity entity{ game_entity::create(info) }; // Try and create the entity
 			if (!entity.is_valid()) return false; // Check if it has a valid ID
 			entities.emplace_back(entity); // Put the entity in the array of entities
+			return true;
+		}
+
+		// game.patch holds the entities the editor changed since it last wrote all of game.bin (see Project.SaveToBinary)
+		// [magic][version][checksum of game.bin][number of records]
+		// then for each record [slot][size][entity data], a size of 0 removes the entity in that slot.
+		// New entities come right after the ones in game.bin, so a slot is always below entities + records
+		constexpr u32 patch_magic{ 0x50475653 }; // 'SVGP'
+		constexpr u32 patch_version{ 1 };
+
+		// Replace, add and remove entities. Returns false if the patch is broken or was made for another game.bin.
+		// All records are checked before any is applied, so entity_data is left as it was then
+		bool apply_patch(const utl::vector<u8>& patch, u32 base_checksum, utl::vector<const u8*, utl::scratch_allocator<const u8*>>& entity_data)
+		{
+			constexpr u32 su32{ sizeof(u32) };
+			const u8* at{ patch.data() };
+			const u8* const end{ patch.data() + patch.size() };
+			if (patch.size() < 4 * su32) return false;
+			if (read_u32(at) != patch_magic || read_u32(at) != patch_version) return false;
+			if (read_u32(at) != base_checksum) return false; // game.bin was changed after the patch was made
+
+			const u32 num_records{ read_u32(at) };
+			if (num_records > (u64)(end - at) / (2 * su32)) return false;
+			const u64 max_slots{ (u64)entity_data.size() + num_records };
+			const u8* const records{ at };
+			for (u32 i{ 0 }; i < num_records; ++i)
+			{
+				if (end - at < 2 * su32) return false;
+				if (read_u32(at) >= max_slots) return false;
+				const u32 size{ read_u32(at) };
+				if ((u64)(end - at) < size) return false;
+				const u8* entity_end{ at };
+				if (size && (!skip_entity(entity_end, at + size) || entity_end != at + size)) return false;
+				at += size;
+			}
+			if (at != end) return false;
+
+			at = records;
+			for (u32 i{ 0 }; i < num_records; ++i)
+			{
+				const u32 slot{ read_u32(at) };
+				const u32 size{ read_u32(at) };
+				if (slot >= entity_data.size()) entity_data.resize(slot + 1, nullptr);
+				entity_data[slot] = size ? at : nullptr;
+				at += size;
+			}
+			return true;
+		}
+
+	} // Anonymous namespace
+
+	bool load_game()
+	{
+		// Set working directory to the executable path
+		if (!set_working_directory()) return false;
+
+		// Read game.bin and find where each entity starts. The patch checksum is of the decompressed data
+		const utl::vector<u8> buffer{ read_content_file("game.bin") };
+		assert(buffer.size()); // Should have a size
+		if (buffer.size() < sizeof(u32)) return false;
+		const u8* at{ buffer.data() };
+		const u8* const end{ buffer.data() + buffer.size() };
+		u32 num_entities{ read_u32(at) }; // read the number of entities
+
+		// Register the chunk bounds of the static transforms
+		static_chunk_offset = transform::static_view().chunk_count;
+		if (num_entities == static_magic)
+		{
+			if (end - at < 2 * (s64)sizeof(u32) || read_u32(at) != static_version) return false;
+			const u32 num_chunks{ read_u32(at) };
+			if ((u64)(end - at) < (u64)num_chunks * 6 * sizeof(f32) + sizeof(u32)) return false;
+			for (u32 i{ 0 }; i < num_chunks; ++i)
+			{
+				f32 bounds[6];
+				memcpy(&bounds[0], at, sizeof(bounds));
+				at += sizeof(bounds);
+				transform::add_static_chunk({ bounds[0], bounds[1], bounds[2] }, { bounds[3], bounds[4], bounds[5] });
+			}
+			num_entities = read_u32(at);
+		}
+		if (!num_entities) return false;
+
+		// Only needed while loading
+		utl::scratch scratch{};
+		utl::vector<const u8*, utl::scratch_allocator<const u8*>> entity_data(num_entities, scratch.allocator<const u8*>());
+		for (u32 entity_index{ 0 }; entity_index < num_entities; ++entity_index)
+		{
+			entity_data[entity_index] = at;
+			if (!skip_entity(at, end)) return false;
+		}
+		// Check if we read all the data in the buffer
+		assert(at == end);
+
+		// Put the changes the editor made since the last full export on top. A patch that is broken or was made
+		// for another game.bin is stale, so it is deleted and game.bin is loaded as it is
+		const utl::vector<u8> patch{ read_file("game.patch") };
+		if (patch.size() && !apply_patch(patch, utl::crc32(buffer.data(), buffer.size()), entity_data))
+		{
+			std::error_code error{};
+			std::filesystem::remove("game.patch", error);
 		}
 
-		// Check if we read all the data in the buffer then return true
-		assert(at == buffer.data() + buffer.size());
+		// Load the entities
+		for (const u8* data : entity_data)
+		{
+			if (data && !load_entity(data)) return false;
+		}
 		return true;
 	}
 
@@ -148,6 +377,95 @@ namespace savage::content {
 		{
 			game_entity::remove(entity.get_id());
 		}
+		entities.clear();
+		transform::remove_static_chunks();
+	}
+
+	utl::vector<u8> pack_static_transforms(const utl::vector<u8>& game_bin)
+	{
+		const u8* at{ game_bin.data() };
+		const u8* const end{ game_bin.data() + game_bin.size() };
+		if (game_bin.size() < sizeof(u32)) return {};
+		const u32 num_entities{ read_u32(at) };
+		if (num_entities == static_magic) return game_bin; // Already packed
+
+		struct entity_data
+		{
+			const u8*	start;
+			const u8*	end;
+			const u8*	transform{ nullptr };
+			u32			chunk{ u32_invalid_id }; // Only set for entities that get a static transform
+		};
+		utl::vector<entity_data> entity_list(num_entities);
+		utl::vector<transform::static_chunk> chunks;
+		std::unordered_map<u64, u32> chunk_of_cell;
+
+		// Only entities the editor marked as static are packed. They also need a uniform scale
+		for (auto& entity : entity_list)
+		{
+			entity.start = at;
+			if (!skip_entity(at, end)) return {};
+			entity.end = at;
+
+			const u8* data{ entity.start };
+			if (!(read_u32(data) & entity_flags::is_static)) continue;
+			entity.transform = find_transform(entity.start);
+			if (!entity.transform) continue;
+			f32 transform[9];
+			memcpy(&transform[0], entity.transform, sizeof(transform));
+			if (transform[6] != transform[7] || transform[6] != transform[8]) continue;
+
+			const math::v3 position{ transform[0], transform[1], transform[2] };
+			auto cell = [](f32 v) { return (u64)((s64)floorf(v / static_chunk_size) & 0x1fffff); };
+			const u64 key{ (cell(position.x) << 42) | (cell(position.y) << 21) | cell(position.z) };
+			auto [it, is_new] = chunk_of_cell.try_emplace(key, (u32)chunks.size());
+			if (is_new) chunks.push_back({ position, position });
+			transform::static_chunk& chunk{ chunks[it->second] };
+			chunk.min = { std::min(chunk.min.x, position.x), std::min(chunk.min.y, position.y), std::min(chunk.min.z, position.z) };
+			chunk.max = { std::max(chunk.max.x, position.x), std::max(chunk.max.y, position.y), std::max(chunk.max.z, position.z) };
+			entity.chunk = it->second;
+		}
+		if (at != end) return {};
+
+		utl::vector<u8> result;
+		auto write = [&result](const void* data, size_t size) {
+			result.insert(result.end(), (const u8*)data, (const u8*)data + size);
+		};
+		auto write_u32 = [&write](u32 value) { write(&value, sizeof(u32)); };
+
+		write_u32(static_magic);
+		write_u32(static_version);
+		write_u32((u32)chunks.size());
+		for (const auto& chunk : chunks)
+		{
+			const f32 bounds[6]{ chunk.min.x, chunk.min.y, chunk.min.z, chunk.max.x, chunk.max.y, chunk.max.z };
+			write(bounds, sizeof(bounds));
+		}
+		write_u32(num_entities);
+
+		for (const auto& entity : entity_list)
+		{
+			if (entity.chunk == u32_invalid_id)
+			{
+				write(entity.start, entity.end - entity.start);
+				continue;
+			}
+
+			f32 transform[9];
+			memcpy(&transform[0], entity.transform, sizeof(transform));
+			const f32 euler[3]{ transform[3], transform[4], transform[5] };
+			f32 quat[4];
+			euler_to_quaternion(euler, quat);
+
+			const transform::packed_transform packed{ transform::pack({ transform[0], transform[1], transform[2] },
+				{ quat[0], quat[1], quat[2], quat[3] }, transform[6], chunks[entity.chunk], entity.chunk) };
+			// Only the transform is replaced, the other components are copied as they are
+			write(entity.start, entity.transform - sizeof(u32) - entity.start);
+			write_u32(component_type::static_transform);
+			write(&packed, static_transform_size);
+			write(entity.transform + transform_size, entity.end - entity.transform - transform_size);
+		}
+		return result;
 	}
 }
 
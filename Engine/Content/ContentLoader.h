@@ -12,5 +12,10 @@ MIT License - see LICENSE file
 namespace savage::content {
 	bool load_game();
 	void unload_game();
+
+	// Store the transforms of entities the editor marked as static (if they have a uniform scale) in the compact
+	// form of transform::packed_transform, grouped into chunks by where they are. Returns an empty vector if
+	// game_bin is broken
+	utl::vector<u8> pack_static_transforms(const utl::vector<u8>& game_bin);
 }
 #endif // !defined(SHIPPING)
\ No newline at end of file
@@ -0,0 +1,134 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "GameCode.h"
+#include "../Components/Script.h"
+#include "../Platform/Platform.h"
+
+#if !defined(SHIPPING)
+
+#include <filesystem>
+#include <string>
+
+namespace savage::content {
+	namespace {
+		// Exported by the game code (see GameEntity.h)
+		using get_script_creator_fn = script::detail::script_creator(*)(size_t);
+
+		struct game_code_module
+		{
+			void*					module{ nullptr };
+			get_script_creator_fn	get_script_creator{ nullptr };
+			std::filesystem::path	copy_path{};
+		};
+
+		game_code_module	game_code{};
+		u32					copy_count{ 0 };
+
+		// Tags of the creators handed out from the loaded game code so its scripts can be found after a reload
+		std::unordered_map<script::detail::script_creator, size_t> creator_tags;
+
+		// Load a copy of the library. The original file stays free so the next build can overwrite it
+		game_code_module load_copy(const char* path)
+		{
+			const std::filesystem::path original{ path };
+			std::filesystem::path copy{ original };
+			copy.replace_extension(".hot" + std::to_string(++copy_count) + original.extension().string());
+
+			std::error_code error{};
+			std::filesystem::copy_file(original, copy, std::filesystem::copy_options::overwrite_existing, error);
+			if (error) return {};
+
+			game_code_module result{};
+			result.module = platform::load_module(copy.string().c_str());
+			if (result.module)
+			{
+				result.get_script_creator = (get_script_creator_fn)platform::get_module_symbol(result.module, "get_script_creator");
+				result.copy_path = copy;
+				if (result.get_script_creator) return result;
+				platform::unload_module(result.module);
+			}
+			std::filesystem::remove(copy, error);
+			return {};
+		}
+
+		void unload(game_code_module& code)
+		{
+			if (!code.module) return;
+			[[maybe_unused]] const bool result{ platform::unload_module(code.module) };
+			assert(result);
+			std::error_code error{};
+			std::filesystem::remove(code.copy_path, error); // Not a problem if it fails, the name is not used again
+			code = {};
+		}
+
+		size_t tag_of(script::detail::script_creator creator)
+		{
+			const auto tag{ creator_tags.find(creator) };
+			return tag != creator_tags.end() ? tag->second : 0;
+		}
+
+		script::detail::script_creator creator_of(size_t tag)
+		{
+			assert(game_code.get_script_creator);
+			const script::detail::script_creator creator{ game_code.get_script_creator(tag) };
+			if (creator) creator_tags[creator] = tag;
+			return creator;
+		}
+
+	} // Anonymous namespace
+
+	bool load_game_code(const char* path)
+	{
+		assert(path);
+		if (game_code.module) return false; // Already loaded
+		game_code = load_copy(path);
+		if (!game_code.module) return false;
+		script::set_module_lookups(tag_of, creator_of);
+		return true;
+	}
+
+	void unload_game_code()
+	{
+		script::set_module_lookups(nullptr, nullptr);
+		unload(game_code);
+		creator_tags.clear();
+	}
+
+	bool reload_game_code(const char* path)
+	{
+		assert(path);
+		if (!game_code.module) return load_game_code(path);
+
+		// Load the new code before anything is thrown away so a bad build keeps the old code running
+		game_code_module new_code{ load_copy(path) };
+		if (!new_code.module) return false;
+
+		// Save and destroy the scripts while their code is still loaded
+		utl::vector<u8> saved;
+		script::unload_module_scripts(tag_of, saved);
+		unload(game_code);
+		creator_tags.clear();
+
+		game_code = new_code;
+		script::reload_module_scripts(creator_of, saved);
+		return true;
+	}
+
+	script::detail::script_creator get_game_code_script_creator(const char* name)
+	{
+		if (!game_code.module) return nullptr;
+		return creator_of(script::detail::string_hash()(name));
+	}
+
+	void* get_game_code_symbol(const char* name)
+	{
+		return game_code.module ? platform::get_module_symbol(game_code.module, name) : nullptr;
+	}
+}
+
+#endif // !defined(SHIPPING)
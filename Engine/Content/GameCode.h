@@ -0,0 +1,27 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "CommonHeaders.h"
+#include "../Components/ComponentsCommon.h"
+
+#if !defined(SHIPPING)
+namespace savage::content {
+	// Game code built as a shared library (used by the editor and for hot reload).
+	// A copy of the library is loaded so the original can be rebuilt while the game code is in use.
+	bool load_game_code(const char* path);
+	void unload_game_code();
+	// Swap in rebuilt game code. The state of live scripts is saved, the old code is unloaded and the scripts
+	// are made again from the new code using their registered tag. If the new code fails to load the old one stays
+	bool reload_game_code(const char* path);
+
+	// Get a script creator from the game code by the name of the script class. Returns nullptr if there is none
+	script::detail::script_creator get_game_code_script_creator(const char* name);
+	// Get any other export of the game code. Returns nullptr if it is not loaded or has no such export
+	void* get_game_code_symbol(const char* name);
+}
+#endif // !defined(SHIPPING)
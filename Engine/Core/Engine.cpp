@@ -7,17 +7,35 @@ MIT License - see LICENSE file
 
 #ifndef SHIPPING
 
-#include "..\Content\ContentLoader.h"
-#include "..\Components\Script.h"
-#include "..\Platform\PlatformTypes.h"
-#include "..\Platform\Platform.h"
-#include "..\Graphics\Renderer.h"
+#include "../Content/ContentLoader.h"
+#include "../Components/Script.h"
+#include "../Platform/PlatformTypes.h"
+#include "../Platform/Platform.h"
+#include "../Graphics/Renderer.h"
+#include "../Spatial/SpatialIndex.h"
+#include "../Utilities/LinearAllocator.h"
+#include "JobSystem.h"
 #include <thread>
 
 using namespace savage;
 
 graphics::render_surface game_window{};
 
+namespace {
+	// The work of one frame. Scripts run on the main thread because game code expects to, the systems that
+	// read the transforms they wrote run after them on the workers
+	jobs::graph frame{};
+
+	void build_frame()
+	{
+		frame.clear();
+		const u32 scripts_job{ frame.add("scripts", [](void*) { script::update(10.f); }, nullptr, jobs::thread_affinity::main_thread) };
+		const u32 spatial_job{ frame.add("spatial index", [](void*) { spatial::update(); }) };
+		frame.depend(spatial_job, scripts_job);
+	}
+} // Anonymous namespace
+
+#ifdef _WIN64
 namespace {
 	LRESULT win_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 	{
@@ -44,34 +62,61 @@ namespace {
 		return DefWindowProc(hwnd, msg, wparam, lparam);
 	}
 } // Anonymous namespace
+#endif // _WIN64
 
 bool engine_intialize()
 {
-	// Load the game then return the result
-	if (!content::load_game()) return false;
+	// Start the jobs first so loading can use them
+	if (!jobs::initialize()) return false;
+
+	// Load the game then return the result. The workers have to be joined on every way out from here
+	if (!content::load_game())
+	{
+		jobs::shutdown();
+		return false;
+	}
 	
 	// Set the window info
+#ifdef _WIN64
 	platform::window_init_info info
 	{
 		&win_proc, nullptr, L"Savage Game" // TODO: Get the name from the game project
 	};
+#else
+	// Headless, the window is a virtual surface with no message handling
+	platform::window_init_info info
+	{
+		nullptr, L"Savage Game" // TODO: Get the name from the game project
+	};
+#endif // _WIN64
 
 	// Make the window
 	game_window.window = platform::create_window(&info);
-	if (!game_window.window.is_valid()) return false;
+	if (!game_window.window.is_valid())
+	{
+		jobs::shutdown();
+		content::unload_game();
+		return false;
+	}
+
+	build_frame();
 
 	return true;
 }
 
 void engine_update()
 {
-	script::update(10.f);
+	// Frame arenas of all threads move on to their next buffer
+	utl::next_frame();
+	frame.run();
 	// Sleep for 10ms
 	std::this_thread::sleep_for(std::chrono::milliseconds(10));
 }
 
 void engine_shutdown()
 {
+	frame.clear();
+	jobs::shutdown();
 	// Unload the game
 	platform::remove_window(game_window.window.get_id());
 	content::unload_game();
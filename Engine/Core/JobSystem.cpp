@@ -0,0 +1,772 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "JobSystem.h"
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+
+#if USE_FIBERS
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+#endif
+
+#ifdef _MSC_VER
+#define NO_INLINE __declspec(noinline)
+#else
+#define NO_INLINE __attribute__((noinline))
+#endif
+
+#if USE_FIBERS && defined(__x86_64__)
+// Save the registers the caller has to keep (System V) on the stack, store the stack pointer in *from and
+// continue on the stack in to. A new fiber's stack is made to look like it was switched away from at the
+// start of fiber_main()
+extern "C" void savage_switch_fiber(void** from, void* to);
+asm(R"(
+	.text
+	.globl savage_switch_fiber
+	.type savage_switch_fiber, @function
+savage_switch_fiber:
+	pushq %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $8, %rsp
+	stmxcsr (%rsp)
+	fnstcw 4(%rsp)
+	movq %rsp, (%rdi)
+	movq %rsi, %rsp
+	ldmxcsr (%rsp)
+	fldcw 4(%rsp)
+	addq $8, %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size savage_switch_fiber, .-savage_switch_fiber
+	.section .note.GNU-stack,"",@progbits
+	.text
+)");
+#endif
+
+namespace savage::jobs {
+	namespace {
+
+		using node = graph::node;
+
+		// Work stealing queue (Chase and Lev). The owner pushes and pops at the bottom, other threads steal
+		// from the top. When it is full the owner copies the jobs to a buffer twice the size. Thieves may still
+		// read the old buffer, so buffers are only freed with the queue
+		class job_deque
+		{
+		public:
+			static constexpr s64 initial_capacity{ 1 << 10 };
+
+			job_deque()
+			{
+				_buffers.emplace_back(std::make_unique<buffer>(initial_capacity));
+				_buffer.store(_buffers.back().get(), std::memory_order_relaxed);
+			}
+
+			void push(node* n)
+			{
+				const s64 b{ _bottom.load(std::memory_order_relaxed) };
+				const s64 t{ _top.load(std::memory_order_acquire) };
+				buffer* jobs{ _buffer.load(std::memory_order_relaxed) };
+				if (b - t >= jobs->capacity) jobs = grow(jobs, t, b);
+				jobs->put(b, n);
+				std::atomic_thread_fence(std::memory_order_release);
+				_bottom.store(b + 1, std::memory_order_relaxed);
+			}
+
+			node* pop()
+			{
+				const s64 b{ _bottom.load(std::memory_order_relaxed) - 1 };
+				buffer* const jobs{ _buffer.load(std::memory_order_relaxed) };
+				_bottom.store(b, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				s64 t{ _top.load(std::memory_order_relaxed) };
+				if (t > b)
+				{
+					_bottom.store(b + 1, std::memory_order_relaxed);
+					return nullptr;
+				}
+
+				node* n{ jobs->get(b) };
+				if (t == b)
+				{
+					// Last job, a thief could be taking it at the same time
+					if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) n = nullptr;
+					_bottom.store(b + 1, std::memory_order_relaxed);
+				}
+				return n;
+			}
+
+			node* steal()
+			{
+				s64 t{ _top.load(std::memory_order_acquire) };
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				const s64 b{ _bottom.load(std::memory_order_acquire) };
+				if (t >= b) return nullptr;
+				node* const n{ _buffer.load(std::memory_order_acquire)->get(t) };
+				return _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) ? n : nullptr;
+			}
+
+		private:
+			struct buffer
+			{
+				explicit buffer(s64 size) : capacity{ size }, jobs{ std::make_unique<std::atomic<node*>[]>((size_t)size) } {}
+				node* get(s64 i) const { return jobs[i & (capacity - 1)].load(std::memory_order_acquire); }
+				void put(s64 i, node* n) { jobs[i & (capacity - 1)].store(n, std::memory_order_release); }
+
+				const s64								capacity;
+				std::unique_ptr<std::atomic<node*>[]>	jobs;
+			};
+
+			// Only called by the owner, so nothing is pushed or popped while the jobs are copied
+			buffer* grow(buffer* old, s64 top, s64 bottom)
+			{
+				_buffers.emplace_back(std::make_unique<buffer>(old->capacity * 2));
+				buffer* const jobs{ _buffers.back().get() };
+				for (s64 i{ top }; i < bottom; ++i) jobs->put(i, old->get(i));
+				_buffer.store(jobs, std::memory_order_release);
+				return jobs;
+			}
+
+			alignas(64) std::atomic<s64>			_top{ 0 };
+			alignas(64) std::atomic<s64>			_bottom{ 0 };
+			std::atomic<buffer*>					_buffer{ nullptr };
+			utl::vector<std::unique_ptr<buffer>>	_buffers;	// Every buffer ever used, owned by the queue
+		};
+
+#if USE_FIBERS
+		// Stacks come straight from the OS with a page below them that can't be touched,
+		// so a fiber that runs out of stack crashes right away instead of writing over memory
+		class fiber_stack_allocator
+		{
+		public:
+			explicit fiber_stack_allocator(size_t stack_size)
+			{
+				const size_t page{ (size_t)sysconf(_SC_PAGESIZE) };
+				_page_size = page;
+				_stack_size = (stack_size + page - 1) & ~(page - 1);
+			}
+
+			u8* allocate()
+			{
+				void* const memory{ mmap(nullptr, _stack_size + _page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0) };
+				if (memory == MAP_FAILED) return nullptr;
+				mprotect(memory, _page_size, PROT_NONE);
+				return (u8*)memory + _page_size;
+			}
+
+			void free(u8* stack)
+			{
+				munmap(stack - _page_size, _stack_size + _page_size);
+			}
+
+			constexpr size_t stack_size() const { return _stack_size; }
+
+		private:
+			size_t _page_size;
+			size_t _stack_size;
+		};
+
+#if defined(__x86_64__)
+		using fiber_context = void*; // Stack pointer saved by savage_switch_fiber()
+		void switch_context(fiber_context& from, fiber_context& to) { savage_switch_fiber(&from, to); }
+#else
+		using fiber_context = ucontext_t;
+		void switch_context(fiber_context& from, fiber_context& to) { swapcontext(&from, &to); }
+#endif
+#endif
+
+		enum class fiber_state : u32
+		{
+			running,
+			done,
+			waiting,
+		};
+
+		struct fiber
+		{
+#if USE_FIBERS
+			fiber_context				context;
+#endif
+			u8*							stack;
+			node*						job;
+			fiber_state					state;
+			const std::atomic<u32>*		wait_for;	// Resume once it's 0, or right away if nullptr
+		};
+
+		struct trace_event
+		{
+			const char*	name;
+			s64			start;
+			s64			end;
+		};
+
+		struct worker
+		{
+			job_deque					jobs;
+			utl::vector<trace_event>	trace;
+			std::thread					thread;
+#if USE_FIBERS
+			fiber_context				scheduler;	// Where the thread was before it switched to a fiber
+#endif
+			fiber*						current{ nullptr };
+		};
+
+		// Worker 0 is the main thread
+		utl::vector<std::unique_ptr<worker>>	workers;
+		thread_local u32						worker_index{ u32_invalid_id };
+
+		// Jobs that only the main thread may run
+		std::mutex								main_mutex;
+		utl::vector<node*>						main_jobs;
+		std::atomic<u32>						main_job_count{ 0 };
+
+		// Workers sleep when there is nothing to do and wake up when jobs are pushed
+		std::mutex								sleep_mutex;
+		std::condition_variable					wake_up;
+		std::atomic<u32>						sleeping{ 0 };
+		std::atomic<u32>						work_signal{ 0 };
+		std::atomic<bool>						running{ false };
+
+		// Nodes for jobs from submit()
+		std::mutex								free_nodes_mutex;
+		utl::vector<std::unique_ptr<node>>		all_nodes;
+		utl::vector<node*>						free_nodes;
+
+		// Fibers that aren't running a job and fibers that wait
+		bool									use_fibers{ false };
+		std::mutex								fiber_mutex;
+		utl::vector<std::unique_ptr<fiber>>		all_fibers;
+		utl::vector<fiber*>						free_fibers;
+		utl::vector<fiber*>						waiting_fibers;
+		std::atomic<u32>						waiting_count{ 0 };
+#if USE_FIBERS
+		std::unique_ptr<fiber_stack_allocator>	stacks;
+#endif
+
+		std::atomic<bool>						tracing{ false };
+		std::chrono::steady_clock::time_point	trace_start;
+
+		// A fiber can go on on another thread after it waited. The compiler may keep the address of a
+		// thread_local around across a switch, so code that runs on fibers reads the worker through here
+		NO_INLINE u32 current_worker()
+		{
+			return worker_index;
+		}
+
+		s64 trace_time()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - trace_start).count();
+		}
+
+		void signal_work()
+		{
+			work_signal.fetch_add(1, std::memory_order_seq_cst);
+			if (sleeping.load(std::memory_order_seq_cst))
+			{
+				std::lock_guard lock{ sleep_mutex };
+				wake_up.notify_all();
+			}
+		}
+
+		void push_ready(node* n)
+		{
+			if (n->affinity == thread_affinity::main_thread)
+			{
+				{
+					std::lock_guard lock{ main_mutex };
+					main_jobs.push_back(n);
+				}
+				main_job_count.fetch_add(1, std::memory_order_release);
+			}
+			else
+			{
+				workers[current_worker()]->jobs.push(n);
+				signal_work();
+			}
+		}
+
+		node* pop_main_job()
+		{
+			if (!main_job_count.load(std::memory_order_acquire)) return nullptr;
+			std::lock_guard lock{ main_mutex };
+			if (main_jobs.empty()) return nullptr;
+			node* const n{ main_jobs.back() };
+			main_jobs.pop_back();
+			main_job_count.fetch_sub(1, std::memory_order_relaxed);
+			return n;
+		}
+
+		// Own jobs first (newest first, they are still in the cache), then the oldest job of another worker
+		node* find_job(u32 index)
+		{
+			if (node* n{ workers[index]->jobs.pop() }) return n;
+			const u32 count{ (u32)workers.size() };
+			for (u32 i{ 1 }; i < count; ++i)
+			{
+				if (node* n{ workers[(index + i) % count]->jobs.steal() }) return n;
+			}
+			return nullptr;
+		}
+
+		void run_job(node* n)
+		{
+			if (tracing.load(std::memory_order_relaxed))
+			{
+				const s64 start{ trace_time() };
+				n->func(n->data);
+				// Recorded on the thread it ends on
+				workers[current_worker()]->trace.push_back({ n->name, start, trace_time() });
+			}
+			else
+			{
+				n->func(n->data);
+			}
+			job_done(*n);
+		}
+
+#if USE_FIBERS
+		// Back to the thread's scheduler, which looks at the state of the fiber
+		void switch_to_scheduler(fiber* f)
+		{
+			switch_context(f->context, workers[current_worker()]->scheduler);
+		}
+
+		// Every fiber runs this forever: run the job it was given, then go back to the scheduler
+		void fiber_main()
+		{
+			for (;;)
+			{
+				fiber* const f{ workers[current_worker()]->current };
+				run_job(f->job);
+				f->state = fiber_state::done;
+				switch_to_scheduler(f);
+			}
+		}
+
+		fiber* create_fiber()
+		{
+			u8* const stack{ stacks->allocate() };
+			if (!stack) return nullptr;
+			auto f{ std::make_unique<fiber>() };
+			f->stack = stack;
+#if defined(__x86_64__)
+			// What savage_switch_fiber() pops: mxcsr and x87 control word, 6 registers, then it returns to
+			// fiber_main() with the stack aligned as if fiber_main() was called
+			u8* const top{ stack + stacks->stack_size() };
+			u64* sp{ (u64*)top };
+			*--sp = 0;							// fiber_main() never returns
+			*--sp = (u64)(size_t)&fiber_main;
+			for (u32 i{ 0 }; i < 6; ++i) *--sp = 0;
+			*--sp = 0x037f'00001f80ull;			// Default mxcsr and x87 control word
+			f->context = sp;
+#else
+			getcontext(&f->context);
+			f->context.uc_stack.ss_sp = stack;
+			f->context.uc_stack.ss_size = stacks->stack_size();
+			f->context.uc_link = nullptr;
+			makecontext(&f->context, &fiber_main, 0);
+#endif
+			fiber* const result{ f.get() };
+			all_fibers.emplace_back(std::move(f));
+			return result;
+		}
+
+		fiber* acquire_fiber()
+		{
+			std::lock_guard lock{ fiber_mutex };
+			if (!free_fibers.empty())
+			{
+				fiber* const f{ free_fibers.back() };
+				free_fibers.pop_back();
+				return f;
+			}
+			fiber* const f{ create_fiber() };
+			assert(f && "Out of memory for fiber stacks");
+			return f;
+		}
+
+		// Switch to the fiber until it is done or waits
+		void resume(fiber* f)
+		{
+			worker& w{ *workers[worker_index] };
+			w.current = f;
+			f->state = fiber_state::running;
+			switch_context(w.scheduler, f->context);
+			w.current = nullptr;
+
+			// The fiber's registers are saved now, so other threads can resume it
+			std::lock_guard lock{ fiber_mutex };
+			if (f->state == fiber_state::done)
+			{
+				free_fibers.push_back(f);
+			}
+			else
+			{
+				waiting_fibers.push_back(f);
+				waiting_count.fetch_add(1, std::memory_order_release);
+			}
+		}
+
+		// A fiber that's done waiting. Fibers of main thread jobs only go on on the main thread
+		fiber* find_ready_fiber(u32 index)
+		{
+			if (!waiting_count.load(std::memory_order_acquire)) return nullptr;
+			std::lock_guard lock{ fiber_mutex };
+			for (u32 i{ 0 }; i < waiting_fibers.size(); ++i)
+			{
+				fiber* const f{ waiting_fibers[i] };
+				if (f->job->affinity == thread_affinity::main_thread && index) continue;
+				if (f->wait_for && f->wait_for->load(std::memory_order_acquire)) continue;
+				waiting_fibers[i] = waiting_fibers.back();
+				waiting_fibers.pop_back();
+				waiting_count.fetch_sub(1, std::memory_order_relaxed);
+				return f;
+			}
+			return nullptr;
+		}
+#endif
+
+		void execute(node* n)
+		{
+#if USE_FIBERS
+			if (use_fibers)
+			{
+				fiber* const f{ acquire_fiber() };
+				f->job = n;
+				resume(f);
+				return;
+			}
+#endif
+			run_job(n);
+		}
+
+		// Do one piece of work if there is any: a fiber that's done waiting, a main thread job, then any job
+		bool run_one(u32 index)
+		{
+#if USE_FIBERS
+			if (use_fibers)
+			{
+				if (fiber* f{ find_ready_fiber(index) })
+				{
+					resume(f);
+					return true;
+				}
+			}
+#endif
+			node* n{ index ? nullptr : pop_main_job() };
+			if (!n) n = find_job(index);
+			if (!n) return false;
+			execute(n);
+			return true;
+		}
+
+		void worker_loop(u32 index)
+		{
+			worker_index = index;
+			while (running.load(std::memory_order_acquire))
+			{
+				const u32 signal{ work_signal.load(std::memory_order_seq_cst) };
+				if (run_one(index)) continue;
+
+				// Look a few more times before going to sleep, jobs often come in quick succession
+				bool found{ false };
+				for (u32 spin{ 0 }; spin < 64 && !found; ++spin)
+				{
+					std::this_thread::yield();
+					found = run_one(index);
+				}
+				// Waiting fibers are checked until they can go on
+				if (found || waiting_count.load(std::memory_order_acquire)) continue;
+
+				std::unique_lock lock{ sleep_mutex };
+				sleeping.fetch_add(1, std::memory_order_seq_cst);
+				wake_up.wait(lock, [signal]() {
+					return work_signal.load(std::memory_order_seq_cst) != signal || !running.load(std::memory_order_acquire);
+				});
+				sleeping.fetch_sub(1, std::memory_order_seq_cst);
+			}
+		}
+
+		node* allocate_node()
+		{
+			std::lock_guard lock{ free_nodes_mutex };
+			if (free_nodes.empty())
+			{
+				all_nodes.emplace_back(std::make_unique<node>());
+				return all_nodes.back().get();
+			}
+			node* const n{ free_nodes.back() };
+			free_nodes.pop_back();
+			return n;
+		}
+
+	} // Anonymous namespace
+
+	// Count the job as done and push the jobs that were only waiting for it
+	void job_done(node& n)
+	{
+		if (!n.owner)
+		{
+			std::atomic<u32>* const counter{ n.counter };
+			{
+				std::lock_guard lock{ free_nodes_mutex };
+				free_nodes.push_back(&n);
+			}
+			if (counter) counter->fetch_sub(1, std::memory_order_release);
+			signal_work(); // Someone may be waiting for it
+			return;
+		}
+
+		graph& g{ *n.owner };
+		for (u32 successor : n.successors)
+		{
+			if (g._pending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) push_ready(&g._nodes[successor]);
+		}
+		g._remaining.fetch_sub(1, std::memory_order_release);
+	}
+
+	bool initialize(const init_info& info)
+	{
+		assert(workers.empty());
+		const u32 worker_count{ info.worker_count ? info.worker_count : std::max(std::thread::hardware_concurrency(), 2u) - 1 };
+
+#if USE_FIBERS
+		use_fibers = info.use_fibers;
+		if (use_fibers)
+		{
+			stacks = std::make_unique<fiber_stack_allocator>(info.fiber_stack_size);
+			for (u32 i{ 0 }; i < info.fiber_count; ++i)
+			{
+				fiber* const f{ create_fiber() };
+				if (!f) return false;
+				free_fibers.push_back(f);
+			}
+		}
+#endif
+
+		worker_index = 0;
+		running = true;
+		workers.emplace_back(std::make_unique<worker>());
+		for (u32 i{ 1 }; i <= worker_count; ++i) workers.emplace_back(std::make_unique<worker>());
+		for (u32 i{ 1 }; i <= worker_count; ++i) workers[i]->thread = std::thread{ worker_loop, i };
+		return true;
+	}
+
+	void shutdown()
+	{
+		assert(worker_index == 0);
+		{
+			std::lock_guard lock{ sleep_mutex };
+			running = false;
+			wake_up.notify_all();
+		}
+		for (u32 i{ 1 }; i < workers.size(); ++i) workers[i]->thread.join();
+		workers.clear();
+		main_jobs.clear();
+		main_job_count = 0;
+		worker_index = u32_invalid_id;
+
+		assert(waiting_fibers.empty() && free_fibers.size() == all_fibers.size());
+#if USE_FIBERS
+		for (auto& f : all_fibers) stacks->free(f->stack);
+		stacks.reset();
+#endif
+		all_fibers.clear();
+		free_fibers.clear();
+		use_fibers = false;
+		free_nodes.clear();
+		all_nodes.clear();
+	}
+
+	u32 thread_count()
+	{
+		return (u32)workers.size();
+	}
+
+	bool is_job_thread()
+	{
+		return current_worker() != u32_invalid_id;
+	}
+
+	bool fibers_enabled()
+	{
+		return use_fibers;
+	}
+
+	u32 fiber_count()
+	{
+		std::lock_guard lock{ fiber_mutex };
+		return (u32)all_fibers.size();
+	}
+
+	void submit(const char* name, job_func func, void* data, std::atomic<u32>* counter, thread_affinity affinity)
+	{
+		assert(func && current_worker() != u32_invalid_id);
+		node* const n{ allocate_node() };
+		n->name = name;
+		n->func = func;
+		n->data = data;
+		n->affinity = affinity;
+		n->dependency_count = 0;
+		n->owner = nullptr;
+		n->counter = counter;
+		push_ready(n);
+	}
+
+	void wait(const std::atomic<u32>& counter)
+	{
+		if (!counter.load(std::memory_order_acquire)) return;
+		const u32 index{ current_worker() };
+		assert(index != u32_invalid_id);
+
+#if USE_FIBERS
+		if (fiber* const f{ workers[index]->current })
+		{
+			// Park the fiber, a scheduler resumes it once the counter is 0
+			f->wait_for = &counter;
+			f->state = fiber_state::waiting;
+			switch_to_scheduler(f);
+			return;
+		}
+#endif
+		// Not on a fiber: keep this thread busy until the counter is 0
+		while (counter.load(std::memory_order_acquire))
+		{
+			if (!run_one(index)) std::this_thread::yield();
+		}
+	}
+
+	void yield()
+	{
+#if USE_FIBERS
+		const u32 index{ current_worker() };
+		if (index == u32_invalid_id) return;
+		if (fiber* const f{ workers[index]->current })
+		{
+			f->wait_for = nullptr;
+			f->state = fiber_state::waiting;
+			switch_to_scheduler(f);
+		}
+#endif
+	}
+
+	u32 graph::add(const char* name, job_func func, void* data, thread_affinity affinity)
+	{
+		assert(func);
+		_nodes.push_back({ name, func, data, affinity, 0, {}, this, nullptr });
+		return (u32)_nodes.size() - 1;
+	}
+
+	void graph::depend(u32 job, u32 dependency)
+	{
+		assert(job < _nodes.size() && dependency < _nodes.size() && job != dependency);
+		_nodes[dependency].successors.push_back(job);
+		++_nodes[job].dependency_count;
+	}
+
+	void graph::run()
+	{
+		assert(worker_index == 0 && !workers[0]->current && "Graphs only run on the main thread after jobs::initialize()");
+		const u32 count{ (u32)_nodes.size() };
+		if (!count) return;
+
+		if (_pending_size != count)
+		{
+			_pending = std::make_unique<std::atomic<u32>[]>(count);
+			_pending_size = count;
+		}
+
+#ifdef _DEBUG
+		{
+			// Every job has to be reachable from a job without dependencies, or the graph never finishes
+			utl::vector<u32> left(count), ready;
+			for (u32 i{ 0 }; i < count; ++i) if (!(left[i] = _nodes[i].dependency_count)) ready.push_back(i);
+			u32 done{ 0 };
+			while (!ready.empty())
+			{
+				const u32 i{ ready.back() };
+				ready.pop_back();
+				++done;
+				for (u32 successor : _nodes[i].successors) if (!--left[successor]) ready.push_back(successor);
+			}
+			assert(done == count && "The graph has a cycle");
+		}
+#endif
+
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			_nodes[i].owner = this;
+			_pending[i].store(_nodes[i].dependency_count, std::memory_order_relaxed);
+		}
+		_remaining.store(count, std::memory_order_release);
+		for (auto& n : _nodes) if (!n.dependency_count) push_ready(&n);
+
+		while (_remaining.load(std::memory_order_acquire))
+		{
+			if (!run_one(0)) std::this_thread::yield();
+		}
+	}
+
+	void graph::clear()
+	{
+		_nodes.clear();
+		_pending.reset();
+		_pending_size = 0;
+	}
+
+	void begin_trace()
+	{
+		assert(worker_index == 0);
+		for (auto& w : workers) w->trace.clear();
+		trace_start = std::chrono::steady_clock::now();
+		tracing = true;
+	}
+
+	std::string end_trace()
+	{
+		assert(worker_index == 0);
+		tracing = false;
+
+		// Complete events ("ph":"X") with times in microseconds, one row per thread
+		std::string json{ "{\"traceEvents\":[\n" };
+		char line[256];
+		bool first{ true };
+		for (u32 i{ 0 }; i < workers.size(); ++i)
+		{
+			snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+				first ? "" : ",\n", i, i ? "Worker" : "Main", i);
+			json += line;
+			first = false;
+			for (const auto& e : workers[i]->trace)
+			{
+				snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					e.name ? e.name : "job", i, e.start / 1000.0, (e.end - e.start) / 1000.0);
+				json += line;
+			}
+			workers[i]->trace.clear();
+		}
+		json += "\n]}\n";
+		return json;
+	}
+}
@@ -0,0 +1,107 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "CommonHeaders.h"
+#include <atomic>
+#include <string>
+
+// Runs the work of a frame as a graph of jobs on worker threads. Each worker has its own queue of jobs
+// that are ready and takes jobs from the queues of the others when it runs out. A job is ready once all
+// jobs it depends on are done. Jobs with main_thread affinity only run on the thread that runs the graph.
+//
+// With fibers (Linux only) every job runs on a fiber of its own. A job that waits for other jobs parks
+// its fiber and the thread goes on with other work, the fiber is picked up again once the wait is over.
+// Without fibers a waiting job runs other jobs on top of its own stack until the wait is over.
+#if defined(__linux__)
+#define USE_FIBERS 1
+#else
+#define USE_FIBERS 0
+#endif
+
+namespace savage::jobs {
+
+	using job_func = void(*)(void* data);
+
+	enum class thread_affinity : u32
+	{
+		any,
+		main_thread,
+	};
+
+	constexpr size_t default_fiber_stack_size{ 64 * 1024 };
+
+	struct init_info
+	{
+		u32		worker_count{ 0 };		// 0 starts one less than the number of cores
+		bool	use_fibers{ false };	// Ignored where there are no fibers
+		u32		fiber_count{ 64 };		// Fibers made up front, more are made when all of them wait
+		size_t	fiber_stack_size{ default_fiber_stack_size };
+	};
+
+	// Start the workers. Call from the main thread
+	bool initialize(const init_info& info = {});
+	void shutdown();
+	// Number of threads that run jobs, the main thread included
+	u32 thread_count();
+	// True if this thread can submit jobs and wait for them: the main thread after initialize() or a job
+	bool is_job_thread();
+	// True if jobs run on fibers
+	bool fibers_enabled();
+	// Number of fibers made so far
+	u32 fiber_count();
+
+	// Run a job on its own. counter is decreased once it is done, add to it before calling
+	// NOTE: only from the main thread or a job
+	void submit(const char* name, job_func func, void* data, std::atomic<u32>* counter = nullptr, thread_affinity affinity = thread_affinity::any);
+	// Return once counter is 0. Doesn't block the thread: it runs other jobs in the meantime
+	void wait(const std::atomic<u32>& counter);
+	// Let other jobs run before going on. Only does something in a job on a fiber
+	void yield();
+
+	// Jobs and the order between them. Build it once and run it every frame
+	class graph
+	{
+	public:
+		// Add a job. Returns its index, which is used to add dependencies
+		u32 add(const char* name, job_func func, void* data = nullptr, thread_affinity affinity = thread_affinity::any);
+		// job won't start before dependency is done
+		void depend(u32 job, u32 dependency);
+		// Run all jobs and return once they are done. The calling thread runs jobs too
+		// NOTE: only from the main thread and not while another graph runs
+		void run();
+		void clear();
+
+		u32 count() const { return (u32)_nodes.size(); }
+
+		// Used by the workers. The counters are in the graph so nodes can be copied while it is built
+		struct node
+		{
+			const char*				name;
+			job_func				func;
+			void*					data;
+			thread_affinity			affinity;
+			u32						dependency_count;
+			utl::vector<u32>		successors;
+			graph*					owner;
+			std::atomic<u32>*		counter;	// Jobs from submit() aren't in a graph
+		};
+
+	private:
+		utl::vector<node>						_nodes;
+		std::unique_ptr<std::atomic<u32>[]>		_pending;	// Jobs each job still waits for
+		u32										_pending_size{ 0 };
+		std::atomic<u32>						_remaining{ 0 };
+
+		friend void job_done(node& n);
+	};
+
+	// Record the start and end of every job until end_trace()
+	void begin_trace();
+	// Stop recording and return the jobs in Chrome trace format (open it with chrome://tracing or Perfetto)
+	std::string end_trace();
+}
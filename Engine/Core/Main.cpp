@@ -48,5 +48,56 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	}
 }
 
+#endif // !USE_WITH_EDITOR
+#elif defined(__linux__)
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+extern bool engine_intialize();
+extern void engine_update();
+extern void engine_shutdown();
+
+#ifndef USE_WITH_EDITOR
+
+namespace {
+	// Set by SIGINT/SIGTERM so a dedicated server or CI run can stop cleanly
+	volatile std::sig_atomic_t quit_requested{ 0 };
+
+	void on_quit_signal(int)
+	{
+		quit_requested = 1;
+	}
+} // Anonymous namespace
+
+// Headless entry point. "--frames N" stops after N updates, which is how benchmarks and CI runs use it
+int main(int argc, char* argv[])
+{
+	uint64_t max_frames{ 0 }; // 0 means run until a quit signal
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--frames") && i + 1 < argc) max_frames = strtoull(argv[++i], nullptr, 10);
+	}
+
+	std::signal(SIGINT, on_quit_signal);
+	std::signal(SIGTERM, on_quit_signal);
+
+	// Try an initialize the engine then if that works we update the state of the engine until we are told to stop
+	if (engine_intialize())
+	{
+		uint64_t frame{ 0 };
+		// There are no window messages to pump so only the engine is updated
+		while (!quit_requested && (!max_frames || frame < max_frames))
+		{
+			engine_update();
+			++frame;
+		}
+		engine_shutdown();
+		return 0;
+	}
+	return 1;
+}
+
 #endif // !USE_WITH_EDITOR
 #endif // _WIN64
\ No newline at end of file
@@ -7,7 +7,7 @@ MIT License - see LICENSE file
 
 #pragma once
 
-#include "..\Components\ComponentsCommon.h"
+#include "../Components/ComponentsCommon.h"
 #include "TransformComponent.h"
 #include "ScriptComponent.h"
 
@@ -42,6 +42,10 @@ namespace savage {
 			virtual ~entity_script() = default;
 			virtual void begin_play() {} // Called on the frame the entity is created
 			virtual void update(float) {} // Called every frame the entity exists and takes the seconds per frame as an input
+			// Optional hooks to save and restore the state of the script (world snapshots)
+			// NOTE: Scripts that don't override these are re-created with their default state
+			virtual void serialize(utl::vector<u8>&) const {} // Append the state of the script to the buffer
+			virtual void deserialize(const u8*, u32) {} // Restore the state from the data and its size in bytes
 		protected:
 			constexpr explicit entity_script(game_entity::entity entity) : game_entity::entity{ entity.get_id()} {}
 		};
@@ -56,7 +60,11 @@ namespace savage {
 			// Register a script with the engine
 			u8 register_script(size_t, script_creator);
 #ifdef USE_WITH_EDITOR
+#ifdef _WIN64
 			extern "C" __declspec(dllexport)
+#else
+			extern "C" __attribute__((visibility("default")))
+#endif // _WIN64
 #endif //USE_WITH_EDITOR
 			// Get the script creator from the DLL
 			script_creator get_script_creator(size_t tag);
@@ -6,7 +6,7 @@ MIT License - see LICENSE file
 */
 
 #pragma once
-#include "..\Components\ComponentsCommon.h"
+#include "../Components/ComponentsCommon.h"
 
 namespace savage::script {
 
@@ -0,0 +1,274 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "RenderList.h"
+#include "../Components/Entity.h"
+#include "../Components/Transform.h"
+#include "../Utilities/LinearAllocator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define USE_SSE 1
+#include <xmmintrin.h>
+#else
+#define USE_SSE 0
+#endif
+
+namespace savage::graphics {
+	namespace {
+
+		struct plane
+		{
+			f32 x, y, z, w; // Normal pointing into the frustum and distance
+		};
+
+		// Renderables are stored as separate arrays so culling only touches what it needs
+		utl::vector<game_entity::entity_id>	entities;
+		utl::vector<f32>					radii;
+		utl::vector<renderable_info>		infos;
+		utl::vector<u32>					renderable_mapping; // Entity index to renderable index
+
+		// Sort key layout (high to low): [material 16][mesh 20][lod 4][depth 24]
+		// Same material is drawn together first, then same mesh, then front to back
+		constexpr u32 material_bits{ 16 };
+		constexpr u32 mesh_bits{ 20 };
+		constexpr u32 lod_bits{ 4 };
+		constexpr u32 depth_bits{ 24 };
+		static_assert(material_bits + mesh_bits + lod_bits + depth_bits == 64);
+		static_assert((1 << lod_bits) >= max_lods);
+
+		// Get the 6 planes from the view-projection matrix (Gribb & Hartmann)
+		// For row vectors clip = v * M, so each plane is made from the columns of M
+		void extract_planes(const math::m4x4& m, plane (&planes)[6])
+		{
+			auto column = [&m](u32 c) { return plane{ m.m[0][c], m.m[1][c], m.m[2][c], m.m[3][c] }; };
+			auto add = [](const plane& a, const plane& b) { return plane{ a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; };
+			auto sub = [](const plane& a, const plane& b) { return plane{ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; };
+
+			const plane c0{ column(0) }, c1{ column(1) }, c2{ column(2) }, c3{ column(3) };
+			planes[0] = add(c3, c0); // Left
+			planes[1] = sub(c3, c0); // Right
+			planes[2] = add(c3, c1); // Bottom
+			planes[3] = sub(c3, c1); // Top
+			planes[4] = c2;			 // Near (z >= 0)
+			planes[5] = sub(c3, c2); // Far
+
+			// Normalize so the plane test gives a real distance we can compare to the radius
+			for (auto& p : planes)
+			{
+				const f32 length{ sqrtf(p.x * p.x + p.y * p.y + p.z * p.z) };
+				assert(length > 0.f);
+				p = { p.x / length, p.y / length, p.z / length, p.w / length };
+			}
+		}
+
+		// Test 4 spheres against the frustum. Returns a 4-bit mask with the visible spheres set
+		u32 cull_4(const f32* x, const f32* y, const f32* z, const f32* r, const plane (&planes)[6])
+		{
+#if USE_SSE
+			const __m128 cx{ _mm_loadu_ps(x) };
+			const __m128 cy{ _mm_loadu_ps(y) };
+			const __m128 cz{ _mm_loadu_ps(z) };
+			const __m128 neg_r{ _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r)) };
+			__m128 visible{ _mm_castsi128_ps(_mm_set1_epi32(-1)) };
+			for (const auto& p : planes)
+			{
+				// distance = dot(normal, center) + w. Visible if distance > -radius for every plane
+				__m128 d{ _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(p.x)), _mm_set1_ps(p.w)) };
+				d = _mm_add_ps(d, _mm_mul_ps(cy, _mm_set1_ps(p.y)));
+				d = _mm_add_ps(d, _mm_mul_ps(cz, _mm_set1_ps(p.z)));
+				visible = _mm_and_ps(visible, _mm_cmpgt_ps(d, neg_r));
+			}
+			return (u32)_mm_movemask_ps(visible);
+#else
+			u32 mask{ 0 };
+			for (u32 i{ 0 }; i < 4; ++i)
+			{
+				bool inside{ true };
+				for (const auto& p : planes)
+				{
+					inside &= (p.x * x[i] + p.y * y[i] + p.z * z[i] + p.w) > -r[i];
+				}
+				mask |= (u32)inside << i;
+			}
+			return mask;
+#endif
+		}
+
+		u32 select_lod(const renderable_info& info, f32 distance, f32 lod_bias)
+		{
+			u32 lod{ 0 };
+			while (lod < max_lods - 1 && info.lod_distances[lod] > 0.f && distance > info.lod_distances[lod] * lod_bias) ++lod;
+			return lod;
+		}
+
+		u64 make_sort_key(const renderable_info& info, u32 lod, f32 distance)
+		{
+			// Positive floats keep their order when compared as integers, so the top bits make a good depth key
+			u32 depth;
+			memcpy(&depth, &distance, sizeof(u32));
+			depth >>= (32 - depth_bits - 1); // Drop the sign bit (always 0) and the low bits of the mantissa
+
+			u64 key{ (u64)(info.material_id & ((1u << material_bits) - 1)) };
+			key = (key << mesh_bits) | (info.mesh_id & ((1u << mesh_bits) - 1));
+			key = (key << lod_bits) | lod;
+			key = (key << depth_bits) | (depth & ((1u << depth_bits) - 1));
+			return key;
+		}
+
+	} // Anonymous namespace
+
+	void add_renderable(game_entity::entity entity, const renderable_info& info)
+	{
+		assert(game_entity::is_alive(entity.get_id()));
+		assert(info.mesh_id < (1u << mesh_bits) && info.material_id < (1u << material_bits));
+		const id::id_type entity_index{ id::index(entity.get_id()) };
+		if (renderable_mapping.size() <= entity_index) renderable_mapping.resize(entity_index + 1, u32_invalid_id);
+		assert(renderable_mapping[entity_index] == u32_invalid_id);
+
+		renderable_mapping[entity_index] = (u32)entities.size();
+		entities.push_back(entity.get_id());
+		radii.push_back(info.radius);
+		infos.push_back(info);
+	}
+
+	void remove_renderable(game_entity::entity_id id)
+	{
+		const id::id_type entity_index{ id::index(id) };
+		assert(entity_index < renderable_mapping.size() && renderable_mapping[entity_index] != u32_invalid_id);
+		const u32 index{ renderable_mapping[entity_index] };
+
+		// Move the last renderable into the removed slot
+		renderable_mapping[id::index(entities.back())] = index;
+		renderable_mapping[entity_index] = u32_invalid_id;
+		utl::erase_unordered(entities, index);
+		utl::erase_unordered(radii, index);
+		utl::erase_unordered(infos, index);
+	}
+
+	render_list build_render_list(const camera& camera, utl::linear_allocator& frame_memory)
+	{
+		render_list list{};
+		const u32 count{ (u32)entities.size() };
+		if (!count) return list;
+
+		plane planes[6];
+		extract_planes(camera.view_projection, planes);
+
+		// Gather the bounding spheres into arrays padded to a multiple of 4 for the SIMD test
+		const u32 padded_count{ (count + 3) & ~3u };
+		f32* const x{ frame_memory.allocate<f32>(padded_count) };
+		f32* const y{ frame_memory.allocate<f32>(padded_count) };
+		f32* const z{ frame_memory.allocate<f32>(padded_count) };
+		f32* const r{ frame_memory.allocate<f32>(padded_count) };
+		u32* const visible{ frame_memory.allocate<u32>(count) };
+		if (!(x && y && z && r && visible)) return list;
+
+		const transform::storage_view transforms{ transform::view() };
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			const id::id_type entity_index{ id::index(entities[i]) };
+			const math::v3& p{ transforms.positions[entity_index] };
+			const math::v3& s{ transforms.scales[entity_index] };
+			x[i] = p.x;
+			y[i] = p.y;
+			z[i] = p.z;
+			r[i] = radii[i] * std::max(std::max(fabsf(s.x), fabsf(s.y)), fabsf(s.z));
+		}
+		for (u32 i{ count }; i < padded_count; ++i)
+		{
+			// Padding is never visible
+			x[i] = y[i] = z[i] = 0.f;
+			r[i] = -INFINITY;
+		}
+
+		// Cull 4 at a time and write out the indices of the visible ones
+		u32 visible_count{ 0 };
+		for (u32 i{ 0 }; i < padded_count; i += 4)
+		{
+			u32 mask{ cull_4(&x[i], &y[i], &z[i], &r[i], planes) };
+			while (mask)
+			{
+				const u32 bit{ (mask & 1) ? 0u : (mask & 2) ? 1u : (mask & 4) ? 2u : 3u };
+				visible[visible_count++] = i + bit;
+				mask &= mask - 1;
+			}
+		}
+		list.culled_count = count - visible_count;
+		if (!visible_count) return list;
+
+		// Make the draw packets
+		draw_packet* const packets{ frame_memory.allocate<draw_packet>(visible_count) };
+		draw_batch* const batches{ frame_memory.allocate<draw_batch>(visible_count) };
+		if (!(packets && batches)) return {};
+
+		const math::v3& eye{ camera.position };
+		for (u32 i{ 0 }; i < visible_count; ++i)
+		{
+			const u32 index{ visible[i] };
+			const f32 dx{ x[index] - eye.x }, dy{ y[index] - eye.y }, dz{ z[index] - eye.z };
+			const f32 distance{ sqrtf(dx * dx + dy * dy + dz * dz) };
+			const renderable_info& info{ infos[index] };
+			const u32 lod{ select_lod(info, distance, camera.lod_bias) };
+			packets[i] = { make_sort_key(info, lod, distance), info.mesh_id, info.material_id, lod, entities[index] };
+		}
+
+		std::sort(packets, packets + visible_count, [](const draw_packet& a, const draw_packet& b) { return a.sort_key < b.sort_key; });
+
+		// Merge packets with the same material, mesh and LOD into batches
+		u32 batch_count{ 0 };
+		for (u32 i{ 0 }; i < visible_count; ++i)
+		{
+			const draw_packet& p{ packets[i] };
+			if (batch_count)
+			{
+				draw_batch& last{ batches[batch_count - 1] };
+				if (last.material_id == p.material_id && last.mesh_id == p.mesh_id && last.lod == p.lod)
+				{
+					++last.packet_count;
+					continue;
+				}
+			}
+			batches[batch_count++] = { p.mesh_id, p.material_id, p.lod, i, 1 };
+		}
+
+		list.packets = packets;
+		list.packet_count = visible_count;
+		list.batches = batches;
+		list.batch_count = batch_count;
+		return list;
+	}
+
+	u32 cull_meshlets(const camera& camera, const meshlet* const meshlets, u32 count, u32* const visible)
+	{
+		assert(meshlets || !count);
+		plane planes[6];
+		extract_planes(camera.view_projection, planes);
+
+		u32 visible_count{ 0 };
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			const meshlet& m{ meshlets[i] };
+			bool inside{ true };
+			for (const auto& p : planes)
+			{
+				inside &= p.x * m.center[0] + p.y * m.center[1] + p.z * m.center[2] + p.w > -m.radius;
+			}
+			if (!inside) continue;
+
+			// Back facing when the sphere is inside the cone opposite to the normals, seen from the camera
+			const f32 dx{ m.center[0] - camera.position.x }, dy{ m.center[1] - camera.position.y }, dz{ m.center[2] - camera.position.z };
+			const f32 distance{ sqrtf(dx * dx + dy * dy + dz * dz) };
+			if (dx * m.cone_axis[0] + dy * m.cone_axis[1] + dz * m.cone_axis[2] >= m.cone_cutoff * distance + m.radius) continue;
+
+			visible[visible_count++] = i;
+		}
+		return visible_count;
+	}
+}
@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "../Components/ComponentsCommon.h"
+
+namespace savage::utl { class linear_allocator; }
+
+namespace savage::graphics {
+
+	constexpr u32 max_lods{ 4 };
+
+	// What the renderer needs to draw an entity
+	struct renderable_info
+	{
+		u32		mesh_id{ u32_invalid_id };
+		u32		material_id{ 0 };
+		f32		radius{ 1.f };					// Bounding sphere radius before scaling
+		f32		lod_distances[max_lods - 1]{};	// Switch to the next LOD past each distance. 0 means no more LODs
+	};
+
+	struct camera
+	{
+		// Row-major view * projection matrix (row vectors, z from 0 to 1 like Direct3D)
+		math::m4x4	view_projection;
+		math::v3	position;
+		f32			lod_bias{ 1.f }; // Multiplies the LOD distances
+	};
+
+	// A small cluster of the triangles of a mesh with its bounds, as packed by the content tools (tools::meshlet)
+	struct meshlet
+	{
+		u32 vertex_offset;
+		u32 triangle_offset;
+		u32 vertex_count;
+		u32 triangle_count;
+		f32 center[3];
+		f32 radius;
+		f32 cone_axis[3];
+		f32 cone_cutoff;	// 1 means the meshlet can't be back facing
+	};
+
+	// One visible entity
+	struct draw_packet
+	{
+		u64						sort_key;
+		u32						mesh_id;
+		u32						material_id;
+		u32						lod;
+		game_entity::entity_id	entity;
+	};
+
+	// Packets that can be drawn together (same material, mesh and LOD)
+	struct draw_batch
+	{
+		u32		mesh_id;
+		u32		material_id;
+		u32		lod;
+		u32		first_packet;
+		u32		packet_count;
+	};
+
+	// Everything to draw this frame. The arrays live in the frame allocator passed to build_render_list()
+	struct render_list
+	{
+		draw_packet*	packets{ nullptr };
+		draw_batch*		batches{ nullptr };
+		u32				packet_count{ 0 };
+		u32				batch_count{ 0 };
+		u32				culled_count{ 0 };
+	};
+
+	// Start drawing an entity
+	void add_renderable(game_entity::entity entity, const renderable_info& info);
+	// Stop drawing an entity
+	void remove_renderable(game_entity::entity_id id);
+
+	// Cull all renderables against the camera, pick their LOD then sort and batch the visible ones
+	// Returns an empty list if the frame allocator is full
+	render_list build_render_list(const camera& camera, utl::linear_allocator& frame_memory);
+
+	// Cull the meshlets of a mesh against the frustum and drop the ones that face away from the camera.
+	// The camera has to be in the space of the mesh: the world matrix is part of view_projection and position
+	// is in object space. Writes the indices of the visible meshlets to visible and returns how many there are
+	u32 cull_meshlets(const camera& camera, const meshlet* const meshlets, u32 count, u32* const visible);
+}
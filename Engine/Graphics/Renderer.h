@@ -8,7 +8,7 @@ MIT License - see LICENSE file
 #pragma once
 
 #include "CommonHeaders.h"
-#include "..\Platform\Window.h"
+#include "../Platform/Window.h"
 
 namespace savage::graphics {
 
@@ -20,6 +20,6 @@ namespace savage::graphics {
 	struct render_surface
 	{
 		platform::Window window{};
-		surface surface{};
+		graphics::surface surface{};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,218 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "Replication.h"
+#include "../Components/Transform.h"
+#include "../Utilities/IOStream.h"
+#include "../Utilities/Quantization.h"
+
+namespace savage::network {
+	namespace {
+
+		// "SVRP" - Savage replication packet
+		constexpr u32 packet_magic{ 0x50525653 };
+
+		// Flags for which parts of a transform are in the packet
+		enum change_flags : u32
+		{
+			position = 0x01,
+			rotation = 0x02,
+			scale = 0x04,
+
+			bits = 3
+		};
+
+		// Most changed transforms are next to each other, so a gap of one is a single bit.
+		// Other gaps are written as [0][5 bits for the width][width bits]
+		void write_gap(utl::bit_stream_writer& bits, u32 gap)
+		{
+			assert(gap);
+			if (gap == 1)
+			{
+				bits.write(1, 1);
+				return;
+			}
+			u32 width{ 0 };
+			while (width < 31 && (gap >> width) > 1) ++width;
+			++width;
+			assert(width < 32);
+			bits.write(0, 1);
+			bits.write(width, 5);
+			bits.write(gap, width);
+		}
+
+		u32 read_gap(utl::bit_stream_reader& bits)
+		{
+			if (bits.read(1)) return 1;
+			const u32 width{ bits.read(5) };
+			return bits.read(width);
+		}
+
+		u32 float_bits(f32 value)
+		{
+			u32 result;
+			memcpy(&result, &value, sizeof(u32));
+			return result;
+		}
+
+		f32 bits_float(u32 value)
+		{
+			f32 result;
+			memcpy(&result, &value, sizeof(f32));
+			return result;
+		}
+
+	} // Anonymous namespace
+
+	transform_encoder::transform_encoder(const replication_settings& settings /* = {} */)
+		: _settings{ settings }
+	{
+		assert(settings.position_bits && settings.position_bits <= 24);
+		assert(settings.rotation_bits && 2 + 3 * settings.rotation_bits <= 32);
+	}
+
+	u32 transform_encoder::encode(utl::vector<u8>& packet)
+	{
+		const transform::storage_view transforms{ transform::view() };
+		const math::v3& min{ _settings.world_min };
+		const math::v3& max{ _settings.world_max };
+		const u32 pos_bits{ _settings.position_bits };
+
+		packet.clear();
+		utl::blob_stream_writer blob{ packet };
+		blob.write(packet_magic);
+		const size_t count_offset{ blob.offset() };
+		blob.write(u32{ 0 }); // Number of transforms, patched at the end
+
+		// Entities created since the last packet are new to the client
+		const u32 known_count{ (u32)_baseline.size() };
+		_baseline.resize(transforms.count);
+
+		utl::bit_stream_writer bits{ packet };
+		u32 count{ 0 };
+		u32 last_index{ u32_invalid_id }; // The first gap is index + 1
+		for (u32 i{ 0 }; i < transforms.count; ++i)
+		{
+			const math::v3& p{ transforms.positions[i] };
+			const math::v4& r{ transforms.rotations[i] };
+			const math::v3& s{ transforms.scales[i] };
+			quantized_transform& base{ _baseline[i] };
+			const bool is_new{ i >= known_count };
+
+			// Skip the transforms that didn't change at all since the last packet
+			if (!is_new &&
+				!memcmp(&p, &base.last_position, sizeof(math::v3)) &&
+				!memcmp(&r, &base.last_rotation, sizeof(math::v4)) &&
+				!memcmp(&s, &base.scale, sizeof(math::v3)))
+			{
+				continue;
+			}
+
+			quantized_transform q
+			{
+				{
+					math::quantize_float(p.x, min.x, max.x, pos_bits),
+					math::quantize_float(p.y, min.y, max.y, pos_bits),
+					math::quantize_float(p.z, min.z, max.z, pos_bits),
+				},
+				math::pack_quaternion(r, _settings.rotation_bits),
+				s, p, r,
+			};
+
+			// Find out what changed compared to what the client has
+			u32 flags{ 0 };
+			if (is_new || q.position[0] != base.position[0] || q.position[1] != base.position[1] || q.position[2] != base.position[2]) flags |= change_flags::position;
+			if (is_new || q.rotation != base.rotation) flags |= change_flags::rotation;
+			if (is_new || memcmp(&q.scale, &base.scale, sizeof(math::v3))) flags |= change_flags::scale;
+			if (!flags)
+			{
+				// Moved less than we can send. Keep the old quantized values so small moves add up
+				base.last_position = p;
+				base.last_rotation = r;
+				continue;
+			}
+
+			write_gap(bits, i - last_index);
+			bits.write(flags, change_flags::bits);
+			if (flags & change_flags::position)
+			{
+				bits.write(q.position[0], pos_bits);
+				bits.write(q.position[1], pos_bits);
+				bits.write(q.position[2], pos_bits);
+			}
+			if (flags & change_flags::rotation)
+			{
+				bits.write(q.rotation, 2 + 3 * _settings.rotation_bits);
+			}
+			if (flags & change_flags::scale)
+			{
+				// Scale rarely changes at runtime so we send it as is
+				bits.write(float_bits(s.x), 32);
+				bits.write(float_bits(s.y), 32);
+				bits.write(float_bits(s.z), 32);
+			}
+
+			base = q;
+			last_index = i;
+			++count;
+		}
+		bits.flush();
+
+		blob.write_at(count_offset, count);
+		return count;
+	}
+
+	u32 transform_decoder::decode(const u8* packet, size_t size)
+	{
+		assert(packet);
+		if (size < 2 * sizeof(u32)) return u32_invalid_id;
+
+		utl::blob_stream_reader blob{ packet, size };
+		if (blob.read<u32>() != packet_magic) return u32_invalid_id;
+		const u32 count{ blob.read<u32>() };
+
+		const transform::storage_view transforms{ transform::view() };
+		const math::v3& min{ _settings.world_min };
+		const math::v3& max{ _settings.world_max };
+		const u32 pos_bits{ _settings.position_bits };
+
+		utl::bit_stream_reader bits{ blob.position(), size - blob.offset() };
+		u32 index{ u32_invalid_id };
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			index += read_gap(bits);
+			if (index >= transforms.count) return u32_invalid_id; // We don't have this entity
+
+			// Start from what we have and replace the parts that changed
+			math::v3 position{ transforms.positions[index] };
+			math::v4 rotation{ transforms.rotations[index] };
+			math::v3 scale{ transforms.scales[index] };
+
+			const u32 flags{ bits.read(change_flags::bits) };
+			if (flags & change_flags::position)
+			{
+				position.x = math::dequantize_float(bits.read(pos_bits), min.x, max.x, pos_bits);
+				position.y = math::dequantize_float(bits.read(pos_bits), min.y, max.y, pos_bits);
+				position.z = math::dequantize_float(bits.read(pos_bits), min.z, max.z, pos_bits);
+			}
+			if (flags & change_flags::rotation)
+			{
+				rotation = math::unpack_quaternion(bits.read(2 + 3 * _settings.rotation_bits), _settings.rotation_bits);
+			}
+			if (flags & change_flags::scale)
+			{
+				scale.x = bits_float(bits.read(32));
+				scale.y = bits_float(bits.read(32));
+				scale.z = bits_float(bits.read(32));
+			}
+
+			transform::set(index, position, rotation, scale);
+		}
+
+		return count;
+	}
+}
@@ -0,0 +1,65 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "CommonHeaders.h"
+
+namespace savage::network {
+
+	// Must be the same on the server and on the clients
+	struct replication_settings
+	{
+		// Positions are quantized inside of these bounds. Anything outside is clamped
+		math::v3	world_min{ -4096.f, -4096.f, -4096.f };
+		math::v3	world_max{ 4096.f, 4096.f, 4096.f };
+		u32			position_bits{ 20 };	// 8192m / 2^20 = ~8mm precision
+		u32			rotation_bits{ 10 };	// Smallest three with 10 bits = 32 bits per quaternion
+	};
+
+	// Writes the transforms that changed since the last packet
+	// NOTE: Entities are matched by index, so the server and the client must have the same entities
+	//		 (e.g. both loaded the same game.bin). The channel has to be reliable and in order.
+	class transform_encoder
+	{
+	public:
+		explicit transform_encoder(const replication_settings& settings = {});
+
+		// Write every transform that changed since the last packet. Returns the number of transforms written
+		u32 encode(utl::vector<u8>& packet);
+		// Forget the baseline so the next packet has every transform (e.g. when a client joins)
+		void reset() { _baseline.clear(); }
+
+	private:
+		struct quantized_transform
+		{
+			u32			position[3];
+			u32			rotation;
+			math::v3	scale;
+			// Values we quantized last time. Most transforms don't move so this lets us skip quantizing them again
+			math::v3	last_position;
+			math::v4	last_rotation;
+		};
+
+		const replication_settings			_settings;
+		// What the client has. We compare quantized values so changes too small to send are ignored
+		utl::vector<quantized_transform>	_baseline;
+	};
+
+	// Applies packets made by transform_encoder to the transforms of this world
+	class transform_decoder
+	{
+	public:
+		explicit transform_decoder(const replication_settings& settings = {})
+			: _settings{ settings } {}
+
+		// Apply a packet. Returns the number of transforms changed or u32_invalid_id if the packet is bad
+		u32 decode(const u8* packet, size_t size);
+
+	private:
+		const replication_settings _settings;
+	};
+}
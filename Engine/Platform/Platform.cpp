@@ -8,6 +8,11 @@ MIT License - see LICENSE file
 #include "Platform.h"
 #include "PlatformTypes.h"
 
+#if defined(__linux__)
+#include <string>
+#include <dlfcn.h>
+#endif
+
 namespace savage::platform {
 
 #ifdef _WIN64
@@ -289,6 +294,157 @@ namespace savage::platform {
 		DestroyWindow(info.hwnd);
 		remove_from_windows(id);
 	}
+
+	void* load_module(const char* path)
+	{
+		assert(path);
+		return LoadLibraryA(path);
+	}
+
+	bool unload_module(void* module)
+	{
+		assert(module);
+		return FreeLibrary((HMODULE)module) != 0;
+	}
+
+	void* get_module_symbol(void* module, const char* name)
+	{
+		assert(module && name);
+		return (void*)GetProcAddress((HMODULE)module, name);
+	}
+#elif defined(__linux__)
+	namespace {
+		// Headless windows are virtual surfaces: they keep a size and state but nothing is shown.
+		// This lets the engine run on servers and CI machines that have no display.
+		struct window_info
+		{
+			std::wstring	caption			{};
+			math::u32v4		client_area		{ 0, 0, 1920, 1080 };
+			math::u32v4		fullscreen_area	{ 0, 0, 1920, 1080 }; // Size of the virtual display
+			bool			is_fullscreen	{ false };
+			bool			is_closed		{ false };
+		};
+
+		// Array of window information
+		utl::vector<window_info> windows;
+
+		///////////////////////////////////////////////////////////////////
+		// TODO: This part will be handled by a free-set container latter
+		utl::vector<u32> available_slots;
+
+		u32 add_to_windows(window_info info)
+		{
+			u32 id{ u32_invalid_id };
+			if (available_slots.empty())
+			{
+				id = (u32)windows.size();
+				windows.emplace_back(info);
+			}
+			else
+			{
+				id = available_slots.back();
+				available_slots.pop_back();
+				assert(id != u32_invalid_id);
+				windows[id] = info;
+			}
+			return id;
+		}
+
+		void remove_from_windows(u32 id)
+		{
+			assert(id < windows.size());
+			available_slots.emplace_back(id);
+		}
+		///////////////////////////////////////////////////////////////////
+
+		// Get the window info from an ID
+		window_info& get_from_id(window_id id)
+		{
+			assert(id < windows.size());
+			assert(!windows[id].is_closed);
+			return windows[id];
+		}
+
+		void resize_window(window_id id, u32 width, u32 height)
+		{
+			window_info& info{ get_from_id(id) };
+			math::u32v4& area{ info.is_fullscreen ? info.fullscreen_area : info.client_area };
+			area.z = area.x + width;
+			area.w = area.y + height;
+		}
+
+		void set_window_fullscreen(window_id id, bool is_fullscreen)
+		{
+			get_from_id(id).is_fullscreen = is_fullscreen;
+		}
+
+		bool is_window_fullscreen(window_id id)
+		{
+			return get_from_id(id).is_fullscreen;
+		}
+
+		window_handle get_window_handle(window_id)
+		{
+			return nullptr;
+		}
+
+		void set_window_caption(window_id id, const wchar_t* caption)
+		{
+			get_from_id(id).caption = caption ? caption : L"";
+		}
+
+		math::u32v4 get_window_size(window_id id)
+		{
+			const window_info& info{ get_from_id(id) };
+			return info.is_fullscreen ? info.fullscreen_area : info.client_area;
+		}
+
+		bool is_window_closed(window_id id)
+		{
+			assert(id < windows.size());
+			return windows[id].is_closed;
+		}
+
+	} // Anonymous namespace
+
+	Window create_window(const window_init_info* const init_info /* = nullptr */)
+	{
+		window_info info{};
+		info.caption = (init_info && init_info->caption) ? init_info->caption : L"Savage Game";
+		if (init_info)
+		{
+			info.client_area.x = (u32)init_info->left;
+			info.client_area.y = (u32)init_info->top;
+			info.client_area.z = info.client_area.x + (u32)(init_info->width ? init_info->width : 1920);
+			info.client_area.w = info.client_area.y + (u32)(init_info->height ? init_info->height : 1080);
+		}
+		return Window{ window_id{ add_to_windows(info) } };
+	}
+
+	void remove_window(window_id id)
+	{
+		get_from_id(id).is_closed = true;
+		remove_from_windows(id);
+	}
+
+	void* load_module(const char* path)
+	{
+		assert(path);
+		// Resolve everything now so a broken library fails here and not in the middle of a frame
+		return dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	}
+
+	bool unload_module(void* module)
+	{
+		assert(module);
+		return dlclose(module) == 0;
+	}
+
+	void* get_module_symbol(void* module, const char* name)
+	{
+		assert(module && name);
+		return dlsym(module, name);
+	}
 #else
 #error "Must implement at least one platform"
 #endif // _WIN64
@@ -17,4 +17,11 @@ namespace savage::platform {
 	Window create_window(const window_init_info* const init_info = nullptr);
 	// Remove the window with the id
 	void remove_window(window_id id);
+
+	// Load a shared library (game code). Returns nullptr if it could not be loaded
+	void* load_module(const char* path);
+	// Returns false if the library could not be unloaded
+	bool unload_module(void* module);
+	// Get an exported function or variable. Returns nullptr if the library does not have it
+	void* get_module_symbol(void* module, const char* name);
 }
\ No newline at end of file
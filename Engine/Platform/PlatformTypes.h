@@ -33,4 +33,22 @@ namespace savage::platform {
 		s32				height		{ 1080 };
 	};
 }
+#elif defined(__linux__)
+
+namespace savage::platform {
+
+	// Headless windows have no native handle
+	using window_handle = void*;
+
+	// Define the window init info for headless systems (no display). The window is only a virtual surface
+	struct window_init_info
+	{
+		window_handle	parent		{ nullptr };
+		const wchar_t*	caption		{ nullptr };
+		s32				left		{ 0 };
+		s32				top			{ 0 };
+		s32				width		{ 1920 };
+		s32				height		{ 1080 };
+	};
+}
 #endif // _WIN64
@@ -0,0 +1,518 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#include "SpatialIndex.h"
+#include "../Components/Entity.h"
+#include "../Components/Transform.h"
+#include <algorithm>
+#include <cmath>
+
+// Dynamic AABB tree, the same idea as the broad-phase in Box2D:
+// - Leaves hold "fat" boxes that are a bit bigger than the entity. As long as the entity stays
+//   inside, update() doesn't touch the tree. When it leaves, the leaf is removed and inserted again.
+// - Insertion picks the sibling with the lowest increase in surface area.
+// - Rotations after insert and remove keep the tree balanced like an AVL tree.
+namespace savage::spatial {
+	namespace {
+
+		struct aabb
+		{
+			math::v3 min;
+			math::v3 max;
+		};
+
+		struct node
+		{
+			aabb			box;
+			u32				parent{ u32_invalid_id }; // Next free node when not used
+			u32				left{ u32_invalid_id };
+			u32				right{ u32_invalid_id };
+			s32				height{ -1 }; // Leaves are 0, free nodes are -1
+			id::id_type		entity{ id::invalid_id };
+
+			constexpr bool is_leaf() const { return left == u32_invalid_id; }
+		};
+
+		struct proxy
+		{
+			game_entity::entity_id	id;
+			u32						node;
+			f32						radius;
+			math::v3				last_position;
+		};
+
+		// How much bigger than the entity the fat box is
+		constexpr f32 fat_margin{ 0.5f };
+		// The fat box is stretched in the direction the entity moves by this many frames
+		constexpr f32 displacement_multiplier{ 4.f };
+
+		utl::vector<node>		nodes;
+		u32						root{ u32_invalid_id };
+		u32						free_node{ u32_invalid_id };
+
+		utl::vector<proxy>		proxies;
+		utl::vector<u32>		proxy_mapping; // Entity index to proxy index
+		utl::vector<u32>		stack; // Reused by queries so they don't allocate
+
+		aabb combine(const aabb& a, const aabb& b)
+		{
+			return {
+				{ std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+				{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) },
+			};
+		}
+
+		f32 surface_area(const aabb& a)
+		{
+			const f32 x{ a.max.x - a.min.x };
+			const f32 y{ a.max.y - a.min.y };
+			const f32 z{ a.max.z - a.min.z };
+			return 2.f * (x * y + y * z + z * x);
+		}
+
+		bool contains(const aabb& outer, const aabb& inner)
+		{
+			return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+				   outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+		}
+
+		bool overlaps(const aabb& a, const aabb& b)
+		{
+			return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+				   a.min.y <= b.max.y && a.max.y >= b.min.y &&
+				   a.min.z <= b.max.z && a.max.z >= b.min.z;
+		}
+
+		// Squared distance from a point to the closest point in the box
+		f32 distance_sq(const aabb& a, const math::v3& p)
+		{
+			f32 d{ 0.f };
+			if (p.x < a.min.x) d += (a.min.x - p.x) * (a.min.x - p.x);
+			else if (p.x > a.max.x) d += (p.x - a.max.x) * (p.x - a.max.x);
+			if (p.y < a.min.y) d += (a.min.y - p.y) * (a.min.y - p.y);
+			else if (p.y > a.max.y) d += (p.y - a.max.y) * (p.y - a.max.y);
+			if (p.z < a.min.z) d += (a.min.z - p.z) * (a.min.z - p.z);
+			else if (p.z > a.max.z) d += (p.z - a.max.z) * (p.z - a.max.z);
+			return d;
+		}
+
+		// Slab test. inv_dir is 1/direction so the division is done once per query
+		bool ray_hits(const aabb& a, const math::v3& origin, const math::v3& inv_dir, f32 max_t)
+		{
+			f32 t_min{ 0.f };
+			f32 t_max{ max_t };
+			const f32 o[3]{ origin.x, origin.y, origin.z };
+			const f32 inv[3]{ inv_dir.x, inv_dir.y, inv_dir.z };
+			const f32 lo[3]{ a.min.x, a.min.y, a.min.z };
+			const f32 hi[3]{ a.max.x, a.max.y, a.max.z };
+			for (u32 i{ 0 }; i < 3; ++i)
+			{
+				f32 t0{ (lo[i] - o[i]) * inv[i] };
+				f32 t1{ (hi[i] - o[i]) * inv[i] };
+				if (t0 > t1) std::swap(t0, t1);
+				t_min = std::max(t_min, t0);
+				t_max = std::min(t_max, t1);
+				if (t_min > t_max) return false;
+			}
+			return true;
+		}
+
+		aabb entity_box(const math::v3& position, const math::v3& scale, f32 radius)
+		{
+			const f32 half{ radius * std::max(std::max(fabsf(scale.x), fabsf(scale.y)), fabsf(scale.z)) };
+			return { { position.x - half, position.y - half, position.z - half }, { position.x + half, position.y + half, position.z + half } };
+		}
+
+		// Grow the box by the margin and stretch it in the direction the entity is moving
+		aabb fatten(const aabb& box, const math::v3& displacement)
+		{
+			aabb fat{ { box.min.x - fat_margin, box.min.y - fat_margin, box.min.z - fat_margin },
+					  { box.max.x + fat_margin, box.max.y + fat_margin, box.max.z + fat_margin } };
+			const f32 d[3]{ displacement.x * displacement_multiplier, displacement.y * displacement_multiplier, displacement.z * displacement_multiplier };
+			if (d[0] < 0.f) fat.min.x += d[0]; else fat.max.x += d[0];
+			if (d[1] < 0.f) fat.min.y += d[1]; else fat.max.y += d[1];
+			if (d[2] < 0.f) fat.min.z += d[2]; else fat.max.z += d[2];
+			return fat;
+		}
+
+		u32 allocate_node()
+		{
+			u32 index{ free_node };
+			if (index == u32_invalid_id)
+			{
+				index = (u32)nodes.size();
+				nodes.emplace_back();
+			}
+			else
+			{
+				free_node = nodes[index].parent;
+			}
+			nodes[index] = node{};
+			nodes[index].height = 0;
+			return index;
+		}
+
+		void release_node(u32 index)
+		{
+			assert(index < nodes.size());
+			nodes[index].parent = free_node;
+			nodes[index].height = -1;
+			free_node = index;
+		}
+
+		// Point the parent of the old child to the new child (or make the new child the root)
+		void replace_child(u32 parent, u32 old_child, u32 new_child)
+		{
+			if (parent == u32_invalid_id)
+			{
+				root = new_child;
+				return;
+			}
+			if (nodes[parent].left == old_child) nodes[parent].left = new_child;
+			else nodes[parent].right = new_child;
+		}
+
+		// Rotate the node if one side is more than one level higher than the other. Returns the new top node
+		u32 balance(u32 a_index)
+		{
+			node& a{ nodes[a_index] };
+			if (a.is_leaf() || a.height < 2) return a_index;
+
+			const u32 b_index{ a.left };
+			const u32 c_index{ a.right };
+			node& b{ nodes[b_index] };
+			node& c{ nodes[c_index] };
+			const s32 diff{ c.height - b.height };
+
+			// Rotate C up
+			if (diff > 1)
+			{
+				const u32 f_index{ c.left };
+				const u32 g_index{ c.right };
+				node& f{ nodes[f_index] };
+				node& g{ nodes[g_index] };
+
+				c.left = a_index;
+				c.parent = a.parent;
+				a.parent = c_index;
+				replace_child(c.parent, a_index, c_index);
+
+				if (f.height > g.height)
+				{
+					c.right = f_index;
+					a.right = g_index;
+					g.parent = a_index;
+					a.box = combine(b.box, g.box);
+					c.box = combine(a.box, f.box);
+					a.height = 1 + std::max(b.height, g.height);
+					c.height = 1 + std::max(a.height, f.height);
+				}
+				else
+				{
+					c.right = g_index;
+					a.right = f_index;
+					f.parent = a_index;
+					a.box = combine(b.box, f.box);
+					c.box = combine(a.box, g.box);
+					a.height = 1 + std::max(b.height, f.height);
+					c.height = 1 + std::max(a.height, g.height);
+				}
+				return c_index;
+			}
+
+			// Rotate B up
+			if (diff < -1)
+			{
+				const u32 d_index{ b.left };
+				const u32 e_index{ b.right };
+				node& d{ nodes[d_index] };
+				node& e{ nodes[e_index] };
+
+				b.left = a_index;
+				b.parent = a.parent;
+				a.parent = b_index;
+				replace_child(b.parent, a_index, b_index);
+
+				if (d.height > e.height)
+				{
+					b.right = d_index;
+					a.left = e_index;
+					e.parent = a_index;
+					a.box = combine(c.box, e.box);
+					b.box = combine(a.box, d.box);
+					a.height = 1 + std::max(c.height, e.height);
+					b.height = 1 + std::max(a.height, d.height);
+				}
+				else
+				{
+					b.right = e_index;
+					a.left = d_index;
+					d.parent = a_index;
+					a.box = combine(c.box, d.box);
+					b.box = combine(a.box, e.box);
+					a.height = 1 + std::max(c.height, d.height);
+					b.height = 1 + std::max(a.height, e.height);
+				}
+				return b_index;
+			}
+
+			return a_index;
+		}
+
+		// Walk up from the node, balancing and fixing the boxes and heights
+		void refit_up(u32 index)
+		{
+			while (index != u32_invalid_id)
+			{
+				index = balance(index);
+				node& n{ nodes[index] };
+				const node& left{ nodes[n.left] };
+				const node& right{ nodes[n.right] };
+				n.height = 1 + std::max(left.height, right.height);
+				n.box = combine(left.box, right.box);
+				index = n.parent;
+			}
+		}
+
+		void insert_leaf(u32 leaf)
+		{
+			if (root == u32_invalid_id)
+			{
+				root = leaf;
+				nodes[leaf].parent = u32_invalid_id;
+				return;
+			}
+
+			// Find the best sibling by going down the side that grows the least
+			const aabb leaf_box{ nodes[leaf].box };
+			u32 index{ root };
+			while (!nodes[index].is_leaf())
+			{
+				const node& n{ nodes[index] };
+				const f32 area{ surface_area(n.box) };
+				const f32 combined_area{ surface_area(combine(n.box, leaf_box)) };
+
+				// Cost of making a new parent for this node and the leaf
+				const f32 cost{ 2.f * combined_area };
+				// Minimum cost of pushing the leaf further down the tree
+				const f32 inheritance_cost{ 2.f * (combined_area - area) };
+
+				auto child_cost = [&](u32 child) {
+					const node& c{ nodes[child] };
+					const f32 new_area{ surface_area(combine(leaf_box, c.box)) };
+					return (c.is_leaf() ? new_area : new_area - surface_area(c.box)) + inheritance_cost;
+				};
+				const f32 left_cost{ child_cost(n.left) };
+				const f32 right_cost{ child_cost(n.right) };
+
+				if (cost < left_cost && cost < right_cost) break;
+				index = left_cost < right_cost ? n.left : n.right;
+			}
+
+			// Make a new parent for the sibling and the leaf
+			const u32 sibling{ index };
+			const u32 old_parent{ nodes[sibling].parent };
+			const u32 new_parent{ allocate_node() }; // NOTE: May move the nodes so no references are held here
+			nodes[new_parent].parent = old_parent;
+			nodes[new_parent].box = combine(leaf_box, nodes[sibling].box);
+			nodes[new_parent].height = nodes[sibling].height + 1;
+			nodes[new_parent].left = sibling;
+			nodes[new_parent].right = leaf;
+			replace_child(old_parent, sibling, new_parent);
+			nodes[sibling].parent = new_parent;
+			nodes[leaf].parent = new_parent;
+
+			refit_up(new_parent);
+		}
+
+		void remove_leaf(u32 leaf)
+		{
+			if (leaf == root)
+			{
+				root = u32_invalid_id;
+				return;
+			}
+
+			// The sibling takes the place of the parent
+			const u32 parent{ nodes[leaf].parent };
+			const u32 grand_parent{ nodes[parent].parent };
+			const u32 sibling{ nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left };
+			replace_child(grand_parent, parent, sibling);
+			nodes[sibling].parent = grand_parent;
+			release_node(parent);
+
+			refit_up(grand_parent);
+		}
+
+	} // Anonymous namespace
+
+	void add(game_entity::entity entity, f32 radius /* = 0.5f */)
+	{
+		assert(game_entity::is_alive(entity.get_id()));
+		const id::id_type entity_index{ id::index(entity.get_id()) };
+		if (proxy_mapping.size() <= entity_index) proxy_mapping.resize(entity_index + 1, u32_invalid_id);
+		assert(proxy_mapping[entity_index] == u32_invalid_id); // Entity is already in the tree
+
+		const transform::storage_view transforms{ transform::view() };
+		const math::v3& position{ transforms.positions[entity_index] };
+
+		const u32 leaf{ allocate_node() };
+		nodes[leaf].box = fatten(entity_box(position, transforms.scales[entity_index], radius), {});
+		nodes[leaf].entity = entity.get_id();
+		insert_leaf(leaf);
+
+		proxy_mapping[entity_index] = (u32)proxies.size();
+		proxies.push_back({ entity.get_id(), leaf, radius, position });
+	}
+
+	void remove(game_entity::entity_id id)
+	{
+		const id::id_type entity_index{ id::index(id) };
+		assert(entity_index < proxy_mapping.size() && proxy_mapping[entity_index] != u32_invalid_id);
+		const u32 index{ proxy_mapping[entity_index] };
+
+		remove_leaf(proxies[index].node);
+		release_node(proxies[index].node);
+
+		// Move the last proxy into the removed slot
+		proxy_mapping[id::index(proxies.back().id)] = index;
+		proxy_mapping[entity_index] = u32_invalid_id;
+		utl::erase_unordered(proxies, index);
+	}
+
+	void update()
+	{
+		const transform::storage_view transforms{ transform::view() };
+		for (auto& p : proxies)
+		{
+			const id::id_type entity_index{ id::index(p.id) };
+			const math::v3& position{ transforms.positions[entity_index] };
+			const aabb box{ entity_box(position, transforms.scales[entity_index], p.radius) };
+
+			// Most entities stay inside their fat box, so this is the only work done for them
+			if (contains(nodes[p.node].box, box)) continue;
+
+			const math::v3 displacement{ position.x - p.last_position.x, position.y - p.last_position.y, position.z - p.last_position.z };
+			remove_leaf(p.node);
+			nodes[p.node].box = fatten(box, displacement);
+			insert_leaf(p.node);
+			p.last_position = position;
+		}
+	}
+
+	void clear()
+	{
+		nodes.clear();
+		proxies.clear();
+		proxy_mapping.clear();
+		root = u32_invalid_id;
+		free_node = u32_invalid_id;
+	}
+
+	void query_sphere(math::v3 center, f32 radius, utl::vector<game_entity::entity_id>& results)
+	{
+		if (root == u32_invalid_id) return;
+		const f32 radius_sq{ radius * radius };
+		const transform::storage_view transforms{ transform::view() };
+
+		stack.clear();
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			const node& n{ nodes[stack.back()] };
+			stack.pop_back();
+			if (distance_sq(n.box, center) > radius_sq) continue;
+
+			if (n.is_leaf())
+			{
+				// Test the real bounds, not the fat box
+				const id::id_type entity_index{ id::index(n.entity) };
+				const proxy& p{ proxies[proxy_mapping[entity_index]] };
+				const aabb box{ entity_box(transforms.positions[entity_index], transforms.scales[entity_index], p.radius) };
+				if (distance_sq(box, center) <= radius_sq) results.push_back(p.id);
+			}
+			else
+			{
+				stack.push_back(n.left);
+				stack.push_back(n.right);
+			}
+		}
+	}
+
+	void query_box(math::v3 min, math::v3 max, utl::vector<game_entity::entity_id>& results)
+	{
+		if (root == u32_invalid_id) return;
+		const aabb query{ min, max };
+		const transform::storage_view transforms{ transform::view() };
+
+		stack.clear();
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			const node& n{ nodes[stack.back()] };
+			stack.pop_back();
+			if (!overlaps(n.box, query)) continue;
+
+			if (n.is_leaf())
+			{
+				const id::id_type entity_index{ id::index(n.entity) };
+				const proxy& p{ proxies[proxy_mapping[entity_index]] };
+				const aabb box{ entity_box(transforms.positions[entity_index], transforms.scales[entity_index], p.radius) };
+				if (overlaps(box, query)) results.push_back(p.id);
+			}
+			else
+			{
+				stack.push_back(n.left);
+				stack.push_back(n.right);
+			}
+		}
+	}
+
+	void query_ray(math::v3 origin, math::v3 direction, f32 max_distance, utl::vector<game_entity::entity_id>& results)
+	{
+		if (root == u32_invalid_id) return;
+		const f32 length{ sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z) };
+		assert(length > math::epsilon);
+		if (length <= math::epsilon) return;
+
+		// Work with a normalized direction so max_t is in world units. Division by zero gives infinity which the slab test handles
+		const math::v3 inv_dir{ length / direction.x, length / direction.y, length / direction.z };
+		const transform::storage_view transforms{ transform::view() };
+
+		stack.clear();
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			const node& n{ nodes[stack.back()] };
+			stack.pop_back();
+			if (!ray_hits(n.box, origin, inv_dir, max_distance)) continue;
+
+			if (n.is_leaf())
+			{
+				const id::id_type entity_index{ id::index(n.entity) };
+				const proxy& p{ proxies[proxy_mapping[entity_index]] };
+				const aabb box{ entity_box(transforms.positions[entity_index], transforms.scales[entity_index], p.radius) };
+				if (ray_hits(box, origin, inv_dir, max_distance)) results.push_back(p.id);
+			}
+			else
+			{
+				stack.push_back(n.left);
+				stack.push_back(n.right);
+			}
+		}
+	}
+
+	u32 count()
+	{
+		return (u32)proxies.size();
+	}
+
+	u32 tree_height()
+	{
+		return root == u32_invalid_id ? 0 : (u32)nodes[root].height;
+	}
+}
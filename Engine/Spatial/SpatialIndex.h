@@ -0,0 +1,34 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "../Components/ComponentsCommon.h"
+
+namespace savage::spatial {
+
+	// Start tracking an entity. Its bounds are a box around its position with a half size of radius * largest scale
+	void add(game_entity::entity entity, f32 radius = 0.5f);
+	// Stop tracking an entity
+	void remove(game_entity::entity_id id);
+	// Read the transforms of all tracked entities and move the ones that left their bounds in the tree
+	// NOTE: Call once per frame after the transforms have been updated. Queries use the bounds from the last update
+	void update();
+	// Remove all entities and free the tree
+	void clear();
+
+	// Find all entities whose bounds touch the sphere
+	void query_sphere(math::v3 center, f32 radius, utl::vector<game_entity::entity_id>& results);
+	// Find all entities whose bounds touch the box
+	void query_box(math::v3 min, math::v3 max, utl::vector<game_entity::entity_id>& results);
+	// Find all entities whose bounds are hit by the ray (direction doesn't have to be normalized)
+	void query_ray(math::v3 origin, math::v3 direction, f32 max_distance, utl::vector<game_entity::entity_id>& results);
+
+	// Number of tracked entities
+	u32 count();
+	// Height of the tree (for checking the balance in tests)
+	u32 tree_height();
+}
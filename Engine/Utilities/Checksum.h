@@ -0,0 +1,40 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "CommonHeaders.h"
+
+namespace savage::utl {
+	namespace detail {
+		// Lookup table for the standard (IEEE, reflected) CRC-32 polynomial
+		struct crc32_table
+		{
+			u32 values[256];
+
+			constexpr crc32_table() : values{}
+			{
+				for (u32 i{ 0 }; i < 256; ++i)
+				{
+					u32 crc{ i };
+					for (u32 bit{ 0 }; bit < 8; ++bit) crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+					values[i] = crc;
+				}
+			}
+		};
+		constexpr crc32_table crc32_lookup{};
+	} // detail namespace
+
+	// CRC-32 of the data. Pass the result of a previous call as crc to continue over more data.
+	// Gives the same values as zlib and System.IO.Hashing.Crc32
+	inline u32 crc32(const void* const data, size_t size, u32 crc = 0)
+	{
+		const u8* bytes{ (const u8*)data };
+		crc = ~crc;
+		for (size_t i{ 0 }; i < size; ++i) crc = (crc >> 8) ^ detail::crc32_lookup.values[(crc ^ bytes[i]) & 0xff];
+		return ~crc;
+	}
+}
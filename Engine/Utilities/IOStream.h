@@ -0,0 +1,171 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "CommonHeaders.h"
+#include <string.h>
+#include <type_traits>
+
+namespace savage::utl {
+
+	// Reads data from a blob of memory and moves the read position along
+	// Reads are not checked against the size (only asserted): data that can be broken has to be checked
+	// with remaining() first
+	// NOTE: The caller has to make sure the buffer outlives the reader
+	class blob_stream_reader
+	{
+	public:
+		blob_stream_reader(const u8* buffer, size_t size)
+			: _buffer{ buffer }, _position{ buffer }, _end{ buffer + size }
+		{
+			assert(buffer);
+		}
+
+		// Read a single value of a trivial type
+		template<typename T>
+		T read()
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be read from a blob");
+			assert(sizeof(T) <= remaining());
+			T value{};
+			memcpy(&value, _position, sizeof(T)); // Copy the data (the buffer may not be aligned for T)
+			_position += sizeof(T); // Move the read pointer
+			return value;
+		}
+
+		// Read a raw block of bytes
+		void read(void* buffer, size_t length)
+		{
+			assert(length <= remaining());
+			memcpy(buffer, _position, length); // Copy the data
+			_position += length; // Move the read pointer
+		}
+
+		// Move the read pointer without reading anything
+		void skip(size_t offset) { assert(offset <= remaining()); _position += offset; }
+
+		constexpr const u8* buffer_start() const { return _buffer; }
+		constexpr const u8* position() const { return _position; }
+		constexpr size_t offset() const { return _position - _buffer; }
+		// Bytes left to read
+		constexpr size_t remaining() const { return _end - _position; }
+
+	private:
+		const u8* const	_buffer;
+		const u8*		_position;
+		const u8* const	_end;
+	};
+
+	// Appends data to a growable buffer
+	class blob_stream_writer
+	{
+	public:
+		explicit blob_stream_writer(utl::vector<u8>& buffer)
+			: _buffer{ buffer } {}
+
+		// Write a single value of a trivial type
+		template<typename T>
+		void write(T value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written to a blob");
+			const size_t offset{ _buffer.size() };
+			_buffer.resize(offset + sizeof(T));
+			memcpy(_buffer.data() + offset, &value, sizeof(T));
+		}
+
+		// Write a raw block of bytes
+		void write(const void* data, size_t length)
+		{
+			// NOTE: insert() copies straight into the new space, unlike resize() which would clear it first
+			const u8* const bytes{ (const u8*)data };
+			_buffer.insert(_buffer.end(), bytes, bytes + length);
+		}
+
+		// Overwrite a value that was already written (used to patch sizes after the fact)
+		template<typename T>
+		void write_at(size_t offset, T value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written to a blob");
+			assert(offset + sizeof(T) <= _buffer.size());
+			memcpy(_buffer.data() + offset, &value, sizeof(T));
+		}
+
+		size_t offset() const { return _buffer.size(); }
+
+	private:
+		utl::vector<u8>& _buffer;
+	};
+
+	// Packs values with any number of bits (up to 32) into a growable buffer
+	class bit_stream_writer
+	{
+	public:
+		explicit bit_stream_writer(utl::vector<u8>& buffer)
+			: _buffer{ buffer } {}
+
+		void write(u32 value, u32 bits)
+		{
+			assert(bits <= 32 && (bits == 32 || value < (u32{ 1 } << bits)));
+			_scratch |= (u64)value << _scratch_bits;
+			_scratch_bits += bits;
+			// Move whole bytes to the buffer
+			while (_scratch_bits >= 8)
+			{
+				_buffer.push_back((u8)_scratch);
+				_scratch >>= 8;
+				_scratch_bits -= 8;
+			}
+		}
+
+		// Write the remaining bits. Must be called when done writing
+		void flush()
+		{
+			if (_scratch_bits) _buffer.push_back((u8)_scratch);
+			_scratch = 0;
+			_scratch_bits = 0;
+		}
+
+	private:
+		utl::vector<u8>&	_buffer;
+		u64					_scratch{ 0 };
+		u32					_scratch_bits{ 0 };
+	};
+
+	// Reads values written by bit_stream_writer
+	// NOTE: The caller has to make sure the buffer outlives the reader
+	class bit_stream_reader
+	{
+	public:
+		bit_stream_reader(const u8* buffer, size_t size)
+			: _position{ buffer }, _end{ buffer + size }
+		{
+			assert(buffer);
+		}
+
+		u32 read(u32 bits)
+		{
+			assert(bits <= 32);
+			// Refill the scratch a byte at a time. Reading past the end gives zeros
+			while (_scratch_bits < bits)
+			{
+				const u64 byte{ _position < _end ? *_position++ : 0u };
+				_scratch |= byte << _scratch_bits;
+				_scratch_bits += 8;
+			}
+			const u32 value{ (u32)(_scratch & ((u64{ 1 } << bits) - 1)) };
+			_scratch >>= bits;
+			_scratch_bits -= bits;
+			return value;
+		}
+
+	private:
+		const u8*		_position;
+		const u8* const	_end;
+		u64				_scratch{ 0 };
+		u32				_scratch_bits{ 0 };
+	};
+}
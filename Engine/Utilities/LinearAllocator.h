@@ -0,0 +1,193 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "CommonHeaders.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace savage::utl {
+
+	// Hands out memory from one block by moving a pointer forward. Nothing is freed on its own,
+	// everything goes away at once with reset(). Meant for data that only lives for one frame.
+	class linear_allocator
+	{
+	public:
+		explicit linear_allocator(size_t capacity)
+			: _buffer{ new u8[capacity] }, _capacity{ capacity } {}
+
+		// Returns nullptr if there is not enough space left
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			assert(alignment && !(alignment & (alignment - 1))); // Must be a power of 2
+			// Align the address, not the offset. new only aligns the buffer for the largest standard type
+			const uintptr_t base{ (uintptr_t)_buffer.get() };
+			const size_t start{ (size_t)(((base + _offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base) };
+			if (start + size > _capacity) return nullptr;
+			_offset = start + size;
+			return _buffer.get() + start;
+		}
+
+		// Allocate room for count elements of T. The elements are NOT constructed
+		template<typename T>
+		T* allocate(size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "Destructors are never called for memory from a linear allocator");
+			return (T*)allocate(count * sizeof(T), alignof(T));
+		}
+
+		// Only gives the memory back if it was the last allocation, so a temporary that is freed right away can be reused
+		void free(void* p, size_t size)
+		{
+			assert(owns(p));
+			if ((u8*)p + size == _buffer.get() + _offset) _offset = (size_t)((u8*)p - _buffer.get());
+		}
+
+		// Free everything that was allocated
+		void reset() { _offset = 0; }
+		// Free everything that was allocated after mark() returned this
+		void rewind(size_t mark) { assert(mark <= _offset); _offset = mark; }
+		constexpr size_t mark() const { return _offset; }
+
+		bool owns(const void* p) const { return p >= _buffer.get() && p < _buffer.get() + _capacity; }
+		constexpr size_t used() const { return _offset; }
+		constexpr size_t capacity() const { return _capacity; }
+
+	private:
+		std::unique_ptr<u8[]>	_buffer;
+		const size_t			_capacity;
+		size_t					_offset{ 0 };
+	};
+
+	// The frame the frame arenas are in. Call next_frame() once at the start of every frame
+	inline std::atomic<u64> current_frame{ 0 };
+	inline void next_frame() { current_frame.fetch_add(1, std::memory_order_release); }
+
+	// One linear allocator for each of the last frame_count frames. Memory from a frame stays valid for
+	// frame_count - 1 more frames, long enough for the next frame (or the GPU) to read it
+	class frame_arena
+	{
+	public:
+		frame_arena(size_t capacity_per_frame, u32 frame_count)
+		{
+			assert(frame_count >= 1 && frame_count <= max_frames);
+			for (u32 i{ 0 }; i < frame_count; ++i) _frames[i] = std::make_unique<linear_allocator>(capacity_per_frame);
+			_frame_count = frame_count;
+		}
+
+		// The allocator of the current frame, emptied the first time it is used in a frame
+		linear_allocator& current()
+		{
+			const u64 frame{ current_frame.load(std::memory_order_acquire) };
+			if (frame != _frame)
+			{
+				_frame = frame;
+				_current = _frames[frame % _frame_count].get();
+				_current->reset();
+			}
+			return *_current;
+		}
+
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return current().allocate(size, alignment); }
+		void free(void* p, size_t size) { if (_current && _current->owns(p)) _current->free(p, size); }
+
+		bool owns(const void* p) const
+		{
+			if (_current && _current->owns(p)) return true;
+			for (u32 i{ 0 }; i < _frame_count; ++i) if (_frames[i]->owns(p)) return true;
+			return false;
+		}
+
+	private:
+		static constexpr u32				max_frames{ 3 };
+		std::unique_ptr<linear_allocator>	_frames[max_frames];
+		u32									_frame_count;
+		linear_allocator*					_current{ nullptr };
+		u64									_frame{ u64_invalid_id };
+	};
+
+	// STL allocator over an arena. Allocations that don't fit go to the heap, so a container
+	// never fails, it just stops being free. Freed arena memory is only reused if it was the last allocation
+	template<typename T, typename Arena>
+	class arena_allocator
+	{
+	public:
+		using value_type = T;
+
+		explicit arena_allocator(Arena* arena) : _arena{ arena } { assert(arena); }
+		template<typename U>
+		arena_allocator(const arena_allocator<U, Arena>& other) : _arena{ other.arena() } {}
+
+		T* allocate(size_t count)
+		{
+			if (void* p{ _arena->allocate(count * sizeof(T), alignof(T)) }) return (T*)p;
+			return (T*)::operator new(count * sizeof(T));
+		}
+
+		void deallocate(T* p, size_t count)
+		{
+			if (_arena->owns(p)) _arena->free(p, count * sizeof(T));
+			else ::operator delete(p);
+		}
+
+		Arena* arena() const { return _arena; }
+
+		template<typename U>
+		bool operator==(const arena_allocator<U, Arena>& other) const { return _arena == other.arena(); }
+		template<typename U>
+		bool operator!=(const arena_allocator<U, Arena>& other) const { return _arena != other.arena(); }
+
+	private:
+		Arena* _arena;
+	};
+
+	template<typename T> using scratch_allocator = arena_allocator<T, linear_allocator>;
+	template<typename T> using frame_allocator = arena_allocator<T, frame_arena>;
+
+	constexpr size_t frame_arena_size{ 4 * 1024 * 1024 };
+	constexpr u32 frame_arena_frames{ 2 };
+	constexpr size_t scratch_size{ 4 * 1024 * 1024 };
+
+	// Each thread has its own frame arena and scratch memory, made the first time the thread uses them
+	// NOTE: a job on a fiber can go on on another thread after jobs::wait(), get them again after waiting
+	inline frame_arena& thread_frame_arena()
+	{
+		thread_local frame_arena arena{ frame_arena_size, frame_arena_frames };
+		return arena;
+	}
+
+	inline linear_allocator& thread_scratch_memory()
+	{
+		thread_local linear_allocator memory{ scratch_size };
+		return memory;
+	}
+
+	// Temporary memory for a scope, taken from this thread's scratch memory and given back when the scope ends.
+	// Scopes can be nested, and anything allocated from it (vectors included) must be gone before it is
+	//	utl::scratch scratch{};
+	//	utl::vector<u32, utl::scratch_allocator<u32>> ids{ scratch.allocator<u32>() };
+	class scratch
+	{
+	public:
+		scratch() : _memory{ thread_scratch_memory() }, _mark{ _memory.mark() } {}
+		~scratch() { _memory.rewind(_mark); }
+		scratch(const scratch&) = delete;
+		scratch& operator=(const scratch&) = delete;
+
+		template<typename T>
+		scratch_allocator<T> allocator() { return scratch_allocator<T>{ &_memory }; }
+
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return _memory.allocate(size, alignment); }
+
+	private:
+		linear_allocator&	_memory;
+		const size_t		_mark;
+	};
+}
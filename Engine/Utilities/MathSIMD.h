@@ -0,0 +1,331 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "CommonHeaders.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// SIMD math that works the same on every platform. simd::floatv holds as many floats as the widest vector
+// the build targets: 8 with AVX2, 4 with SSE or NEON and 4 plain floats without either. The batch kernels
+// at the bottom are written once on top of it and work on the math:: types, which are DirectXMath types
+// on Windows and plain structs elsewhere. Define MATH_SIMD_FORCE_SCALAR to test the fallback
+#if !defined(MATH_SIMD_FORCE_SCALAR) && defined(__AVX2__)
+#define MATH_SIMD_AVX2 1
+#include <immintrin.h>
+#elif !defined(MATH_SIMD_FORCE_SCALAR) && (defined(_M_X64) || defined(__SSE2__))
+#define MATH_SIMD_SSE 1
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define MATH_SIMD_SSE4 1
+#include <smmintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+#elif !defined(MATH_SIMD_FORCE_SCALAR) && (defined(__aarch64__) || defined(_M_ARM64))
+#define MATH_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define MATH_SIMD_SCALAR 1
+#endif
+
+namespace savage::math::simd {
+
+#if MATH_SIMD_AVX2
+	constexpr const char* isa_name{ "AVX2" };
+
+	struct floatv
+	{
+		static constexpr u32 width{ 8 };
+		__m256 v;
+
+		static floatv load(const f32* p) { return { _mm256_loadu_ps(p) }; }
+		static floatv set1(f32 x) { return { _mm256_set1_ps(x) }; }
+		void store(f32* p) const { _mm256_storeu_ps(p, v); }
+	};
+
+	inline floatv operator+(floatv a, floatv b) { return { _mm256_add_ps(a.v, b.v) }; }
+	inline floatv operator-(floatv a, floatv b) { return { _mm256_sub_ps(a.v, b.v) }; }
+	inline floatv operator*(floatv a, floatv b) { return { _mm256_mul_ps(a.v, b.v) }; }
+	inline floatv operator/(floatv a, floatv b) { return { _mm256_div_ps(a.v, b.v) }; }
+#if defined(__FMA__)
+	inline floatv fmadd(floatv a, floatv b, floatv c) { return { _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+	inline floatv fnmadd(floatv a, floatv b, floatv c) { return { _mm256_fnmadd_ps(a.v, b.v, c.v) }; }
+#else
+	inline floatv fmadd(floatv a, floatv b, floatv c) { return a * b + c; }
+	inline floatv fnmadd(floatv a, floatv b, floatv c) { return c - a * b; }
+#endif
+	inline floatv min(floatv a, floatv b) { return { _mm256_min_ps(a.v, b.v) }; }
+	inline floatv max(floatv a, floatv b) { return { _mm256_max_ps(a.v, b.v) }; }
+	inline floatv sqrt(floatv a) { return { _mm256_sqrt_ps(a.v) }; }
+	inline floatv round(floatv a) { return { _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC) }; }
+	inline floatv cmp_lt(floatv a, floatv b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+	inline floatv bit_and(floatv a, floatv b) { return { _mm256_and_ps(a.v, b.v) }; }
+	inline floatv bit_or(floatv a, floatv b) { return { _mm256_or_ps(a.v, b.v) }; }
+	inline floatv bit_xor(floatv a, floatv b) { return { _mm256_xor_ps(a.v, b.v) }; }
+	inline floatv select(floatv mask, floatv a, floatv b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+	// All bits set in the lanes where bit is set in the integer in a (which has to be a whole number)
+	inline floatv lane_bit(floatv a, u32 bit)
+	{
+		const __m256i b{ _mm256_set1_epi32(1 << bit) };
+		return { _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_cvtps_epi32(a.v), b), b)) };
+	}
+
+#elif MATH_SIMD_SSE
+#if MATH_SIMD_SSE4
+	constexpr const char* isa_name{ "SSE4.1" };
+#else
+	constexpr const char* isa_name{ "SSE2" };
+#endif
+
+	struct floatv
+	{
+		static constexpr u32 width{ 4 };
+		__m128 v;
+
+		static floatv load(const f32* p) { return { _mm_loadu_ps(p) }; }
+		static floatv set1(f32 x) { return { _mm_set1_ps(x) }; }
+		void store(f32* p) const { _mm_storeu_ps(p, v); }
+	};
+
+	inline floatv operator+(floatv a, floatv b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline floatv operator-(floatv a, floatv b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline floatv operator*(floatv a, floatv b) { return { _mm_mul_ps(a.v, b.v) }; }
+	inline floatv operator/(floatv a, floatv b) { return { _mm_div_ps(a.v, b.v) }; }
+	inline floatv fmadd(floatv a, floatv b, floatv c) { return a * b + c; }
+	inline floatv fnmadd(floatv a, floatv b, floatv c) { return c - a * b; }
+	inline floatv min(floatv a, floatv b) { return { _mm_min_ps(a.v, b.v) }; }
+	inline floatv max(floatv a, floatv b) { return { _mm_max_ps(a.v, b.v) }; }
+	inline floatv sqrt(floatv a) { return { _mm_sqrt_ps(a.v) }; }
+#if MATH_SIMD_SSE4
+	inline floatv round(floatv a) { return { _mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC) }; }
+#else
+	// The conversion rounds to nearest, which is fine for the angles and values this is used for
+	inline floatv round(floatv a) { return { _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)) }; }
+#endif
+	inline floatv cmp_lt(floatv a, floatv b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+	inline floatv bit_and(floatv a, floatv b) { return { _mm_and_ps(a.v, b.v) }; }
+	inline floatv bit_or(floatv a, floatv b) { return { _mm_or_ps(a.v, b.v) }; }
+	inline floatv bit_xor(floatv a, floatv b) { return { _mm_xor_ps(a.v, b.v) }; }
+#if MATH_SIMD_SSE4
+	inline floatv select(floatv mask, floatv a, floatv b) { return { _mm_blendv_ps(b.v, a.v, mask.v) }; }
+#else
+	inline floatv select(floatv mask, floatv a, floatv b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+#endif
+	inline floatv lane_bit(floatv a, u32 bit)
+	{
+		const __m128i b{ _mm_set1_epi32(1 << bit) };
+		return { _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_cvtps_epi32(a.v), b), b)) };
+	}
+
+#elif MATH_SIMD_NEON
+	constexpr const char* isa_name{ "NEON" };
+
+	struct floatv
+	{
+		static constexpr u32 width{ 4 };
+		float32x4_t v;
+
+		static floatv load(const f32* p) { return { vld1q_f32(p) }; }
+		static floatv set1(f32 x) { return { vdupq_n_f32(x) }; }
+		void store(f32* p) const { vst1q_f32(p, v); }
+	};
+
+	inline floatv operator+(floatv a, floatv b) { return { vaddq_f32(a.v, b.v) }; }
+	inline floatv operator-(floatv a, floatv b) { return { vsubq_f32(a.v, b.v) }; }
+	inline floatv operator*(floatv a, floatv b) { return { vmulq_f32(a.v, b.v) }; }
+	inline floatv operator/(floatv a, floatv b) { return { vdivq_f32(a.v, b.v) }; }
+	inline floatv fmadd(floatv a, floatv b, floatv c) { return { vfmaq_f32(c.v, a.v, b.v) }; }
+	inline floatv fnmadd(floatv a, floatv b, floatv c) { return { vfmsq_f32(c.v, a.v, b.v) }; }
+	inline floatv min(floatv a, floatv b) { return { vminq_f32(a.v, b.v) }; }
+	inline floatv max(floatv a, floatv b) { return { vmaxq_f32(a.v, b.v) }; }
+	inline floatv sqrt(floatv a) { return { vsqrtq_f32(a.v) }; }
+	inline floatv round(floatv a) { return { vrndnq_f32(a.v) }; }
+	inline floatv cmp_lt(floatv a, floatv b) { return { vreinterpretq_f32_u32(vcltq_f32(a.v, b.v)) }; }
+	inline floatv bit_and(floatv a, floatv b) { return { vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))) }; }
+	inline floatv bit_or(floatv a, floatv b) { return { vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))) }; }
+	inline floatv bit_xor(floatv a, floatv b) { return { vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))) }; }
+	inline floatv select(floatv mask, floatv a, floatv b) { return { vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v) }; }
+	inline floatv lane_bit(floatv a, u32 bit)
+	{
+		return { vreinterpretq_f32_u32(vtstq_s32(vcvtnq_s32_f32(a.v), vdupq_n_s32(1 << bit))) };
+	}
+
+#else
+	constexpr const char* isa_name{ "Scalar" };
+
+	// Same interface on plain floats. Masks are floats with all bits set
+	struct floatv
+	{
+		static constexpr u32 width{ 4 };
+		f32 v[4];
+
+		static floatv load(const f32* p) { return { { p[0], p[1], p[2], p[3] } }; }
+		static floatv set1(f32 x) { return { { x, x, x, x } }; }
+		void store(f32* p) const { memcpy(p, v, sizeof(v)); }
+	};
+
+	namespace detail {
+		inline u32 bits(f32 x) { u32 u; memcpy(&u, &x, sizeof(u)); return u; }
+		inline f32 from_bits(u32 u) { f32 x; memcpy(&x, &u, sizeof(x)); return x; }
+
+		template<typename F>
+		floatv each(F&& f) { floatv r; for (u32 i{ 0 }; i < floatv::width; ++i) r.v[i] = f(i); return r; }
+	}
+
+	inline floatv operator+(floatv a, floatv b) { return detail::each([&](u32 i) { return a.v[i] + b.v[i]; }); }
+	inline floatv operator-(floatv a, floatv b) { return detail::each([&](u32 i) { return a.v[i] - b.v[i]; }); }
+	inline floatv operator*(floatv a, floatv b) { return detail::each([&](u32 i) { return a.v[i] * b.v[i]; }); }
+	inline floatv operator/(floatv a, floatv b) { return detail::each([&](u32 i) { return a.v[i] / b.v[i]; }); }
+	inline floatv fmadd(floatv a, floatv b, floatv c) { return a * b + c; }
+	inline floatv fnmadd(floatv a, floatv b, floatv c) { return c - a * b; }
+	inline floatv min(floatv a, floatv b) { return detail::each([&](u32 i) { return b.v[i] < a.v[i] ? b.v[i] : a.v[i]; }); }
+	inline floatv max(floatv a, floatv b) { return detail::each([&](u32 i) { return a.v[i] < b.v[i] ? b.v[i] : a.v[i]; }); }
+	inline floatv sqrt(floatv a) { return detail::each([&](u32 i) { return sqrtf(a.v[i]); }); }
+	inline floatv round(floatv a) { return detail::each([&](u32 i) { return nearbyintf(a.v[i]); }); }
+	inline floatv cmp_lt(floatv a, floatv b) { return detail::each([&](u32 i) { return detail::from_bits(a.v[i] < b.v[i] ? ~0u : 0u); }); }
+	inline floatv bit_and(floatv a, floatv b) { return detail::each([&](u32 i) { return detail::from_bits(detail::bits(a.v[i]) & detail::bits(b.v[i])); }); }
+	inline floatv bit_or(floatv a, floatv b) { return detail::each([&](u32 i) { return detail::from_bits(detail::bits(a.v[i]) | detail::bits(b.v[i])); }); }
+	inline floatv bit_xor(floatv a, floatv b) { return detail::each([&](u32 i) { return detail::from_bits(detail::bits(a.v[i]) ^ detail::bits(b.v[i])); }); }
+	inline floatv select(floatv mask, floatv a, floatv b) { return detail::each([&](u32 i) { return detail::bits(mask.v[i]) ? a.v[i] : b.v[i]; }); }
+	inline floatv lane_bit(floatv a, u32 bit) { return detail::each([&](u32 i) { return detail::from_bits(((s32)a.v[i] >> bit) & 1 ? ~0u : 0u); }); }
+#endif
+
+	inline floatv operator-(floatv a) { return bit_xor(a, floatv::set1(-0.f)); }
+	inline floatv abs(floatv a) { return select(cmp_lt(a, floatv::set1(0.f)), -a, a); }
+
+	// Sine and cosine of each lane. Within 2 ulp for |x| < 8192, which covers any angle an editor makes
+	inline void sin_cos(floatv x, floatv& s, floatv& c)
+	{
+		// Take out the nearest multiple q of pi/2 in three steps, each product is exact
+		const floatv q{ round(x * floatv::set1(0.636619772f)) };
+		floatv r{ fnmadd(q, floatv::set1(1.5703125f), x) };
+		r = fnmadd(q, floatv::set1(4.837512969970703125e-4f), r);
+		r = fnmadd(q, floatv::set1(7.54978995489188216e-8f), r);
+
+		// Polynomials for r in [-pi/4, pi/4] (Cephes sinf and cosf)
+		const floatv r2{ r * r };
+		floatv ps{ fmadd(fmadd(floatv::set1(-1.9515295891e-4f), r2, floatv::set1(8.3321608736e-3f)), r2, floatv::set1(-1.6666654611e-1f)) };
+		ps = fmadd(ps * r2, r, r);
+		floatv pc{ fmadd(fmadd(floatv::set1(2.443315711809948e-5f), r2, floatv::set1(-1.388731625493765e-3f)), r2, floatv::set1(4.166664568298827e-2f)) };
+		pc = fmadd(pc * r2, r2, fnmadd(floatv::set1(0.5f), r2, floatv::set1(1.f)));
+
+		// Odd quadrants swap sine and cosine, the sign comes from bit 1 of q (and of q + 1 for the cosine)
+		const floatv swap{ lane_bit(q, 0) };
+		const floatv sign{ floatv::set1(-0.f) };
+		s = bit_xor(select(swap, pc, ps), bit_and(lane_bit(q, 1), sign));
+		c = bit_xor(select(swap, ps, pc), bit_and(lane_bit(q + floatv::set1(1.f), 1), sign));
+	}
+
+	// Load up to width structs of N floats each as N vectors (structure of arrays). Lanes past count repeat the last one
+	template<u32 N, typename T>
+	void load_soa(const T* src, u32 count, floatv (&out)[N])
+	{
+		static_assert(sizeof(T) == N * sizeof(f32));
+		f32 lanes[N][floatv::width];
+		for (u32 i{ 0 }; i < floatv::width; ++i)
+		{
+			const f32* const p{ (const f32*)&src[std::min(i, count - 1)] };
+			for (u32 k{ 0 }; k < N; ++k) lanes[k][i] = p[k];
+		}
+		for (u32 k{ 0 }; k < N; ++k) out[k] = floatv::load(lanes[k]);
+	}
+
+	// Store the first count lanes of N vectors as count structs of N floats
+	template<u32 N, typename T>
+	void store_soa(const floatv (&in)[N], u32 count, T* dst)
+	{
+		static_assert(sizeof(T) == N * sizeof(f32));
+		f32 lanes[N][floatv::width];
+		for (u32 k{ 0 }; k < N; ++k) in[k].store(lanes[k]);
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			f32* const p{ (f32*)&dst[i] };
+			for (u32 k{ 0 }; k < N; ++k) p[k] = lanes[k][i];
+		}
+	}
+}
+
+namespace savage::math {
+
+	// Quaternions from (pitch, yaw, roll) in radians: roll around z, then pitch around x, then yaw around y.
+	// The same rotation as XMQuaternionRotationRollPitchYawFromVector
+	inline void euler_to_quat_batch(const v3* euler, v4* quats, u32 count)
+	{
+		using namespace simd;
+		const floatv half{ floatv::set1(0.5f) };
+		for (u32 i{ 0 }; i < count; i += floatv::width)
+		{
+			const u32 n{ std::min(floatv::width, count - i) };
+			floatv e[3];
+			load_soa(euler + i, n, e);
+			floatv sp, cp, sy, cy, sr, cr;
+			sin_cos(e[0] * half, sp, cp);
+			sin_cos(e[1] * half, sy, cy);
+			sin_cos(e[2] * half, sr, cr);
+
+			const floatv cr_sp{ cr * sp }, sr_cp{ sr * cp }, cr_cp{ cr * cp }, sr_sp{ sr * sp };
+			const floatv q[4]
+			{
+				fmadd(cr_sp, cy, sr_cp * sy),
+				fnmadd(sr_sp, cy, cr_cp * sy),
+				fnmadd(cr_sp, sy, sr_cp * cy),
+				fmadd(cr_cp, cy, sr_sp * sy),
+			};
+			store_soa(q, n, quats + i);
+		}
+	}
+
+	// Hamilton product a * b of each pair: the rotation b followed by the rotation a.
+	// NOTE: XMQuaternionMultiply(q1, q2) is q2 * q1, so it takes its arguments the other way around
+	inline void quat_mul_batch(const v4* a, const v4* b, v4* out, u32 count)
+	{
+		using namespace simd;
+		for (u32 i{ 0 }; i < count; i += floatv::width)
+		{
+			const u32 n{ std::min(floatv::width, count - i) };
+			floatv p[4], q[4];
+			load_soa(a + i, n, p);
+			load_soa(b + i, n, q);
+			const floatv r[4]
+			{
+				fmadd(p[3], q[0], fmadd(p[0], q[3], fnmadd(p[2], q[1], p[1] * q[2]))),
+				fmadd(p[3], q[1], fmadd(p[1], q[3], fnmadd(p[0], q[2], p[2] * q[0]))),
+				fmadd(p[3], q[2], fmadd(p[2], q[3], fnmadd(p[1], q[0], p[0] * q[1]))),
+				fnmadd(p[0], q[0], fnmadd(p[1], q[1], fnmadd(p[2], q[2], p[3] * q[3]))),
+			};
+			store_soa(r, n, out + i);
+		}
+	}
+
+	// Rotate each vector by its unit quaternion: v + w * t + cross(q, t) with t = 2 * cross(q, v)
+	inline void quat_rotate_batch(const v4* quats, const v3* v, v3* out, u32 count)
+	{
+		using namespace simd;
+		const floatv two{ floatv::set1(2.f) };
+		for (u32 i{ 0 }; i < count; i += floatv::width)
+		{
+			const u32 n{ std::min(floatv::width, count - i) };
+			floatv q[4], p[3];
+			load_soa(quats + i, n, q);
+			load_soa(v + i, n, p);
+			const floatv t[3]
+			{
+				two * fnmadd(q[2], p[1], q[1] * p[2]),
+				two * fnmadd(q[0], p[2], q[2] * p[0]),
+				two * fnmadd(q[1], p[0], q[0] * p[1]),
+			};
+			const floatv r[3]
+			{
+				fmadd(q[3], t[0], p[0]) + fnmadd(q[2], t[1], q[1] * t[2]),
+				fmadd(q[3], t[1], p[1]) + fnmadd(q[0], t[2], q[2] * t[0]),
+				fmadd(q[3], t[2], p[2]) + fnmadd(q[1], t[0], q[0] * t[1]),
+			};
+			store_soa(r, n, out + i);
+		}
+	}
+}
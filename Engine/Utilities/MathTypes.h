@@ -26,5 +26,46 @@ namespace savage::math {
 	using m3x3 = DirectX::XMFLOAT3X3; // NOTE: DirectXMath does not have aligned 3x3 matrices
 	using m4x4 = DirectX::XMFLOAT4X4;
 	using m4x4a = DirectX::XMFLOAT4X4A;
+#else
+	// DirectXMath is only on Windows so other platforms get plain types with the same layout and constructors
+	struct v2
+	{
+		float x, y;
+		v2() = default;
+		constexpr v2(float _x, float _y) : x{ _x }, y{ _y } {}
+		explicit v2(const float* p) : x{ p[0] }, y{ p[1] } {}
+	};
+	struct alignas(16) v2a : v2 { using v2::v2; };
+
+	struct v3
+	{
+		float x, y, z;
+		v3() = default;
+		constexpr v3(float _x, float _y, float _z) : x{ _x }, y{ _y }, z{ _z } {}
+		explicit v3(const float* p) : x{ p[0] }, y{ p[1] }, z{ p[2] } {}
+	};
+	struct alignas(16) v3a : v3 { using v3::v3; };
+
+	struct v4
+	{
+		float x, y, z, w;
+		v4() = default;
+		constexpr v4(float _x, float _y, float _z, float _w) : x{ _x }, y{ _y }, z{ _z }, w{ _w } {}
+		explicit v4(const float* p) : x{ p[0] }, y{ p[1] }, z{ p[2] }, w{ p[3] } {}
+	};
+
+	template<typename T> struct t2 { T x, y; };
+	template<typename T> struct t3 { T x, y, z; };
+	template<typename T> struct t4 { T x, y, z, w; };
+	using u32v2 = t2<uint32_t>;
+	using u32v3 = t3<uint32_t>;
+	using u32v4 = t4<uint32_t>;
+	using s32v2 = t2<int32_t>;
+	using s32v3 = t3<int32_t>;
+	using s32v4 = t4<int32_t>;
+
+	struct m3x3 { float m[3][3]; };
+	struct m4x4 { float m[4][4]; };
+	struct alignas(16) m4x4a : m4x4 {};
 #endif
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "CommonHeaders.h"
+#include <math.h>
+#include <string.h>
+
+namespace savage::math {
+
+	// Map a float in [min, max] to an unsigned integer with the given number of bits
+	inline u32 quantize_float(f32 value, f32 min, f32 max, u32 bits)
+	{
+		assert(bits && bits <= 24 && max > min); // f32 only has 24 bits of precision
+		const u32 steps{ (u32{ 1 } << bits) - 1 };
+		const f32 t{ (value - min) / (max - min) };
+		const f32 clamped{ t < 0.f ? 0.f : (t > 1.f ? 1.f : t) };
+		return (u32)(clamped * (f32)steps + 0.5f); // Round to the nearest step
+	}
+
+	// Get back the float from a value made by quantize_float()
+	inline f32 dequantize_float(u32 value, f32 min, f32 max, u32 bits)
+	{
+		assert(bits && bits <= 24 && max > min);
+		const u32 steps{ (u32{ 1 } << bits) - 1 };
+		return min + (max - min) * ((f32)value / (f32)steps);
+	}
+
+	// Convert to a 16 bit (half precision) float. Rounds to nearest, too big values become infinity
+	inline u16 f32_to_f16(f32 value)
+	{
+		u32 bits;
+		memcpy(&bits, &value, sizeof(u32));
+		const u32 sign{ (bits >> 16) & 0x8000 };
+		const s32 exponent{ (s32)((bits >> 23) & 0xff) - 127 + 15 };
+		u32 mantissa{ bits & 0x7fffff };
+
+		if (((bits >> 23) & 0xff) == 0xff) return (u16)(sign | 0x7c00 | (mantissa ? 0x200 : 0)); // Inf or NaN
+		if (exponent >= 31) return (u16)(sign | 0x7c00);
+		if (exponent <= 0)
+		{
+			// Denormal or zero
+			if (exponent < -10) return (u16)sign;
+			mantissa |= 0x800000;
+			const u32 shift{ (u32)(14 - exponent) };
+			return (u16)(sign | ((mantissa + (1u << (shift - 1))) >> shift));
+		}
+		// Rounding can carry into the exponent, which is still the right result
+		return (u16)(sign | (((u32)exponent << 10) + ((mantissa + 0x1000) >> 13)));
+	}
+
+	// Get back the float from a value made by f32_to_f16()
+	inline f32 f16_to_f32(u16 value)
+	{
+		const u32 sign{ (u32)(value & 0x8000) << 16 };
+		u32 exponent{ (u32)(value >> 10) & 0x1f };
+		u32 mantissa{ (u32)value & 0x3ff };
+		u32 bits;
+
+		if (exponent == 0x1f) bits = sign | 0x7f800000 | (mantissa << 13);
+		else if (exponent) bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+		else if (!mantissa) bits = sign;
+		else
+		{
+			// Denormal, make it normal
+			exponent = 127 - 15 + 1;
+			while (!(mantissa & 0x400)) { mantissa <<= 1; --exponent; }
+			bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+		}
+		f32 result;
+		memcpy(&result, &bits, sizeof(f32));
+		return result;
+	}
+
+	// Pack a unit vector with octahedral encoding: the vector is projected on an octahedron which is then unfolded
+	// onto a square, so the error is about the same in every direction.
+	// Layout: [bits for x][bits for y]
+	inline u32 pack_unit_vector(const v3& v, u32 bits = 16)
+	{
+		assert(bits && 2 * bits <= 32);
+		const f32 length{ fabsf(v.x) + fabsf(v.y) + fabsf(v.z) };
+		f32 x{ length > 0.f ? v.x / length : 0.f }, y{ length > 0.f ? v.y / length : 0.f };
+		if (v.z < 0.f)
+		{
+			// Fold the lower half over the diagonals
+			const f32 folded_x{ (1.f - fabsf(y)) * (x < 0.f ? -1.f : 1.f) };
+			y = (1.f - fabsf(x)) * (y < 0.f ? -1.f : 1.f);
+			x = folded_x;
+		}
+		return (quantize_float(x, -1.f, 1.f, bits) << bits) | quantize_float(y, -1.f, 1.f, bits);
+	}
+
+	// Get back the unit vector from a value made by pack_unit_vector()
+	inline v3 unpack_unit_vector(u32 packed, u32 bits = 16)
+	{
+		assert(bits && 2 * bits <= 32);
+		const u32 mask{ (u32{ 1 } << bits) - 1 };
+		const f32 x{ dequantize_float((packed >> bits) & mask, -1.f, 1.f, bits) };
+		const f32 y{ dequantize_float(packed & mask, -1.f, 1.f, bits) };
+		const f32 z{ 1.f - fabsf(x) - fabsf(y) };
+		// Unfold the lower half
+		const f32 t{ z < 0.f ? -z : 0.f };
+		const f32 vx{ x + (x < 0.f ? t : -t) }, vy{ y + (y < 0.f ? t : -t) };
+		const f32 length{ sqrtf(vx * vx + vy * vy + z * z) };
+		return { vx / length, vy / length, z / length };
+	}
+
+	// Pack a unit quaternion with the "smallest three" method:
+	// The biggest component is left out and rebuilt from the other three, since x^2 + y^2 + z^2 + w^2 = 1.
+	// The other three are then always in [-1/sqrt(2), 1/sqrt(2)] which gives them more precision.
+	// Layout: [2 bits index of the biggest component][bits for each of the three smallest]
+	// NOTE: bits_per_component = 10 fits a quaternion in 32 bits
+	inline u32 pack_quaternion(const v4& q, u32 bits_per_component = 10)
+	{
+		assert(bits_per_component && 2 + 3 * bits_per_component <= 32);
+		constexpr f32 range{ 0.707106781f }; // 1 / sqrt(2)
+		const f32 c[4]{ q.x, q.y, q.z, q.w };
+
+		u32 largest{ 0 };
+		for (u32 i{ 1 }; i < 4; ++i)
+		{
+			if (fabsf(c[i]) > fabsf(c[largest])) largest = i;
+		}
+
+		// q and -q are the same rotation, so flip the sign to make the left out component positive
+		const f32 sign{ c[largest] < 0.f ? -1.f : 1.f };
+		u32 packed{ largest };
+		for (u32 i{ 0 }; i < 4; ++i)
+		{
+			if (i == largest) continue;
+			packed = (packed << bits_per_component) | quantize_float(c[i] * sign, -range, range, bits_per_component);
+		}
+		return packed;
+	}
+
+	// Get back the quaternion from a value made by pack_quaternion()
+	inline v4 unpack_quaternion(u32 packed, u32 bits_per_component = 10)
+	{
+		assert(bits_per_component && 2 + 3 * bits_per_component <= 32);
+		constexpr f32 range{ 0.707106781f }; // 1 / sqrt(2)
+		const u32 mask{ (u32{ 1 } << bits_per_component) - 1 };
+		const u32 largest{ (packed >> (3 * bits_per_component)) & 0x3 };
+
+		f32 c[4]{};
+		f32 sum{ 0.f };
+		u32 shift{ 2 * bits_per_component };
+		for (u32 i{ 0 }; i < 4; ++i)
+		{
+			if (i == largest) continue;
+			c[i] = dequantize_float((packed >> shift) & mask, -range, range, bits_per_component);
+			sum += c[i] * c[i];
+			shift -= bits_per_component;
+		}
+		c[largest] = sqrtf(1.f - (sum < 1.f ? sum : 1.f));
+		return { c[0], c[1], c[2], c[3] };
+	}
+}
@@ -14,12 +14,13 @@ MIT License - see LICENSE file
 #if USE_STL_VECTOR
 #include <vector>
 namespace savage::utl {
-	template<typename T>
-	using vector = std::vector<T>;
+	// The allocator can be swapped for one that uses temporary memory (see LinearAllocator.h)
+	template<typename T, typename A = std::allocator<T>>
+	using vector = std::vector<T, A>;
 
 	// Swap two elements in a vector and remove the last element in the vector
-	template<typename T>
-	void erase_unordered(std::vector<T>& v, size_t index)
+	template<typename T, typename A>
+	void erase_unordered(std::vector<T, A>& v, size_t index)
 	{
 		// If the vector has two or more elements
 		if (v.size() > 1)
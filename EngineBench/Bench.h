@@ -0,0 +1,100 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+#include "CommonHeaders.h"
+
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+namespace savage::bench {
+
+	// Heap allocations since the start of the program (counted by the operator new of the benchmark executable)
+	u64 allocation_count();
+
+	struct result
+	{
+		std::string	name;
+		u64			ops{ 0 };
+		u32			samples{ 0 };
+		double			mean{ 0.0 };	// Nanoseconds per operation
+		double			p50{ 0.0 };
+		double			p90{ 0.0 };
+		double			p99{ 0.0 };
+		double			min{ 0.0 };
+		double			max{ 0.0 };
+		double			allocations_per_op{ 0.0 };
+		bool		valid{ true };	// The benchmark checked its own results and they were right
+	};
+
+	// Time a batch of ops_per_sample operations samples times, after one batch to warm up.
+	// func(sample) runs one batch and returns false if it got a wrong result.
+	// The percentiles are of the nanoseconds per operation of each batch
+	template<typename Func>
+	result measure(const char* name, u32 samples, u32 ops_per_sample, Func&& func)
+	{
+		using clock = std::chrono::high_resolution_clock;
+		assert(samples && ops_per_sample);
+		result r{};
+		r.name = name;
+		r.samples = samples;
+		r.ops = (u64)samples * ops_per_sample;
+		r.valid = func(0u);
+
+		utl::vector<double> times(samples);
+		const u64 allocations{ allocation_count() };
+		for (u32 i{ 0 }; i < samples; ++i)
+		{
+			const auto start{ clock::now() };
+			r.valid &= func(i + 1);
+			times[i] = std::chrono::duration<double, std::nano>(clock::now() - start).count() / ops_per_sample;
+		}
+		// NOTE: times was allocated before counting and the clock does not allocate
+		r.allocations_per_op = (double)(allocation_count() - allocations) / (double)r.ops;
+
+		std::sort(times.begin(), times.end());
+		auto percentile = [&times](double p) { return times[std::min((size_t)(p * times.size()), times.size() - 1)]; };
+		double total{ 0.0 };
+		for (double t : times) total += t;
+		r.mean = total / samples;
+		r.p50 = percentile(0.5);
+		r.p90 = percentile(0.9);
+		r.p99 = percentile(0.99);
+		r.min = times.front();
+		r.max = times.back();
+		return r;
+	}
+
+	inline void print(const result& r)
+	{
+		std::cout << std::left << std::setw(24) << r.name << std::right << std::fixed << std::setprecision(1)
+			<< " p50 " << std::setw(9) << r.p50 << " ns  p90 " << std::setw(9) << r.p90 << " ns  p99 " << std::setw(9) << r.p99
+			<< " ns  allocs/op " << std::setprecision(3) << r.allocations_per_op << (r.valid ? "" : "  INVALID") << std::endl;
+	}
+
+	// One object per benchmark so the results of two runs can be compared by a script
+	inline bool write_json(const char* path, const char* config, const utl::vector<result>& results)
+	{
+		std::ofstream file{ path, std::ios::out | std::ios::trunc };
+		if (!file) return false;
+		file << std::setprecision(6) << "{\n  \"config\": \"" << config << "\",\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [\n";
+		for (size_t i{ 0 }; i < results.size(); ++i)
+		{
+			const result& r{ results[i] };
+			file << "    { \"name\": \"" << r.name << "\", \"ops\": " << r.ops << ", \"samples\": " << r.samples
+				<< ", \"mean\": " << r.mean << ", \"p50\": " << r.p50 << ", \"p90\": " << r.p90 << ", \"p99\": " << r.p99
+				<< ", \"min\": " << r.min << ", \"max\": " << r.max << ", \"allocations_per_op\": " << r.allocations_per_op
+				<< ", \"valid\": " << (r.valid ? "true" : "false") << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		file << "  ]\n}\n";
+		return (bool)file;
+	}
+}
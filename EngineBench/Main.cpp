@@ -0,0 +1,404 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+#ifdef _MSC_VER
+#pragma comment(lib, "Engine.lib")
+#endif // _MSC_VER
+
+// Runs every benchmark once and exits, so it can be part of a build or a nightly job:
+//   EngineBench [--json file] [--filter text] [--quick]
+// --json writes the results to the file (EngineBench.json by default), --filter only runs the benchmarks
+// with the text in their name and --quick takes fewer samples. Returns 1 if a benchmark got a wrong result
+
+#include "Bench.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
+#include "../Engine/Components/Script.h"
+#include "../Engine/Content/ContentLoader.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <random>
+#ifdef _WIN64
+#include <Windows.h>
+#endif // _WIN64
+
+#ifdef _MSC_VER
+#define NO_INLINE __declspec(noinline)
+#else
+#define NO_INLINE __attribute__((noinline))
+#endif // _MSC_VER
+
+// Count every heap allocation, including the ones made inside the engine
+namespace {
+	std::atomic<u64> allocations{ 0 };
+
+	// Out of line so the compiler doesn't see the malloc() and free() inside operator new and delete
+	// and warn that they don't match
+	NO_INLINE void* allocate(size_t size, size_t alignment)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		size = size ? size : 1;
+		void* p{ nullptr };
+#ifdef _MSC_VER
+		p = alignment ? _aligned_malloc(size, alignment) : malloc(size);
+#else
+		// aligned_alloc() needs the size to be a multiple of the alignment
+		p = alignment ? aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1)) : malloc(size);
+#endif // _MSC_VER
+		if (!p) throw std::bad_alloc{};
+		return p;
+	}
+
+	NO_INLINE void deallocate(void* p, bool aligned)
+	{
+#ifdef _MSC_VER
+		if (aligned) _aligned_free(p);
+		else free(p);
+#else
+		(void)aligned;
+		free(p);
+#endif // _MSC_VER
+	}
+}
+void* operator new(size_t size) { return allocate(size, 0); }
+void* operator new[](size_t size) { return allocate(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocate(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocate(size, (size_t)alignment); }
+void operator delete(void* p) noexcept { deallocate(p, false); }
+void operator delete[](void* p) noexcept { deallocate(p, false); }
+void operator delete(void* p, size_t) noexcept { deallocate(p, false); }
+void operator delete[](void* p, size_t) noexcept { deallocate(p, false); }
+void operator delete(void* p, std::align_val_t) noexcept { deallocate(p, true); }
+void operator delete[](void* p, std::align_val_t) noexcept { deallocate(p, true); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { deallocate(p, true); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { deallocate(p, true); }
+
+using namespace savage;
+
+u64 bench::allocation_count() { return allocations.load(std::memory_order_relaxed); }
+
+// Script for the update benchmark: reads its transform like most gameplay scripts do
+class bench_script : public script::entity_script
+{
+public:
+	constexpr explicit bench_script(game_entity::entity entity) : script::entity_script{ entity } {}
+	void update(float dt) override
+	{
+		_distance += transform().position().x * dt;
+		++updates;
+	}
+	static inline u64 updates{ 0 };
+private:
+	f32 _distance{ 0.f };
+};
+REGISTER_SCRIPT(bench_script);
+
+namespace {
+	struct settings
+	{
+		u32			samples{ 200 };
+		const char*	filter{ nullptr };
+	};
+
+	transform::init_info random_transform(std::mt19937& random)
+	{
+		std::uniform_real_distribution<f32> unit{ -1.f, 1.f };
+		transform::init_info info{};
+		info.position[0] = unit(random) * 500.f;
+		info.position[1] = unit(random) * 50.f;
+		info.position[2] = unit(random) * 500.f;
+		info.rotation[3] = 1.f;
+		return info;
+	}
+
+	utl::vector<game_entity::entity> create_entities(u32 count, std::mt19937& random, script::init_info* script_info = nullptr)
+	{
+		utl::vector<game_entity::entity> entities;
+		entities.reserve(count);
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			transform::init_info transform_info{ random_transform(random) };
+			game_entity::entity_info info{ &transform_info, script_info };
+			entities.emplace_back(game_entity::create(info));
+		}
+		return entities;
+	}
+
+	void remove_entities(const utl::vector<game_entity::entity>& entities)
+	{
+		for (auto entity : entities) game_entity::remove(entity.get_id());
+	}
+
+	// Create one entity and remove a random one, with 10,000 alive so removed slots get reused
+	bench::result entity_churn(const settings& s)
+	{
+		constexpr u32 ops{ 1000 };
+		std::mt19937 random{ 1 };
+		utl::vector<game_entity::entity> entities{ create_entities(10000, random) };
+		entities.reserve(entities.size() + ops);
+		transform::init_info transform_info{ random_transform(random) };
+		game_entity::entity_info info{ &transform_info };
+
+		bench::result r{ bench::measure("entity_create_remove", s.samples, ops, [&](u32) {
+			bool valid{ true };
+			for (u32 i{ 0 }; i < ops; ++i)
+			{
+				const game_entity::entity created{ game_entity::create(info) };
+				valid &= game_entity::is_alive(created.get_id());
+				entities.emplace_back(created);
+
+				const u32 index{ (u32)random() % (u32)entities.size() };
+				const game_entity::entity_id removed{ entities[index].get_id() };
+				game_entity::remove(removed);
+				utl::erase_unordered(entities, index);
+				valid &= !game_entity::is_alive(removed);
+			}
+			return valid;
+		}) };
+		remove_entities(entities);
+		return r;
+	}
+
+	// Read the transform of random entities through their components
+	bench::result transform_read(const settings& s)
+	{
+		constexpr u32 ops{ 10000 };
+		std::mt19937 random{ 2 };
+		const utl::vector<game_entity::entity> entities{ create_entities(100000, random) };
+		utl::vector<u32> order(ops);
+		for (auto& index : order) index = (u32)random() % (u32)entities.size();
+
+		f32 sum{ 0.f };
+		bench::result r{ bench::measure("transform_read", s.samples, ops, [&](u32) {
+			for (u32 index : order)
+			{
+				const transform::component t{ entities[index].transform() };
+				sum += t.position().x + t.rotation().w + t.scale().y;
+			}
+			return sum == sum; // Not NaN, and the reads can't be optimized away
+		}) };
+		remove_entities(entities);
+		return r;
+	}
+
+	// Overwrite the transform of random entities like replication does
+	bench::result transform_write(const settings& s)
+	{
+		constexpr u32 ops{ 10000 };
+		std::mt19937 random{ 3 };
+		const utl::vector<game_entity::entity> entities{ create_entities(100000, random) };
+		utl::vector<id::id_type> order(ops);
+		for (auto& index : order) index = id::index(entities[(u32)random() % (u32)entities.size()].get_id());
+
+		bench::result r{ bench::measure("transform_write", s.samples, ops, [&](u32 sample) {
+			const math::v3 position{ (f32)sample, 0.f, 0.f }, scale{ 1.f, 1.f, 1.f };
+			const math::v4 rotation{ 0.f, 0.f, 0.f, 1.f };
+			for (id::id_type index : order) transform::set(index, position, rotation, scale);
+			return transform::view().positions[order[0]].x == (f32)sample;
+		}) };
+		remove_entities(entities);
+		return r;
+	}
+
+	// One update of 10,000 scripts per sample
+	bench::result script_update(const settings& s)
+	{
+		constexpr u32 count{ 10000 };
+		std::mt19937 random{ 4 };
+		script::init_info script_info{ &script::detail::create_script<bench_script> };
+		const utl::vector<game_entity::entity> entities{ create_entities(count, random, &script_info) };
+
+		bench::result r{ bench::measure("script_update", std::max(s.samples / 4, 1u), count, [&](u32) {
+			const u64 before{ bench_script::updates };
+			script::update(1.f / 60.f);
+			return bench_script::updates - before == count;
+		}) };
+		remove_entities(entities);
+		return r;
+	}
+
+	// is_alive on a mix of live IDs and stale IDs whose slots were reused
+	bench::result id_validity(const settings& s)
+	{
+		constexpr u32 ops{ 10000 };
+		std::mt19937 random{ 5 };
+		utl::vector<game_entity::entity> entities{ create_entities(20000, random) };
+		utl::vector<game_entity::entity_id> stale;
+		for (u32 i{ 0 }; i < 10000; ++i)
+		{
+			const u32 index{ (u32)random() % (u32)entities.size() };
+			stale.emplace_back(entities[index].get_id());
+			game_entity::remove(entities[index].get_id());
+			utl::erase_unordered(entities, index);
+		}
+		const utl::vector<game_entity::entity> reused{ create_entities(10000, random) };
+		entities.insert(entities.end(), reused.begin(), reused.end());
+
+		utl::vector<game_entity::entity_id> ids(ops);
+		utl::vector<u8> alive(ops);
+		for (u32 i{ 0 }; i < ops; ++i)
+		{
+			alive[i] = (u8)(random() & 1);
+			ids[i] = alive[i] ? entities[(u32)random() % (u32)entities.size()].get_id() : stale[(u32)random() % (u32)stale.size()];
+		}
+
+		bench::result r{ bench::measure("id_is_alive", s.samples, ops, [&](u32) {
+			u32 wrong{ 0 };
+			for (u32 i{ 0 }; i < ops; ++i) wrong += game_entity::is_alive(ids[i]) != (bool)alive[i];
+			return !wrong;
+		}) };
+		remove_entities(entities);
+		return r;
+	}
+
+	std::filesystem::path executable_directory()
+	{
+#ifdef _WIN64
+		wchar_t path[MAX_PATH];
+		const u32 length{ GetModuleFileName(0, &path[0], MAX_PATH) };
+		if (!length || GetLastError() == ERROR_INSUFFICIENT_BUFFER) return {};
+		return std::filesystem::path{ path }.parent_path();
+#else
+		std::error_code error{};
+		const std::filesystem::path p{ std::filesystem::read_symlink("/proc/self/exe", error) };
+		return error ? std::filesystem::path{} : p.parent_path();
+#endif // _WIN64
+	}
+
+	utl::vector<u8> read_file(const std::filesystem::path& path)
+	{
+		std::ifstream file{ path, std::ios::in | std::ios::binary };
+		if (!file) return {};
+		return { std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	}
+
+	bool write_file(const std::filesystem::path& path, const utl::vector<u8>& data)
+	{
+		std::ofstream file{ path, std::ios::out | std::ios::binary | std::ios::trunc };
+		file.write((const char*)data.data(), data.size());
+		return (bool)file;
+	}
+
+	// Load and unload a game.bin of 10,000 entities, a quarter of them with a script. ns/op is per entity.
+	// content::load_game() reads game.bin next to the executable, so whatever is there is put back afterwards
+	bench::result game_bin_load(const settings& s)
+	{
+		constexpr u32 count{ 10000 };
+		const std::filesystem::path directory{ executable_directory() };
+		const std::filesystem::path game_bin{ directory / "game.bin" }, game_patch{ directory / "game.patch" };
+		const bool had_game_bin{ std::filesystem::exists(game_bin) }, had_game_patch{ std::filesystem::exists(game_patch) };
+		const utl::vector<u8> old_game_bin{ read_file(game_bin) }, old_game_patch{ read_file(game_patch) };
+
+		utl::vector<u8> level;
+		auto write = [&level](const void* data, size_t size) { level.insert(level.end(), (const u8*)data, (const u8*)data + size); };
+		auto write_u32 = [&write](u32 value) { write(&value, sizeof(u32)); };
+		std::mt19937 random{ 6 };
+		std::uniform_real_distribution<f32> unit{ -1.f, 1.f };
+		const char script_name[]{ "bench_script" };
+		write_u32(count);
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			const bool has_script{ (i % 4) == 0 };
+			write_u32(0); // Entity flags
+			write_u32(has_script ? 2 : 1);
+			const f32 transform[9]{ unit(random) * 500.f, unit(random) * 50.f, unit(random) * 500.f, 0.f, unit(random) * 3.14159f, 0.f, 1.f, 1.f, 1.f };
+			write_u32(0); // Transform
+			write(transform, sizeof(transform));
+			if (has_script)
+			{
+				write_u32(1); // Script
+				write_u32((u32)strlen(script_name));
+				write(script_name, strlen(script_name));
+			}
+		}
+
+		bench::result r{};
+		r.name = "game_bin_load";
+		if (directory.empty() || !write_file(game_bin, level))
+		{
+			r.valid = false;
+			return r;
+		}
+		std::error_code error{};
+		std::filesystem::remove(game_patch, error);
+
+		r = bench::measure("game_bin_load", std::max(s.samples / 10, 1u), count, [&](u32) {
+			const bool loaded{ content::load_game() };
+			content::unload_game();
+			return loaded;
+		});
+
+		if (had_game_bin) write_file(game_bin, old_game_bin);
+		else std::filesystem::remove(game_bin, error);
+		if (had_game_patch) write_file(game_patch, old_game_patch);
+		return r;
+	}
+
+	using benchmark = bench::result(*)(const settings&);
+	constexpr benchmark benchmarks[]
+	{
+		entity_churn,
+		transform_read,
+		transform_write,
+		script_update,
+		id_validity,
+		game_bin_load,
+	};
+	constexpr const char* benchmark_names[]
+	{
+		"entity_create_remove",
+		"transform_read",
+		"transform_write",
+		"script_update",
+		"id_is_alive",
+		"game_bin_load",
+	};
+	static_assert(_countof(benchmarks) == _countof(benchmark_names));
+} // Anonymous namespace
+
+int main(int argc, char* argv[])
+{
+	settings s{};
+	// load_game() changes the working directory, so make the path absolute first
+	std::filesystem::path json_path{ std::filesystem::absolute("EngineBench.json") };
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--json") && i + 1 < argc) json_path = std::filesystem::absolute(argv[++i]);
+		else if (!strcmp(argv[i], "--filter") && i + 1 < argc) s.filter = argv[++i];
+		else if (!strcmp(argv[i], "--quick")) s.samples = 20;
+		else
+		{
+			std::cout << "Usage: EngineBench [--json file] [--filter text] [--quick]" << std::endl;
+			return 2;
+		}
+	}
+
+	utl::vector<bench::result> results;
+	bool valid{ true };
+	for (u32 i{ 0 }; i < _countof(benchmarks); ++i)
+	{
+		if (s.filter && !strstr(benchmark_names[i], s.filter)) continue;
+		results.emplace_back(benchmarks[i](s));
+		bench::print(results.back());
+		valid &= results.back().valid;
+	}
+
+#ifdef _DEBUG
+	constexpr const char* config{ "debug" };
+#else
+	constexpr const char* config{ "release" };
+#endif // _DEBUG
+	if (!bench::write_json(json_path.string().c_str(), config, results))
+	{
+		std::cout << "Could not write " << json_path.string() << std::endl;
+		return 1;
+	}
+	return valid ? 0 : 1;
+}
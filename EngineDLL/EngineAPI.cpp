@@ -8,6 +8,10 @@ MIT License - see LICENSE file
 #include "Common.h"
 #include "CommonHeaders.h"
 #include "..\Engine\Components\Script.h"
+#include "..\Engine\Content\GameCode.h"
+#include "..\Engine\Content\Compression.h"
+#include "..\Engine\Content\ContentLoader.h"
+#include "..\Engine\Utilities\Checksum.h"
 #include "..\Graphics\Renderer.h"
 #include "..\Platform\PlatformTypes.h"
 #include "..\Platform\Platform.h"
@@ -17,16 +21,20 @@ MIT License - see LICENSE file
 #endif
 
 #include <Windows.h>
+#include <fstream>
 
 using namespace savage;
 
 namespace {
-	HMODULE game_code_dll{ nullptr };
-	using _get_script_creator = savage::script::detail::script_creator(*)(size_t);
-	_get_script_creator get_script_creator{ nullptr };
 	using _get_script_names = LPSAFEARRAY(*)(void);
 	_get_script_names get_script_names{ nullptr };
 
+	enum cook_flags : u32
+	{
+		pack_static_transforms = 0x01,
+		compress = 0x02,
+	};
+
 	// Array of render surfaces
 	utl::vector<graphics::render_surface> surfaces;
 
@@ -34,39 +42,69 @@ namespace {
 
 EDITOR_INTERFACE u32 LoadGameCodeDLL(const char* dll_path)
 {
-	if (game_code_dll) return FALSE; // Return false if already loaded
-	game_code_dll = LoadLibraryA(dll_path); // Load the DLL
-	assert(game_code_dll);
-	
+	// Load a copy of the DLL so it can be rebuilt and hot reloaded while the editor uses it
+	if (!content::load_game_code(dll_path)) return FALSE;
+
 	// Get a pointer to the get script names then ask for it
-	get_script_names = (_get_script_names)GetProcAddress(game_code_dll, "get_script_names");
-	// Do the same for script creator 
-	get_script_creator = (_get_script_creator)GetProcAddress(game_code_dll, "get_sctipt_creator");
+	get_script_names = (_get_script_names)content::get_game_code_symbol("get_script_names");
 
 	// Return the state
-	return (game_code_dll && get_script_creator && get_script_names) ? TRUE : FALSE;
+	return get_script_names ? TRUE : FALSE;
 }
 
-EDITOR_INTERFACE u32 UnloadGameCodeDLL(const char* dll_path)
+EDITOR_INTERFACE u32 UnloadGameCodeDLL()
 {
-	if (!game_code_dll) return FALSE; // Return false if already unloaded
-	assert(game_code_dll);
-	int result{ FreeLibrary(game_code_dll) }; // Free the DLL
-	assert(result); // Should be unloaded now
-	game_code_dll = nullptr;
+	if (!get_script_names) return FALSE; // Return false if already unloaded
+	content::unload_game_code();
+	get_script_names = nullptr;
 	return TRUE;
 }
 
+// Swap in a rebuilt game code DLL. Scripts on live entities are saved, made again from the new DLL and get their state back
+EDITOR_INTERFACE u32 ReloadGameCodeDLL(const char* dll_path)
+{
+	if (!content::reload_game_code(dll_path)) return FALSE;
+	get_script_names = (_get_script_names)content::get_game_code_symbol("get_script_names");
+	return get_script_names ? TRUE : FALSE;
+}
+
 EDITOR_INTERFACE script::detail::script_creator GetScriptCreator(const char* name)
 {
-	// If the DLL is loaded AND we have the script creator call it then convert the name to a tag then return the pointer otherwise it is a null pointer
-	return (game_code_dll && get_script_creator) ? get_script_creator(script::detail::string_hash()(name)) : nullptr;
+	// If the DLL is loaded convert the name to a tag then return the pointer otherwise it is a null pointer
+	return content::get_game_code_script_creator(name);
 }
 
 EDITOR_INTERFACE LPSAFEARRAY GetScriptNames()
 {
 	// If the DLL is loaded AND we have the script names return them otherwise return a null pointer
-	return (game_code_dll && get_script_names) ? get_script_names() : nullptr;
+	return get_script_names ? get_script_names() : nullptr;
+}
+
+// Prepare game.bin for loading like a shipped game. flags are cook_flags. checksum gets the CRC-32
+// of the data before compression, which is what a game.patch for the cooked file needs
+EDITOR_INTERFACE u32 CookGameBinary(const char* path, u32 flags, u32* checksum)
+{
+	utl::vector<u8> data;
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!file) return FALSE;
+		data.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read((char*)data.data(), data.size());
+		if (content::is_compressed(data.data(), data.size())) return FALSE;
+	}
+
+	if (flags & cook_flags::pack_static_transforms)
+	{
+		data = content::pack_static_transforms(data);
+		if (data.empty()) return FALSE;
+	}
+	if (checksum) *checksum = utl::crc32(data.data(), data.size());
+	if (flags & cook_flags::compress) data = content::compress(data.data(), data.size());
+
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	file.write((const char*)data.data(), data.size());
+	return file ? TRUE : FALSE;
 }
 
 EDITOR_INTERFACE u32 CreateRenderSurface(HWND host, s32 width, s32 height)
@@ -11,6 +11,9 @@ MIT License - see LICENSE file
 #include "..\Engine\Components\Entity.h"
 #include "..\Engine\Components\Transform.h"
 #include "..\Engine\Components\script.h"
+#include "..\Engine\Components\TransformChannel.h"
+#include "..\Engine\Utilities\MathSIMD.h"
+#include <algorithm>
 
 using namespace savage;
 
@@ -25,17 +28,14 @@ namespace {
 
 		transform::init_info to_init_info()
 		{
-			using namespace DirectX;
 			transform::init_info info{};
 			memcpy(&info.position[0], &position[0], sizeof(position)); // Copy position values as is
 			memcpy(&info.scale[0], &scale[0], sizeof(scale)); // Copy scale values as is
-			XMFLOAT3A rot{ &rotation[0] }; // Gets the rotation form the editor
+			const math::v3 euler{ &rotation[0] }; // Gets the rotation form the editor
 			// Transform Euler angle for rotation form editor to quaternion for the engine
-			XMVECTOR quat{ XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3A(&rot)) };
-			// Save it to an array for the engine
-			XMFLOAT4A rot_quat{};
-			XMStoreFloat4A(&rot_quat, quat);
-			memcpy(&info.rotation[0], &rot_quat.x, sizeof(rotation)); // Return translated quaternion value to engine
+			math::v4 quat{};
+			math::euler_to_quat_batch(&euler, &quat, 1);
+			memcpy(&info.rotation[0], &quat.x, sizeof(info.rotation)); // Return translated quaternion value to engine
 			return info;
 		}
 	};
@@ -61,6 +61,26 @@ namespace {
 		script_component script;
 	};
 
+	// Convert the rotations of up to batch_size entities at once with the SIMD batch kernel
+	constexpr u32 batch_size{ 64 };
+	void to_init_infos(const game_entity_descriptor* desc, u32 count, transform::init_info* infos)
+	{
+		assert(count && count <= batch_size);
+		math::v3 euler[batch_size];
+		math::v4 quats[batch_size];
+		for (u32 i{ 0 }; i < count; ++i) euler[i] = math::v3{ &desc[i].transform.rotation[0] };
+		math::euler_to_quat_batch(euler, quats, count);
+
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			const transform_component& t{ desc[i].transform };
+			transform::init_info& info{ infos[i] };
+			memcpy(&info.position[0], &t.position[0], sizeof(t.position)); // Copy position values as is
+			memcpy(&info.scale[0], &t.scale[0], sizeof(t.scale)); // Copy scale values as is
+			memcpy(&info.rotation[0], &quats[i].x, sizeof(info.rotation));
+		}
+	}
+
 	game_entity::entity entity_from_id(id::id_type id)
 	{
 		return game_entity::entity{ game_entity::entity_id{id} };
@@ -86,4 +106,67 @@ EDITOR_INTERFACE void RemoveGameEntity(id::id_type id)
 {
 	assert(id::is_valid(id));
 	game_entity::remove(game_entity::entity_id{ id });
+}
+
+// Create count entities from a packed array of descriptors and write their IDs to ids (invalid if one failed).
+// Returns how many were created. One call for a whole scene instead of one call per entity
+EDITOR_INTERFACE u32 CreateGameEntities(const game_entity_descriptor* descriptors, u32 count, id::id_type* ids)
+{
+	assert(descriptors && ids);
+	u32 created{ 0 };
+	for (u32 first{ 0 }; first < count; first += batch_size)
+	{
+		const u32 batch_count{ std::min(count - first, batch_size) };
+		transform::init_info transform_infos[batch_size]{};
+		to_init_infos(&descriptors[first], batch_count, transform_infos);
+
+		for (u32 i{ 0 }; i < batch_count; ++i)
+		{
+			script::init_info script_info{};
+			script_info.script_creator = descriptors[first + i].script.script_creator;
+			game_entity::entity_info entity_info
+			{
+				&transform_infos[i],
+				&script_info,
+			};
+			const game_entity::entity entity{ game_entity::create(entity_info) };
+			ids[first + i] = entity.get_id();
+			if (entity.is_valid()) ++created;
+		}
+	}
+	return created;
+}
+
+// Remove count entities in one call
+EDITOR_INTERFACE void RemoveGameEntities(const id::id_type* ids, u32 count)
+{
+	assert(ids);
+	for (u32 i{ 0 }; i < count; ++i)
+	{
+		assert(id::is_valid(ids[i]));
+		game_entity::remove(game_entity::entity_id{ ids[i] });
+	}
+}
+
+// Make the transform channel the editor reads runtime transforms from and sends edits through.
+// Returns the start of the channel memory, the editor reads the layout from there
+EDITOR_INTERFACE void* OpenTransformChannel(u32 capacity, u32 queue_capacity)
+{
+	if (!transform_channel::data() && !transform_channel::initialize(capacity, queue_capacity)) return nullptr;
+	return transform_channel::data();
+}
+
+EDITOR_INTERFACE void CloseTransformChannel()
+{
+	transform_channel::shutdown();
+}
+
+// Apply the edits the editor queued then publish the current transforms. Called once per viewport frame.
+// If the channel is too small, the published frame's total says how many transforms the engine has
+EDITOR_INTERFACE u32 UpdateTransformChannel()
+{
+	if (!transform_channel::data()) return 0;
+	const u32 applied{ transform_channel::apply_edits() };
+	transform_channel::publish();
+	return applied;
 }
\ No newline at end of file
@@ -8,11 +8,71 @@ MIT License - see LICENSE file
 
 #define TEST_ENTITY_COMPONENTS 0
 #define TEST_WINDOW 1
+#define TEST_WORLD_SNAPSHOT 0
+#define TEST_REPLICATION 0
+#define TEST_SPATIAL_INDEX 0
+#define TEST_FRUSTUM_CULLING 0
+#define TEST_TRANSFORM_CHANNEL 0
+#define TEST_HOT_RELOAD 0
+#define TEST_COMPRESSION 0
+#define TEST_STATIC_TRANSFORMS 0
+#define TEST_PRIMITIVE_MESH 0
+#define TEST_MESH_PROCESSING 0
+#define TEST_VERTEX_CACHE 0
+#define TEST_MESH_SIMPLIFICATION 0
+#define TEST_MESHLETS 0
+#define TEST_MARCHING_CUBES 0
+#define TEST_JOB_SYSTEM 0
+#define TEST_FIBERS 0
+#define TEST_FRAME_MEMORY 0
+#define TEST_SIMD_MATH 0
+#define TEST_TRANSFORM_CATEGORIES 0
+#define TEST_ID_STRESS 0
 
 #if TEST_ENTITY_COMPONENTS
 #include "TestEntityComponents.h"
 #elif TEST_WINDOW
 #include "TestWindow.h"
+#elif TEST_WORLD_SNAPSHOT
+#include "TestWorldSnapshot.h"
+#elif TEST_REPLICATION
+#include "TestReplication.h"
+#elif TEST_SPATIAL_INDEX
+#include "TestSpatialIndex.h"
+#elif TEST_FRUSTUM_CULLING
+#include "TestFrustumCulling.h"
+#elif TEST_TRANSFORM_CHANNEL
+#include "TestTransformChannel.h"
+#elif TEST_HOT_RELOAD
+#include "TestHotReload.h"
+#elif TEST_COMPRESSION
+#include "TestCompression.h"
+#elif TEST_STATIC_TRANSFORMS
+#include "TestStaticTransforms.h"
+#elif TEST_PRIMITIVE_MESH
+#include "TestPrimitiveMesh.h"
+#elif TEST_MESH_PROCESSING
+#include "TestMeshProcessing.h"
+#elif TEST_VERTEX_CACHE
+#include "TestVertexCache.h"
+#elif TEST_MESH_SIMPLIFICATION
+#include "TestMeshSimplification.h"
+#elif TEST_MESHLETS
+#include "TestMeshlets.h"
+#elif TEST_MARCHING_CUBES
+#include "TestMarchingCubes.h"
+#elif TEST_JOB_SYSTEM
+#include "TestJobSystem.h"
+#elif TEST_FIBERS
+#include "TestFibers.h"
+#elif TEST_FRAME_MEMORY
+#include "TestFrameMemory.h"
+#elif TEST_SIMD_MATH
+#include "TestSimdMath.h"
+#elif TEST_TRANSFORM_CATEGORIES
+#include "TestTransformCategories.h"
+#elif TEST_ID_STRESS
+#include "TestIdStress.h"
 #else
 #error One of the tests need to be enabled
 #endif
@@ -52,7 +112,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 #else
 int main()
 {
-#if _DEBUG
+#if _DEBUG && defined(_MSC_VER)
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF); // Look for memory leaks and set a flag
 #endif
 	engine_test test{};
@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Content/Compression.h"
+#include "../Engine/Core/JobSystem.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override { return jobs::initialize(); }
+
+	void run() override
+	{
+		do {
+			test_level("Grid level", make_level(200000, true));
+			test_level("Scattered level", make_level(200000, false));
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override { jobs::shutdown(); }
+
+private:
+	// Make a game.bin like the editor writes: every entity has a transform and most have one of a few scripts
+	static utl::vector<u8> make_level(u32 entity_count, bool grid)
+	{
+		const char* const script_names[]{ "CharacterScript", "RotatorScript", "DoorScript", "PickupScript" };
+		std::mt19937 random{ 17 };
+		std::uniform_real_distribution<f32> position{ -500.f, 500.f };
+		std::uniform_real_distribution<f32> angle{ -3.14159f, 3.14159f };
+
+		utl::vector<u8> level;
+		auto write = [&level](const void* data, size_t size) {
+			level.insert(level.end(), (const u8*)data, (const u8*)data + size);
+		};
+		auto write_u32 = [&write](u32 value) { write(&value, sizeof(u32)); };
+
+		write_u32(entity_count);
+		for (u32 i{ 0 }; i < entity_count; ++i)
+		{
+			const bool has_script{ (i % 4) != 0 };
+			write_u32(0); // Entity flags
+			write_u32(has_script ? 2 : 1);
+
+			// Transform: position, rotation, scale
+			f32 transform[9]{ 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f, 1.f, 1.f };
+			if (grid)
+			{
+				transform[0] = (f32)(i % 512) * 2.f;
+				transform[2] = (f32)(i / 512) * 2.f;
+				transform[4] = (f32)(i % 8) * 0.7853982f;
+			}
+			else
+			{
+				transform[0] = position(random);
+				transform[1] = position(random) * 0.1f;
+				transform[2] = position(random);
+				transform[4] = angle(random);
+			}
+			write_u32(0);
+			write(transform, sizeof(transform));
+
+			if (has_script)
+			{
+				const char* const name{ script_names[i % _countof(script_names)] };
+				write_u32(1);
+				write_u32((u32)strlen(name));
+				write(name, strlen(name));
+			}
+		}
+		return level;
+	}
+
+	static void test_level(const char* name, const utl::vector<u8>& level)
+	{
+		using clock = std::chrono::high_resolution_clock;
+		constexpr u32 runs{ 10 };
+
+		const auto compress_start{ clock::now() };
+		const utl::vector<u8> compressed{ content::compress(level.data(), level.size()) };
+		const f32 compress_seconds{ std::chrono::duration<f32>(clock::now() - compress_start).count() };
+
+		utl::vector<u8> output(content::decompressed_size(compressed.data(), compressed.size()));
+		auto decompress_seconds = [&](u32 thread_count) {
+			f32 best{ 1e9f };
+			for (u32 i{ 0 }; i < runs; ++i)
+			{
+				const auto start{ clock::now() };
+				content::decompress(compressed.data(), compressed.size(), output.data(), thread_count);
+				best = std::min(best, std::chrono::duration<f32>(clock::now() - start).count());
+			}
+			return best;
+		};
+		const f32 one_thread{ decompress_seconds(1) };
+		const f32 all_threads{ decompress_seconds(0) };
+		const bool same{ output.size() == level.size() && !memcmp(output.data(), level.data(), level.size()) };
+
+		// A header that claims more than its blocks can hold must not be trusted for the allocation
+		utl::vector<u8> broken{ compressed };
+		const u64 huge_size{ (u64)1 << 40 };
+		memcpy(broken.data() + offsetof(content::compressed_header, size), &huge_size, sizeof(huge_size));
+		const bool refused{ !content::decompressed_size(broken.data(), broken.size()) };
+
+		const f32 gb{ (f32)level.size() / 1e9f };
+		std::cout << name << ": " << level.size() / 1024 << " KB -> " << compressed.size() / 1024 << " KB (ratio "
+			<< (f32)level.size() / compressed.size() << ")" << (same ? "" : " MISMATCH") << (refused ? "" : " BROKEN HEADER READ") << std::endl;
+		std::cout << "  Compress:              " << gb / compress_seconds << " GB/s" << std::endl;
+		std::cout << "  Decompress 1 thread:   " << gb / one_thread << " GB/s" << std::endl;
+		std::cout << "  Decompress " << jobs::thread_count() << " threads:  " << gb / all_threads << " GB/s" << std::endl;
+	}
+};
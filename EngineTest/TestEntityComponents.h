@@ -8,8 +8,8 @@ MIT License - see LICENSE file
 #pragma once
 
 #include "Test.h"
-#include "..\Engine\Components\Entity.h"
-#include "..\Engine\Components\Transform.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
 
 #include <iostream>
 #include <ctime>
@@ -74,7 +74,7 @@ private:
 			if (entity.is_valid())
 			{
 				game_entity::remove(entity.get_id()); // Remove game entities
-				_entities.erase(_entities.begin() + index);
+				utl::erase_unordered(_entities, index); // Order doesn't matter, so don't shift the rest of the array
 				assert(!game_entity::is_alive(entity.get_id())); // It should be dead
 				++_removed; // Record keeping
 			}
@@ -0,0 +1,143 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Core/JobSystem.h"
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#if USE_FIBERS
+#include <ucontext.h>
+#endif
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override { return true; }
+
+	void run() override
+	{
+		do {
+			switch_cost();
+			waiting_scripts(false);
+			waiting_scripts(true);
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override {}
+
+private:
+	using clock = std::chrono::high_resolution_clock;
+	static constexpr u32 switch_count{ 1000000 };
+
+	// A job that gives its thread away over and over: two switches each time
+	void switch_cost()
+	{
+		jobs::init_info info{};
+		info.use_fibers = true;
+		jobs::initialize(info);
+		if (!jobs::fibers_enabled())
+		{
+			std::cout << "No fibers on this platform" << std::endl;
+			jobs::shutdown();
+			return;
+		}
+
+		std::atomic<u32> done{ 1 };
+		const auto start{ clock::now() };
+		jobs::submit("yield", [](void*) { for (u32 i{ 0 }; i < switch_count; ++i) jobs::yield(); }, nullptr, &done);
+		jobs::wait(done);
+		const f32 job_ns{ std::chrono::duration<f32, std::nano>(clock::now() - start).count() / switch_count };
+		jobs::shutdown();
+
+#if USE_FIBERS
+		// The same round trip with swapcontext, which also saves the signal mask with a system call
+		static ucontext_t main_context, fiber_context;
+		static utl::vector<u8> stack(64 * 1024);
+		getcontext(&fiber_context);
+		fiber_context.uc_stack.ss_sp = stack.data();
+		fiber_context.uc_stack.ss_size = stack.size();
+		fiber_context.uc_link = &main_context;
+		makecontext(&fiber_context, []() { for (u32 i{ 0 }; i < switch_count; ++i) swapcontext(&fiber_context, &main_context); }, 0);
+		const auto ucontext_start{ clock::now() };
+		for (u32 i{ 0 }; i <= switch_count; ++i) swapcontext(&main_context, &fiber_context);
+		const f32 ucontext_ns{ std::chrono::duration<f32, std::nano>(clock::now() - ucontext_start).count() / switch_count };
+
+		std::cout << "Fiber switch there and back:" << std::endl;
+		std::cout << "  jobs::yield():  " << job_ns << " ns (with the wait list)" << std::endl;
+		std::cout << "  swapcontext():  " << ucontext_ns << " ns" << std::endl;
+#endif
+	}
+
+	struct script
+	{
+		u32		id;
+		u64		results[4];
+		u64		sum;
+		bool	wrong_thread;
+	};
+
+	static u64 query(u32 id)
+	{
+		u64 x{ id };
+		for (u32 i{ 0 }; i < 2000; ++i) x = x * 6364136223846793005ull + 1442695040888963407ull;
+		return x;
+	}
+
+	// Scripts that ask for 4 queries each and wait for the answers. Every 8th script runs on the main thread
+	void waiting_scripts(bool fibers)
+	{
+		constexpr u32 script_count{ 512 };
+		static std::thread::id main_id;
+		main_id = std::this_thread::get_id();
+
+		jobs::init_info info{};
+		info.use_fibers = fibers;
+		info.fiber_count = 16;
+		jobs::initialize(info);
+
+		utl::vector<script> scripts(script_count);
+		jobs::graph frame{};
+		for (u32 i{ 0 }; i < script_count; ++i)
+		{
+			scripts[i] = { i, {}, 0, false };
+			const bool main_thread{ i % 8 == 0 };
+			frame.add("script", [](void* data) {
+				script& s{ *(script*)data };
+				std::atomic<u32> queries{ 4 };
+				for (u32 q{ 0 }; q < 4; ++q)
+				{
+					s.results[q] = s.id * 4 + q;
+					jobs::submit("query", [](void* result) { *(u64*)result = query((u32)*(u64*)result); }, &s.results[q], &queries);
+				}
+				jobs::wait(queries);
+				for (u64 r : s.results) s.sum += r;
+				s.wrong_thread |= std::this_thread::get_id() != main_id;
+			}, &scripts[i], main_thread ? jobs::thread_affinity::main_thread : jobs::thread_affinity::any);
+		}
+
+		const auto start{ clock::now() };
+		frame.run();
+		const f32 ms{ std::chrono::duration<f32, std::milli>(clock::now() - start).count() };
+
+		bool valid{ true };
+		for (const auto& s : scripts)
+		{
+			u64 sum{ 0 };
+			for (u32 q{ 0 }; q < 4; ++q) sum += query(s.id * 4 + q);
+			valid &= s.sum == sum && (s.id % 8 || !s.wrong_thread);
+		}
+		std::cout << "Waiting scripts " << (jobs::fibers_enabled() ? "with fibers:    " : "without fibers: ") << ms << " ms, "
+			<< jobs::thread_count() << " threads, " << jobs::fiber_count() << " fibers" << (valid ? "" : " INVALID") << std::endl;
+		jobs::shutdown();
+	}
+};
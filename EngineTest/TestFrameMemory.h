@@ -0,0 +1,137 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Utilities/LinearAllocator.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+// Count every heap allocation of the test
+namespace { std::atomic<u64> malloc_count{ 0 }; }
+void* operator new(size_t size) { ++malloc_count; if (void* p{ malloc(size ? size : 1) }) return p; throw std::bad_alloc{}; }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override { return true; }
+
+	void run() override
+	{
+		do {
+			check_lifetimes();
+			benchmark();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override {}
+
+private:
+	// Frame memory lives for one more frame, scratch memory until its scope ends
+	void check_lifetimes()
+	{
+		bool valid{ true };
+		u32* last_frame{ nullptr };
+		for (u32 frame{ 0 }; frame < 8; ++frame)
+		{
+			utl::next_frame();
+			if (last_frame) for (u32 i{ 0 }; i < 1000; ++i) valid &= last_frame[i] == frame - 1 + i;
+			last_frame = utl::thread_frame_arena().current().allocate<u32>(1000);
+			for (u32 i{ 0 }; i < 1000; ++i) last_frame[i] = frame + i;
+		}
+
+		const size_t start{ utl::thread_scratch_memory().mark() };
+		{
+			utl::scratch outer{};
+			utl::vector<u32, utl::scratch_allocator<u32>> a{ outer.allocator<u32>() };
+			a.resize(100);
+			{
+				utl::scratch inner{};
+				utl::vector<u64, utl::scratch_allocator<u64>> b(100, 0, inner.allocator<u64>());
+				valid &= utl::thread_scratch_memory().owns(b.data());
+			}
+			valid &= utl::thread_scratch_memory().mark() > start;
+			// Too big for the scratch memory: comes from the heap instead
+			utl::vector<u8, utl::scratch_allocator<u8>> big(utl::scratch_size * 2, 0, outer.allocator<u8>());
+			valid &= !utl::thread_scratch_memory().owns(big.data());
+		}
+		valid &= utl::thread_scratch_memory().mark() == start;
+
+		// Alignments above what new gives the buffer, like cache lines for packets
+		utl::linear_allocator memory{ 4096 };
+		for (u32 i{ 0 }; i < 8; ++i)
+		{
+			memory.allocate(i + 1, 1);
+			valid &= !((uintptr_t)memory.allocate(16, 64) & 63) && !((uintptr_t)memory.allocate(16, 256) & 255);
+		}
+		std::cout << "Frame memory lifetimes" << (valid ? "" : " INVALID") << std::endl;
+	}
+
+	// 1024 small temporary lists of about 64 ids each, like the per entity lists of a frame of gameplay.
+	// Reserving the most a list can hold costs nothing in an arena: the list is the last allocation when it goes away
+	template<typename MakeList>
+	static void frame_work(MakeList&& make_list, bool reserve, u64& checksum)
+	{
+		for (u32 system{ 0 }; system < 1024; ++system)
+		{
+			auto list{ make_list() };
+			if (reserve) list.reserve(128);
+			u32 x{ system * 2654435761u };
+			for (u32 i{ 0 }; i < 128; ++i)
+			{
+				x = x * 1664525u + 1013904223u;
+				if (x & 0x100) list.push_back(x >> 8);
+			}
+			checksum += list.size() + list[list.size() / 2];
+		}
+	}
+
+	void benchmark()
+	{
+		using clock = std::chrono::high_resolution_clock;
+		constexpr u32 frames{ 600 };
+
+		u64 expected{ 0 };
+		auto measure = [&expected](const char* name, auto&& frame) {
+			for (bool reserve : { false, true })
+			{
+				u64 checksum{ 0 };
+				const u64 mallocs{ malloc_count.load() };
+				const auto start{ clock::now() };
+				for (u32 i{ 0 }; i < frames; ++i)
+				{
+					utl::next_frame();
+					frame(reserve, checksum);
+				}
+				const f32 us{ std::chrono::duration<f32, std::micro>(clock::now() - start).count() / frames };
+				if (!expected) expected = checksum;
+				std::cout << "  " << name << (reserve ? " reserved: " : " growing:  ") << (f32)(malloc_count.load() - mallocs) / frames
+					<< " mallocs, " << us << " us per frame" << (checksum == expected ? "" : " INVALID") << std::endl;
+			}
+		};
+
+		std::cout << "Temporary lists, " << frames << " frames" << std::endl;
+		measure("Heap       ", [](bool reserve, u64& checksum) {
+			frame_work([]() { return utl::vector<u32>{}; }, reserve, checksum);
+		});
+		measure("Scratch    ", [](bool reserve, u64& checksum) {
+			utl::scratch scratch{};
+			frame_work([&scratch]() { return utl::vector<u32, utl::scratch_allocator<u32>>{ scratch.allocator<u32>() }; }, reserve, checksum);
+		});
+		measure("Frame arena", [](bool reserve, u64& checksum) {
+			utl::frame_arena& arena{ utl::thread_frame_arena() };
+			frame_work([&arena]() { return utl::vector<u32, utl::frame_allocator<u32>>{ utl::frame_allocator<u32>{ &arena } }; }, reserve, checksum);
+		});
+	}
+};
@@ -0,0 +1,123 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
+#include "../Engine/Graphics/RenderList.h"
+#include "../Engine/Utilities/LinearAllocator.h"
+
+#include <iostream>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		srand((u32)time(nullptr)); // get random seed for testing
+
+		transform::init_info transform_info{};
+		transform_info.rotation[3] = 1.f;
+		transform_info.scale[0] = transform_info.scale[1] = transform_info.scale[2] = 1.f;
+		game_entity::entity_info entity_info{ &transform_info };
+		for (u32 i{ 0 }; i < 100000; ++i)
+		{
+			transform_info.position[0] = random_position();
+			transform_info.position[1] = random_position();
+			transform_info.position[2] = random_position();
+			const game_entity::entity entity{ game_entity::create(entity_info) };
+			_entities.push_back(entity);
+
+			graphics::renderable_info info{};
+			info.mesh_id = rand() % 64;
+			info.material_id = rand() % 16;
+			info.radius = 1.f;
+			info.lod_distances[0] = 50.f;
+			info.lod_distances[1] = 150.f;
+			info.lod_distances[2] = 300.f;
+			graphics::add_renderable(entity, info);
+		}
+		return true;
+	}
+
+	void run() override
+	{
+		do {
+			using clock = std::chrono::high_resolution_clock;
+			constexpr u32 frames{ 60 };
+			f32 total_ms{ 0.f };
+			graphics::render_list list{};
+
+			// Spin the camera around the middle of the world so the visible set changes every frame
+			for (u32 frame{ 0 }; frame < frames; ++frame)
+			{
+				const graphics::camera camera{ make_camera((f32)frame * 0.1f) };
+				_frame_memory.reset();
+				const auto start{ clock::now() };
+				list = graphics::build_render_list(camera, _frame_memory);
+				total_ms += std::chrono::duration<f32, std::milli>(clock::now() - start).count();
+			}
+
+			bool sorted{ true };
+			for (u32 i{ 1 }; i < list.packet_count; ++i) sorted &= list.packets[i - 1].sort_key <= list.packets[i].sort_key;
+
+			std::cout << "Renderables:    " << _entities.size() << std::endl;
+			std::cout << "Build time:     " << total_ms / frames << " ms per frame" << std::endl;
+			std::cout << "Culled:         " << _entities.size() * frames / total_ms << " entities per ms" << std::endl;
+			std::cout << "Visible:        " << list.packet_count << " (" << list.culled_count << " culled)" << std::endl;
+			std::cout << "Batches:        " << list.batch_count << std::endl;
+			std::cout << "Sorted:         " << sorted << std::endl;
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override
+	{
+		for (auto entity : _entities)
+		{
+			graphics::remove_renderable(entity.get_id());
+			game_entity::remove(entity.get_id());
+		}
+	}
+
+private:
+	static f32 random_position() { return (f32)(rand() % 1000) - 500.f; }
+
+	// Left-handed camera at the origin turned by angle around the y axis with a 90 degree field of view
+	static graphics::camera make_camera(f32 angle)
+	{
+		constexpr f32 near_z{ 0.1f }, far_z{ 500.f }, aspect{ 16.f / 9.f };
+		const f32 y_scale{ 1.f / tanf(0.25f * 3.14159265f) };
+		const f32 x_scale{ y_scale / aspect };
+		const f32 z_scale{ far_z / (far_z - near_z) };
+		const f32 c{ cosf(angle) }, s{ sinf(angle) };
+
+		// view = inverse of the rotation (its transpose), then multiply by the projection
+		const f32 view[4][4]{ { c, 0.f, s, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { -s, 0.f, c, 0.f }, { 0.f, 0.f, 0.f, 1.f } };
+		const f32 projection[4][4]{ { x_scale, 0.f, 0.f, 0.f }, { 0.f, y_scale, 0.f, 0.f }, { 0.f, 0.f, z_scale, 1.f }, { 0.f, 0.f, -near_z * z_scale, 0.f } };
+
+		graphics::camera camera{};
+		for (u32 row{ 0 }; row < 4; ++row)
+			for (u32 col{ 0 }; col < 4; ++col)
+			{
+				f32 sum{ 0.f };
+				for (u32 k{ 0 }; k < 4; ++k) sum += view[row][k] * projection[k][col];
+				camera.view_projection.m[row][col] = sum;
+			}
+		camera.position = { 0.f, 0.f, 0.f };
+		return camera;
+	}
+
+	utl::vector<game_entity::entity>	_entities;
+	utl::linear_allocator				_frame_memory{ 16 * 1024 * 1024 };
+};
@@ -0,0 +1,222 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
+#include "../Engine/Components/Script.h"
+#include "../Engine/Content/GameCode.h"
+#include "../Engine/Components/World.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#ifdef _WIN64
+#include <Windows.h>
+#endif // _WIN64
+
+using namespace savage;
+
+// The same script before and after a change to the game code. The state has to survive the swap
+class counter_script : public script::entity_script
+{
+public:
+	constexpr explicit counter_script(game_entity::entity entity) : script::entity_script{ entity } {}
+	void update(float) override { _counter += step(); }
+	void serialize(utl::vector<u8>& buffer) const override
+	{
+		const u8* const data{ (const u8*)&_counter };
+		buffer.insert(buffer.end(), data, data + sizeof(_counter));
+	}
+	void deserialize(const u8* data, u32 size) override
+	{
+		if (size == sizeof(_counter)) memcpy(&_counter, data, size);
+	}
+	u32 counter() const { return _counter; }
+
+protected:
+	virtual u32 step() const { return 1; }
+
+private:
+	u32 _counter{ 0 };
+};
+
+class counter_script_rebuilt : public counter_script
+{
+public:
+	constexpr explicit counter_script_rebuilt(game_entity::entity entity) : counter_script{ entity } {}
+
+protected:
+	u32 step() const override { return 10; }
+};
+
+// Registered so world snapshots can make them again. Not under their class names, the game code library has a counter_script too
+constexpr size_t counter_tag{ 0x1234 };
+constexpr size_t counter_rebuilt_tag{ 0x1235 };
+namespace {
+	const u8 _reg_counter_script{ script::detail::register_script(counter_tag, &script::detail::create_script<counter_script>) };
+	const u8 _reg_counter_script_rebuilt{ script::detail::register_script(counter_rebuilt_tag, &script::detail::create_script<counter_script_rebuilt>) };
+}
+
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		transform::init_info transform_info{};
+		script::init_info script_info{ &script::detail::create_script<counter_script> };
+		game_entity::entity_info entity_info{ &transform_info, &script_info };
+		for (u32 i{ 0 }; i < script_count; ++i)
+		{
+			_entities.push_back(game_entity::create(entity_info));
+		}
+
+		// The game code library is built next to the test by the EngineTestGameCode project
+		_game_code_path = (executable_directory() / game_code_name).string();
+		if (!content::load_game_code(_game_code_path.c_str()))
+		{
+			std::cout << "Failed to load " << _game_code_path << std::endl;
+			return false;
+		}
+		script_info.script_creator = content::get_game_code_script_creator("counter_script");
+		if (!script_info.script_creator) return false;
+		for (u32 i{ 0 }; i < script_count; ++i)
+		{
+			_game_code_entities.push_back(game_entity::create(entity_info));
+		}
+		return true;
+	}
+
+	void run() override
+	{
+		do {
+			using clock = std::chrono::high_resolution_clock;
+
+			// Reload the game code library for real: a new copy is loaded, the scripts are saved and made
+			// again from the new copy, then the old copy is unloaded
+			for (u32 i{ 0 }; i < 5; ++i) script::update(0.016f);
+			const u32 module_before{ total(_game_code_entities) };
+			const u32 exe_before{ total(_entities) };
+			const script::detail::script_creator old_creator{ content::get_game_code_script_creator("counter_script") };
+			// Snapshots only keep the tags of scripts, so one taken before the reload is restored with the new copy
+			utl::vector<u8> snapshot;
+			world::snapshot(snapshot);
+			script::update(0.016f);
+			const u32 module_updated{ total(_game_code_entities) };
+
+			auto start{ clock::now() };
+			const bool module_reloaded{ content::reload_game_code(_game_code_path.c_str()) };
+			const f32 module_reload_ms{ std::chrono::duration<f32, std::milli>(clock::now() - start).count() };
+			const u32 module_after{ total(_game_code_entities) };
+			const bool module_swapped{ content::get_game_code_script_creator("counter_script") != old_creator };
+			const bool snapshot_restored{ world::restore(snapshot) && total(_game_code_entities) == module_before && total(_entities) == exe_before };
+			script::update(0.016f);
+			const bool module_runs{ total(_game_code_entities) == module_before + script_count };
+
+			std::cout << "Game code module:" << std::endl;
+			std::cout << "  Reloaded:       " << module_reloaded << " (" << module_reload_ms << " ms)" << std::endl;
+			std::cout << "  New copy used:  " << module_swapped << std::endl;
+			std::cout << "  State kept:     " << (module_updated == module_after) << std::endl;
+			std::cout << "  Snapshot:       " << snapshot_restored << std::endl;
+			std::cout << "  Scripts run:    " << module_runs << std::endl;
+
+			// Changed code: both "modules" are in this executable, the lookups stand in for the exports of the game code
+			const u32 before{ total(_entities) };
+
+			start = clock::now();
+			utl::vector<u8> saved;
+			const u32 unloaded{ script::unload_module_scripts(&old_tag_of, saved) };
+			const u32 reloaded{ script::reload_module_scripts(&new_creator_of, saved) };
+			const f32 reload_ms{ std::chrono::duration<f32, std::milli>(clock::now() - start).count() };
+			const u32 after{ total(_entities) };
+
+			// The rebuilt code adds 10 instead of 1
+			script::update(0.016f);
+			const bool new_code_runs{ total(_entities) == after + script_count * 10 };
+
+			std::cout << "Changed code:" << std::endl;
+			std::cout << "  Scripts:        " << unloaded << " saved, " << reloaded << " made again" << std::endl;
+			std::cout << "  Reload time:    " << reload_ms << " ms (" << saved.size() / 1024 << " KB of state)" << std::endl;
+			std::cout << "  State kept:     " << (before == after) << std::endl;
+			std::cout << "  New code runs:  " << new_code_runs << std::endl;
+
+			// Swap back so the test can be run again
+			saved.clear();
+			script::unload_module_scripts(&new_tag_of, saved);
+			script::reload_module_scripts(&old_creator_of, saved);
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override
+	{
+		for (auto entity : _entities) game_entity::remove(entity.get_id());
+		// The scripts have to be gone before their code is unloaded
+		for (auto entity : _game_code_entities) game_entity::remove(entity.get_id());
+		content::unload_game_code();
+	}
+
+private:
+	static constexpr u32 script_count{ 10000 };
+#ifdef _WIN64
+	static constexpr const char* game_code_name{ "EngineTestGameCode.dll" };
+#else
+	static constexpr const char* game_code_name{ "EngineTestGameCode.so" };
+#endif // _WIN64
+
+	static std::filesystem::path executable_directory()
+	{
+#ifdef _WIN64
+		wchar_t path[MAX_PATH];
+		const u32 length{ GetModuleFileName(0, &path[0], MAX_PATH) };
+		if (!length || GetLastError() == ERROR_INSUFFICIENT_BUFFER) return {};
+		return std::filesystem::path{ path }.parent_path();
+#else
+		std::error_code error{};
+		const std::filesystem::path p{ std::filesystem::read_symlink("/proc/self/exe", error) };
+		return error ? std::filesystem::path{} : p.parent_path();
+#endif // _WIN64
+	}
+
+	static size_t old_tag_of(script::detail::script_creator creator)
+	{
+		return creator == &script::detail::create_script<counter_script> ? counter_tag : 0;
+	}
+	static size_t new_tag_of(script::detail::script_creator creator)
+	{
+		return creator == &script::detail::create_script<counter_script_rebuilt> ? counter_tag : 0;
+	}
+	static script::detail::script_creator old_creator_of(size_t tag)
+	{
+		return tag == counter_tag ? &script::detail::create_script<counter_script> : nullptr;
+	}
+	static script::detail::script_creator new_creator_of(size_t tag)
+	{
+		return tag == counter_tag ? &script::detail::create_script<counter_script_rebuilt> : nullptr;
+	}
+
+	static u32 total(const utl::vector<game_entity::entity>& entities)
+	{
+		u32 sum{ 0 };
+		for (const auto& entity : entities)
+		{
+			// Scripts only know their entity, so read the counter through the script's own state
+			utl::vector<u8> state;
+			script::serialize(entity.script(), state);
+			u32 counter;
+			memcpy(&counter, state.data() + state.size() - sizeof(u32), sizeof(u32));
+			sum += counter;
+		}
+		return sum;
+	}
+
+	utl::vector<game_entity::entity> _entities;
+	utl::vector<game_entity::entity> _game_code_entities;
+	std::string						 _game_code_path;
+};
@@ -0,0 +1,225 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
+#include "../Engine/Components/Script.h"
+
+#include <iostream>
+#include <chrono>
+#include <random>
+
+using namespace savage;
+
+// Counts its updates so the test knows every live script was updated exactly once
+class stress_script : public script::entity_script
+{
+public:
+	constexpr explicit stress_script(game_entity::entity entity) : script::entity_script{ entity } {}
+	void update(float) override { ++updates; }
+	static inline u64 updates{ 0 };
+};
+
+// Random creates and removes of entities, half of them with a script, checked against a shadow model of every
+// slot. Each ID that was given out has to stay dead after its entity is removed, even when its slot is reused,
+// no two live entities or scripts may share a slot and the number of slots may not grow past what is needed.
+// The random numbers come from a fixed seed so a failure happens again on the next run
+class engine_test : public test
+{
+public:
+	bool initialize() override { return true; }
+
+	void run() override
+	{
+		do {
+			using clock = std::chrono::high_resolution_clock;
+			const auto start{ clock::now() };
+			run_round(ops_per_round);
+			check_all();
+			const f32 seconds{ std::chrono::duration<f32>(clock::now() - start).count() };
+			_ops += ops_per_round;
+			print_results(ops_per_round / seconds);
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override
+	{
+		for (auto entity : _live) game_entity::remove(entity.get_id());
+	}
+
+private:
+	// Few live entities so every slot is reused often enough to run out of generations in the first round
+	static constexpr u32 ops_per_round{ 4000000 };
+	static constexpr u32 min_live{ 16 };
+	static constexpr u32 max_live{ 128 };
+	static constexpr u32 max_dead{ 1 << 20 };		// Removed IDs kept to check again later (oldest are overwritten)
+	static constexpr u32 update_interval{ 4096 };
+
+	struct slot
+	{
+		id::id_type	generation{ 0 };	// Of the last ID given out for the slot
+		bool		used{ false };		// Was ever given out
+		bool		live{ false };
+		bool		retired{ false };	// Out of generations, must never be given out again
+	};
+
+	struct failures
+	{
+		u32 dead_alive{ 0 };		// A removed ID is alive
+		u32 live_dead{ 0 };			// A live ID is not alive
+		u32 aliased{ 0 };			// A new entity or script got the slot of a live one
+		u32 old_generation{ 0 };	// A reused slot did not get a newer generation
+		u32 reused_retired{ 0 };	// A slot that ran out of generations was given out again
+		u32 missing_script{ 0 };
+		u32 script_updates{ 0 };	// script::update() did not update every script once
+		u32 leaked_slots{ 0 };		// There are more slots than the most ever alive needs
+		u32 no_retired{ 0 };		// No slot ran out of generations, so retiring slots was not tested
+
+		u32 total() const { return dead_alive + live_dead + aliased + old_generation + reused_retired + missing_script + script_updates + leaked_slots + no_retired; }
+	};
+
+	// Check a new ID against the shadow slots and take the slot
+	void take(utl::vector<slot>& slots, id::id_type id)
+	{
+		const id::id_type index{ id::index(id) }, generation{ id::generation(id) };
+		if (index >= slots.size()) slots.resize(index + 1);
+		slot& s{ slots[index] };
+		_failures.aliased += s.live;
+		_failures.reused_retired += s.retired;
+		_failures.old_generation += s.used && generation <= s.generation;
+		s = { generation, true, true, false };
+	}
+
+	void release(utl::vector<slot>& slots, id::id_type id)
+	{
+		slot& s{ slots[id::index(id)] };
+		s.live = false;
+		s.retired = !id::has_next_generation(id);
+		_retired += s.retired;
+	}
+
+	void create(bool with_script)
+	{
+		transform::init_info transform_info{};
+		script::init_info script_info{ &script::detail::create_script<stress_script> };
+		game_entity::entity_info info{ &transform_info, with_script ? &script_info : nullptr };
+		const game_entity::entity entity{ game_entity::create(info) };
+		const id::id_type id{ entity.get_id() };
+		take(_entity_slots, id);
+		_failures.live_dead += !game_entity::is_alive(entity.get_id());
+
+		const script::component c{ entity.script() };
+		_failures.missing_script += with_script != c.is_valid();
+		if (c.is_valid())
+		{
+			take(_script_slots, (id::id_type)c.get_id());
+			++_live_scripts;
+		}
+		_live.emplace_back(entity);
+		_peak_live = std::max(_peak_live, (u32)_live.size());
+		_peak_scripts = std::max(_peak_scripts, _live_scripts);
+	}
+
+	void remove(u32 live_index)
+	{
+		const game_entity::entity entity{ _live[live_index] };
+		const script::component c{ entity.script() };
+		if (c.is_valid())
+		{
+			release(_script_slots, (id::id_type)c.get_id());
+			--_live_scripts;
+		}
+		game_entity::remove(entity.get_id());
+		release(_entity_slots, (id::id_type)entity.get_id());
+		_failures.dead_alive += game_entity::is_alive(entity.get_id());
+
+		if (_dead.size() < max_dead) _dead.emplace_back(entity.get_id());
+		else _dead[_next_dead++ % max_dead] = entity.get_id();
+		utl::erase_unordered(_live, live_index);
+	}
+
+	void run_round(u32 ops)
+	{
+		for (u32 i{ 0 }; i < ops; ++i)
+		{
+			const u32 r{ (u32)_random() };
+			const u32 live_count{ (u32)_live.size() };
+			switch (r & 7)
+			{
+			case 0: case 1: case 2:
+				if (live_count < max_live) create(r & 8);
+				else remove((r >> 4) % live_count);
+				break;
+			case 3: case 4: case 5:
+				if (live_count > min_live) remove((r >> 4) % live_count);
+				else create(r & 8);
+				break;
+			case 6: // Stale IDs stay dead
+				if (!_dead.empty()) _failures.dead_alive += game_entity::is_alive(_dead[(r >> 4) % _dead.size()]);
+				break;
+			case 7:
+				if (live_count) _failures.live_dead += !game_entity::is_alive(_live[(r >> 4) % live_count].get_id());
+				break;
+			}
+
+			if ((i % update_interval) == update_interval - 1)
+			{
+				const u64 before{ stress_script::updates };
+				script::update(1.f / 60.f);
+				_failures.script_updates += stress_script::updates - before != _live_scripts;
+			}
+		}
+	}
+
+	// Every removed ID kept is dead, every live one alive, and there are no more slots than needed: at most
+	// the most that were alive at once, the free IDs that are held back before reuse and the retired slots
+	void check_all()
+	{
+		for (const auto id : _dead) _failures.dead_alive += game_entity::is_alive(id);
+		for (const auto& entity : _live) _failures.live_dead += !game_entity::is_alive(entity.get_id());
+
+		auto retired = [](const utl::vector<slot>& slots) {
+			u32 count{ 0 };
+			for (const auto& s : slots) count += s.retired;
+			return count;
+		};
+		_failures.leaked_slots += _entity_slots.size() > _peak_live + id::min_deleted_elements + 1 + retired(_entity_slots);
+		_failures.leaked_slots += _script_slots.size() > _peak_scripts + id::min_deleted_elements + 1 + retired(_script_slots);
+		_failures.no_retired += !_retired;
+	}
+
+	void print_results(f32 ops_per_second)
+	{
+		std::cout << "ID stress: " << _ops / 1000000 << "M operations, " << ops_per_second / 1e6f << "M/s" << std::endl;
+		std::cout << "  Live entities: " << _live.size() << " (peak " << _peak_live << "), entity slots: " << _entity_slots.size()
+			<< ", script slots: " << _script_slots.size() << ", retired slots: " << _retired << std::endl;
+		std::cout << "  Failures: " << _failures.total();
+		if (_failures.total())
+		{
+			std::cout << " INVALID (dead alive " << _failures.dead_alive << ", live dead " << _failures.live_dead << ", aliased " << _failures.aliased
+				<< ", old generation " << _failures.old_generation << ", reused retired " << _failures.reused_retired << ", missing script "
+				<< _failures.missing_script << ", script updates " << _failures.script_updates << ", leaked slots " << _failures.leaked_slots << ", no retired slots " << _failures.no_retired << ")";
+		}
+		std::cout << std::endl;
+	}
+
+	std::mt19937						_random{ 2022 };
+	utl::vector<game_entity::entity>	_live;
+	utl::vector<game_entity::entity_id>	_dead;
+	utl::vector<slot>					_entity_slots;
+	utl::vector<slot>					_script_slots;
+	failures							_failures{};
+	u64									_ops{ 0 };
+	u32									_next_dead{ 0 };
+	u32									_live_scripts{ 0 };
+	u32									_peak_live{ 0 };
+	u32									_peak_scripts{ 0 };
+	u32									_retired{ 0 };
+};
@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Core/JobSystem.h"
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <thread>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override { return jobs::initialize(); }
+
+	void run() override
+	{
+		do {
+			check_order();
+			check_wide_graph();
+			benchmark();
+			trace_frame();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override { jobs::shutdown(); }
+
+private:
+	struct order_job
+	{
+		std::atomic<u32>*	clock;
+		u32					done_at;
+		bool				main_thread_only;
+		bool				wrong_thread;
+		utl::vector<u32>	dependencies;
+		utl::vector<order_job>* all;
+	};
+
+	// Every job checks the jobs it depends on are done and main thread jobs check where they run
+	void check_order()
+	{
+		constexpr u32 job_count{ 2000 };
+		std::mt19937 random{ 5 };
+		std::atomic<u32> clock{ 0 };
+		utl::vector<order_job> order(job_count);
+		static std::thread::id main_id;
+		main_id = std::this_thread::get_id();
+
+		jobs::graph g{};
+		for (u32 i{ 0 }; i < job_count; ++i)
+		{
+			order_job& o{ order[i] };
+			o.clock = &clock;
+			o.all = &order;
+			o.main_thread_only = random() % 16 == 0;
+			g.add("job", [](void* data) {
+				order_job& o{ *(order_job*)data };
+				for (u32 d : o.dependencies) if (!(*o.all)[d].done_at) o.done_at = u32_invalid_id;
+				o.wrong_thread = o.main_thread_only && std::this_thread::get_id() != main_id;
+				if (o.done_at != u32_invalid_id) o.done_at = o.clock->fetch_add(1) + 1;
+			}, &o, o.main_thread_only ? jobs::thread_affinity::main_thread : jobs::thread_affinity::any);
+			// Up to 3 jobs from the last 64
+			for (u32 k{ 0 }, count{ i ? (u32)(random() % 4) : 0 }; k < count; ++k)
+			{
+				const u32 dependency{ i - 1 - (u32)(random() % std::min(i, 64u)) };
+				o.dependencies.push_back(dependency);
+				g.depend(i, dependency);
+			}
+		}
+
+		bool valid{ true };
+		for (u32 run{ 0 }; run < 50; ++run)
+		{
+			clock = 0;
+			for (auto& o : order) o.done_at = 0, o.wrong_thread = false;
+			g.run();
+			for (const auto& o : order) valid &= o.done_at && o.done_at != u32_invalid_id && !o.wrong_thread;
+		}
+		std::cout << "Job order: " << job_count << " jobs, " << jobs::thread_count() << " threads" << (valid ? "" : " INVALID") << std::endl;
+	}
+
+	// More jobs without dependencies than the queues start with, so they have to grow while jobs are stolen
+	void check_wide_graph()
+	{
+		constexpr u32 job_count{ 100000 };
+		utl::vector<std::atomic<u32>> runs(job_count);
+		jobs::graph g{};
+		for (u32 i{ 0 }; i < job_count; ++i)
+		{
+			g.add("wide", [](void* data) { ((std::atomic<u32>*)data)->fetch_add(1, std::memory_order_relaxed); }, &runs[i]);
+		}
+
+		bool valid{ true };
+		for (u32 run{ 1 }; run <= 3; ++run)
+		{
+			g.run();
+			for (const auto& r : runs) valid &= r.load(std::memory_order_relaxed) == run;
+		}
+		std::cout << "Wide graph: " << job_count << " jobs" << (valid ? "" : " INVALID") << std::endl;
+	}
+
+	// Jobs per second for small jobs, all at once and as a chain
+	void benchmark()
+	{
+		using clock = std::chrono::high_resolution_clock;
+		constexpr u32 job_count{ 10000 };
+		static std::atomic<u64> sum{ 0 };
+		auto work = [](void* data) {
+			u64 x{ (u64)(size_t)data };
+			for (u32 i{ 0 }; i < 100; ++i) x = x * 6364136223846793005ull + 1442695040888963407ull;
+			sum.fetch_add(x, std::memory_order_relaxed);
+		};
+
+		jobs::graph wide{}, chain{};
+		for (u32 i{ 0 }; i < job_count; ++i)
+		{
+			wide.add("wide", work, (void*)(size_t)i);
+			chain.add("chain", work, (void*)(size_t)i);
+			if (i) chain.depend(i, i - 1);
+		}
+
+		for (auto* g : { &wide, &chain })
+		{
+			constexpr u32 runs{ 20 };
+			const auto start{ clock::now() };
+			for (u32 run{ 0 }; run < runs; ++run) g->run();
+			const f32 seconds{ std::chrono::duration<f32>(clock::now() - start).count() };
+			std::cout << "  " << (g == &wide ? "Independent" : "Chain      ") << ": " << job_count * runs / seconds / 1e6f << "M jobs/s ("
+				<< seconds / (job_count * runs) * 1e9f << " ns per job)" << std::endl;
+		}
+	}
+
+	// A frame like the engine runs, written to jobs_trace.json for chrome://tracing
+	void trace_frame()
+	{
+		auto sleep = [](void* data) { std::this_thread::sleep_for(std::chrono::microseconds((size_t)data)); };
+		jobs::graph frame{};
+		const u32 input{ frame.add("input", sleep, (void*)200, jobs::thread_affinity::main_thread) };
+		const u32 scripts{ frame.add("scripts", sleep, (void*)1000, jobs::thread_affinity::main_thread) };
+		const u32 transforms{ frame.add("transforms", sleep, (void*)500) };
+		const u32 spatial{ frame.add("spatial index", sleep, (void*)700) };
+		const u32 culling{ frame.add("culling", sleep, (void*)800) };
+		frame.add("streaming", sleep, (void*)2000); // Doesn't wait for anything
+		const u32 render{ frame.add("render", sleep, (void*)500, jobs::thread_affinity::main_thread) };
+		frame.depend(scripts, input);
+		frame.depend(transforms, scripts);
+		frame.depend(spatial, transforms);
+		frame.depend(culling, transforms);
+		frame.depend(render, culling);
+		frame.depend(render, spatial);
+
+		jobs::begin_trace();
+		for (u32 i{ 0 }; i < 3; ++i) frame.run();
+		const std::string trace{ jobs::end_trace() };
+		std::ofstream{ "jobs_trace.json" } << trace;
+		std::cout << "  Trace of 3 frames written to jobs_trace.json (" << trace.size() << " bytes)" << std::endl;
+	}
+};
@@ -0,0 +1,146 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../ContentTools/PrimitiveMesh.h"
+#include "../ContentTools/MarchingCubes.h"
+#include "../ContentTools/Geometry.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override { return true; }
+
+	void run() override
+	{
+		do {
+			check_surfaces();
+			benchmark();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override {}
+
+private:
+	// x^2 + y^2 + z^2 - r^2 with the radius in data
+	static void sphere_row(const void* data, f32 x, f32 step, f32 y, f32 z, u32 count, f32* values)
+	{
+		const f32 radius{ *(const f32*)data };
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			const f32 px{ x + i * step };
+			values[i] = px * px + y * y + z * z - radius * radius;
+		}
+	}
+
+	// Closed means every edge has two triangles, one on each side. Returns the signed volume
+	static double check_mesh(const char* name, const tools::mesh& m, bool& valid)
+	{
+		std::unordered_map<u64, s32> edges;
+		double volume{ 0.0 };
+		valid = !(m.raw_indices.size() % 3);
+		for (size_t i{ 0 }; valid && i < m.raw_indices.size(); i += 3)
+		{
+			const u32 v[3]{ m.raw_indices[i], m.raw_indices[i + 1], m.raw_indices[i + 2] };
+			for (u32 k{ 0 }; k < 3; ++k)
+			{
+				const u32 a{ v[k] }, b{ v[(k + 1) % 3] };
+				valid &= a < m.positions.size() && a != b;
+				// +1 going one way, -1 going back
+				edges[a < b ? (u64)a << 32 | b : (u64)b << 32 | a] += a < b ? 1 : -1;
+			}
+			if (!valid) break;
+			const math::v3& p0{ m.positions[v[0]] }, & p1{ m.positions[v[1]] }, & p2{ m.positions[v[2]] };
+			volume += (p0.x * (p1.y * p2.z - p1.z * p2.y) + p0.y * (p1.z * p2.x - p1.x * p2.z) + p0.z * (p1.x * p2.y - p1.y * p2.x)) / 6.0;
+		}
+		u32 open_edges{ 0 };
+		for (const auto& e : edges) open_edges += e.second != 0;
+
+		// No position is made twice
+		std::unordered_map<u64, u32> positions;
+		u32 duplicates{ 0 };
+		for (const auto& p : m.positions)
+		{
+			u64 key{ 0 };
+			for (f32 c : { p.x, p.y, p.z })
+			{
+				u32 bits;
+				memcpy(&bits, &c, sizeof(bits));
+				key = key * 0x100000001b3ull ^ bits;
+			}
+			duplicates += positions[key]++ != 0;
+		}
+
+		valid &= !open_edges && !duplicates;
+		std::cout << name << ": " << m.positions.size() << " vertices, " << m.raw_indices.size() / 3 << " triangles, "
+			<< open_edges << " open edges, " << duplicates << " duplicate vertices";
+		return volume;
+	}
+
+	void check_surfaces()
+	{
+		using namespace tools;
+		constexpr f32 pi{ 3.14159265f };
+
+		const f32 radius{ 0.8f };
+		marching_cubes_info info{};
+		info.field = { sphere_row, &radius };
+		info.min = { -1.f, -1.f, -1.f };
+		info.max = { 1.f, 1.f, 1.f };
+		info.cells[0] = info.cells[1] = info.cells[2] = 96;
+		mesh sphere{};
+		create_marching_cubes(sphere, info);
+		bool valid;
+		const double volume{ check_mesh("Sphere", sphere, valid) };
+		std::cout << ", volume " << volume << " (expected about " << 4.f / 3.f * pi * radius * radius * radius << ")"
+			<< (valid ? "" : " INVALID") << std::endl;
+
+		primitive_init_info primitive{ marching_cube, { 64, 48, 32 } };
+		primitive.size = { 2.f, 1.f, 1.f };
+		scene scene{};
+		create_primitive_mesh(scene, primitive);
+		const mesh& m{ scene.lod_groups[0].meshes[0] };
+		const double metaballs{ check_mesh("Metaballs", m, valid) };
+		valid &= m.uv_sets.size() == 1 && m.uv_sets[0].size() == m.raw_indices.size() && metaballs > 0.0;
+		std::cout << ", volume " << metaballs << (valid ? "" : " INVALID") << std::endl;
+	}
+
+	// Cells per second for the built in metaballs
+	void benchmark()
+	{
+		using namespace tools;
+		using clock = std::chrono::high_resolution_clock;
+
+		std::cout << "Marching cubes (" << std::thread::hardware_concurrency() << " threads)" << std::endl;
+		for (u32 cells : { 256u, 512u })
+		{
+			const math::v3 size{ 1.f, 1.f, 1.f };
+			marching_cubes_info info{};
+			info.field = metaball_field(size);
+			info.min = { -1.f, -1.f, -1.f };
+			info.max = size;
+			info.cells[0] = info.cells[1] = info.cells[2] = cells;
+
+			mesh m{};
+			const auto start{ clock::now() };
+			create_marching_cubes(m, info);
+			const f32 seconds{ std::chrono::duration<f32>(clock::now() - start).count() };
+			const f32 voxels{ (f32)cells * cells * cells };
+			std::cout << "  " << cells << "^3: " << m.raw_indices.size() / 3 << " triangles in " << seconds * 1000.f << " ms ("
+				<< voxels / seconds / 1e6f << "M voxels/s)" << std::endl;
+		}
+	}
+};
@@ -0,0 +1,194 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../ContentTools/PrimitiveMesh.h"
+#include "../ContentTools/Geometry.h"
+#include "../Engine/Utilities/Quantization.h"
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override { return true; }
+
+	void run() override
+	{
+		do {
+			check_results();
+			check_packing();
+			benchmark();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override {}
+
+private:
+	static tools::geometry_import_settings settings(f32 smoothing_angle)
+	{
+		tools::geometry_import_settings settings{};
+		settings.smothing_angle = smoothing_angle;
+		settings.calculate_normals = 1;
+		settings.calculate_tangents = 1;
+		return settings;
+	}
+
+	// A cube has 24 vertices with hard edges and 8 with soft ones. Sphere normals point away from the center
+	// and every tangent is a unit vector on the plane of its normal
+	void check_results()
+	{
+		using namespace tools;
+		for (const f32 angle : { 30.f, 180.f })
+		{
+			scene scene{};
+			create_primitive_mesh(scene, { cube });
+			process_scene(scene, settings(angle));
+			const mesh& m{ scene.lod_groups[0].meshes[0] };
+			std::cout << "Cube with " << angle << " degree smoothing: " << m.positions.size() << " positions, "
+				<< m.vertices.size() << " vertices, " << m.indices.size() / 3 << " triangles" << std::endl;
+		}
+
+		scene scene{};
+		create_primitive_mesh(scene, { uv_sphere, { 64, 32, 1 } });
+		process_scene(scene, settings(60.f));
+		const mesh& m{ scene.lod_groups[0].meshes[0] };
+		f32 normal_error{ 0.f }, tangent_error{ 0.f };
+		u32 mirrored{ 0 };
+		for (const auto& v : m.vertices)
+		{
+			const f32 length{ sqrtf(v.position.x * v.position.x + v.position.y * v.position.y + v.position.z * v.position.z) };
+			const f32 d{ (v.normal.x * v.position.x + v.normal.y * v.position.y + v.normal.z * v.position.z) / length };
+			normal_error = std::max(normal_error, 1.f - d);
+			const f32 t_length{ sqrtf(v.tangent.x * v.tangent.x + v.tangent.y * v.tangent.y + v.tangent.z * v.tangent.z) };
+			const f32 t_dot{ v.tangent.x * v.normal.x + v.tangent.y * v.normal.y + v.tangent.z * v.normal.z };
+			tangent_error = std::max(tangent_error, std::max(fabsf(t_length - 1.f), fabsf(t_dot)));
+			mirrored += v.tangent.w < 0.f;
+		}
+		std::cout << "UV sphere 64x32: " << m.vertices.size() << " vertices (" << m.positions.size() << " positions), max normal error "
+			<< normal_error << ", max tangent error " << tangent_error << ", " << mirrored << " mirrored" << std::endl;
+	}
+
+	// Read the packed scene back and compare the compact vertices with the full precision ones
+	void check_packing()
+	{
+		using namespace tools;
+		scene scene{};
+		create_primitive_mesh(scene, { uv_sphere, { 64, 32, 1 } });
+		process_scene(scene, settings(60.f));
+
+		scene_data data[vertex_format::count]{};
+		for (u32 format{ 0 }; format < vertex_format::count; ++format)
+		{
+			data[format].settings.vertex_format = (u8)format;
+			pack_data(scene, data[format]);
+		}
+
+		// Find the vertices of the only mesh in the buffer
+		auto find_mesh = [](const scene_data& data, const packed_mesh_header*& mesh_header) {
+			const u8* at{ data.buffer };
+			const packed_scene_header& header{ *(const packed_scene_header*)at };
+			assert(header.magic == packed_scene_magic && header.size == data.buffer_size && header.lod_group_count == 1);
+			at += sizeof(packed_scene_header);
+			auto skip_name = [&at]() { at += sizeof(u32) + ((*(const u32*)at + 3) & ~3u); };
+			skip_name(); // Scene
+			skip_name(); // Lod group
+			at += sizeof(u32);
+			skip_name(); // Mesh
+			mesh_header = (const packed_mesh_header*)at;
+			return at + sizeof(packed_mesh_header);
+		};
+
+		const packed_mesh_header* full{ nullptr }, * compact{ nullptr };
+		const u8* const full_vertices{ find_mesh(data[vertex_format::full_precision], full) };
+		const u8* const compact_vertices{ find_mesh(data[vertex_format::compact], compact) };
+		assert(full->vertex_count == compact->vertex_count && full->elements == compact->elements);
+
+		f32 normal_error{ 0.f }, tangent_error{ 0.f }, uv_error{ 0.f };
+		bool signs_match{ true };
+		for (u32 i{ 0 }; i < full->vertex_count; ++i)
+		{
+			const f32* const f{ (const f32*)(full_vertices + i * full->vertex_size) };
+			const u8* const c{ compact_vertices + i * compact->vertex_size };
+			u32 normal, tangent;
+			u16 uv[2];
+			memcpy(&normal, c + 12, sizeof(u32));
+			memcpy(&tangent, c + 16, sizeof(u32));
+			memcpy(uv, c + 20, sizeof(uv));
+			const math::v3 n{ math::unpack_unit_vector(normal, 16) }, t{ math::unpack_unit_vector(tangent >> 1, 15) };
+			normal_error = std::max(normal_error, acosf(std::min(n.x * f[3] + n.y * f[4] + n.z * f[5], 1.f)));
+			tangent_error = std::max(tangent_error, acosf(std::min(t.x * f[6] + t.y * f[7] + t.z * f[8], 1.f)));
+			signs_match &= (tangent & 1) == (f[9] < 0.f);
+			uv_error = std::max(uv_error, std::max(fabsf(math::f16_to_f32(uv[0]) - f[10]), fabsf(math::f16_to_f32(uv[1]) - f[11])));
+		}
+
+		std::cout << "Packed UV sphere 64x32: " << full->vertex_count << " vertices, " << full->index_count << " indices of " << full->index_size << " bytes" << std::endl;
+		std::cout << "  Buffer: full precision " << data[vertex_format::full_precision].buffer_size << " bytes, compact "
+			<< data[vertex_format::compact].buffer_size << " bytes, position only " << data[vertex_format::position_only].buffer_size << " bytes" << std::endl;
+		std::cout << "  Compact vertex " << compact->vertex_size << " bytes (full " << full->vertex_size << "): max normal error "
+			<< normal_error * 57.29578f << " degrees, max tangent error " << tangent_error * 57.29578f << " degrees, max uv error "
+			<< uv_error << (signs_match ? "" : ", SIGN MISMATCH") << std::endl;
+
+		for (auto& d : data)
+		{
+#ifdef _WIN64
+			CoTaskMemFree(d.buffer);
+#else
+			free(d.buffer);
+#endif // _WIN64
+		}
+	}
+
+	void benchmark()
+	{
+		using namespace tools;
+		using clock = std::chrono::high_resolution_clock;
+		struct run { const char* name; primitive_init_info info; u32 copies; };
+		const run runs[]
+		{
+			{ "1 uv sphere", { uv_sphere, { 1000, 500, 1 } }, 1 },
+			{ "1 ico sphere", { ico_shpere, { 224, 1, 1 } }, 1 },
+			{ "1 cube", { cube, { 290, 290, 290 } }, 1 },
+			{ "8 uv spheres", { uv_sphere, { 1000, 500, 1 } }, 8 },
+		};
+
+		std::cout << "Mesh processing (" << std::thread::hardware_concurrency() << " threads)" << std::endl;
+		for (const auto& r : runs)
+		{
+			scene scene{};
+			for (u32 i{ 0 }; i < r.copies; ++i) create_primitive_mesh(scene, r.info);
+			u64 triangles{ 0 }, vertices{ 0 };
+			for (const auto& lod : scene.lod_groups) triangles += lod.meshes[0].raw_indices.size() / 3;
+
+			const auto start{ clock::now() };
+			process_scene(scene, settings(60.f));
+			const f32 seconds{ std::chrono::duration<f32>(clock::now() - start).count() };
+			for (const auto& lod : scene.lod_groups) vertices += lod.meshes[0].vertices.size();
+
+			scene_data data{};
+			data.settings.vertex_format = vertex_format::compact;
+			const auto pack_start{ clock::now() };
+			pack_data(scene, data);
+			const f32 pack_seconds{ std::chrono::duration<f32>(clock::now() - pack_start).count() };
+
+			std::cout << "  " << r.name << ": " << triangles / 1e6f << "M triangles, " << vertices / 1e6f << "M vertices in "
+				<< seconds * 1000.f << " ms (" << triangles / seconds / 1e6f << "M triangles/s), packed to "
+				<< data.buffer_size / (1024 * 1024) << " MB in " << pack_seconds * 1000.f << " ms" << std::endl;
+#ifdef _WIN64
+			CoTaskMemFree(data.buffer);
+#else
+			free(data.buffer);
+#endif // _WIN64
+		}
+	}
+};
@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../ContentTools/PrimitiveMesh.h"
+#include "../ContentTools/Geometry.h"
+#include "../ContentTools/MeshSimplification.h"
+
+#include <iostream>
+#include <chrono>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override { return true; }
+
+	void run() override
+	{
+		do {
+			check_lods();
+			benchmark();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override {}
+
+private:
+	static tools::geometry_import_settings settings(u8 lod_count)
+	{
+		tools::geometry_import_settings settings{};
+		settings.smothing_angle = 60.f;
+		settings.calculate_normals = 1;
+		settings.calculate_tangents = 1;
+		settings.lod_count = lod_count;
+		return settings;
+	}
+
+	// Volume and bounds of a mesh. Closed meshes have to keep their volume and open ones their border
+	static void measure(const tools::mesh& m, double& volume, math::v3& min, math::v3& max)
+	{
+		volume = 0.0;
+		min = { 1e30f, 1e30f, 1e30f };
+		max = { -1e30f, -1e30f, -1e30f };
+		for (size_t i{ 0 }; i < m.indices.size(); i += 3)
+		{
+			const math::v3& p0{ m.vertices[m.indices[i]].position }, & p1{ m.vertices[m.indices[i + 1]].position }, & p2{ m.vertices[m.indices[i + 2]].position };
+			volume += (p0.x * (p1.y * p2.z - p1.z * p2.y) + p0.y * (p1.z * p2.x - p1.x * p2.z) + p0.z * (p1.x * p2.y - p1.y * p2.x)) / 6.0;
+		}
+		for (const auto& v : m.vertices)
+		{
+			min = { std::min(min.x, v.position.x), std::min(min.y, v.position.y), std::min(min.z, v.position.z) };
+			max = { std::max(max.x, v.position.x), std::max(max.y, v.position.y), std::max(max.z, v.position.z) };
+		}
+	}
+
+	void check_lods()
+	{
+		using namespace tools;
+		const primitive_init_info shapes[]
+		{
+			{ plane, { 128, 1, 128 } },
+			{ uv_sphere, { 128, 64, 1 } },
+			{ ico_shpere, { 32, 1, 1 } },
+			{ cylender, { 128, 32, 1 } },
+			{ capsule, { 64, 16, 8 } },
+		};
+
+		for (const auto& info : shapes)
+		{
+			scene scene{};
+			create_primitive_mesh(scene, info);
+			process_scene(scene, settings(5));
+			const lod_group& lod{ scene.lod_groups[0] };
+			std::cout << lod.meshes[0].name << std::endl;
+			for (const auto& m : lod.meshes)
+			{
+				double volume;
+				math::v3 min, max;
+				measure(m, volume, min, max);
+				std::cout << "  " << m.name << ": " << m.indices.size() / 3 << " triangles, " << m.vertices.size() << " vertices, error "
+					<< std::max(m.lod_threshold, 0.f) << ", volume " << volume << ", bounds (" << min.x << ", " << min.z << ") to ("
+					<< max.x << ", " << max.z << "), ACMR " << m.cache_stats_after.acmr << std::endl;
+			}
+		}
+	}
+
+	// Triangles removed per second for one big mesh and for many meshes at the same time
+	void benchmark()
+	{
+		using namespace tools;
+		using clock = std::chrono::high_resolution_clock;
+
+		scene source{};
+		create_primitive_mesh(source, { uv_sphere, { 1000, 500, 1 } });
+		process_scene(source, settings(0));
+		const mesh& m{ source.lod_groups[0].meshes[0] };
+		const u32 triangles{ (u32)m.indices.size() / 3 };
+		std::cout << "Simplifying " << triangles / 1e6f << "M triangles (" << std::thread::hardware_concurrency() << " threads)" << std::endl;
+		for (const f32 ratio : { 0.5f, 0.1f, 0.01f })
+		{
+			mesh lod{};
+			const auto start{ clock::now() };
+			const f32 error{ simplify_mesh(m, lod, (u32)(triangles * ratio)) };
+			const f32 seconds{ std::chrono::duration<f32>(clock::now() - start).count() };
+			const u32 removed{ triangles - (u32)lod.indices.size() / 3 };
+			std::cout << "  To " << lod.indices.size() / 3 << " triangles (error " << error << "): " << seconds * 1000.f << " ms, "
+				<< removed / seconds / 1e6f << "M triangles removed/s" << std::endl;
+		}
+
+		scene scene{};
+		for (u32 i{ 0 }; i < 8; ++i) create_primitive_mesh(scene, { ico_shpere, { 100, 1, 1 } });
+		process_scene(scene, settings(0));
+		u32 before{ 0 };
+		for (const auto& lod : scene.lod_groups) before += (u32)lod.meshes[0].indices.size() / 3;
+		geometry_import_settings lod_settings{ settings(4) };
+		lod_settings.calculate_tangents = 0;
+		const auto start{ clock::now() };
+		process_scene(scene, lod_settings);
+		const f32 seconds{ std::chrono::duration<f32>(clock::now() - start).count() };
+		u32 lod_triangles{ 0 };
+		for (const auto& lod : scene.lod_groups)
+		{
+			for (size_t i{ 1 }; i < lod.meshes.size(); ++i) lod_triangles += (u32)lod.meshes[i].indices.size() / 3;
+		}
+		std::cout << "  8 ico spheres of " << before / 8 << " triangles, processed with 4 lods (" << lod_triangles << " triangles): "
+			<< seconds * 1000.f << " ms" << std::endl;
+	}
+};
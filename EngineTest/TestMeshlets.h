@@ -0,0 +1,171 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../ContentTools/PrimitiveMesh.h"
+#include "../ContentTools/Geometry.h"
+#include "../Engine/Graphics/RenderList.h"
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <array>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override { return true; }
+
+	void run() override
+	{
+		do {
+			check_meshlets();
+			check_culling();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override {}
+
+private:
+	static tools::geometry_import_settings settings()
+	{
+		tools::geometry_import_settings settings{};
+		settings.smothing_angle = 60.f;
+		settings.calculate_normals = 1;
+		return settings;
+	}
+
+	// Every triangle has to be in exactly one meshlet and no meshlet may be over the limits
+	static bool valid(const tools::mesh& m)
+	{
+		using triangle = std::array<u32, 3>;
+		auto normalized = [](u32 a, u32 b, u32 c) {
+			// Same winding, smallest index first
+			if (b < a && b < c) return triangle{ b, c, a };
+			if (c < a && c < b) return triangle{ c, a, b };
+			return triangle{ a, b, c };
+		};
+
+		utl::vector<triangle> source, clustered;
+		for (size_t i{ 0 }; i < m.indices.size(); i += 3) source.push_back(normalized(m.indices[i], m.indices[i + 1], m.indices[i + 2]));
+		for (const auto& meshlet : m.meshlets)
+		{
+			if (meshlet.vertex_count > tools::max_meshlet_vertices || meshlet.triangle_count > tools::max_meshlet_triangles) return false;
+			for (u32 i{ 0 }; i < meshlet.triangle_count; ++i)
+			{
+				const u8* const t{ &m.meshlet_triangles[meshlet.triangle_offset + i * 3] };
+				if (t[0] >= meshlet.vertex_count || t[1] >= meshlet.vertex_count || t[2] >= meshlet.vertex_count) return false;
+				const u32* const v{ &m.meshlet_vertices[meshlet.vertex_offset] };
+				clustered.push_back(normalized(v[t[0]], v[t[1]], v[t[2]]));
+			}
+		}
+		std::sort(source.begin(), source.end());
+		std::sort(clustered.begin(), clustered.end());
+		return source == clustered;
+	}
+
+	void check_meshlets()
+	{
+		using namespace tools;
+		using clock = std::chrono::high_resolution_clock;
+		const primitive_init_info shapes[]
+		{
+			{ plane, { 707, 1, 707 } },
+			{ uv_sphere, { 1000, 500, 1 } },
+			{ ico_shpere, { 224, 1, 1 } },
+			{ cube, { 290, 290, 290 } },
+		};
+
+		std::cout << "Meshlets (" << max_meshlet_vertices << " vertices, " << max_meshlet_triangles << " triangles)" << std::endl;
+		for (const auto& info : shapes)
+		{
+			scene scene{};
+			create_primitive_mesh(scene, info);
+			process_scene(scene, settings());
+			mesh& m{ scene.lod_groups[0].meshes[0] };
+
+			const auto start{ clock::now() };
+			build_meshlets(m);
+			const f32 seconds{ std::chrono::duration<f32>(clock::now() - start).count() };
+
+			const f32 triangles{ m.indices.size() / 3.f };
+			const f32 meshlets{ (f32)m.meshlets.size() };
+			u32 cone_count{ 0 };
+			for (const auto& meshlet : m.meshlets) cone_count += meshlet.cone_cutoff < 1.f;
+			std::cout << "  " << m.name << ": " << triangles / 1e6f << "M triangles in " << m.meshlets.size() << " meshlets, "
+				<< m.meshlet_vertices.size() / meshlets << " vertices and " << triangles / meshlets << " triangles each, "
+				<< cone_count * 100.f / meshlets << "% with a cone, " << seconds * 1000.f << " ms ("
+				<< triangles / seconds / 1e6f << "M triangles/s)" << (valid(m) ? "" : " INVALID") << std::endl;
+		}
+	}
+
+	// Camera 5 units in front of a sphere. Meshlets culled as back facing can't have a front facing triangle
+	void check_culling()
+	{
+		using namespace tools;
+		using clock = std::chrono::high_resolution_clock;
+		scene scene{};
+		create_primitive_mesh(scene, { ico_shpere, { 224, 1, 1 } });
+		process_scene(scene, settings());
+		const mesh& m{ scene.lod_groups[0].meshes[0] };
+
+		constexpr f32 near_z{ 0.1f }, far_z{ 100.f }, distance{ 5.f };
+		const f32 y_scale{ 1.f / tanf(0.25f * 3.14159265f) };
+		const f32 z_scale{ far_z / (far_z - near_z) };
+		graphics::camera camera{};
+		// View moves the sphere 5 units down +z, then the 90 degree projection
+		const f32 view[4][4]{ { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f, 0.f }, { 0.f, 0.f, distance, 1.f } };
+		const f32 projection[4][4]{ { y_scale, 0.f, 0.f, 0.f }, { 0.f, y_scale, 0.f, 0.f }, { 0.f, 0.f, z_scale, 1.f }, { 0.f, 0.f, -near_z * z_scale, 0.f } };
+		for (u32 row{ 0 }; row < 4; ++row)
+			for (u32 col{ 0 }; col < 4; ++col)
+			{
+				f32 sum{ 0.f };
+				for (u32 k{ 0 }; k < 4; ++k) sum += view[row][k] * projection[k][col];
+				camera.view_projection.m[row][col] = sum;
+			}
+		camera.position = { 0.f, 0.f, -distance };
+
+		static_assert(sizeof(graphics::meshlet) == sizeof(tools::meshlet));
+		const graphics::meshlet* const meshlets{ (const graphics::meshlet*)m.meshlets.data() };
+		const u32 count{ (u32)m.meshlets.size() };
+		utl::vector<u32> visible(count);
+		constexpr u32 runs{ 100 };
+		u32 visible_count{ 0 };
+		const auto start{ clock::now() };
+		for (u32 i{ 0 }; i < runs; ++i) visible_count = graphics::cull_meshlets(camera, meshlets, count, visible.data());
+		const f32 seconds{ std::chrono::duration<f32>(clock::now() - start).count() / runs };
+
+		// Check every triangle of the culled meshlets
+		utl::vector<u8> is_visible(count, 0);
+		for (u32 i{ 0 }; i < visible_count; ++i) is_visible[visible[i]] = 1;
+		u32 front_facing_culled{ 0 }, front_facing{ 0 };
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			const tools::meshlet& meshlet{ m.meshlets[i] };
+			for (u32 t{ 0 }; t < meshlet.triangle_count; ++t)
+			{
+				const u8* const triangle{ &m.meshlet_triangles[meshlet.triangle_offset + t * 3] };
+				const math::v3& p0{ m.vertices[m.meshlet_vertices[meshlet.vertex_offset + triangle[0]]].position };
+				const math::v3& p1{ m.vertices[m.meshlet_vertices[meshlet.vertex_offset + triangle[1]]].position };
+				const math::v3& p2{ m.vertices[m.meshlet_vertices[meshlet.vertex_offset + triangle[2]]].position };
+				const math::v3 e1{ p1.x - p0.x, p1.y - p0.y, p1.z - p0.z }, e2{ p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+				const math::v3 n{ e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+				const bool faces_camera{ n.x * (p0.x - camera.position.x) + n.y * (p0.y - camera.position.y) + n.z * (p0.z - camera.position.z) < 0.f };
+				front_facing += faces_camera;
+				front_facing_culled += faces_camera && !is_visible[i];
+			}
+		}
+
+		std::cout << "Meshlet culling: " << visible_count << " of " << count << " visible (" << (count - visible_count) * 100.f / count
+			<< "% culled) in " << seconds * 1e6f << " us, " << front_facing << " front facing triangles"
+			<< (front_facing_culled ? ", FRONT FACING CULLED" : "") << std::endl;
+	}
+};
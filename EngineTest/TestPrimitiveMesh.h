@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../ContentTools/PrimitiveMesh.h"
+#include "../ContentTools/Geometry.h"
+
+#include <iostream>
+#include <chrono>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override { return true; }
+
+	void run() override
+	{
+		do {
+			check_shapes();
+			benchmark();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override {}
+
+private:
+	// Every closed shape has to face out: the signed volume of its triangles is the volume of the shape
+	void check_shapes()
+	{
+		using namespace tools;
+		struct shape { primitive_mesh_type type; u32 segments[3]; bool closed; f32 volume; };
+		constexpr f32 pi{ 3.14159265f };
+		const shape shapes[]
+		{
+			{ plane, { 8, 1, 8 }, false, 0.f },
+			{ cube, { 3, 4, 5 }, true, 1.f },
+			{ uv_sphere, { 256, 128, 1 }, true, 4.f / 3.f * pi },
+			{ ico_shpere, { 64, 1, 1 }, true, 4.f / 3.f * pi },
+			{ cylender, { 256, 3, 1 }, true, pi },
+			{ capsule, { 256, 64, 2 }, true, pi * 0.25f + 4.f / 3.f * pi * 0.125f },
+		};
+
+		for (const auto& s : shapes)
+		{
+			primitive_init_info info{ s.type, { s.segments[0], s.segments[1], s.segments[2] } };
+			if (s.type == capsule) info.size = { 0.5f, 2.f, 0.5f };
+			scene scene{};
+			create_primitive_mesh(scene, info);
+			const mesh& m{ scene.lod_groups[0].meshes[0] };
+
+			bool valid{ m.uv_sets.size() == 1 && m.uv_sets[0].size() == m.raw_indices.size() && !(m.raw_indices.size() % 3) };
+			double volume{ 0.0 };
+			for (size_t i{ 0 }; valid && i < m.raw_indices.size(); i += 3)
+			{
+				const u32 a{ m.raw_indices[i] }, b{ m.raw_indices[i + 1] }, c{ m.raw_indices[i + 2] };
+				valid &= a < m.positions.size() && b < m.positions.size() && c < m.positions.size();
+				if (!valid) break;
+				const math::v3& p0{ m.positions[a] }, & p1{ m.positions[b] }, & p2{ m.positions[c] };
+				// dot(p0, cross(p1, p2)) with triangles facing cross(p1 - p0, p2 - p0)
+				volume += (p0.x * (p1.y * p2.z - p1.z * p2.y) + p0.y * (p1.z * p2.x - p1.x * p2.z) + p0.z * (p1.x * p2.y - p1.y * p2.x)) / 6.0;
+			}
+
+			std::cout << m.name << ": " << m.positions.size() << " vertices, " << m.raw_indices.size() / 3 << " triangles";
+			if (s.closed) std::cout << ", volume " << volume << " (expected about " << s.volume << ")";
+			std::cout << (valid ? "" : " INVALID") << std::endl;
+		}
+	}
+
+	// Triangles per second for each shape at up to 10 million triangles
+	void benchmark()
+	{
+		using namespace tools;
+		using clock = std::chrono::high_resolution_clock;
+		struct run { primitive_mesh_type type; u32 segments[3]; };
+		const run runs[]
+		{
+			{ plane, { 707, 1, 707 } }, { plane, { 2236, 1, 2236 } },
+			{ uv_sphere, { 1000, 1000, 1 } }, { uv_sphere, { 3162, 1581, 1 } },
+			{ ico_shpere, { 224, 1, 1 } }, { ico_shpere, { 707, 1, 1 } },
+			{ cube, { 913, 913, 913 } },
+			{ cylender, { 3162, 1581, 1 } },
+		};
+
+		std::cout << "Primitive generation (" << std::thread::hardware_concurrency() << " threads)" << std::endl;
+		for (const auto& r : runs)
+		{
+			const primitive_init_info info{ r.type, { r.segments[0], r.segments[1], r.segments[2] } };
+			scene scene{};
+			const auto start{ clock::now() };
+			create_primitive_mesh(scene, info);
+			const f32 seconds{ std::chrono::duration<f32>(clock::now() - start).count() };
+			const mesh& m{ scene.lod_groups[0].meshes[0] };
+			const f32 triangles{ m.raw_indices.size() / 3.f };
+			std::cout << "  " << m.name << ": " << triangles / 1e6f << "M triangles in " << seconds * 1000.f << " ms ("
+				<< triangles / seconds / 1e6f << "M triangles/s)" << std::endl;
+		}
+	}
+};
@@ -0,0 +1,143 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
+#include "../Engine/Components/World.h"
+#include "../Engine/Network/Replication.h"
+
+#include <iostream>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <algorithm>
+
+using namespace savage;
+
+// Runs a server and a client in the same process. Both worlds are kept as snapshots and
+// swapped in and out, and packets go through an in-memory queue instead of a socket.
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		srand((u32)time(nullptr)); // get random seed for testing
+
+		transform::init_info transform_info{};
+		transform_info.rotation[3] = 1.f;
+		game_entity::entity_info entity_info{ &transform_info };
+		for (u32 i{ 0 }; i < 100000; ++i)
+		{
+			transform_info.position[0] = random_position();
+			transform_info.position[1] = random_position();
+			transform_info.position[2] = random_position();
+			_entities.push_back(game_entity::create(entity_info));
+		}
+
+		// Both sides start with the same level loaded, then the client gets the full state when joining
+		world::snapshot(_server);
+		_client = _server;
+		_encoder.encode(_packet);
+		_join_size = _packet.size();
+		const bool joined{ _decoder.decode(_packet.data(), _packet.size()) == _entities.size() };
+		world::snapshot(_client);
+		return joined;
+	}
+
+	void run() override
+	{
+		do {
+			using clock = std::chrono::high_resolution_clock;
+			f32 encode_ms{ 0.f }, decode_ms{ 0.f };
+			size_t bytes{ 0 };
+			constexpr u32 frames{ 60 };
+
+			for (u32 frame{ 0 }; frame < frames; ++frame)
+			{
+				// Server: move 1% of the entities then send the changes
+				world::restore(_server);
+				move_random(1000);
+				auto start{ clock::now() };
+				_encoder.encode(_packet);
+				encode_ms += std::chrono::duration<f32, std::milli>(clock::now() - start).count();
+				_channel.push_back(_packet);
+				bytes += _packet.size();
+				world::snapshot(_server);
+
+				// Client: apply everything that arrived
+				world::restore(_client);
+				while (!_channel.empty())
+				{
+					start = clock::now();
+					const u32 count{ _decoder.decode(_channel.front().data(), _channel.front().size()) };
+					decode_ms += std::chrono::duration<f32, std::milli>(clock::now() - start).count();
+					assert(count != u32_invalid_id);
+					_channel.pop_front();
+				}
+				world::snapshot(_client);
+			}
+
+			const f32 error{ max_position_error() };
+			std::cout << "Join packet:    " << _join_size << " bytes" << std::endl;
+			std::cout << "Average packet: " << bytes / frames << " bytes" << std::endl;
+			std::cout << "Encode time:    " << encode_ms / frames << " ms" << std::endl;
+			std::cout << "Decode time:    " << decode_ms / frames << " ms" << std::endl;
+			std::cout << "Max pos error:  " << error << std::endl;
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override
+	{
+		world::restore(_server);
+		for (auto entity : _entities) game_entity::remove(entity.get_id());
+	}
+
+private:
+	static f32 random_position() { return (f32)(rand() % 4000) - 2000.f; }
+
+	void move_random(u32 count)
+	{
+		const transform::storage_view transforms{ transform::view() };
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			const id::id_type index{ id::index(_entities[rand() % _entities.size()].get_id()) };
+			math::v3 position{ transforms.positions[index] };
+			position.x += 0.5f;
+			transform::set(index, position, transforms.rotations[index], transforms.scales[index]);
+		}
+	}
+
+	f32 max_position_error()
+	{
+		world::restore(_server);
+		const transform::storage_view server{ transform::view() };
+		utl::vector<math::v3> positions{ server.positions, server.positions + server.count };
+
+		world::restore(_client);
+		const transform::storage_view client{ transform::view() };
+		f32 error{ 0.f };
+		for (u32 i{ 0 }; i < client.count; ++i)
+		{
+			error = std::max(error, fabsf(positions[i].x - client.positions[i].x));
+			error = std::max(error, fabsf(positions[i].y - client.positions[i].y));
+			error = std::max(error, fabsf(positions[i].z - client.positions[i].z));
+		}
+		return error;
+	}
+
+	utl::vector<game_entity::entity>	_entities;
+	utl::vector<u8>						_server;
+	utl::vector<u8>						_client;
+	utl::vector<u8>						_packet;
+	size_t								_join_size{ 0 };
+	utl::deque<utl::vector<u8>>			_channel;
+	network::transform_encoder			_encoder{};
+	network::transform_decoder			_decoder{};
+};
@@ -0,0 +1,177 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Utilities/MathSIMD.h"
+
+#include <iostream>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		std::mt19937 random{ 11 };
+		std::uniform_real_distribution<f32> angle{ -2.f * math::pi, 2.f * math::pi };
+		std::uniform_real_distribution<f32> unit{ -1.f, 1.f };
+		_euler.resize(count);
+		_quats.resize(count);
+		_vectors.resize(count);
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			_euler[i] = { angle(random), angle(random), angle(random) };
+			_vectors[i] = { unit(random) * 10.f, unit(random) * 10.f, unit(random) * 10.f };
+		}
+		math::euler_to_quat_batch(_euler.data(), _quats.data(), count);
+		return true;
+	}
+
+	void run() override
+	{
+		do {
+			std::cout << "SIMD math (" << math::simd::isa_name << ", " << math::simd::floatv::width << " lanes)" << std::endl;
+			check_sin_cos();
+			check_kernels();
+			benchmark();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override {}
+
+private:
+	static constexpr u32 count{ 1 << 20 };
+
+	// Errors against double precision for angles in the range the editor makes and far outside it
+	void check_sin_cos()
+	{
+		using namespace math::simd;
+		for (f32 range : { 10.f, 8192.f })
+		{
+			std::mt19937 random{ 3 };
+			std::uniform_real_distribution<f32> angle{ -range, range };
+			double max_error{ 0.0 };
+			for (u32 i{ 0 }; i < count; i += floatv::width)
+			{
+				f32 x[floatv::width], s[floatv::width], c[floatv::width];
+				for (auto& a : x) a = angle(random);
+				floatv sv, cv;
+				sin_cos(floatv::load(x), sv, cv);
+				sv.store(s);
+				cv.store(c);
+				for (u32 k{ 0 }; k < floatv::width; ++k)
+				{
+					max_error = std::max(max_error, std::max(fabs(s[k] - sin((double)x[k])), fabs(c[k] - cos((double)x[k]))));
+				}
+			}
+			std::cout << "  sin_cos, |x| < " << range << ": max error " << max_error << " (" << max_error / FLT_EPSILON << " epsilon)"
+				<< (max_error < 4.f * FLT_EPSILON ? "" : " INVALID") << std::endl;
+		}
+	}
+
+	void check_kernels()
+	{
+		utl::vector<math::v4> product(count);
+		utl::vector<math::v3> rotated(count);
+		math::quat_mul_batch(_quats.data(), _quats.data() + 1, product.data(), count - 1);
+		math::quat_rotate_batch(_quats.data(), _vectors.data(), rotated.data(), count);
+
+		double euler_error{ 0.0 }, mul_error{ 0.0 }, rotate_error{ 0.0 };
+		for (u32 i{ 0 }; i < count; ++i)
+		{
+			double q[4];
+			euler_to_quat(_euler[i], q);
+			// q and -q are the same rotation
+			const double sign{ q[0] * _quats[i].x + q[1] * _quats[i].y + q[2] * _quats[i].z + q[3] * _quats[i].w < 0.0 ? -1.0 : 1.0 };
+			const f32* const got{ &_quats[i].x };
+			for (u32 k{ 0 }; k < 4; ++k) euler_error = std::max(euler_error, fabs(got[k] - sign * q[k]));
+
+			if (i + 1 < count)
+			{
+				const f32* const a{ &_quats[i].x }, * const b{ &_quats[i + 1].x };
+				const double expected[4]
+				{
+					(double)a[3] * b[0] + (double)a[0] * b[3] + (double)a[1] * b[2] - (double)a[2] * b[1],
+					(double)a[3] * b[1] + (double)a[1] * b[3] + (double)a[2] * b[0] - (double)a[0] * b[2],
+					(double)a[3] * b[2] + (double)a[2] * b[3] + (double)a[0] * b[1] - (double)a[1] * b[0],
+					(double)a[3] * b[3] - (double)a[0] * b[0] - (double)a[1] * b[1] - (double)a[2] * b[2],
+				};
+				for (u32 k{ 0 }; k < 4; ++k) mul_error = std::max(mul_error, fabs((&product[i].x)[k] - expected[k]));
+			}
+
+			// q * v * conjugate(q) with the rotation matrix of q
+			const f32* const r{ &_quats[i].x };
+			const double x{ r[0] }, y{ r[1] }, z{ r[2] }, w{ r[3] };
+			const double v[3]{ _vectors[i].x, _vectors[i].y, _vectors[i].z };
+			const double expected[3]
+			{
+				(1 - 2 * (y * y + z * z)) * v[0] + 2 * (x * y - w * z) * v[1] + 2 * (x * z + w * y) * v[2],
+				2 * (x * y + w * z) * v[0] + (1 - 2 * (x * x + z * z)) * v[1] + 2 * (y * z - w * x) * v[2],
+				2 * (x * z - w * y) * v[0] + 2 * (y * z + w * x) * v[1] + (1 - 2 * (x * x + y * y)) * v[2],
+			};
+			for (u32 k{ 0 }; k < 3; ++k) rotate_error = std::max(rotate_error, fabs((&rotated[i].x)[k] - expected[k]) / 10.0);
+		}
+		std::cout << "  euler_to_quat_batch: max error " << euler_error / FLT_EPSILON << " epsilon" << (euler_error < 8.f * FLT_EPSILON ? "" : " INVALID") << std::endl;
+		std::cout << "  quat_mul_batch:      max error " << mul_error / FLT_EPSILON << " epsilon" << (mul_error < 4.f * FLT_EPSILON ? "" : " INVALID") << std::endl;
+		std::cout << "  quat_rotate_batch:   max error " << rotate_error / FLT_EPSILON << " epsilon (of the length)" << (rotate_error < 8.f * FLT_EPSILON ? "" : " INVALID") << std::endl;
+	}
+
+	// Reference in double precision: roll around z, then pitch around x, then yaw around y
+	static void euler_to_quat(const math::v3& e, double (&q)[4])
+	{
+		const double sp{ sin(e.x * 0.5) }, cp{ cos(e.x * 0.5) };
+		const double sy{ sin(e.y * 0.5) }, cy{ cos(e.y * 0.5) };
+		const double sr{ sin(e.z * 0.5) }, cr{ cos(e.z * 0.5) };
+		q[0] = cr * sp * cy + sr * cp * sy;
+		q[1] = cr * cp * sy - sr * sp * cy;
+		q[2] = sr * cp * cy - cr * sp * sy;
+		q[3] = cr * cp * cy + sr * sp * sy;
+	}
+
+	// Millions of quaternions per second, batch kernel against one at a time with sinf and cosf
+	void benchmark()
+	{
+		using clock = std::chrono::high_resolution_clock;
+		utl::vector<math::v4> out(count);
+		auto measure = [&out](auto&& func) {
+			f32 best{ 1e9f };
+			for (u32 run{ 0 }; run < 5; ++run)
+			{
+				const auto start{ clock::now() };
+				func();
+				best = std::min(best, std::chrono::duration<f32>(clock::now() - start).count());
+			}
+			return count / best / 1e6f;
+		};
+
+		const f32 scalar{ measure([&]() {
+			for (u32 i{ 0 }; i < count; ++i)
+			{
+				const math::v3& e{ _euler[i] };
+				const f32 sp{ sinf(e.x * 0.5f) }, cp{ cosf(e.x * 0.5f) };
+				const f32 sy{ sinf(e.y * 0.5f) }, cy{ cosf(e.y * 0.5f) };
+				const f32 sr{ sinf(e.z * 0.5f) }, cr{ cosf(e.z * 0.5f) };
+				out[i] = { cr * sp * cy + sr * cp * sy, cr * cp * sy - sr * sp * cy, sr * cp * cy - cr * sp * sy, cr * cp * cy + sr * sp * sy };
+			}
+		}) };
+		const f32 batch{ measure([&]() { math::euler_to_quat_batch(_euler.data(), out.data(), count); }) };
+		const f32 mul{ measure([&]() { math::quat_mul_batch(_quats.data(), _quats.data(), out.data(), count); }) };
+		std::cout << "  Euler to quaternion: " << scalar << "M/s with sinf/cosf, " << batch << "M/s batched" << std::endl;
+		std::cout << "  Quaternion multiply: " << mul << "M/s batched" << std::endl;
+	}
+
+	utl::vector<math::v3>	_euler;
+	utl::vector<math::v4>	_quats;
+	utl::vector<math::v3>	_vectors;
+};
@@ -0,0 +1,151 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
+#include "../Engine/Spatial/SpatialIndex.h"
+
+#include <iostream>
+#include <chrono>
+#include <ctime>
+#include <algorithm>
+#include <cmath>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		srand((u32)time(nullptr)); // get random seed for testing
+
+		transform::init_info transform_info{};
+		transform_info.rotation[3] = 1.f;
+		game_entity::entity_info entity_info{ &transform_info };
+		for (u32 i{ 0 }; i < 100000; ++i)
+		{
+			transform_info.position[0] = random_position();
+			transform_info.position[1] = random_position();
+			transform_info.position[2] = random_position();
+			const game_entity::entity entity{ game_entity::create(entity_info) };
+			_entities.push_back(entity);
+			spatial::add(entity);
+		}
+		return true;
+	}
+
+	void run() override
+	{
+		do {
+			using clock = std::chrono::high_resolution_clock;
+			constexpr u32 frames{ 60 };
+			constexpr u32 queries{ 10000 };
+			f32 update_ms{ 0.f };
+
+			// Every entity moves a little every frame
+			for (u32 frame{ 0 }; frame < frames; ++frame)
+			{
+				move_all(0.05f);
+				const auto start{ clock::now() };
+				spatial::update();
+				update_ms += std::chrono::duration<f32, std::milli>(clock::now() - start).count();
+			}
+
+			// Radius queries at random places, checked against a brute force search
+			utl::vector<game_entity::entity_id> results;
+			u64 hits{ 0 };
+			auto start{ clock::now() };
+			for (u32 i{ 0 }; i < queries; ++i)
+			{
+				results.clear();
+				spatial::query_sphere({ random_position(), random_position(), random_position() }, 20.f, results);
+				hits += results.size();
+			}
+			const f32 sphere_ms{ std::chrono::duration<f32, std::milli>(clock::now() - start).count() };
+			const bool sphere_ok{ check_sphere() };
+
+			start = clock::now();
+			for (u32 i{ 0 }; i < queries; ++i)
+			{
+				results.clear();
+				const math::v3 center{ random_position(), random_position(), random_position() };
+				spatial::query_box({ center.x - 10.f, center.y - 10.f, center.z - 10.f }, { center.x + 10.f, center.y + 10.f, center.z + 10.f }, results);
+			}
+			const f32 box_ms{ std::chrono::duration<f32, std::milli>(clock::now() - start).count() };
+
+			start = clock::now();
+			for (u32 i{ 0 }; i < queries; ++i)
+			{
+				results.clear();
+				spatial::query_ray({ random_position(), random_position(), random_position() }, { 1.f, 0.3f, -0.2f }, 200.f, results);
+			}
+			const f32 ray_ms{ std::chrono::duration<f32, std::milli>(clock::now() - start).count() };
+
+			std::cout << "Entities:        " << spatial::count() << " (tree height " << spatial::tree_height() << ")" << std::endl;
+			std::cout << "Update time:     " << update_ms / frames << " ms per frame" << std::endl;
+			std::cout << "Sphere queries:  " << queries / sphere_ms << " per ms (" << hits / queries << " hits on average)" << std::endl;
+			std::cout << "Box queries:     " << queries / box_ms << " per ms" << std::endl;
+			std::cout << "Ray queries:     " << queries / ray_ms << " per ms" << std::endl;
+			std::cout << "Matches brute force: " << sphere_ok << std::endl;
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override
+	{
+		spatial::clear();
+		for (auto entity : _entities) game_entity::remove(entity.get_id());
+	}
+
+private:
+	static f32 random_position() { return (f32)(rand() % 1000) - 500.f; }
+	static f32 random_step(f32 step) { return step * ((f32)(rand() % 201) - 100.f) / 100.f; }
+
+	void move_all(f32 step)
+	{
+		const transform::storage_view transforms{ transform::view() };
+		for (const auto entity : _entities)
+		{
+			const id::id_type index{ id::index(entity.get_id()) };
+			math::v3 position{ transforms.positions[index] };
+			position.x += random_step(step);
+			position.y += random_step(step);
+			position.z += random_step(step);
+			transform::set(index, position, transforms.rotations[index], transforms.scales[index]);
+		}
+	}
+
+	bool check_sphere()
+	{
+		const math::v3 center{ random_position(), random_position(), random_position() };
+		constexpr f32 radius{ 50.f };
+		utl::vector<game_entity::entity_id> results;
+		spatial::query_sphere(center, radius, results);
+
+		// Entities are boxes with a half size of 0.5, so compare the distance to the box
+		utl::vector<game_entity::entity_id> expected;
+		const transform::storage_view transforms{ transform::view() };
+		for (const auto entity : _entities)
+		{
+			const math::v3& p{ transforms.positions[id::index(entity.get_id())] };
+			const f32 dx{ std::max(fabsf(p.x - center.x) - 0.5f, 0.f) };
+			const f32 dy{ std::max(fabsf(p.y - center.y) - 0.5f, 0.f) };
+			const f32 dz{ std::max(fabsf(p.z - center.z) - 0.5f, 0.f) };
+			if (dx * dx + dy * dy + dz * dz <= radius * radius) expected.push_back(entity.get_id());
+		}
+
+		auto by_id = [](game_entity::entity_id a, game_entity::entity_id b) { return (id::id_type)a < (id::id_type)b; };
+		std::sort(results.begin(), results.end(), by_id);
+		std::sort(expected.begin(), expected.end(), by_id);
+		return results == expected;
+	}
+
+	utl::vector<game_entity::entity> _entities;
+};
@@ -0,0 +1,195 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
+#include "../Engine/Content/ContentLoader.h"
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		// A level of 1024 x 1024 units with the static transforms in chunks of 64 x 64
+		std::mt19937 random{ 3 };
+		std::uniform_real_distribution<f32> unit{ 0.f, 1.f };
+		constexpr u32 cells{ 16 };
+		for (u32 z{ 0 }; z < cells; ++z)
+		{
+			for (u32 x{ 0 }; x < cells; ++x)
+			{
+				transform::add_static_chunk({ x * 64.f, 0.f, z * 64.f }, { x * 64.f + 64.f, 32.f, z * 64.f + 64.f });
+			}
+		}
+
+		for (u32 i{ 0 }; i < entity_count; ++i)
+		{
+			transform::init_info info{};
+			const u32 cx{ (u32)(unit(random) * cells) % cells }, cz{ (u32)(unit(random) * cells) % cells };
+			info.position[0] = cx * 64.f + unit(random) * 64.f;
+			info.position[1] = unit(random) * 32.f;
+			info.position[2] = cz * 64.f + unit(random) * 64.f;
+
+			const f32 angle{ unit(random) * 6.2831853f }, axis_y{ unit(random) * 2.f - 1.f };
+			const f32 axis_xz{ sqrtf(1.f - axis_y * axis_y) };
+			info.rotation[0] = axis_xz * sinf(angle * 0.5f);
+			info.rotation[1] = axis_y * sinf(angle * 0.5f);
+			info.rotation[3] = cosf(angle * 0.5f);
+			info.scale[0] = info.scale[1] = info.scale[2] = 0.5f + unit(random) * 4.f;
+			info.static_chunk = cz * cells + cx;
+			_source.push_back(info);
+
+			game_entity::entity_info entity_info{ &info };
+			_entities.push_back(game_entity::create(entity_info));
+		}
+		return true;
+	}
+
+	void run() override
+	{
+		do {
+			measure_error();
+			measure_iteration();
+			measure_game_bin();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override
+	{
+		for (auto entity : _entities) game_entity::remove(entity.get_id());
+		transform::remove_static_chunks();
+	}
+
+private:
+	static constexpr u32 entity_count{ 200000 };
+
+	// How far the stored transforms are from what was asked for
+	void measure_error()
+	{
+		f32 position_error{ 0.f }, rotation_error{ 0.f }, scale_error{ 0.f };
+		for (u32 i{ 0 }; i < entity_count; ++i)
+		{
+			const transform::component t{ _entities[i].transform() };
+			const transform::init_info& info{ _source[i] };
+			const math::v3 p{ t.position() }, s{ t.scale() };
+			const math::v4 q{ t.rotation() };
+			position_error = std::max(position_error, std::max(fabsf(p.x - info.position[0]), std::max(fabsf(p.y - info.position[1]), fabsf(p.z - info.position[2]))));
+			scale_error = std::max(scale_error, fabsf(s.x - info.scale[0]) / info.scale[0]);
+			// Angle between the two rotations
+			const f32 dot{ fabsf(q.x * info.rotation[0] + q.y * info.rotation[1] + q.z * info.rotation[2] + q.w * info.rotation[3]) };
+			rotation_error = std::max(rotation_error, 2.f * acosf(std::min(dot, 1.f)));
+		}
+		std::cout << "Static transforms: " << entity_count << std::endl;
+		std::cout << "  Max position error: " << position_error * 1000.f << " mm (64 m chunks)" << std::endl;
+		std::cout << "  Max rotation error: " << rotation_error * 57.29578f << " degrees" << std::endl;
+		std::cout << "  Max scale error:    " << scale_error * 100.f << " %" << std::endl;
+	}
+
+	// Find the static transforms in a box, once through the full arrays and once through the packed ones.
+	// Both loops test every condition with & instead of && since which ones pass is random and would mispredict
+	void measure_iteration()
+	{
+		using clock = std::chrono::high_resolution_clock;
+		constexpr u32 runs{ 50 };
+		const math::v3 min{ 100.f, 0.f, 100.f }, max{ 400.f, 16.f, 400.f };
+
+		u32 full_count{ 0 }, packed_count{ 0 };
+		const auto full_start{ clock::now() };
+		for (u32 run{ 0 }; run < runs; ++run)
+		{
+			const transform::storage_view transforms{ transform::view() };
+			full_count = 0;
+			for (u32 i{ 0 }; i < transforms.count; ++i)
+			{
+				const math::v3& p{ transforms.positions[i] };
+				const f32 s{ transforms.scales[i].x };
+				full_count += (p.x >= min.x) & (p.x <= max.x) & (p.y >= min.y) & (p.y <= max.y) & (p.z >= min.z) & (p.z <= max.z) & (s > 1.f);
+			}
+		}
+		const f32 full_ms{ std::chrono::duration<f32, std::milli>(clock::now() - full_start).count() / runs };
+
+		// The packed query moves the box into the 16 bit space of each chunk once, then only compares integers
+		struct chunk_box { u16 min[3]; u16 max[3]; };
+		utl::vector<chunk_box> boxes(transform::static_view().chunk_count);
+		const auto packed_start{ clock::now() };
+		for (u32 run{ 0 }; run < runs; ++run)
+		{
+			const transform::static_storage_view statics{ transform::static_view() };
+			for (u32 i{ 0 }; i < statics.chunk_count; ++i)
+			{
+				const transform::static_chunk& chunk{ statics.chunks[i] };
+				const f32 box_min[3]{ min.x, min.y, min.z }, box_max[3]{ max.x, max.y, max.z };
+				const f32 chunk_min[3]{ chunk.min.x, chunk.min.y, chunk.min.z }, chunk_max[3]{ chunk.max.x, chunk.max.y, chunk.max.z };
+				for (u32 axis{ 0 }; axis < 3; ++axis)
+				{
+					const f32 scale{ 65535.f / (chunk_max[axis] - chunk_min[axis]) };
+					const f32 lo{ ceilf((box_min[axis] - chunk_min[axis]) * scale) }, hi{ floorf((box_max[axis] - chunk_min[axis]) * scale) };
+					boxes[i].min[axis] = (u16)std::clamp(lo, 0.f, 65535.f);
+					boxes[i].max[axis] = (u16)std::clamp(hi, 0.f, 65535.f);
+					if (hi < 0.f || lo > 65535.f) boxes[i].min[axis] = 65535, boxes[i].max[axis] = 0; // Box misses the chunk
+				}
+			}
+
+			packed_count = 0;
+			for (u32 i{ 0 }; i < statics.count; ++i)
+			{
+				const transform::packed_transform& t{ statics.transforms[i] };
+				const chunk_box& box{ boxes[t.chunk] };
+				packed_count += (t.position[0] >= box.min[0]) & (t.position[0] <= box.max[0]) & (t.position[1] >= box.min[1]) & (t.position[1] <= box.max[1]) &
+					(t.position[2] >= box.min[2]) & (t.position[2] <= box.max[2]) & (t.scale > 0x3c00); // f16 1.0
+			}
+		}
+		const f32 packed_ms{ std::chrono::duration<f32, std::milli>(clock::now() - packed_start).count() / runs };
+
+		std::cout << "  Box query full:   " << full_ms << " ms (" << sizeof(math::v3) * 2 << " bytes read each, " << full_count << " found)" << std::endl;
+		std::cout << "  Box query packed: " << packed_ms << " ms (" << sizeof(transform::packed_transform) << " bytes read each, " << packed_count << " found)" << std::endl;
+
+		// The packed form is kept next to the full arrays with its entity index and mapping, nothing else is cached
+		const size_t full_bytes{ sizeof(math::v3) * 2 + sizeof(math::v4) };
+		const size_t static_bytes{ sizeof(transform::packed_transform) + sizeof(id::id_type) + sizeof(u32) };
+		std::cout << "  Memory: " << full_bytes << " bytes per transform in the full arrays, static transforms add " << static_bytes << std::endl;
+	}
+
+	// Size of a game.bin with only static entities before and after packing
+	void measure_game_bin()
+	{
+		utl::vector<u8> game_bin;
+		auto write = [&game_bin](const void* data, size_t size) {
+			game_bin.insert(game_bin.end(), (const u8*)data, (const u8*)data + size);
+		};
+		auto write_u32 = [&write](u32 value) { write(&value, sizeof(u32)); };
+		write_u32(entity_count);
+		for (const auto& info : _source)
+		{
+			write_u32(1); // Static
+			write_u32(1);
+			write_u32(0); // Transform
+			const f32 euler[3]{ 0.f, asinf(info.rotation[1]) * 2.f, 0.f };
+			write(info.position, sizeof(info.position));
+			write(euler, sizeof(euler));
+			write(info.scale, sizeof(info.scale));
+		}
+
+		const utl::vector<u8> packed{ content::pack_static_transforms(game_bin) };
+		std::cout << "  game.bin: " << game_bin.size() / entity_count << " bytes per entity, packed "
+			<< packed.size() / (f32)entity_count << " bytes per entity" << std::endl;
+	}
+
+	utl::vector<game_entity::entity>	_entities;
+	utl::vector<transform::init_info>	_source;
+};
@@ -0,0 +1,224 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <algorithm>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		// Like a level: most things are static, some move and a few are stretched
+		std::mt19937 random{ 5 };
+		std::uniform_real_distribution<f32> unit{ 0.f, 1.f };
+		constexpr u32 cells{ 16 };
+		for (u32 z{ 0 }; z < cells; ++z)
+		{
+			for (u32 x{ 0 }; x < cells; ++x)
+			{
+				transform::add_static_chunk({ x * 64.f, 0.f, z * 64.f }, { x * 64.f + 64.f, 32.f, z * 64.f + 64.f });
+			}
+		}
+
+		for (u32 i{ 0 }; i < entity_count; ++i)
+		{
+			transform::init_info info{};
+			info.position[0] = unit(random) * cells * 64.f;
+			info.position[1] = unit(random) * 32.f;
+			info.position[2] = unit(random) * cells * 64.f;
+			const f32 angle{ unit(random) * 6.2831853f };
+			info.rotation[1] = sinf(angle * 0.5f);
+			info.rotation[3] = cosf(angle * 0.5f);
+			info.scale[0] = info.scale[1] = info.scale[2] = 0.5f + unit(random) * 2.f;
+
+			const f32 kind{ unit(random) };
+			if (kind < 0.6f)
+			{
+				const u32 cx{ std::min((u32)(info.position[0] / 64.f), cells - 1) }, cz{ std::min((u32)(info.position[2] / 64.f), cells - 1) };
+				info.static_chunk = cz * cells + cx;
+			}
+			else if (kind > 0.9f)
+			{
+				info.scale[1] *= 3.f;
+			}
+
+			game_entity::entity_info entity_info{ &info };
+			_entities.push_back(game_entity::create(entity_info));
+		}
+		return true;
+	}
+
+	void run() override
+	{
+		do {
+			change_categories();
+			move_statics();
+			check_kernels();
+			benchmark();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override
+	{
+		for (auto entity : _entities) game_entity::remove(entity.get_id());
+		transform::remove_static_chunks();
+	}
+
+private:
+	static constexpr u32 entity_count{ 200000 };
+	static constexpr transform::category categories[]{ transform::category::static_transform, transform::category::dynamic_uniform, transform::category::dynamic_nonuniform };
+	static constexpr const char* category_names[]{ "Static", "Dynamic uniform", "Dynamic non-uniform" };
+
+	// Stretch some dynamic transforms and make others uniform again, remove a few and make new ones in their slots
+	void change_categories()
+	{
+		std::mt19937 random{ _round++ };
+		std::uniform_int_distribution<u32> pick{ 0, entity_count - 1 };
+		const transform::storage_view transforms{ transform::view() };
+		for (u32 i{ 0 }; i < 10000; ++i)
+		{
+			const id::id_type index{ id::index(_entities[pick(random)].get_id()) };
+			if (transform::get_category(index) == transform::category::static_transform) continue;
+			math::v3 scale{ transforms.scales[index] };
+			scale.y = (i & 1) ? scale.x : scale.x * 2.f;
+			transform::set(index, transforms.positions[index], transforms.rotations[index], scale);
+		}
+		for (u32 i{ 0 }; i < 1000; ++i)
+		{
+			game_entity::entity& entity{ _entities[pick(random)] };
+			const transform::component t{ entity.transform() };
+			transform::init_info info{};
+			const math::v3 p{ t.position() }, s{ t.scale() };
+			const math::v4 q{ t.rotation() };
+			memcpy(info.position, &p, sizeof(p));
+			memcpy(info.rotation, &q, sizeof(q));
+			memcpy(info.scale, &s, sizeof(s));
+			game_entity::remove(entity.get_id());
+			game_entity::entity_info entity_info{ &info };
+			entity = game_entity::create(entity_info);
+		}
+	}
+
+	// Move some static transforms like the editor would: inside their chunk they stay static, out of it or with
+	// a non-uniform scale they become dynamic and keep exactly what was set
+	void move_statics()
+	{
+		const transform::category_storage_view statics{ transform::view(transform::category::static_transform) };
+		const transform::storage_view transforms{ transform::view() };
+		utl::vector<id::id_type> moved{ statics.entity_indices, statics.entity_indices + std::min(statics.count, 300u) };
+		bool valid{ true };
+		u32 kept{ 0 }, left{ 0 };
+		for (u32 i{ 0 }; i < (u32)moved.size(); ++i)
+		{
+			const id::id_type index{ moved[i] };
+			math::v3 position{ transforms.positions[index] };
+			math::v3 scale{ transforms.scales[index] };
+			if (i % 3 == 1) position.y += 100.f; // Above every chunk
+			if (i % 3 == 2) scale.y *= 2.f;
+			transform::set(index, position, transforms.rotations[index], scale);
+
+			const transform::category c{ transform::get_category(index) };
+			if (i % 3 == 0)
+			{
+				// Already quantized, so it packs to the same values
+				valid &= c == transform::category::static_transform && transforms.positions[index].y == position.y;
+				++kept;
+			}
+			else
+			{
+				valid &= c == (i % 3 == 1 ? transform::category::dynamic_uniform : transform::category::dynamic_nonuniform);
+				valid &= transforms.positions[index].y == position.y && transforms.scales[index].y == scale.y;
+				++left;
+			}
+		}
+		std::cout << "Moved statics: " << kept << " stayed static, " << left << " became dynamic "
+			<< (valid ? "with their values kept" : "INVALID") << std::endl;
+	}
+
+	// Each kernel has to give the same answer as the generic path, and every transform is in one category
+	void check_kernels()
+	{
+		bool valid{ true };
+		u32 total{ 0 };
+		for (u32 c{ 0 }; c < _countof(categories); ++c)
+		{
+			const transform::category_storage_view stream{ transform::view(categories[c]) };
+			total += stream.count;
+			utl::vector<math::m4x4> specialized(stream.count), generic(stream.count);
+			transform::world_matrices(categories[c], specialized.data());
+			transform::world_matrices(stream.entity_indices, stream.count, generic.data());
+			valid &= !stream.count || !memcmp(specialized.data(), generic.data(), stream.count * sizeof(math::m4x4));
+
+			utl::vector<id::id_type> found(stream.count), generic_found(stream.count);
+			const math::v3 center{ 300.f, 10.f, 300.f };
+			const u32 found_count{ transform::find_overlapping(categories[c], center, 100.f, 1.5f, found.data()) };
+			const u32 generic_count{ transform::find_overlapping(stream.entity_indices, stream.count, center, 100.f, 1.5f, generic_found.data()) };
+			valid &= found_count == generic_count && std::equal(found.begin(), found.begin() + found_count, generic_found.begin());
+
+			for (u32 i{ 0 }; i < stream.count; ++i)
+			{
+				valid &= transform::get_category(stream.entity_indices[i]) == categories[c];
+			}
+			std::cout << category_names[c] << ": " << stream.count << " transforms, " << found_count << " found" << std::endl;
+		}
+		valid &= total == entity_count;
+		std::cout << "Categories " << (valid ? "match the generic path" : "INVALID") << std::endl;
+	}
+
+	// World matrices and sphere queries per category, specialized against generic
+	void benchmark()
+	{
+		using clock = std::chrono::high_resolution_clock;
+		constexpr u32 runs{ 20 };
+		auto measure = [](auto&& func) {
+			f32 best{ 1e9f };
+			for (u32 run{ 0 }; run < runs; ++run)
+			{
+				const auto start{ clock::now() };
+				func();
+				best = std::min(best, std::chrono::duration<f32, std::milli>(clock::now() - start).count());
+			}
+			return best;
+		};
+
+		utl::vector<math::m4x4> matrices(entity_count);
+		utl::vector<id::id_type> found(entity_count);
+		const math::v3 center{ 300.f, 10.f, 300.f };
+		f32 total_generic{ 0.f }, total_specialized{ 0.f };
+		for (u32 c{ 0 }; c < _countof(categories); ++c)
+		{
+			const transform::category_storage_view stream{ transform::view(categories[c]) };
+			const f32 generic_ms{ measure([&]() { transform::world_matrices(stream.entity_indices, stream.count, matrices.data()); }) };
+			const f32 specialized_ms{ measure([&]() { transform::world_matrices(categories[c], matrices.data()); }) };
+			const f32 generic_query_ms{ measure([&]() { transform::find_overlapping(stream.entity_indices, stream.count, center, 100.f, 1.5f, found.data()); }) };
+			const f32 specialized_query_ms{ measure([&]() { transform::find_overlapping(categories[c], center, 100.f, 1.5f, found.data()); }) };
+			total_generic += generic_ms;
+			total_specialized += specialized_ms;
+			std::cout << "  " << category_names[c] << " matrices: " << generic_ms << " ms generic, " << specialized_ms << " ms specialized ("
+				<< generic_ms / specialized_ms << "x), query: " << generic_query_ms << " ms generic, " << specialized_query_ms << " ms specialized ("
+				<< generic_query_ms / specialized_query_ms << "x)" << std::endl;
+		}
+		std::cout << "  All matrices: " << total_generic << " ms generic, " << total_specialized << " ms specialized ("
+			<< total_generic / total_specialized << "x)" << std::endl;
+	}
+
+	utl::vector<game_entity::entity>	_entities;
+	u32									_round{ 0 };
+};
@@ -0,0 +1,129 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
+#include "../Engine/Components/TransformChannel.h"
+
+#include <iostream>
+#include <chrono>
+#include <atomic>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		transform::init_info transform_info{};
+		transform_info.rotation[3] = 1.f;
+		game_entity::entity_info entity_info{ &transform_info };
+		for (u32 i{ 0 }; i < entity_count; ++i)
+		{
+			_entities.push_back(game_entity::create(entity_info));
+		}
+		_overflow_reported = test_overflow();
+		return transform_channel::initialize(entity_count, 1024);
+	}
+
+	void run() override
+	{
+		do {
+			using clock = std::chrono::high_resolution_clock;
+			constexpr u32 frames{ 300 };
+			std::atomic<bool> done{ false };
+			u32 good_reads{ 0 }, torn_reads{ 0 }, bad_reads{ 0 }, edits_sent{ 0 };
+			// The channel keeps counting frames over the runs
+			const u64 first_frame{ transform_channel::data()->frame.load() + 1 };
+
+			// The "editor" reads every frame it can see and sends an edit for each one
+			std::thread editor{ [&]() {
+				u64 last_frame{ 0 };
+				while (!done.load(std::memory_order_relaxed))
+				{
+					transform_channel::read_view view{};
+					if (!transform_channel::begin_read(view) || view.frame == last_frame) continue;
+
+					// The engine gives every entity y = frame, so a good read has the same value everywhere
+					bool consistent{ view.count == entity_count };
+					for (u32 i{ 0 }; i < view.count; ++i) consistent &= view.positions[i].y == (f32)view.frame;
+
+					if (!transform_channel::end_read(view)) { ++torn_reads; continue; }
+					consistent ? ++good_reads : ++bad_reads;
+					last_frame = view.frame;
+
+					transform_channel::transform_edit edit{};
+					edit.entity_id = _entities[edits_sent % entity_count].get_id();
+					edit.flags = transform_channel::edit_flags::scale;
+					edit.scale[0] = edit.scale[1] = edit.scale[2] = 2.f;
+					edits_sent += transform_channel::push_edit(edit) ? 1 : 0;
+				}
+			} };
+
+			f32 publish_ms{ 0.f };
+			u32 edits_applied{ 0 };
+			for (u32 frame{ 1 }; frame <= frames; ++frame)
+			{
+				move_all((f32)(first_frame + frame - 1));
+				edits_applied += transform_channel::apply_edits();
+				const auto start{ clock::now() };
+				transform_channel::publish();
+				publish_ms += std::chrono::duration<f32, std::milli>(clock::now() - start).count();
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			done = true;
+			editor.join();
+			edits_applied += transform_channel::apply_edits();
+
+			std::cout << "Entities:       " << entity_count << " (" << transform_channel::size() / 1024 << " KB channel)" << std::endl;
+			std::cout << "Publish time:   " << publish_ms / frames << " ms per frame" << std::endl;
+			std::cout << "Editor reads:   " << good_reads << " good, " << torn_reads << " torn and detected, " << bad_reads << " bad" << std::endl;
+			std::cout << "Edits applied:  " << edits_applied << " of " << edits_sent << std::endl;
+			std::cout << "Overflow:       " << (_overflow_reported ? "reported" : "NOT REPORTED") << std::endl;
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override
+	{
+		transform_channel::shutdown();
+		for (auto entity : _entities) game_entity::remove(entity.get_id());
+	}
+
+private:
+	static constexpr u32 entity_count{ 100000 };
+
+	// A channel too small for all transforms publishes what fits and tells the editor how many there are.
+	// Uses its own channel, before the one the runs share is made
+	static bool test_overflow()
+	{
+		if (!transform_channel::initialize(entity_count / 2, 1024)) return false;
+		const bool all_published{ transform_channel::publish() };
+		transform_channel::read_view view{};
+		const bool read{ transform_channel::begin_read(view) && transform_channel::end_read(view) };
+		transform_channel::shutdown();
+		return !all_published && read && view.count == entity_count / 2 && view.total == entity_count;
+	}
+
+	void move_all(f32 y)
+	{
+		const transform::storage_view transforms{ transform::view() };
+		for (const auto entity : _entities)
+		{
+			const id::id_type index{ id::index(entity.get_id()) };
+			math::v3 position{ transforms.positions[index] };
+			position.y = y;
+			transform::set(index, position, transforms.rotations[index], transforms.scales[index]);
+		}
+	}
+
+	utl::vector<game_entity::entity> _entities;
+	bool _overflow_reported{ false };
+};
@@ -0,0 +1,120 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../ContentTools/PrimitiveMesh.h"
+#include "../ContentTools/Geometry.h"
+
+#include <iostream>
+#include <chrono>
+#include <random>
+
+using namespace savage;
+
+class engine_test : public test
+{
+public:
+	bool initialize() override { return true; }
+
+	void run() override
+	{
+		do {
+			report_meshes();
+			benchmark();
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override {}
+
+private:
+	static void print(const char* name, const tools::vertex_cache_stats& before, const tools::vertex_cache_stats& after)
+	{
+		std::cout << "  " << name << ": ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> "
+			<< after.atvr << ", overfetch " << before.overfetch << " -> " << after.overfetch << std::endl;
+	}
+
+	// Statistics the processing stage keeps for every mesh, also for triangles in random order like some exporters write them
+	void report_meshes()
+	{
+		using namespace tools;
+		const primitive_init_info shapes[]
+		{
+			{ plane, { 256, 1, 256 } },
+			{ cube, { 64, 64, 64 } },
+			{ uv_sphere, { 256, 128, 1 } },
+			{ ico_shpere, { 64, 1, 1 } },
+			{ cylender, { 256, 64, 1 } },
+			{ capsule, { 128, 32, 16 } },
+		};
+
+		geometry_import_settings settings{};
+		settings.smothing_angle = 60.f;
+		settings.calculate_normals = 1;
+		settings.calculate_tangents = 1;
+
+		std::mt19937 random{ 5 };
+		std::cout << "Vertex cache (16 entries) and fetch (64 byte lines)" << std::endl;
+		for (const auto& info : shapes)
+		{
+			scene scene{};
+			create_primitive_mesh(scene, info);
+			create_primitive_mesh(scene, info);
+			shuffle_triangles(scene.lod_groups[1].meshes[0], random);
+			process_scene(scene, settings);
+
+			const mesh& m{ scene.lod_groups[0].meshes[0] }, & shuffled{ scene.lod_groups[1].meshes[0] };
+			print(m.name.c_str(), m.cache_stats_before, m.cache_stats_after);
+			print((m.name + " shuffled").c_str(), shuffled.cache_stats_before, shuffled.cache_stats_after);
+		}
+	}
+
+	static void shuffle_triangles(tools::mesh& m, std::mt19937& random)
+	{
+		const u32 triangle_count{ (u32)m.raw_indices.size() / 3 };
+		for (u32 i{ triangle_count - 1 }; i > 0; --i)
+		{
+			const u32 j{ std::uniform_int_distribution<u32>{ 0, i }(random) };
+			for (u32 corner{ 0 }; corner < 3; ++corner)
+			{
+				std::swap(m.raw_indices[i * 3 + corner], m.raw_indices[j * 3 + corner]);
+				for (auto& uvs : m.uv_sets) std::swap(uvs[i * 3 + corner], uvs[j * 3 + corner]);
+			}
+		}
+	}
+
+	// Triangles per second of the two reordering passes on a million triangles
+	void benchmark()
+	{
+		using namespace tools;
+		using clock = std::chrono::high_resolution_clock;
+		scene scene{};
+		create_primitive_mesh(scene, { uv_sphere, { 1000, 500, 1 } });
+		geometry_import_settings settings{};
+		settings.smothing_angle = 60.f;
+		process_scene(scene, settings);
+		mesh& m{ scene.lod_groups[0].meshes[0] };
+		std::mt19937 random{ 9 };
+		for (u32 i{ (u32)m.indices.size() / 3 - 1 }; i > 0; --i)
+		{
+			const u32 j{ std::uniform_int_distribution<u32>{ 0, i }(random) };
+			for (u32 corner{ 0 }; corner < 3; ++corner) std::swap(m.indices[i * 3 + corner], m.indices[j * 3 + corner]);
+		}
+
+		const f32 triangles{ m.indices.size() / 3.f };
+		const auto cache_start{ clock::now() };
+		optimize_vertex_cache(m.indices, (u32)m.vertices.size());
+		const f32 cache_seconds{ std::chrono::duration<f32>(clock::now() - cache_start).count() };
+		const auto fetch_start{ clock::now() };
+		optimize_vertex_fetch(m);
+		const f32 fetch_seconds{ std::chrono::duration<f32>(clock::now() - fetch_start).count() };
+
+		std::cout << "Reordering " << triangles / 1e6f << "M shuffled triangles: vertex cache " << cache_seconds * 1000.f << " ms ("
+			<< triangles / cache_seconds / 1e6f << "M triangles/s), vertex fetch " << fetch_seconds * 1000.f << " ms" << std::endl;
+	}
+};
@@ -8,13 +8,14 @@ MIT License - see LICENSE file
 #pragma once
 
 #include "Test.h"
-#include "..\Platform\PlatformTypes.h"
-#include "..\Platform\Platform.h"
+#include "../Platform/PlatformTypes.h"
+#include "../Platform/Platform.h"
 
 using namespace savage;
 
 platform::Window _windows[4];
 
+#ifdef _WIN64
 LRESULT win_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 {
 	switch (msg)
@@ -49,6 +50,7 @@ LRESULT win_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 
 	return DefWindowProc(hwnd, msg, wparam, lparam);
 }
+#endif // _WIN64
 
 class engine_test : public test
 {
@@ -56,6 +58,7 @@ public:
 	bool initialize() override
 	{
 
+#ifdef _WIN64
 		platform::window_init_info info[]
 		{
 			{&win_proc, nullptr, L"Test Window 1", 100, 100, 400, 800},
@@ -63,6 +66,16 @@ public:
 			{&win_proc, nullptr, L"Test Window 3", 200, 200, 400, 800},
 			{&win_proc, nullptr, L"Test Window 4", 250, 250, 400, 800},
 		};
+#else
+		// Headless windows have no window procedure
+		platform::window_init_info info[]
+		{
+			{nullptr, L"Test Window 1", 100, 100, 400, 800},
+			{nullptr, L"Test Window 2", 150, 150, 400, 800},
+			{nullptr, L"Test Window 3", 200, 200, 400, 800},
+			{nullptr, L"Test Window 4", 250, 250, 400, 800},
+		};
+#endif // _WIN64
 		static_assert(_countof(info) == _countof(_windows));
 
 		// Create the windows
@@ -0,0 +1,179 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+#pragma once
+
+#include "Test.h"
+#include "../Engine/Components/Entity.h"
+#include "../Engine/Components/Transform.h"
+#include "../Engine/Components/Script.h"
+#include "../Engine/Components/World.h"
+
+#include <iostream>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+
+using namespace savage;
+
+// A script with some state that has to come back when the world is rewound
+class counter_script : public script::entity_script
+{
+public:
+	constexpr explicit counter_script(game_entity::entity entity) : script::entity_script{ entity } {}
+	void update(float) override { ++_counter; }
+	void serialize(utl::vector<u8>& buffer) const override
+	{
+		const u8* const data{ (const u8*)&_counter };
+		buffer.insert(buffer.end(), data, data + sizeof(_counter));
+	}
+	void deserialize(const u8* data, u32 size) override
+	{
+		if (size == sizeof(_counter)) memcpy(&_counter, data, size);
+	}
+
+private:
+	u32 _counter{ 0 };
+};
+// Snapshots save scripts by tag, so the script has to be registered to be made again
+REGISTER_SCRIPT(counter_script);
+
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		srand((u32)time(nullptr)); // get random seed for testing
+
+		// Fill the world with 100,000 entities then remove some so the free list is not empty
+		transform::init_info transform_info{};
+		script::init_info script_info{ &script::detail::create_script<counter_script> };
+		for (u32 i{ 0 }; i < 100000; ++i)
+		{
+			// Every 100th entity gets a script
+			transform_info.position[0] = (f32)i;
+			game_entity::entity_info entity_info{ &transform_info, i % 100 ? nullptr : &script_info };
+			_entities.push_back(game_entity::create(entity_info));
+		}
+		for (u32 i{ 0 }; i < 2000; ++i)
+		{
+			const u32 index{ (u32)rand() % (u32)_entities.size() };
+			game_entity::remove(_entities[index].get_id());
+			utl::erase_unordered(_entities, index);
+		}
+
+		// Take a first snapshot so the timings don't include allocating the buffer
+		world::snapshot(_snapshot);
+		return true;
+	}
+
+	void run() override
+	{
+		do {
+			using clock = std::chrono::high_resolution_clock;
+
+			// Give the scripts some state to save
+			script::update(0.016f);
+			const u32 counters{ total() };
+
+			// Time a full snapshot of the world
+			auto start{ clock::now() };
+			world::snapshot(_snapshot);
+			const f32 snapshot_ms{ std::chrono::duration<f32, std::milli>(clock::now() - start).count() };
+
+			// Broken snapshots are turned down without touching the world
+			utl::vector<u8> broken{ _snapshot };
+			broken.resize(broken.size() / 2);
+			const bool truncated_rejected{ !world::restore(broken) };
+			broken = _snapshot;
+			broken.push_back(0);
+			const bool padded_rejected{ !world::restore(broken) };
+			broken = _snapshot;
+			const id::id_type bad_index{ 0xffffff00 };
+			memcpy(broken.data() + uniform_entities_offset(broken), &bad_index, sizeof(bad_index));
+			const bool bad_index_rejected{ !world::restore(broken) };
+			assert(truncated_rejected && padded_rejected && bad_index_rejected);
+
+			// Push a few frames where only some entities change
+			world::rewind_buffer rewind{ 8 };
+			rewind.push();
+			script::update(0.016f);
+			const game_entity::entity removed{ _entities.back() };
+			game_entity::remove(removed.get_id());
+			_entities.pop_back();
+			rewind.push();
+			assert(!game_entity::is_alive(removed.get_id()));
+
+			// Go back one frame and check that the entity is alive again
+			start = clock::now();
+			const bool rewound{ rewind.rewind(1) };
+			const f32 rewind_ms{ std::chrono::duration<f32, std::milli>(clock::now() - start).count() };
+			assert(rewound && game_entity::is_alive(removed.get_id()));
+			_entities.push_back(removed);
+
+			// The scripts are made again and should have the counters they had when the frame was pushed
+			const bool scripts_restored{ total() == counters };
+			assert(scripts_restored);
+
+			// A restored world should give back the exact same snapshot
+			utl::vector<u8> restored;
+			world::snapshot(restored);
+			assert(restored == _snapshot);
+
+			std::cout << "Snapshot size:  " << _snapshot.size() << " bytes" << std::endl;
+			std::cout << "Snapshot time:  " << snapshot_ms << " ms" << std::endl;
+			std::cout << "Rewind time:    " << rewind_ms << " ms" << std::endl;
+			std::cout << "Rewind memory:  " << rewind.memory_size() << " bytes" << std::endl;
+			std::cout << "Restored match: " << (rewound && restored == _snapshot) << std::endl;
+			std::cout << "Scripts match:  " << scripts_restored << std::endl;
+			std::cout << "Broken refused: " << (truncated_rejected && padded_rejected && bad_index_rejected) << std::endl;
+		} while (getchar() != 'q'); // Test until 'q' is pressed
+	}
+
+	void shutdown() override
+	{
+		for (auto entity : _entities) game_entity::remove(entity.get_id());
+	}
+
+private:
+	// Offset of the first uniform scale transform in a snapshot, going through the vectors transform::save_state() writes
+	static size_t uniform_entities_offset(const utl::vector<u8>& snapshot)
+	{
+		const size_t element_sizes[]{ sizeof(transform::packed_transform), sizeof(id::id_type), sizeof(u32), sizeof(transform::static_chunk),
+			sizeof(transform::category), sizeof(u32) };
+		size_t offset{ 2 * sizeof(u32) };
+		u32 count;
+		memcpy(&count, snapshot.data() + offset, sizeof(u32));
+		offset += sizeof(u32) + (size_t)count * (2 * sizeof(math::v3) + sizeof(math::v4));
+		for (const size_t size : element_sizes)
+		{
+			memcpy(&count, snapshot.data() + offset, sizeof(u32));
+			offset += sizeof(u32) + count * size;
+		}
+		return offset + sizeof(u32);
+	}
+
+	u32 total() const
+	{
+		u32 sum{ 0 };
+		for (const auto& entity : _entities)
+		{
+			if (!entity.script().is_valid()) continue;
+
+			// Scripts only know their entity, so read the counter through the script's own state
+			utl::vector<u8> state;
+			script::serialize(entity.script(), state);
+			u32 counter;
+			memcpy(&counter, state.data() + state.size() - sizeof(u32), sizeof(u32));
+			sum += counter;
+		}
+		return sum;
+	}
+
+	utl::vector<game_entity::entity>	_entities;
+	utl::vector<u8>						_snapshot;
+};
@@ -0,0 +1,48 @@
+/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+// A tiny game code library for TEST_HOT_RELOAD. It is loaded, reloaded and unloaded by content::load_game_code()
+// the same way the editor loads the game code, but only has one script and its own lookup so it doesn't need the engine
+
+#include "../Engine/EngineAPI/GameEntity.h"
+#include <cstring>
+#include <string>
+
+using namespace savage;
+
+namespace {
+
+	class counter_script : public script::entity_script
+	{
+	public:
+		constexpr explicit counter_script(game_entity::entity entity) : script::entity_script{ entity } {}
+		void update(float) override { ++_counter; }
+		void serialize(utl::vector<u8>& buffer) const override
+		{
+			const u8* const data{ (const u8*)&_counter };
+			buffer.insert(buffer.end(), data, data + sizeof(_counter));
+		}
+		void deserialize(const u8* data, u32 size) override
+		{
+			if (size == sizeof(_counter)) memcpy(&_counter, data, size);
+		}
+
+	private:
+		u32 _counter{ 0 };
+	};
+
+} // Anonymous namespace
+
+#ifdef _WIN64
+extern "C" __declspec(dllexport)
+#else
+extern "C" __attribute__((visibility("default")))
+#endif // _WIN64
+script::detail::script_creator get_script_creator(size_t tag)
+{
+	return tag == script::detail::string_hash()("counter_script") ? &script::detail::create_script<counter_script> : nullptr;
+}
@@ -12,6 +12,8 @@ using Savage_Editor.Utilities;
 using System;
 using System.Collections.Generic;
 using System.Collections.ObjectModel;
+using System.Collections.Specialized;
+using System.ComponentModel;
 using System.Diagnostics;
 using System.Linq;
 using System.Runtime.Serialization;
@@ -61,6 +63,35 @@ namespace Savage_Editor.Components
 			}
 		}
 
+		// Same as setting IsActive on each entity but the engine is called once for all of them
+		public static void SetActive(IEnumerable<GameEntity> entities, bool isActive)
+		{
+			var changed = entities.Where(x => x._isActive != isActive).ToList();
+			if (changed.Count == 0) return;
+
+			if (isActive) // Should be loaded
+			{
+				var ids = EngineAPI.EntityAPI.CreateGameEntities(changed);
+				for (int i = 0; i < changed.Count; ++i)
+				{
+					changed[i].EntityID = ids[i];
+					Debug.Assert(ID.IsValid(ids[i]));
+				}
+			}
+			else // Should be removed
+			{
+				var loaded = changed.Where(x => ID.IsValid(x._entityID)).ToList();
+				EngineAPI.EntityAPI.RemoveGameEntities(loaded);
+				loaded.ForEach(x => x.EntityID = ID.INVALID_ID);
+			}
+
+			foreach (var entity in changed)
+			{
+				entity._isActive = isActive;
+				entity.OnPropertyChanged(nameof(IsActive));
+			}
+		}
+
 		private bool _isEnbaled = true;
 		[DataMember]
 		public bool IsEnbaled
@@ -76,6 +107,29 @@ namespace Savage_Editor.Components
 			}
 		}
 
+		// Static entities never move in the game, so their transform can be stored in the compact form in game.bin
+		private bool _isStatic;
+		[DataMember]
+		public bool IsStatic
+		{
+			get => _isStatic;
+			set
+			{
+				if (_isStatic != value)
+				{
+					_isStatic = value;
+					_binaryClean = false;
+					OnPropertyChanged(nameof(IsStatic));
+				}
+			}
+		}
+
+		// False until the project writes the entity to game.bin or game.patch, and again whenever it changes after
+		// that, so a save only has to write the entities that changed. Not saved, loaded entities start out dirty
+		private bool _binaryClean;
+		public bool IsBinaryDirty => !_binaryClean;
+		public void MarkBinaryClean() => _binaryClean = true;
+
 		private string _name;
 		[DataMember]
 		public string Name
@@ -132,6 +186,16 @@ namespace Savage_Editor.Components
 			}
 		}
 
+		// Any change to the components changes what is written for the entity
+		private void OnComponentsChanged(object sender, NotifyCollectionChangedEventArgs e)
+		{
+			_binaryClean = false;
+			if (e.OldItems != null) foreach (Component component in e.OldItems) component.PropertyChanged -= OnComponentChanged;
+			if (e.NewItems != null) foreach (Component component in e.NewItems) component.PropertyChanged += OnComponentChanged;
+		}
+
+		private void OnComponentChanged(object sender, PropertyChangedEventArgs e) => _binaryClean = false;
+
 		[OnDeserialized]
 		void OnDeserialized(StreamingContext contex)
 		{
@@ -139,6 +203,9 @@ namespace Savage_Editor.Components
 			{
 				Components = new ReadOnlyObservableCollection<Component>(_components);
 				OnPropertyChanged(nameof(Components));
+
+				_components.CollectionChanged += OnComponentsChanged;
+				foreach (var component in _components) component.PropertyChanged += OnComponentChanged;
 			}
 		}
 
@@ -170,6 +237,21 @@ namespace Savage_Editor.Components
 			}
 		}
 
+		private bool? _isStatic;
+		[DataMember]
+		public bool? IsStatic
+		{
+			get => _isStatic;
+			set
+			{
+				if (_isStatic != value)
+				{
+					_isStatic = value;
+					OnPropertyChanged(nameof(IsStatic));
+				}
+			}
+		}
+
 		private string _name;
 		[DataMember]
 		public string Name
@@ -236,6 +318,7 @@ namespace Savage_Editor.Components
 			switch (propertyName)
 			{
 				case nameof(IsEnbaled): SelectedEntities.ForEach(x => x.IsEnbaled = IsEnbaled.Value); return true; // Update all values for IsEnabled
+				case nameof(IsStatic): SelectedEntities.ForEach(x => x.IsStatic = IsStatic.Value); return true; // Update all values for IsStatic
 				case nameof(Name): SelectedEntities.ForEach(x => x.Name = Name); return true; // Update all values for Name
 			}
 			return false;
@@ -244,6 +327,7 @@ namespace Savage_Editor.Components
 		protected virtual bool UpdateMSGameEntities()
 		{
 			IsEnbaled = GetMixedValue(SelectedEntities, new Func<GameEntity, bool>(x => x.IsEnbaled));
+			IsStatic = GetMixedValue(SelectedEntities, new Func<GameEntity, bool>(x => x.IsStatic));
 			Name = GetMixedValue(SelectedEntities, new Func<GameEntity, string>(x => x.Name));
 
 			return true;
@@ -5,6 +5,7 @@ Copyright (c) 2020-2022 Arash Khatami
 MIT License - see LICENSE file
 */
 
+using Savage_Editor.DLLWrappers;
 using Savage_Editor.Utilities;
 using System;
 using System.IO;
@@ -27,6 +28,7 @@ namespace Savage_Editor.Components
 				{
 					_position = value;
 					OnPropertyChanged(nameof(Position));
+					SendToEngine(TransformEditFlags.Position);
 				}
 			}
 		}
@@ -42,6 +44,7 @@ namespace Savage_Editor.Components
 				{
 					_rotation = value;
 					OnPropertyChanged(nameof(Rotation));
+					SendToEngine(TransformEditFlags.Rotation);
 				}
 			}
 		}
@@ -57,12 +60,27 @@ namespace Savage_Editor.Components
 				{
 					_scale = value;
 					OnPropertyChanged(nameof(Scale));
+					SendToEngine(TransformEditFlags.Scale);
 				}
 			}
 		}
 
 		public override IMSComponent GetMultiselectionComponent(MSEntity msEntity) => new MSTransform(msEntity);
 
+		// Move the engine entity too, through the transform channel the viewports update
+		private void SendToEngine(TransformEditFlags flags)
+		{
+			if (Owner == null || !ID.IsValid(Owner.EntityID)) return;
+			TransformChannel.SendEdit(new TransformEdit()
+			{
+				EntityID = Owner.EntityID,
+				Flags = flags,
+				Position = _position,
+				Rotation = Quaternion.CreateFromYawPitchRoll(_rotation.Y, _rotation.X, _rotation.Z), // Same as euler_to_quat_batch()
+				Scale = _scale,
+			});
+		}
+
 		// Save the values in binary
 		public override void WriteToBinary(BinaryWriter bw)
 		{
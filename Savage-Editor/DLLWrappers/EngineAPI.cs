@@ -10,6 +10,8 @@ using Savage_Editor.EngineAPIStructs;
 using Savage_Editor.GameProject;
 using Savage_Editor.Utilities;
 using System;
+using System.Collections.Generic;
+using System.Diagnostics;
 using System.Linq;
 using System.Numerics;
 using System.Runtime.InteropServices;
@@ -36,10 +38,29 @@ namespace Savage_Editor.EngineAPIStructs
 		public TransformComponent Transform = new TransformComponent();
 		public ScriptComponent Script = new ScriptComponent();
 	}
+
+	// Blittable version of GameEntityDescriptor, an array of these is passed to the engine without any copying
+	[StructLayout(LayoutKind.Sequential)]
+	struct PackedGameEntityDescriptor
+	{
+		public Vector3 Position;
+		public Vector3 Rotation;
+		public Vector3 Scale;
+		public IntPtr ScriptCreator;
+	}
 } // Anonymous namespace
 
 namespace Savage_Editor.DLLWrappers
 {
+	// What CookGameBinary does to game.bin
+	[Flags]
+	enum CookFlags : uint
+	{
+		None = 0x00,
+		PackStaticTransforms = 0x01,
+		Compress = 0x02,
+	}
+
 	static class EngineAPI
 	{
 		private const string _engineDLL = "EngineDLL.dll";
@@ -47,11 +68,15 @@ namespace Savage_Editor.DLLWrappers
 		public static extern int LoadGameCodeDLL(string dllPath);
 		[DllImport(_engineDLL)]
 		public static extern int UnloadGameCodeDLL();
+		[DllImport(_engineDLL, CharSet = CharSet.Ansi)]
+		public static extern int ReloadGameCodeDLL(string dllPath);
 		[DllImport(_engineDLL)]
 		public static extern IntPtr GetScriptCreator(string name);
 		[DllImport(_engineDLL)]
 		[return: MarshalAs(UnmanagedType.SafeArray)]
 		public static extern string[] GetScriptNames();
+		[DllImport(_engineDLL, CharSet = CharSet.Ansi)]
+		public static extern int CookGameBinary(string path, CookFlags flags, out uint checksum);
 		[DllImport(_engineDLL)]
 		public static extern int CreateRenderSurface(IntPtr host, int width, int height);
 		[DllImport(_engineDLL)]
@@ -62,6 +87,13 @@ namespace Savage_Editor.DLLWrappers
 		[DllImport(_engineDLL)]
 		public static extern int ResizeRenderSurface(int surfaceID);
 
+		[DllImport(_engineDLL)]
+		public static extern IntPtr OpenTransformChannel(int capacity, int queueCapacity);
+		[DllImport(_engineDLL)]
+		public static extern void CloseTransformChannel();
+		[DllImport(_engineDLL)]
+		public static extern int UpdateTransformChannel();
+
 
 		internal static class EntityAPI
 		{
@@ -80,25 +112,47 @@ namespace Savage_Editor.DLLWrappers
 					desc.Transform.Scale = c.Scale;
 				}
 				// Script component
+				desc.Script.ScriptCreator = GetScriptCreator(entity);
+
+				return CreateGameEntity(desc);
+			}
+
+			private static IntPtr GetScriptCreator(GameEntity entity)
+			{
+				var c = entity.GetComponent<Script>();
+				if (c != null && Project.Current != null) // Check for script component and that the project is loaded so it may be deferred until the DLL is loaded.
 				{
-					var c = entity.GetComponent<Script>();
-					if (c != null && Project.Current != null) // Check for script component and that the project is loaded so it may be deferred until the DLL is loaded.
+					// Find the script in the project
+					if (Project.Current.AvailableScripts.Contains(c.Name))
 					{
-						// Find the script in the project
-						if (Project.Current.AvailableScripts.Contains(c.Name))
-						{
-							// Add the script creator
-							desc.Script.ScriptCreator = GetScriptCreator(c.Name);
-						}
-						else
-						{
-							// Log an error
-							Logger.Log(MessageType.Error, $"Unable to find the script {c.Name}. Script component will NOT be created.");
-						}
+						// Add the script creator
+						return EngineAPI.GetScriptCreator(c.Name);
 					}
+					// Log an error
+					Logger.Log(MessageType.Error, $"Unable to find the script {c.Name}. Script component will NOT be created.");
 				}
+				return IntPtr.Zero;
+			}
 
-				return CreateGameEntity(desc);
+			// Create many entities with one call into the engine. Returns the new entity IDs in the same order
+			[DllImport(_engineDLL)]
+			private static extern int CreateGameEntities([In] PackedGameEntityDescriptor[] descs, int count, [Out] int[] ids);
+			public static int[] CreateGameEntities(IList<GameEntity> entities)
+			{
+				var descs = new PackedGameEntityDescriptor[entities.Count];
+				for (int i = 0; i < descs.Length; ++i)
+				{
+					var c = entities[i].GetComponent<Transform>();
+					descs[i].Position = c.Position;
+					descs[i].Rotation = c.Rotation;
+					descs[i].Scale = c.Scale;
+					descs[i].ScriptCreator = GetScriptCreator(entities[i]);
+				}
+
+				var ids = new int[descs.Length];
+				var created = CreateGameEntities(descs, descs.Length, ids);
+				Debug.Assert(created == descs.Length);
+				return ids;
 			}
 
 			[DllImport(_engineDLL)]
@@ -107,6 +161,15 @@ namespace Savage_Editor.DLLWrappers
 			{
 				RemoveGameEntity(entity.EntityID);
 			}
+
+			// Remove many entities with one call into the engine
+			[DllImport(_engineDLL)]
+			private static extern void RemoveGameEntities([In] int[] ids, int count);
+			public static void RemoveGameEntities(IList<GameEntity> entities)
+			{
+				var ids = entities.Select(x => x.EntityID).ToArray();
+				RemoveGameEntities(ids, ids.Length);
+			}
 		}
 	}
 }
@@ -0,0 +1,187 @@
+﻿/*
+Copyright (c) 2022 Daniel McLarty
+Copyright (c) 2020-2022 Arash Khatami
+
+MIT License - see LICENSE file
+*/
+
+using System;
+using System.Diagnostics;
+using System.Numerics;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Windows.Media;
+
+namespace Savage_Editor.DLLWrappers
+{
+	// Must match transform_channel::edit_flags in Engine/Components/TransformChannel.h
+	[Flags]
+	enum TransformEditFlags : uint
+	{
+		Position = 0x01,
+		Rotation = 0x02,
+		Scale = 0x04,
+	}
+
+	// Must match transform_channel::transform_edit
+	[StructLayout(LayoutKind.Sequential)]
+	struct TransformEdit
+	{
+		public int EntityID;
+		public TransformEditFlags Flags;
+		public Vector3 Position;
+		public Quaternion Rotation;
+		public Vector3 Scale;
+	}
+
+	// One published frame. The spans point straight at the engine's memory, nothing is copied.
+	// Call TransformChannel.EndRead() after using it to know if the engine overwrote it in the meantime.
+	ref struct TransformFrame
+	{
+		public ReadOnlySpan<Vector3> Positions;
+		public ReadOnlySpan<Quaternion> Rotations;
+		public ReadOnlySpan<Vector3> Scales;
+		public int Total; // More than Positions.Length if the channel is too small for all transforms
+		public long Frame;
+		internal int Buffer;
+		internal uint Sequence;
+	}
+
+	// Editor side of the transform channel the engine shares with the viewports
+	unsafe class TransformChannel : IDisposable
+	{
+		private const uint _magic = 0x43545653; // 'SVTC'
+		private const uint _version = 2;
+
+		// Offsets in transform_channel::channel_header
+		private const int _capacityOffset = 8;
+		private const int _queueCapacityOffset = 12;
+		private const int _frameOffset = 16;
+		private const int _latestOffset = 24;
+		private const int _queueSlotsOffset = 28;
+		private const int _buffersOffset = 32;
+		private const int _bufferSize = 32;
+		private const int _queueHeadOffset = 128;
+		private const int _queueTailOffset = 192;
+
+		private const int _initialCapacity = 4096;
+
+		// The channel the viewports share. It is opened with the first viewport and updated once per
+		// rendered frame, so transform changes made in the editor reach the engine entities
+		private static TransformChannel? _shared;
+		private static int _viewportCount;
+
+		private byte* _channel;
+
+		public int Capacity => *(int*)(_channel + _capacityOffset);
+		public long Frame => Volatile.Read(ref *(long*)(_channel + _frameOffset));
+
+		public static void AddViewport()
+		{
+			if (_viewportCount++ > 0) return;
+			_shared = Open(_initialCapacity);
+			CompositionTarget.Rendering += OnRendering;
+		}
+
+		public static void RemoveViewport()
+		{
+			Debug.Assert(_viewportCount > 0);
+			if (--_viewportCount > 0) return;
+			CompositionTarget.Rendering -= OnRendering;
+			_shared?.Dispose();
+			_shared = null;
+		}
+
+		// Send a change to the engine. Does nothing if no viewport is open
+		public static void SendEdit(in TransformEdit edit)
+		{
+			if (_shared == null) return;
+			if (!_shared.PushEdit(edit))
+			{
+				Update(); // The queue is full, let the engine take the edits in it first
+				_shared?.PushEdit(edit);
+			}
+		}
+
+		private static void OnRendering(object sender, EventArgs e) => Update();
+
+		// Apply the queued edits and publish the engine's transforms. If the engine has more transforms
+		// than fit, the channel is opened again big enough for all of them
+		private static void Update()
+		{
+			if (_shared == null) return;
+			EngineAPI.UpdateTransformChannel();
+			if (!_shared.BeginRead(out var frame) || frame.Total <= _shared.Capacity) return;
+
+			var capacity = _shared.Capacity;
+			while (capacity < frame.Total) capacity *= 2;
+			_shared.Dispose(); // The queue is empty here, UpdateTransformChannel() applied all edits
+			_shared = Open(capacity);
+			if (_shared != null) EngineAPI.UpdateTransformChannel();
+		}
+
+		public static TransformChannel? Open(int capacity, int queueCapacity = 4096)
+		{
+			var channel = EngineAPI.OpenTransformChannel(capacity, queueCapacity);
+			if (channel == IntPtr.Zero) return null;
+			Debug.Assert(*(uint*)channel == _magic && *(uint*)(channel + 4) == _version);
+			return new TransformChannel((byte*)channel);
+		}
+
+		private TransformChannel(byte* channel)
+		{
+			_channel = channel;
+		}
+
+		public void Dispose()
+		{
+			if (_channel == null) return;
+			_channel = null;
+			EngineAPI.CloseTransformChannel();
+		}
+
+		// Get the latest frame the engine published. Returns false if there is none yet
+		public bool BeginRead(out TransformFrame frame)
+		{
+			frame = default;
+			if (Frame == 0) return false;
+
+			var latest = Volatile.Read(ref *(int*)(_channel + _latestOffset));
+			var buffer = _channel + _buffersOffset + latest * _bufferSize;
+			var sequence = Volatile.Read(ref *(uint*)buffer);
+			if ((sequence & 1) != 0) return false; // The engine is writing it
+
+			var count = *(int*)(buffer + 4);
+			frame.Total = *(int*)(buffer + 28);
+			frame.Positions = new ReadOnlySpan<Vector3>(_channel + *(uint*)(buffer + 16), count);
+			frame.Rotations = new ReadOnlySpan<Quaternion>(_channel + *(uint*)(buffer + 20), count);
+			frame.Scales = new ReadOnlySpan<Vector3>(_channel + *(uint*)(buffer + 24), count);
+			frame.Frame = *(long*)(buffer + 8);
+			frame.Buffer = latest;
+			frame.Sequence = sequence;
+			return true;
+		}
+
+		// Returns false if the engine wrote to the frame while it was being read
+		public bool EndRead(in TransformFrame frame)
+		{
+			Interlocked.MemoryBarrier();
+			var buffer = _channel + _buffersOffset + frame.Buffer * _bufferSize;
+			return *(uint*)buffer == frame.Sequence;
+		}
+
+		// Queue a change for the engine. Returns false if the queue is full
+		public bool PushEdit(in TransformEdit edit)
+		{
+			var queueCapacity = *(uint*)(_channel + _queueCapacityOffset);
+			var head = *(uint*)(_channel + _queueHeadOffset); // Only the editor writes the head
+			var tail = Volatile.Read(ref *(uint*)(_channel + _queueTailOffset));
+			if (head - tail >= queueCapacity) return false;
+
+			var slots = (TransformEdit*)(_channel + *(uint*)(_channel + _queueSlotsOffset));
+			slots[head & (queueCapacity - 1)] = edit;
+			Volatile.Write(ref *(uint*)(_channel + _queueHeadOffset), head + 1);
+			return true;
+		}
+	}
+}
@@ -77,6 +77,17 @@ namespace Savage_Editor.Editors
 			});
 		}
 
+		private Action GetIsStaticAction()
+		{
+			var vm = DataContext as MSEntity; // Remember entities old state
+			var selection = vm.SelectedEntities.Select(entity => (entity, entity.IsStatic)).ToList();
+			return new Action(() =>
+			{
+				selection.ForEach(item => item.entity.IsStatic = item.IsStatic);
+				(DataContext as MSEntity).Refresh();
+			});
+		}
+
 		private void OnName_TextBox_GotKeyboardFocus(object sender, KeyboardFocusChangedEventArgs e)
 		{
 			_propertyName = string.Empty;
@@ -103,6 +114,15 @@ namespace Savage_Editor.Editors
 			Project.UndoRedo.Add(new UndoRedoAction(undoAction, redoAction, vm.IsEnbaled == true ? "Enable game entity / game entities" : "Disable game entity / game entities"));
 		}
 
+		private void OnIsStatic_CheckBox_Click(object sender, RoutedEventArgs e)
+		{
+			var undoAction = GetIsStaticAction(); // Remember old state
+			var vm = DataContext as MSEntity;
+			vm.IsStatic = (sender as CheckBox).IsChecked == true;
+			var redoAction = GetIsStaticAction(); // Remember new values
+			Project.UndoRedo.Add(new UndoRedoAction(undoAction, redoAction, vm.IsStatic == true ? "Make game entity / game entities static" : "Make game entity / game entities dynamic"));
+		}
+
 		private void OnAddComponent_Button_PreviewMouse_LBD(object sender, MouseButtonEventArgs e)
 		{
 			var menu = FindResource("addComponentMenu") as ContextMenu;
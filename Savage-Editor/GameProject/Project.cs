@@ -10,6 +10,7 @@ using Savage_Editor.DLLWrappers;
 using Savage_Editor.GameDev;
 using Savage_Editor.Utilities;
 using System;
+using System.Collections.Generic;
 using System.Collections.ObjectModel;
 using System.Diagnostics;
 using System.IO;
@@ -178,25 +179,138 @@ namespace Savage_Editor.GameProject
 			UndoRedo.Reset();
 		}
 
+		// What the last full export of game.bin had in it, so later saves only write what changed to game.patch
+		private Scene _binaryScene;
+		private List<byte[]> _binaryEntities;                   // Entity data in game.bin, by slot
+		private Dictionary<GameEntity, int> _binarySlots;       // Slot of each entity in game.bin
+		private Dictionary<int, byte[]> _patchedEntities;       // Entity data that differs from game.bin, by slot
+		private Dictionary<GameEntity, byte[]> _newEntities;    // Data of the entities added since game.bin was written
+		private uint _binaryChecksum;
+		private DateTime _binaryWriteTime;
+
+		private const uint _patchMagic = 0x50475653; // 'SVGP'
+		private const uint _patchVersion = 1;
+
+		private static byte[] EntityToBinary(GameEntity entity)
+		{
+			using (var ms = new MemoryStream())
+			using (var bw = new BinaryWriter(ms))
+			{
+				bw.Write(entity.IsStatic ? 1 : 0); // Entity flags (see entity_flags in ContentLoader.cpp)
+				bw.Write(entity.Components.Count); // Number of components in the entity
+				// Write all components
+				foreach (var component in entity.Components)
+				{
+					bw.Write((int)component.ToEnumType());
+					component.WriteToBinary(bw);
+				}
+				bw.Flush();
+				return ms.ToArray();
+			}
+		}
+
+		// Write every entity to game.bin and remember what was written
+		private void SaveFullBinary(string bin, string patch, List<(GameEntity entity, byte[] data)> entities)
+		{
+			using (var ms = new MemoryStream())
+			{
+				using (var bw = new BinaryWriter(ms))
+				{
+					bw.Write(entities.Count);
+					foreach (var (_, data) in entities) bw.Write(data);
+				}
+				var bytes = ms.ToArray();
+				File.WriteAllBytes(bin, bytes);
+				var checksum = Crc32.Compute(bytes);
+				// Release builds load it like a shipped game. Patches are checked against the cooked data
+				if (StandAloneBiuldConfig == BuildConfiguration.Release &&
+					EngineAPI.CookGameBinary(bin, CookFlags.PackStaticTransforms | CookFlags.Compress, out checksum) == 0)
+				{
+					Logger.Log(MessageType.Warning, "Failed to cook game.bin");
+					File.WriteAllBytes(bin, bytes);
+					checksum = Crc32.Compute(bytes);
+				}
+				if (File.Exists(patch)) File.Delete(patch);
+
+				_binaryScene = ActiveScene;
+				_binaryEntities = entities.Select(x => x.data).ToList();
+				_binarySlots = new Dictionary<GameEntity, int>();
+				for (int i = 0; i < entities.Count; ++i) _binarySlots[entities[i].entity] = i;
+				_patchedEntities = new Dictionary<int, byte[]>();
+				_newEntities = new Dictionary<GameEntity, byte[]>();
+				entities.ForEach(x => x.entity.MarkBinaryClean());
+				_binaryChecksum = checksum;
+				_binaryWriteTime = File.GetLastWriteTimeUtc(bin);
+			}
+		}
+
 		// Save the project such that it works with the engine
+		// Only the entities that changed since the last full export are written, to game.patch.
+		// The patch has everything changed since then, so it replaces the last one and the engine
+		// only has to apply one patch on top of game.bin.
 		private void SaveToBinary()
 		{
 			var configName = _getConfigurationNames(StandAloneBiuldConfig);
 			var bin = $@"{Path}x64\{configName}\game.bin";
+			var patch = $@"{Path}x64\{configName}\game.patch";
+
+			var entities = ActiveScene.GameEntities;
+			List<(GameEntity entity, byte[] data)> AllToBinary() => entities.Select(x => (x, EntityToBinary(x))).ToList();
+
+			// Need a full export if there is nothing to patch or game.bin was changed by someone else
+			if (_binaryScene != ActiveScene || !File.Exists(bin) || File.GetLastWriteTimeUtc(bin) != _binaryWriteTime)
+			{
+				SaveFullBinary(bin, patch, AllToBinary());
+				return;
+			}
 
-			using (var bw = new BinaryWriter(File.Open(bin, FileMode.Create, FileAccess.Write)))
+			// Only the entities that are new or changed since the last save are written again
+			foreach (var entity in entities)
 			{
-				bw.Write(ActiveScene.GameEntities.Count);
-				foreach (var entity in ActiveScene.GameEntities)
+				var inBinary = _binarySlots.TryGetValue(entity, out var slot);
+				if (!entity.IsBinaryDirty && (inBinary || _newEntities.ContainsKey(entity))) continue;
+
+				var data = EntityToBinary(entity);
+				entity.MarkBinaryClean();
+				if (!inBinary) _newEntities[entity] = data;
+				// Changed back to what game.bin has, for example by undo
+				else if (_binaryEntities[slot].AsSpan().SequenceEqual(data)) _patchedEntities.Remove(slot);
+				else _patchedEntities[slot] = data;
+			}
+
+			// New entities that were removed again are just forgotten
+			var alive = new HashSet<GameEntity>(entities);
+			foreach (var entity in _newEntities.Keys.Where(x => !alive.Contains(x)).ToList()) _newEntities.Remove(entity);
+
+			// Entities in game.bin that are gone get an empty record. Their changes are kept in case they come back
+			var usedSlots = new HashSet<int>(entities.Where(x => _binarySlots.ContainsKey(x)).Select(x => _binarySlots[x]));
+			var records = _patchedEntities.Where(x => usedSlots.Contains(x.Key)).Select(x => (slot: x.Key, data: x.Value)).ToList();
+			for (int slot = 0; slot < _binaryEntities.Count; ++slot)
+			{
+				if (!usedSlots.Contains(slot)) records.Add((slot, Array.Empty<byte>()));
+			}
+			// New entities go right after the ones in game.bin, with no gaps (the engine checks the slots against that)
+			var nextSlot = _binaryEntities.Count;
+			foreach (var entity in entities.Where(x => _newEntities.ContainsKey(x))) records.Add((nextSlot++, _newEntities[entity]));
+
+			// A patch that touches most of the game is not worth it
+			if (records.Count * 2 > entities.Count)
+			{
+				SaveFullBinary(bin, patch, AllToBinary());
+				return;
+			}
+
+			using (var bw = new BinaryWriter(File.Open(patch, FileMode.Create, FileAccess.Write)))
+			{
+				bw.Write(_patchMagic);
+				bw.Write(_patchVersion);
+				bw.Write(_binaryChecksum);
+				bw.Write(records.Count);
+				foreach (var (slot, data) in records.OrderBy(x => x.slot))
 				{
-					bw.Write(0); // Entity type (reserved for later)
-					bw.Write(entity.Components.Count); // Number of components in the entity
-													   // Write all components
-					foreach (var component in entity.Components)
-					{
-						bw.Write((int)component.ToEnumType());
-						component.WriteToBinary(bw);
-					}
+					bw.Write(slot);
+					bw.Write(data.Length);
+					bw.Write(data);
 				}
 			}
 		}
@@ -222,12 +336,14 @@ namespace Savage_Editor.GameProject
 		{
 			try
 			{
-				UnloadGameCodeDLL();
+				// The engine uses a copy of the DLL so it can stay loaded while it is rebuilt
+				var isLoaded = AvailableScripts != null;
 				// Build then load the DLL
 				await Task.Run(() => VisualStudio.BuildSolution(this, _getConfigurationNames(DLLBiuldConfig), showWindow));
 				if (VisualStudio.BuildSucceeded)
 				{
-					LoadGameCodeDLL();
+					if (isLoaded) ReloadGameCodeDLL(); // Keep the scripts of live entities and their state
+					else LoadGameCodeDLL();
 				}
 			}
 			catch (Exception ex)
@@ -255,7 +371,7 @@ namespace Savage_Editor.GameProject
 				// Find the scripts
 				AvailableScripts = EngineAPI.GetScriptNames();
 				// Load the scripts
-				ActiveScene.GameEntities.Where(x => x.GetComponent<Script>() != null).ToList().ForEach(x => x.IsActive = true);
+				GameEntity.SetActive(ActiveScene.GameEntities.Where(x => x.GetComponent<Script>() != null), true);
 				Logger.Log(MessageType.Info, "Game Code DLL loaded successfully.");
 			}
 			else // If the DLL fails to load
@@ -264,10 +380,27 @@ namespace Savage_Editor.GameProject
 			}
 		}
 
+		private void ReloadGameCodeDLL()
+		{
+			var configName = _getConfigurationNames(DLLBiuldConfig);
+			var dll = $@"{Path}x64\{configName}\{Name}.dll";
+
+			var watch = Stopwatch.StartNew();
+			if (File.Exists(dll) && EngineAPI.ReloadGameCodeDLL(dll) != 0)
+			{
+				AvailableScripts = EngineAPI.GetScriptNames();
+				Logger.Log(MessageType.Info, $"Game Code DLL reloaded in {watch.ElapsedMilliseconds} ms.");
+			}
+			else // The old game code is still loaded
+			{
+				Logger.Log(MessageType.Warning, "Game Code DLL failed to reload. Still using the previous build.");
+			}
+		}
+
 		private void UnloadGameCodeDLL()
 		{
 			// Unload the scripts
-			ActiveScene.GameEntities.Where(x => x.GetComponent<Script>() != null).ToList().ForEach(x => x.IsActive = false);
+			GameEntity.SetActive(ActiveScene.GameEntities.Where(x => x.GetComponent<Script>() != null), false);
 			// Unload the DLL
 			if (EngineAPI.UnloadGameCodeDLL() != 0)
 			{
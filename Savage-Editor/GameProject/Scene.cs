@@ -89,10 +89,7 @@ namespace Savage_Editor.GameProject
 			}
 
 			// Set status on load for all entities
-			foreach (var entity in _gameEntities)
-			{
-				entity.IsActive = IsActive;
-			}
+			GameEntity.SetActive(_gameEntities, IsActive);
 
 			//Define add entity
 			AddGameEntityCommand = new RelayCommand<GameEntity>(x =>
@@ -5,6 +5,7 @@ Copyright (c) 2020-2022 Arash Khatami
 MIT License - see LICENSE file
 */
 
+using Savage_Editor.DLLWrappers;
 using System;
 using System.Diagnostics;
 using System.Windows;
@@ -44,6 +45,7 @@ namespace Savage_Editor.Utilities
 			_host = new RenderSurfaceHost(ActualWidth, ActualHeight);
 			_host.MessageHook += new HwndSourceHook(HostMsgFilter);
 			Content = _host;
+			TransformChannel.AddViewport();
 
 			var window = this.FindVisualParent<Window>();
 			Debug.Assert(window != null);
@@ -107,6 +109,7 @@ namespace Savage_Editor.Utilities
 				if (disposing)
 				{
 					_host.Dispose();
+					TransformChannel.RemoveViewport();
 				}
 				_disposedValue = true;
 			}
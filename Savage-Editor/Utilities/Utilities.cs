@@ -34,6 +34,31 @@ namespace Savage_Editor.Utilities
 		}
 	}
 
+	// Same CRC-32 as the engine (Engine/Utilities/Checksum.h)
+	public static class Crc32
+	{
+		private static readonly uint[] _table = MakeTable();
+
+		private static uint[] MakeTable()
+		{
+			var table = new uint[256];
+			for (uint i = 0; i < 256; ++i)
+			{
+				var c = i;
+				for (int k = 0; k < 8; ++k) c = (c & 1) != 0 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+				table[i] = c;
+			}
+			return table;
+		}
+
+		public static uint Compute(byte[] data)
+		{
+			var crc = ~0u;
+			foreach (var b in data) crc = _table[(crc ^ b) & 0xff] ^ (crc >> 8);
+			return ~crc;
+		}
+	}
+
 	class DelayEventTimerArgs : EventArgs
 	{
 		// Do we want to call the event